@@ -0,0 +1,282 @@
+#include <algorithm>  // for std::sort, std::max
+#include <chrono>     // for std::chrono::steady_clock, std::chrono::duration
+#include <cstdlib>    // for EXIT_SUCCESS, EXIT_FAILURE
+#include <ctime>      // for std::time, std::strftime, std::gmtime
+#include <exception>  // for std::exception
+#include <fstream>
+#include <iostream>
+#include <memory>     // for std::unique_ptr
+#include <sstream>    // for std::ostringstream
+#include <stdexcept>  // for std::runtime_error
+#include <string>
+#include <vector>
+#include "../src/framework/module_creator.h"       // for module_creator
+#include "../src/framework/module_factory.h"       // for module_factory
+#include "../src/framework/state_map.h"            // for state_map, string_vector
+#include "../src/module_library/module_library.h"  // for standardBML::module_library
+
+using library = standardBML::module_library;
+using bench_clock = std::chrono::steady_clock;
+
+namespace
+{
+/**
+ *  @brief A module to benchmark, along with the functions that dominate its
+ *  run time. The module's test cases supply its inputs.
+ */
+struct benchmark_target {
+    std::string module_name;
+    string_vector functions;
+};
+
+std::vector<benchmark_target> const default_targets = {
+    {"c3_leaf_photosynthesis", {"c3photoC", "c3EvapoTrans"}},
+    {"c4_leaf_photosynthesis", {"c4photoC", "EvapoTrans2"}},
+    {"c3_canopy", {"c3CanAC", "sunML", "c3photoC", "c3EvapoTrans"}},
+    {"c4_canopy", {"CanAC", "sunML", "c4photoC", "EvapoTrans2"}},
+    {"ten_layer_canopy_properties", {"sunML"}},
+    {"ten_layer_c3_canopy", {"c3photoC", "c3EvapoTrans"}},
+    {"ten_layer_c4_canopy", {"c4photoC", "EvapoTrans2"}},
+    {"two_layer_soil_profile", {"soilML"}}};
+
+// One row from a module test case file
+struct test_case {
+    state_map inputs;
+    std::string description;
+};
+
+string_vector split_csv_line(std::string const& line)
+{
+    string_vector fields;
+    std::string field;
+    bool quoted = false;
+
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (c == ',' && !quoted) {
+            fields.push_back(field);
+            field.clear();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+
+    return fields;
+}
+
+/**
+ *  @brief Reads the test cases for a module from a file in the format used by
+ *  `tests/module_test_cases`: a row indicating whether each column is an
+ *  `input`, an `output`, or the `description`; a row of quantity names; and
+ *  one row for each test case. Only the inputs and descriptions are needed.
+ */
+std::vector<test_case> read_test_cases(std::string const& filename)
+{
+    std::ifstream in(filename);
+    if (!in) {
+        throw std::runtime_error("Could not open `" + filename + "`");
+    }
+
+    std::string line;
+    std::getline(in, line);
+    string_vector const types = split_csv_line(line);
+    std::getline(in, line);
+    string_vector const names = split_csv_line(line);
+
+    std::vector<test_case> cases;
+    while (std::getline(in, line)) {
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        string_vector const values = split_csv_line(line);
+        if (values.size() != types.size()) {
+            throw std::runtime_error(
+                "`" + filename + "` has a row with the wrong number of fields");
+        }
+
+        test_case tc;
+        for (size_t i = 0; i < types.size(); ++i) {
+            if (types[i] == "input") {
+                tc.inputs[names[i]] = std::stod(values[i]);
+            } else if (types[i] == "description") {
+                tc.description = values[i];
+            }
+        }
+        cases.push_back(tc);
+    }
+
+    return cases;
+}
+
+std::string json_string(std::string const& s)
+{
+    std::string result = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+std::string json_string_array(string_vector const& v)
+{
+    std::string result = "[";
+    for (size_t i = 0; i < v.size(); ++i) {
+        result += (i > 0 ? ", " : "") + json_string(v[i]);
+    }
+    return result + "]";
+}
+
+// Runs a module `n` times and returns the elapsed time in seconds
+double time_runs(module const& m, long n)
+{
+    auto const start = bench_clock::now();
+    for (long i = 0; i < n; ++i) {
+        m.run();
+    }
+    std::chrono::duration<double> const elapsed = bench_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ *  @brief Times one test case of one module and returns the result as a JSON
+ *  object.
+ *
+ *  The number of calls per sample is doubled until a sample takes at least
+ *  `min_sample_seconds`, and then `nsamples` samples are timed.
+ */
+std::string benchmark_case(
+    benchmark_target const& target,
+    module_creator* mc,
+    test_case const& tc,
+    double min_sample_seconds,
+    int nsamples)
+{
+    std::ostringstream json;
+    json.precision(6);
+
+    json << "    {\n"
+         << "      \"module\": " << json_string(target.module_name) << ",\n"
+         << "      \"functions\": " << json_string_array(target.functions) << ",\n"
+         << "      \"test_case\": " << json_string(tc.description) << ",\n";
+
+    try {
+        state_map outputs;
+        for (std::string const& name : mc->get_outputs()) {
+            outputs[name] = 0.0;
+        }
+
+        std::unique_ptr<module> m = mc->create_module(tc.inputs, &outputs);
+
+        long calls = 1;
+        while (time_runs(*m, calls) < min_sample_seconds && calls < (1L << 40)) {
+            calls *= 2;
+        }
+
+        std::vector<double> ns_per_call;
+        for (int i = 0; i < nsamples; ++i) {
+            ns_per_call.push_back(1e9 * time_runs(*m, calls) / calls);
+        }
+        std::sort(ns_per_call.begin(), ns_per_call.end());
+
+        json << "      \"calls_per_sample\": " << calls << ",\n"
+             << "      \"samples\": " << nsamples << ",\n"
+             << "      \"ns_per_call_min\": " << ns_per_call.front() << ",\n"
+             << "      \"ns_per_call_median\": " << ns_per_call[nsamples / 2] << "\n";
+    } catch (std::exception const& e) {
+        json << "      \"error\": " << json_string(e.what()) << "\n";
+    }
+
+    json << "    }";
+    return json.str();
+}
+
+std::string current_time()
+{
+    char buffer[32];
+    std::time_t const now = std::time(nullptr);
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buffer;
+}
+}  // namespace
+
+/**
+ *  @brief A command-line program that benchmarks individual modules using the
+ *  inputs from their test cases and writes the results to a JSON file.
+ *
+ *  Usage: module_benchmarks [output file] [test case directory] [module ...]
+ *
+ *  By default, the modules in `default_targets` are benchmarked, the test
+ *  cases are read from `../tests/module_test_cases`, and the results are
+ *  written to `module_benchmarks.json`. Any module with a test case file can be
+ *  benchmarked by listing its name after the other arguments.
+ */
+int main(int argc, char* argv[])
+{
+    std::string const output_file = argc > 1 ? argv[1] : "module_benchmarks.json";
+    std::string const test_case_directory = argc > 2 ? argv[2] : "../tests/module_test_cases";
+
+    std::vector<benchmark_target> targets = default_targets;
+    if (argc > 3) {
+        targets.clear();
+        for (int i = 3; i < argc; ++i) {
+            targets.push_back({argv[i], {}});
+        }
+    }
+
+    double const min_sample_seconds = 0.05;
+    int const nsamples = 7;
+
+    try {
+        string_vector entries;
+
+        for (benchmark_target const& target : targets) {
+            std::cerr << "Benchmarking " << target.module_name << "\n";
+
+            std::unique_ptr<module_creator> mc(
+                module_factory<library>::retrieve(target.module_name));
+
+            std::vector<test_case> const cases = read_test_cases(
+                test_case_directory + "/BioCro_" + target.module_name + ".csv");
+
+            for (test_case const& tc : cases) {
+                entries.push_back(benchmark_case(
+                    target, mc.get(), tc, min_sample_seconds, nsamples));
+            }
+        }
+
+        std::ofstream out(output_file);
+        out << "{\n"
+            << "  \"benchmark\": \"modules\",\n"
+            << "  \"compiler\": " << json_string(__VERSION__) << ",\n"
+            << "  \"date\": " << json_string(current_time()) << ",\n"
+            << "  \"results\": [\n";
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            out << entries[i] << (i + 1 < entries.size() ? ",\n" : "\n");
+        }
+
+        out << "  ]\n"
+            << "}\n";
+
+        if (!out) {
+            throw std::runtime_error("Could not write to `" + output_file + "`");
+        }
+
+        std::cerr << "Wrote " << output_file << "\n";
+    } catch (std::exception const& e) {
+        std::cerr << "module_benchmarks: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,223 @@
+#include <cstdlib>    // for std::strtoul, EXIT_SUCCESS, EXIT_FAILURE
+#include <exception>  // for std::exception
+#include <iostream>
+#include <memory>     // for std::unique_ptr
+#include <stdexcept>  // for std::runtime_error
+#include <string>
+#include <vector>
+#include "../src/framework/module_creator.h"       // for module_creator, mc_vector
+#include "../src/framework/module_factory.h"       // for module_factory
+#include "../src/framework/state_map.h"            // for state_vector_map, string_vector
+#include "../src/module_fusion.h"                  // for fuse_direct_modules
+#include "../src/module_library/module_library.h"  // for standardBML::module_library
+#include "../src/result_sink.h"                    // for csv_sink, binary_sink, chunked_result_writer
+#include "../src/simulation_dispatch.h"            // for dispatching_simulation
+#include "driver_input.h"                          // for read_drivers, add_time_to_drivers
+#include "json.h"                                  // for parse_json_file
+#include "model_definition.h"                      // for model_definition, local_module_name
+
+using library = standardBML::module_library;
+
+namespace
+{
+char const* usage =
+    "Usage: biocro_cli [options] MODEL DRIVERS OUTPUT [DRIVERS OUTPUT ...]\n"
+    "\n"
+    "Runs a BioCro simulation for each pair of DRIVERS and OUTPUT files using\n"
+    "the model defined in the JSON file MODEL.\n"
+    "\n"
+    "DRIVERS files must have a `.csv` or `.bin` extension; `.bin` files use\n"
+    "the format written by `run_biocro_to_file(format = 'binary')` in R.\n"
+    "OUTPUT files are written in the same format, chosen by their extension.\n"
+    "\n"
+    "Options:\n"
+    "  -q, --output-quantities REGEX  Only write quantities whose names match\n"
+    "                                 REGEX; may be given more than once\n"
+    "  -d, --output-decimation N      Only write every N-th time point\n"
+    "  -c, --chunk-size N             Number of rows written at a time\n"
+    "                                 (default: 1000)\n"
+    "  -f, --fuse-modules             Replace the direct modules by a fused\n"
+    "                                 module when they match one\n"
+    "  -v, --verbose                  Print the simulation report\n"
+    "  -h, --help                     Print this message and exit\n";
+
+struct cli_options {
+    string_vector output_quantities;
+    size_t output_decimation = 1;
+    size_t chunk_size = 1000;
+    bool fuse_modules = false;
+    bool verbose = false;
+    std::string model_file;
+    string_vector driver_files;
+    string_vector output_files;
+};
+
+size_t parse_count(std::string const& option, std::string const& value)
+{
+    char* end;
+    unsigned long const n = std::strtoul(value.c_str(), &end, 10);
+
+    if (value.empty() || *end != '\0' || n < 1) {
+        throw std::runtime_error(
+            "The value of `" + option + "` must be a positive whole number");
+    }
+
+    return n;
+}
+
+cli_options parse_arguments(int argc, char* argv[])
+{
+    cli_options opts;
+    string_vector positional;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string const arg = argv[i];
+
+        auto next_value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("`" + arg + "` requires a value");
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            std::cout << usage;
+            std::exit(EXIT_SUCCESS);
+        } else if (arg == "-f" || arg == "--fuse-modules") {
+            opts.fuse_modules = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            opts.verbose = true;
+        } else if (arg == "-q" || arg == "--output-quantities") {
+            opts.output_quantities.push_back(next_value());
+        } else if (arg == "-d" || arg == "--output-decimation") {
+            opts.output_decimation = parse_count(arg, next_value());
+        } else if (arg == "-c" || arg == "--chunk-size") {
+            opts.chunk_size = parse_count(arg, next_value());
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::runtime_error("Unknown option `" + arg + "`");
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() < 3 || positional.size() % 2 != 1) {
+        throw std::runtime_error(
+            "A model file must be followed by one or more pairs of drivers "
+            "and output files");
+    }
+
+    opts.model_file = positional[0];
+    for (size_t i = 1; i < positional.size(); i += 2) {
+        opts.driver_files.push_back(positional[i]);
+        opts.output_files.push_back(positional[i + 1]);
+    }
+
+    return opts;
+}
+
+std::unique_ptr<result_sink> make_sink(std::string const& filename)
+{
+    auto ends_with = [&](std::string const& suffix) {
+        return filename.size() >= suffix.size() &&
+               filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    if (ends_with(".csv")) {
+        return std::unique_ptr<result_sink>(new csv_sink(filename));
+    } else if (ends_with(".bin")) {
+        return std::unique_ptr<result_sink>(new binary_sink(filename));
+    } else {
+        throw std::runtime_error(
+            "The output file `" + filename + "` must have a `.csv` or " +
+            "`.bin` extension");
+    }
+}
+
+// Retrieves module creators from the standard module library; the creators
+// are owned by `storage`
+mc_vector get_module_creators(
+    string_vector const& module_names,
+    std::vector<std::unique_ptr<module_creator>>& storage)
+{
+    mc_vector mcs;
+    for (std::string const& name : module_names) {
+        storage.emplace_back(
+            module_factory<library>::retrieve(local_module_name(name)));
+        mcs.push_back(storage.back().get());
+    }
+    return mcs;
+}
+}  // namespace
+
+/**
+ *  @brief A command-line program that runs BioCro simulations without R.
+ *
+ *  The model definition and module creators are only prepared once, so
+ *  running several sets of drivers in a single invocation avoids repeating
+ *  that work. Output columns are named as in the data frames returned by
+ *  `run_biocro()`, including the `doy` and `hour` columns that are calculated
+ *  from `time`. They are sorted by byte value, which may differ from R's
+ *  locale-dependent order for names that differ in case.
+ */
+int main(int argc, char* argv[])
+{
+    try {
+        cli_options const opts = parse_arguments(argc, argv);
+
+        model_definition const md =
+            model_definition_from_json(parse_json_file(opts.model_file));
+
+        std::vector<std::unique_ptr<module_creator>> mc_storage;
+
+        mc_vector direct_mcs =
+            get_module_creators(md.direct_module_names, mc_storage);
+
+        if (opts.fuse_modules) {
+            direct_mcs = fuse_direct_modules(direct_mcs, mc_storage);
+        }
+
+        mc_vector const differential_mcs =
+            get_module_creators(md.differential_module_names, mc_storage);
+
+        for (size_t i = 0; i < opts.driver_files.size(); ++i) {
+            state_vector_map drivers = read_drivers(opts.driver_files[i]);
+            add_time_to_drivers(drivers);
+
+            if (drivers.empty() || drivers.begin()->second.empty()) {
+                throw std::runtime_error(
+                    "The drivers in `" + opts.driver_files[i] +
+                    "` are empty");
+            }
+
+            // Open the output file before running the simulation so any
+            // problems with it are reported right away
+            std::unique_ptr<result_sink> sink = make_sink(opts.output_files[i]);
+
+            dispatching_simulation gro(
+                md.initial_values, md.parameters, drivers,
+                direct_mcs, differential_mcs, md.ode_solver_type,
+                md.output_step_size, md.adaptive_rel_error_tol,
+                md.adaptive_abs_error_tol, md.adaptive_max_steps);
+
+            // The simulation has its own copy of the drivers
+            state_vector_map().swap(drivers);
+
+            // Rows are written in chunks as the simulation produces them,
+            // when the ODE solver allows it
+            chunked_result_writer writer(
+                *sink, opts.output_quantities, opts.output_decimation,
+                opts.chunk_size, true);
+
+            gro.run_simulation(writer);
+
+            if (opts.verbose) {
+                std::cerr << gro.generate_report();
+            }
+        }
+    } catch (std::exception const& e) {
+        std::cerr << "biocro_cli: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
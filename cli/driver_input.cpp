@@ -0,0 +1,243 @@
+#include <cstdint>    // for uint32_t, uint64_t
+#include <cstdlib>    // for std::strtod
+#include <cstring>    // for std::memcpy
+#include <cmath>      // for NAN
+#include <fstream>
+#include <stdexcept>  // for std::runtime_error
+#include <vector>
+#include "driver_input.h"
+
+namespace
+{
+// Splits one line of a CSV file into fields, removing any surrounding double
+// quotes. Quoted fields may contain commas and doubled quotes (`""`).
+string_vector split_csv_line(std::string const& line)
+{
+    string_vector fields;
+    std::string field;
+    bool quoted = false;
+
+    for (size_t i = 0; i < line.size(); ++i) {
+        char const c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+
+    return fields;
+}
+
+double parse_csv_value(std::string const& field, std::string const& filename, size_t line_number)
+{
+    if (field.empty() || field == "NA") {
+        return NAN;
+    }
+
+    char* end;
+    double const x = std::strtod(field.c_str(), &end);
+
+    if (*end != '\0') {
+        throw std::runtime_error(
+            filename + ", line " + std::to_string(line_number) + ": `" +
+            field + "` is not a number");
+    }
+
+    return x;
+}
+
+// Reads an unsigned integer stored in little-endian byte order
+template <typename uint_type>
+uint_type load_little_endian(char const* bytes)
+{
+    uint_type x = 0;
+    for (size_t i = 0; i < sizeof(uint_type); ++i) {
+        x |= static_cast<uint_type>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+    }
+    return x;
+}
+
+size_t read_int(std::ifstream& in, std::string const& filename)
+{
+    char bytes[4];
+    if (!in.read(bytes, 4)) {
+        throw std::runtime_error("`" + filename + "` ended unexpectedly");
+    }
+    return load_little_endian<uint32_t>(bytes);
+}
+
+bool ends_with(std::string const& s, std::string const& suffix)
+{
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+}  // namespace
+
+/**
+ *  @brief Reads drivers from a CSV file with a header row containing the
+ *  quantity names. Empty fields and `NA` are read as NaN.
+ */
+state_vector_map read_csv_drivers(std::string const& filename)
+{
+    std::ifstream in(filename);
+    if (!in) {
+        throw std::runtime_error("Could not open `" + filename + "`");
+    }
+
+    std::string line;
+    if (!std::getline(in, line)) {
+        throw std::runtime_error("`" + filename + "` is empty");
+    }
+
+    string_vector const names = split_csv_line(line);
+    std::vector<std::vector<double>> columns(names.size());
+
+    size_t line_number = 1;
+    while (std::getline(in, line)) {
+        ++line_number;
+
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        string_vector const fields = split_csv_line(line);
+
+        if (fields.size() != names.size()) {
+            throw std::runtime_error(
+                filename + ", line " + std::to_string(line_number) + ": " +
+                "expected " + std::to_string(names.size()) + " fields but " +
+                "found " + std::to_string(fields.size()));
+        }
+
+        for (size_t j = 0; j < fields.size(); ++j) {
+            columns[j].push_back(parse_csv_value(fields[j], filename, line_number));
+        }
+    }
+
+    state_vector_map drivers;
+    for (size_t j = 0; j < names.size(); ++j) {
+        if (drivers.count(names[j]) > 0) {
+            throw std::runtime_error(
+                "`" + filename + "` contains more than one `" + names[j] +
+                "` column");
+        }
+        drivers[names[j]].swap(columns[j]);
+    }
+
+    return drivers;
+}
+
+/**
+ *  @brief Reads drivers from a binary file in the format written by
+ *  `binary_sink`, i.e., the format produced by `run_biocro_to_file()` with
+ *  `format = 'binary'`. All chunks are concatenated.
+ */
+state_vector_map read_binary_drivers(std::string const& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open `" + filename + "`");
+    }
+
+    char magic[8];
+    if (!in.read(magic, 8) || std::string(magic, 8) != std::string("BIOCRO\x01\n", 8)) {
+        throw std::runtime_error(
+            "`" + filename + "` is not a BioCro binary file");
+    }
+
+    size_t const ncol = read_int(in, filename);
+
+    string_vector names(ncol);
+    for (size_t j = 0; j < ncol; ++j) {
+        size_t const len = read_int(in, filename);
+        names[j].resize(len);
+        if (len > 0 && !in.read(&names[j][0], len)) {
+            throw std::runtime_error("`" + filename + "` ended unexpectedly");
+        }
+    }
+
+    std::vector<std::vector<double>> columns(ncol);
+    std::vector<char> bytes;
+
+    // Read chunks until the end of the file is reached
+    while (in.peek() != std::ifstream::traits_type::eof()) {
+        size_t const nrows = read_int(in, filename);
+
+        bytes.resize(8 * nrows * ncol);
+        if (!bytes.empty() && !in.read(bytes.data(), bytes.size())) {
+            throw std::runtime_error("`" + filename + "` ended unexpectedly");
+        }
+
+        for (size_t j = 0; j < ncol; ++j) {
+            for (size_t i = 0; i < nrows; ++i) {
+                uint64_t const bits =
+                    load_little_endian<uint64_t>(&bytes[8 * (j * nrows + i)]);
+                double x;
+                std::memcpy(&x, &bits, 8);
+                columns[j].push_back(x);
+            }
+        }
+    }
+
+    state_vector_map drivers;
+    for (size_t j = 0; j < ncol; ++j) {
+        drivers[names[j]].swap(columns[j]);
+    }
+
+    return drivers;
+}
+
+/**
+ *  @brief Reads drivers from a CSV file or a binary file, depending on the
+ *  file extension (`.csv` or `.bin`)
+ */
+state_vector_map read_drivers(std::string const& filename)
+{
+    if (ends_with(filename, ".csv")) {
+        return read_csv_drivers(filename);
+    } else if (ends_with(filename, ".bin")) {
+        return read_binary_drivers(filename);
+    } else {
+        throw std::runtime_error(
+            "The drivers file `" + filename + "` must have a `.csv` or " +
+            "`.bin` extension");
+    }
+}
+
+/**
+ *  @brief Adds a `time` column calculated from the `doy` and `hour` columns,
+ *  if the drivers do not already have one; this mirrors the R function
+ *  `add_time_to_weather_data()`.
+ */
+void add_time_to_drivers(state_vector_map& drivers)
+{
+    if (drivers.count("time") > 0 ||
+        drivers.count("doy") == 0 ||
+        drivers.count("hour") == 0) {
+        return;
+    }
+
+    std::vector<double> const& doy = drivers.at("doy");
+    std::vector<double> const& hour = drivers.at("hour");
+    std::vector<double> time(doy.size());
+
+    for (size_t i = 0; i < doy.size(); ++i) {
+        time[i] = doy[i] + hour[i] / 24.0;
+    }
+
+    drivers["time"].swap(time);
+}
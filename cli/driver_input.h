@@ -0,0 +1,15 @@
+#ifndef CLI_DRIVER_INPUT_H
+#define CLI_DRIVER_INPUT_H
+
+#include <string>
+#include "../src/framework/state_map.h"  // for state_vector_map
+
+state_vector_map read_csv_drivers(std::string const& filename);
+
+state_vector_map read_binary_drivers(std::string const& filename);
+
+state_vector_map read_drivers(std::string const& filename);
+
+void add_time_to_drivers(state_vector_map& drivers);
+
+#endif
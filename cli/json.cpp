@@ -0,0 +1,351 @@
+#include <cmath>      // for NAN
+#include <cstdlib>    // for std::strtod
+#include <fstream>
+#include <sstream>    // for std::ostringstream
+#include <stdexcept>  // for std::runtime_error
+#include "json.h"
+
+namespace
+{
+/**
+ *  @brief A recursive-descent parser for the JSON grammar described at
+ *  https://www.json.org
+ */
+class json_parser
+{
+   public:
+    json_parser(std::string const& text) : text{text} {}
+
+    json_value parse_document()
+    {
+        json_value v = parse_value();
+        skip_whitespace();
+        if (pos != text.size()) {
+            fail("unexpected characters after the end of the document");
+        }
+        return v;
+    }
+
+   private:
+    std::string const& text;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(std::string const& message) const
+    {
+        // Report the location as a line number, which is easier to use than
+        // a character offset
+        size_t line = 1;
+        for (size_t i = 0; i < pos && i < text.size(); ++i) {
+            if (text[i] == '\n') {
+                ++line;
+            }
+        }
+        throw std::runtime_error(
+            "JSON parse error on line " + std::to_string(line) + ": " +
+            message);
+    }
+
+    void skip_whitespace()
+    {
+        while (pos < text.size() &&
+               (text[pos] == ' ' || text[pos] == '\t' ||
+                text[pos] == '\n' || text[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    void expect(char c)
+    {
+        skip_whitespace();
+        if (pos >= text.size() || text[pos] != c) {
+            fail(std::string("expected `") + c + "`");
+        }
+        ++pos;
+    }
+
+    bool consume_literal(std::string const& literal)
+    {
+        if (text.compare(pos, literal.size(), literal) == 0) {
+            pos += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    json_value parse_value()
+    {
+        skip_whitespace();
+        if (pos >= text.size()) {
+            fail("unexpected end of document");
+        }
+
+        json_value v;
+        char const c = text[pos];
+
+        if (c == '{') {
+            v.type = json_value::kind::object;
+            v.object_value = parse_object();
+        } else if (c == '[') {
+            v.type = json_value::kind::array;
+            v.array_value = parse_array();
+        } else if (c == '"') {
+            v.type = json_value::kind::string;
+            v.string_value = parse_string();
+        } else if (consume_literal("true")) {
+            v.type = json_value::kind::boolean;
+            v.boolean_value = true;
+        } else if (consume_literal("false")) {
+            v.type = json_value::kind::boolean;
+            v.boolean_value = false;
+        } else if (consume_literal("null")) {
+            v.type = json_value::kind::null;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            v.type = json_value::kind::number;
+            v.number_value = parse_number();
+        } else {
+            fail(std::string("unexpected character `") + c + "`");
+        }
+
+        return v;
+    }
+
+    std::vector<std::pair<std::string, json_value>> parse_object()
+    {
+        std::vector<std::pair<std::string, json_value>> members;
+        expect('{');
+        skip_whitespace();
+
+        if (pos < text.size() && text[pos] == '}') {
+            ++pos;
+            return members;
+        }
+
+        while (true) {
+            skip_whitespace();
+            if (pos >= text.size() || text[pos] != '"') {
+                fail("expected a string key");
+            }
+            std::string key = parse_string();
+            expect(':');
+            members.emplace_back(key, parse_value());
+
+            skip_whitespace();
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+            } else {
+                expect('}');
+                return members;
+            }
+        }
+    }
+
+    std::vector<json_value> parse_array()
+    {
+        std::vector<json_value> elements;
+        expect('[');
+        skip_whitespace();
+
+        if (pos < text.size() && text[pos] == ']') {
+            ++pos;
+            return elements;
+        }
+
+        while (true) {
+            elements.push_back(parse_value());
+
+            skip_whitespace();
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+            } else {
+                expect(']');
+                return elements;
+            }
+        }
+    }
+
+    unsigned parse_hex4()
+    {
+        if (pos + 4 > text.size()) {
+            fail("incomplete unicode escape");
+        }
+        unsigned code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char const h = text[pos++];
+            code <<= 4;
+            if (h >= '0' && h <= '9') {
+                code += h - '0';
+            } else if (h >= 'a' && h <= 'f') {
+                code += h - 'a' + 10;
+            } else if (h >= 'A' && h <= 'F') {
+                code += h - 'A' + 10;
+            } else {
+                fail("invalid unicode escape");
+            }
+        }
+        return code;
+    }
+
+    static void append_utf8(std::string& s, unsigned code)
+    {
+        if (code < 0x80) {
+            s += static_cast<char>(code);
+        } else if (code < 0x800) {
+            s += static_cast<char>(0xC0 | (code >> 6));
+            s += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            s += static_cast<char>(0xE0 | (code >> 12));
+            s += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            s += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            s += static_cast<char>(0xF0 | (code >> 18));
+            s += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            s += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            s += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    std::string parse_string()
+    {
+        expect('"');
+        std::string s;
+
+        while (true) {
+            if (pos >= text.size()) {
+                fail("unterminated string");
+            }
+
+            char const c = text[pos++];
+
+            if (c == '"') {
+                return s;
+            } else if (c != '\\') {
+                s += c;
+                continue;
+            }
+
+            if (pos >= text.size()) {
+                fail("unterminated string");
+            }
+
+            char const e = text[pos++];
+            switch (e) {
+                case '"': s += '"'; break;
+                case '\\': s += '\\'; break;
+                case '/': s += '/'; break;
+                case 'b': s += '\b'; break;
+                case 'f': s += '\f'; break;
+                case 'n': s += '\n'; break;
+                case 'r': s += '\r'; break;
+                case 't': s += '\t'; break;
+                case 'u': {
+                    unsigned code = parse_hex4();
+
+                    // Combine surrogate pairs into a single code point
+                    if (code >= 0xD800 && code < 0xDC00 &&
+                        consume_literal("\\u")) {
+                        unsigned const low = parse_hex4();
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+
+                    append_utf8(s, code);
+                    break;
+                }
+                default:
+                    fail(std::string("invalid escape sequence `\\") + e + "`");
+            }
+        }
+    }
+
+    double parse_number()
+    {
+        char const* start = text.c_str() + pos;
+        char* end;
+        double const x = std::strtod(start, &end);
+
+        if (end == start) {
+            fail("invalid number");
+        }
+
+        pos += end - start;
+        return x;
+    }
+};
+}  // namespace
+
+bool json_value::has(std::string const& key) const
+{
+    for (auto const& member : object_value) {
+        if (member.first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ *  @brief Returns the member of an object with the specified key, throwing an
+ *  exception if this value is not an object or does not have such a member.
+ */
+json_value const& json_value::at(std::string const& key) const
+{
+    if (type != kind::object) {
+        throw std::runtime_error(
+            "Cannot look up `" + key + "` in a JSON value that is not an object");
+    }
+
+    for (auto const& member : object_value) {
+        if (member.first == key) {
+            return member.second;
+        }
+    }
+
+    throw std::runtime_error("The JSON object has no member called `" + key + "`");
+}
+
+/**
+ *  @brief Returns the value of a number, treating `null` as NaN to match the
+ *  way R's `NA` values are exported. The `context` is used in error messages.
+ */
+double json_value::as_number(std::string const& context) const
+{
+    if (type == kind::null) {
+        return NAN;
+    }
+
+    if (type != kind::number) {
+        throw std::runtime_error("`" + context + "` must be a number");
+    }
+
+    return number_value;
+}
+
+std::string const& json_value::as_string(std::string const& context) const
+{
+    if (type != kind::string) {
+        throw std::runtime_error("`" + context + "` must be a string");
+    }
+
+    return string_value;
+}
+
+json_value parse_json(std::string const& text)
+{
+    return json_parser(text).parse_document();
+}
+
+json_value parse_json_file(std::string const& filename)
+{
+    std::ifstream in(filename);
+    if (!in) {
+        throw std::runtime_error("Could not open `" + filename + "`");
+    }
+
+    std::ostringstream contents;
+    contents << in.rdbuf();
+
+    try {
+        return parse_json(contents.str());
+    } catch (std::runtime_error const& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef CLI_JSON_H
+#define CLI_JSON_H
+
+#include <string>
+#include <utility>  // for std::pair
+#include <vector>
+
+/**
+ *  @class json_value
+ *
+ *  @brief A parsed JSON value.
+ *
+ *  This is a minimal representation that is only intended for reading the
+ *  model definition files used by the command-line runner; it supports the
+ *  full JSON grammar, but does not attempt to be fast or to preserve number
+ *  formatting. The members of an object are stored in the order they appear
+ *  in the file.
+ */
+class json_value
+{
+   public:
+    enum class kind { null, boolean, number, string, array, object };
+
+    kind type = kind::null;
+    bool boolean_value = false;
+    double number_value = 0.0;
+    std::string string_value;
+    std::vector<json_value> array_value;
+    std::vector<std::pair<std::string, json_value>> object_value;
+
+    bool is_null() const { return type == kind::null; }
+
+    bool has(std::string const& key) const;
+
+    json_value const& at(std::string const& key) const;
+
+    double as_number(std::string const& context) const;
+
+    std::string const& as_string(std::string const& context) const;
+};
+
+json_value parse_json(std::string const& text);
+
+json_value parse_json_file(std::string const& filename);
+
+#endif
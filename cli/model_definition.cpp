@@ -0,0 +1,113 @@
+#include <cmath>      // for std::isnan
+#include <stdexcept>  // for std::runtime_error
+#include "model_definition.h"
+
+namespace
+{
+state_map state_map_from_json(json_value const& object, std::string const& name)
+{
+    if (object.type != json_value::kind::object) {
+        throw std::runtime_error("`" + name + "` must be an object");
+    }
+
+    state_map result;
+    for (auto const& member : object.object_value) {
+        if (result.count(member.first) > 0) {
+            throw std::runtime_error(
+                "`" + name + "` contains more than one `" + member.first + "`");
+        }
+        result[member.first] =
+            member.second.as_number(name + "$" + member.first);
+    }
+    return result;
+}
+
+string_vector module_names_from_json(json_value const& modules, std::string const& name)
+{
+    string_vector result;
+
+    if (modules.type == json_value::kind::array) {
+        for (json_value const& m : modules.array_value) {
+            result.push_back(m.as_string(name));
+        }
+    } else if (modules.type == json_value::kind::object) {
+        for (auto const& member : modules.object_value) {
+            result.push_back(member.second.as_string(name + "$" + member.first));
+        }
+    } else {
+        throw std::runtime_error("`" + name + "` must be an array or an object");
+    }
+
+    return result;
+}
+}  // namespace
+
+/**
+ *  @brief Converts a parsed JSON document into a `model_definition`; see the
+ *  description of that class for the required structure.
+ */
+model_definition model_definition_from_json(json_value const& definition)
+{
+    model_definition md;
+
+    md.initial_values =
+        state_map_from_json(definition.at("initial_values"), "initial_values");
+
+    md.parameters =
+        state_map_from_json(definition.at("parameters"), "parameters");
+
+    md.direct_module_names =
+        module_names_from_json(definition.at("direct_modules"), "direct_modules");
+
+    md.differential_module_names =
+        module_names_from_json(definition.at("differential_modules"), "differential_modules");
+
+    json_value const& solver = definition.at("ode_solver");
+
+    md.ode_solver_type = solver.at("type").as_string("ode_solver$type");
+
+    md.output_step_size =
+        solver.at("output_step_size").as_number("ode_solver$output_step_size");
+
+    md.adaptive_rel_error_tol =
+        solver.at("adaptive_rel_error_tol").as_number("ode_solver$adaptive_rel_error_tol");
+
+    md.adaptive_abs_error_tol =
+        solver.at("adaptive_abs_error_tol").as_number("ode_solver$adaptive_abs_error_tol");
+
+    // The maximum number of steps is only used by adaptive solvers, so a
+    // missing value can safely be replaced by zero
+    double const max_steps =
+        solver.at("adaptive_max_steps").as_number("ode_solver$adaptive_max_steps");
+
+    md.adaptive_max_steps = std::isnan(max_steps) ? 0 : static_cast<int>(max_steps);
+
+    return md;
+}
+
+/**
+ *  @brief Extracts the local module name from a fully-qualified module name
+ *  such as `"BioCro:thermal_time_linear"`.
+ *
+ *  The command-line runner is linked against the standard module library
+ *  only, so an exception is thrown if the name refers to any other library.
+ *  Names without a library prefix are returned unchanged.
+ */
+std::string local_module_name(std::string const& module_name)
+{
+    size_t const colon = module_name.find(':');
+
+    if (colon == std::string::npos) {
+        return module_name;
+    }
+
+    std::string const library_name = module_name.substr(0, colon);
+
+    if (library_name != "BioCro") {
+        throw std::runtime_error(
+            "`" + module_name + "` is not from the BioCro module library; the " +
+            "command-line runner only supports the BioCro module library");
+    }
+
+    return module_name.substr(colon + 1);
+}
@@ -0,0 +1,46 @@
+#ifndef CLI_MODEL_DEFINITION_H
+#define CLI_MODEL_DEFINITION_H
+
+#include <string>
+#include "../src/framework/state_map.h"  // for state_map, string_vector
+#include "json.h"                        // for json_value
+
+/**
+ *  @class model_definition
+ *
+ *  @brief The inputs to a BioCro simulation, other than the drivers, as read
+ *  from a JSON file.
+ *
+ *  The file must contain a single object with the same structure as the crop
+ *  model definitions in the R package (e.g. `soybean`):
+ *
+ *  - `initial_values` and `parameters`: objects whose members are numbers
+ *
+ *  - `direct_modules` and `differential_modules`: arrays of fully-qualified
+ *    module names such as `"BioCro:thermal_time_linear"`, or objects whose
+ *    members are such names (in which case the member names are ignored)
+ *
+ *  - `ode_solver`: an object with a string `type` member and numeric
+ *    `output_step_size`, `adaptive_rel_error_tol`, `adaptive_abs_error_tol`,
+ *    and `adaptive_max_steps` members
+ *
+ *  Numbers may be `null`, which is interpreted as NaN; this corresponds to the
+ *  `NA` values used in R. Other members of the object are ignored.
+ */
+struct model_definition {
+    state_map initial_values;
+    state_map parameters;
+    string_vector direct_module_names;
+    string_vector differential_module_names;
+    std::string ode_solver_type;
+    double output_step_size;
+    double adaptive_rel_error_tol;
+    double adaptive_abs_error_tol;
+    int adaptive_max_steps;
+};
+
+model_definition model_definition_from_json(json_value const& definition);
+
+std::string local_module_name(std::string const& module_name);
+
+#endif
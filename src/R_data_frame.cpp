@@ -0,0 +1,215 @@
+#include <algorithm>            // for std::copy
+#include <string>
+#include <vector>
+#include "simulation_output.h"  // for add_doy_and_hour
+#include "R_data_frame.h"
+
+namespace
+{
+/**
+ *  @brief Turns an R list of columns into a data frame by setting its names,
+ *  row names, and class
+ *
+ *  The row names use R's compact representation of automatic row names,
+ *  `c(NA, -nrow)`.
+ *
+ *  @param [in, out] columns An R list whose elements are the columns, each
+ *                   with `nrow` elements; it must already be protected
+ *
+ *  @param [in] column_names The names of the columns, in the same order
+ *
+ *  @param [in] nrow The number of rows
+ *
+ *  @return `columns`, which is now a data frame
+ */
+SEXP make_data_frame(
+    SEXP columns,
+    string_vector const& column_names,
+    size_t nrow)
+{
+    SEXP names = PROTECT(Rf_allocVector(STRSXP, column_names.size()));
+    for (size_t j = 0; j < column_names.size(); ++j) {
+        SET_STRING_ELT(names, j, Rf_mkChar(column_names[j].c_str()));
+    }
+    Rf_setAttrib(columns, R_NamesSymbol, names);
+
+    SEXP row_names = PROTECT(Rf_allocVector(INTSXP, 2));
+    INTEGER(row_names)[0] = NA_INTEGER;
+    INTEGER(row_names)[1] = -static_cast<int>(nrow);
+    Rf_setAttrib(columns, R_RowNamesSymbol, row_names);
+
+    Rf_setAttrib(columns, R_ClassSymbol, Rf_mkString("data.frame"));
+
+    UNPROTECT(2);  // UNPROTECT names and row_names
+    return columns;
+}
+}  // namespace
+
+/**
+ *  @brief Converts a simulation result into an R data frame
+ *
+ *  Each column is copied into a newly allocated R vector, and its storage in
+ *  `result` is released immediately afterwards. This means that at most one
+ *  column is ever duplicated, rather than the entire result.
+ *
+ *  If the result includes a `time` column, `doy` and `hour` columns are
+ *  calculated from it using `add_doy_and_hour()`.
+ *
+ *  The columns are not sorted, since R and C++ may use different collation
+ *  orders; sorting the columns of the returned data frame in R does not copy
+ *  their contents.
+ *
+ *  @param [in, out] result The simulation result; it will be empty afterwards
+ *
+ *  @return An R data frame
+ */
+SEXP data_frame_from_result(state_vector_map& result)
+{
+    add_doy_and_hour(result);
+
+    size_t const ncol = result.size();
+    size_t const nrow = ncol > 0 ? result.begin()->second.size() : 0;
+
+    SEXP df = PROTECT(Rf_allocVector(VECSXP, ncol));
+    string_vector column_names;
+    column_names.reserve(ncol);
+
+    size_t j = 0;
+    for (auto& x : result) {
+        SEXP column = SET_VECTOR_ELT(df, j, Rf_allocVector(REALSXP, nrow));
+        std::copy(x.second.begin(), x.second.end(), REAL(column));
+        column_names.push_back(x.first);
+
+        // Release the C++ copy of this column right away
+        std::vector<double>().swap(x.second);
+        ++j;
+    }
+
+    result.clear();
+
+    make_data_frame(df, column_names, nrow);
+
+    UNPROTECT(1);  // UNPROTECT df
+    return df;
+}
+
+/**
+ *  @brief Converts a module profile into an R data frame
+ *
+ *  The data frame has one row for each entry in the profile, sorted by name,
+ *  and the following columns:
+ *
+ *  - `name`: the name of the module or helping function
+ *
+ *  - `calls`: the number of times it was run
+ *
+ *  - `seconds`: the cumulative wall-clock time spent running it, including
+ *    any time spent in nested entries
+ *
+ *  - `iterations`: the cumulative number of iterations used by its solver,
+ *    or zero if it does not use an iterative solver
+ *
+ *  @param [in] profile The profile to convert
+ *
+ *  @return An R data frame
+ */
+SEXP data_frame_from_profile(standardBML::profile_map const& profile)
+{
+    size_t const nrow = profile.size();
+
+    SEXP df = PROTECT(Rf_allocVector(VECSXP, 4));
+    SEXP name = SET_VECTOR_ELT(df, 0, Rf_allocVector(STRSXP, nrow));
+    SEXP calls = SET_VECTOR_ELT(df, 1, Rf_allocVector(REALSXP, nrow));
+    SEXP seconds = SET_VECTOR_ELT(df, 2, Rf_allocVector(REALSXP, nrow));
+    SEXP iterations = SET_VECTOR_ELT(df, 3, Rf_allocVector(REALSXP, nrow));
+
+    size_t i = 0;
+    for (auto const& x : profile) {
+        SET_STRING_ELT(name, i, Rf_mkChar(x.first.c_str()));
+        REAL(calls)[i] = static_cast<double>(x.second.calls);
+        REAL(seconds)[i] = x.second.seconds;
+        REAL(iterations)[i] = static_cast<double>(x.second.iterations);
+        ++i;
+    }
+
+    make_data_frame(df, {"name", "calls", "seconds", "iterations"}, nrow);
+
+    UNPROTECT(1);  // UNPROTECT df
+    return df;
+}
+
+/**
+ *  @brief Converts a list of event occurrences into an R data frame
+ *
+ *  The data frame has one row for each occurrence, in the order they
+ *  occurred, and the following columns:
+ *
+ *  - `name`: the name of the event
+ *
+ *  - `time`: the value of `time` when the event occurred
+ *
+ *  @param [in] occurrences The event occurrences to convert
+ *
+ *  @return An R data frame
+ */
+SEXP data_frame_from_events(std::vector<event_occurrence> const& occurrences)
+{
+    size_t const nrow = occurrences.size();
+
+    SEXP df = PROTECT(Rf_allocVector(VECSXP, 2));
+    SEXP name = SET_VECTOR_ELT(df, 0, Rf_allocVector(STRSXP, nrow));
+    SEXP time = SET_VECTOR_ELT(df, 1, Rf_allocVector(REALSXP, nrow));
+
+    for (size_t i = 0; i < nrow; ++i) {
+        SET_STRING_ELT(name, i, Rf_mkChar(occurrences[i].name.c_str()));
+        REAL(time)[i] = occurrences[i].time;
+    }
+
+    make_data_frame(df, {"name", "time"}, nrow);
+
+    UNPROTECT(1);  // UNPROTECT df
+    return df;
+}
+
+/**
+ *  @brief Converts a list of derivative checks into an R data frame
+ *
+ *  The data frame has one row for each check, in order, and one column for
+ *  each member of `derivative_check`, with the same names.
+ *
+ *  @param [in] checks The derivative checks to convert
+ *
+ *  @return An R data frame
+ */
+SEXP data_frame_from_derivative_checks(std::vector<derivative_check> const& checks)
+{
+    size_t const nrow = checks.size();
+
+    SEXP df = PROTECT(Rf_allocVector(VECSXP, 7));
+    SEXP kernel = SET_VECTOR_ELT(df, 0, Rf_allocVector(STRSXP, nrow));
+    SEXP output = SET_VECTOR_ELT(df, 1, Rf_allocVector(STRSXP, nrow));
+    SEXP input = SET_VECTOR_ELT(df, 2, Rf_allocVector(STRSXP, nrow));
+    SEXP dual = SET_VECTOR_ELT(df, 3, Rf_allocVector(REALSXP, nrow));
+    SEXP finite_difference = SET_VECTOR_ELT(df, 4, Rf_allocVector(REALSXP, nrow));
+    SEXP relative_error = SET_VECTOR_ELT(df, 5, Rf_allocVector(REALSXP, nrow));
+    SEXP tolerance = SET_VECTOR_ELT(df, 6, Rf_allocVector(REALSXP, nrow));
+
+    for (size_t i = 0; i < nrow; ++i) {
+        SET_STRING_ELT(kernel, i, Rf_mkChar(checks[i].kernel.c_str()));
+        SET_STRING_ELT(output, i, Rf_mkChar(checks[i].output.c_str()));
+        SET_STRING_ELT(input, i, Rf_mkChar(checks[i].input.c_str()));
+        REAL(dual)[i] = checks[i].dual;
+        REAL(finite_difference)[i] = checks[i].finite_difference;
+        REAL(relative_error)[i] = checks[i].relative_error;
+        REAL(tolerance)[i] = checks[i].tolerance;
+    }
+
+    make_data_frame(
+        df,
+        {"kernel", "output", "input", "dual", "finite_difference",
+         "relative_error", "tolerance"},
+        nrow);
+
+    UNPROTECT(1);  // UNPROTECT df
+    return df;
+}
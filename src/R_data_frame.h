@@ -0,0 +1,19 @@
+#ifndef R_DATA_FRAME_H
+#define R_DATA_FRAME_H
+
+#include <vector>
+#include <Rinternals.h>                      // for SEXP
+#include "framework/state_map.h"             // for state_vector_map, string_vector
+#include "kernel_derivatives.h"              // for derivative_check
+#include "module_library/module_profiler.h"  // for profile_map
+#include "simulation_events.h"               // for event_occurrence
+
+SEXP data_frame_from_result(state_vector_map& result);
+
+SEXP data_frame_from_profile(standardBML::profile_map const& profile);
+
+SEXP data_frame_from_events(std::vector<event_occurrence> const& occurrences);
+
+SEXP data_frame_from_derivative_checks(std::vector<derivative_check> const& checks);
+
+#endif
@@ -0,0 +1,29 @@
+#include <string>
+#include <exception>              // for std::exception
+#include <Rinternals.h>           // for Rf_error
+#include "kernel_derivatives.h"   // for check_kernel_derivatives
+#include "R_data_frame.h"         // for data_frame_from_derivative_checks
+#include "R_kernel_derivatives.h"
+
+using std::string;
+
+extern "C" {
+/**
+ *  @brief Compares the derivatives of the photosynthesis and growth kernels
+ *  calculated with dual numbers to finite differences; see
+ *  `check_kernel_derivatives()`.
+ *
+ *  @return An R data frame describing the comparisons; see
+ *          `data_frame_from_derivative_checks()` for details.
+ */
+SEXP R_check_kernel_derivatives()
+{
+    try {
+        return data_frame_from_derivative_checks(check_kernel_derivatives());
+    } catch (std::exception const& e) {
+        Rf_error("%s", (string("Caught exception in R_check_kernel_derivatives: ") + e.what()).c_str());
+    } catch (...) {
+        Rf_error("Caught unhandled exception in R_check_kernel_derivatives.");
+    }
+}
+}
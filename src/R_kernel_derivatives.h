@@ -0,0 +1,8 @@
+#ifndef R_KERNEL_DERIVATIVES_H
+#define R_KERNEL_DERIVATIVES_H
+
+#include <Rinternals.h>  // for SEXP
+
+extern "C" SEXP R_check_kernel_derivatives();
+
+#endif
@@ -1,16 +1,112 @@
 #include <string>
+#include <vector>
+#include <memory>                          // for std::unique_ptr
+#include <algorithm>                       // for std::copy
 #include <exception>                       // for std::exception
+#include <stdexcept>                       // for std::runtime_error
 #include <Rinternals.h>                    // for Rf_error and Rprintf
-#include "framework/R_helper_functions.h"  // for map_from_list, map_vector_from_list, mc_vector_from_list, list_from_map
+#include "framework/R_helper_functions.h"  // for map_from_list, map_vector_from_list, mc_vector_from_list, make_vector
+#include "R_data_frame.h"                  // for data_frame_from_result, data_frame_from_profile, data_frame_from_events
 #include "framework/state_map.h"           // for state_map, state_vector_map, string_vector
 #include "framework/module_creator.h"      // for mc_vector
-#include "framework/biocro_simulation.h"
+#include "simulation_batch.h"               // for run_simulation_batch
+#include "simulation_output.h"              // for select_quantity_names
+#include "result_sink.h"                    // for result_sink, csv_sink, binary_sink, chunked_result_writer
+#include "module_profiling.h"               // for profile_modules, profile_report
+#include "direct_module_hoisting.h"         // for hoist_direct_modules, add_constant_outputs, hoisting_report
+#include "module_fusion.h"                  // for fuse_direct_modules
+#include "sensitivity_simulation.h"         // for sensitivity_simulation
+#include "simulation_dispatch.h"            // for dispatching_simulation
+#include "simulation_events.h"              // for simulation_event
 #include "R_run_biocro.h"
 
 using std::string;
 
+namespace
+{
+/**
+ *  @brief Converts an R list with `name`, `quantity`, `threshold`,
+ *  `direction`, and `terminal` elements, each of which is a vector with one
+ *  element per event, into a vector of events.
+ */
+std::vector<simulation_event> events_from_list(SEXP events)
+{
+    SEXP names = Rf_getAttrib(events, R_NamesSymbol);
+    auto element = [&](string const& name) -> SEXP {
+        for (R_xlen_t i = 0; i < Rf_xlength(events); ++i) {
+            if (name == CHAR(STRING_ELT(names, i))) {
+                return VECTOR_ELT(events, i);
+            }
+        }
+        throw std::runtime_error("The events do not include `" + name + "`");
+    };
+
+    SEXP event_name = element("name");
+    SEXP quantity = element("quantity");
+    SEXP threshold = element("threshold");
+    SEXP direction = element("direction");
+    SEXP terminal = element("terminal");
+
+    std::vector<simulation_event> result;
+    for (R_xlen_t i = 0; i < Rf_xlength(quantity); ++i) {
+        result.push_back({
+            CHAR(STRING_ELT(event_name, i)),
+            CHAR(STRING_ELT(quantity, i)),
+            REAL(threshold)[i],
+            static_cast<int>(REAL(direction)[i]),
+            LOGICAL(terminal)[i] != 0});
+    }
+
+    return result;
+}
+}  // namespace
+
 extern "C" {
 
+/**
+ *  @brief Runs a BioCro simulation and returns the result as an R list
+ *
+ *  @param [in] output_quantities An R vector of strings specifying regular
+ *              expressions used to select the quantities that are returned;
+ *              see `select_quantity_names()` for details. If empty, all
+ *              quantities are returned. With the `homemade_lsoda` and
+ *              `homemade_dopri5` solvers, only the selected quantities are
+ *              stored during the simulation; see
+ *              `dispatching_simulation::set_output_selection()`.
+ *
+ *  @param [in] output_decimation An R numeric vector with one element
+ *              specifying that only every N-th time point should be returned
+ *
+ *  @param [in] profile An R logical vector with one element indicating
+ *              whether the run time of each module should be measured. If
+ *              so, the measurements are attached to the returned data frame
+ *              as a `profile` attribute; see `data_frame_from_profile()` for
+ *              details.
+ *
+ *  @param [in] hoist_modules An R logical vector with one element
+ *              indicating whether direct modules that do not depend on the
+ *              differential quantities should be run before the simulation
+ *              rather than during it; see `hoist_direct_modules()` for
+ *              details.
+ *
+ *  @param [in] n_threads An R numeric vector with one element specifying the
+ *              number of threads used to run the driver-only modules when
+ *              `hoist_modules` is true
+ *
+ *  @param [in] events An R list describing events that occur when
+ *              differential quantities cross thresholds; see
+ *              `events_from_list()` and `simulation_event`. If it describes
+ *              any events, the ones that occurred are attached to the
+ *              returned data frame as an `events` attribute; see
+ *              `data_frame_from_events()` for details.
+ *
+ *  @param [in] fuse_modules An R logical vector with one element indicating
+ *              whether the direct modules should be replaced by a fused
+ *              module from the module library when they match one; see
+ *              `fuse_direct_modules()` for details.
+ *
+ *  @return An R data frame representing the selected quantities
+ */
 SEXP R_run_biocro(
     SEXP initial_values,
     SEXP parameters,
@@ -22,7 +118,14 @@ SEXP R_run_biocro(
     SEXP solver_adaptive_rel_error_tol,
     SEXP solver_adaptive_abs_error_tol,
     SEXP solver_adaptive_max_steps,
-    SEXP verbose)
+    SEXP verbose,
+    SEXP output_quantities,
+    SEXP output_decimation,
+    SEXP profile,
+    SEXP hoist_modules,
+    SEXP n_threads,
+    SEXP events,
+    SEXP fuse_modules)
 {
     try {
         state_map iv = map_from_list(initial_values);
@@ -42,18 +145,99 @@ SEXP R_run_biocro(
         double adaptive_rel_error_tol = REAL(solver_adaptive_rel_error_tol)[0];
         double adaptive_abs_error_tol = REAL(solver_adaptive_abs_error_tol)[0];
         int adaptive_max_steps = (int)REAL(solver_adaptive_max_steps)[0];
+        string_vector output_patterns = make_vector(output_quantities);
+        size_t decimation = (size_t)REAL(output_decimation)[0];
+        bool should_profile = LOGICAL(profile)[0];
+        bool should_hoist = LOGICAL(hoist_modules)[0];
+        size_t nthreads = (size_t)REAL(n_threads)[0];
+        std::vector<simulation_event> sim_events = events_from_list(events);
+        bool should_fuse = LOGICAL(fuse_modules)[0];
+
+        // When profiling, each module creator is replaced by one that
+        // produces timed modules; the replacements are owned by `profiled_mcs`
+        std::vector<std::unique_ptr<module_creator>> profiled_mcs;
+        if (should_profile) {
+            direct_mcs = profile_modules(direct_mcs, profiled_mcs);
+            differential_mcs = profile_modules(differential_mcs, profiled_mcs);
+        }
+
+        standardBML::profile_map module_profile;
+        std::unique_ptr<standardBML::profile_scope> scope;
+        if (should_profile) {
+            scope.reset(new standardBML::profile_scope(module_profile));
+        }
+
+        hoisting_summary hoisted;
+        if (should_hoist) {
+            hoisted = hoist_direct_modules(iv, p, d, direct_mcs, nthreads);
+        }
+
+        // If requested, and the remaining direct modules match one of the
+        // fused modules in the module library, they are replaced by it; the
+        // replacement is owned by `fused_mcs`. Profiled modules are never
+        // fused, so each one still appears separately in the profile.
+        std::vector<std::unique_ptr<module_creator>> fused_mcs;
+        if (should_fuse) {
+            direct_mcs = fuse_direct_modules(direct_mcs, fused_mcs);
+        }
+
+        dispatching_simulation gro(iv, p, d,
+                                   direct_mcs, differential_mcs,
+                                   solver_type_string, output_step_size,
+                                   adaptive_rel_error_tol, adaptive_abs_error_tol,
+                                   adaptive_max_steps);
+
+        gro.set_events(sim_events);
+
+        // The constant outputs of hoisted modules are added to the result
+        // afterwards, so patterns that only match them are not unused
+        string_vector const constant_names = keys(hoisted.constant_outputs);
+        gro.set_output_selection(output_patterns, decimation, constant_names);
+
+        // The simulation has its own copy of the drivers
+        state_vector_map().swap(d);
 
-        biocro_simulation gro(iv, p, d, direct_mcs, differential_mcs,
-                              solver_type_string, output_step_size,
-                              adaptive_rel_error_tol, adaptive_abs_error_tol,
-                              adaptive_max_steps);
         state_vector_map result = gro.run_simulation();
 
+        scope.reset();
+
         if (loquacious) {
             Rprintf("%s", gro.generate_report().c_str());
+
+            if (should_hoist) {
+                Rprintf("%s", hoisting_report(hoisted).c_str());
+            }
+
+            if (should_profile) {
+                Rprintf("%s", profile_report(module_profile).c_str());
+            }
+        }
+
+        state_map selected_constants;
+        for (std::string const& name : select_quantity_names(
+                 constant_names, output_patterns, keys(result))) {
+            selected_constants[name] = hoisted.constant_outputs.at(name);
+        }
+
+        add_constant_outputs(result, selected_constants);
+
+        SEXP df = PROTECT(data_frame_from_result(result));
+
+        if (should_profile) {
+            SEXP profile_df = PROTECT(data_frame_from_profile(module_profile));
+            Rf_setAttrib(df, Rf_install("profile"), profile_df);
+            UNPROTECT(1);  // UNPROTECT profile_df
         }
 
-        return list_from_map(result);
+        if (!sim_events.empty()) {
+            SEXP events_df =
+                PROTECT(data_frame_from_events(gro.get_event_occurrences()));
+            Rf_setAttrib(df, Rf_install("events"), events_df);
+            UNPROTECT(1);  // UNPROTECT events_df
+        }
+
+        UNPROTECT(1);  // UNPROTECT df
+        return df;
     } catch (std::exception const& e) {
         Rf_error("%s", string(string("Caught exception in R_run_biocro: ") + e.what()).c_str());
     } catch (...) {
@@ -61,4 +245,296 @@ SEXP R_run_biocro(
     }
 }
 
+/**
+ *  @brief Runs a BioCro simulation and writes the result to a file rather
+ *  than returning it to R
+ *
+ *  @param [in] filename An R string specifying the path to the output file
+ *
+ *  @param [in] format An R string specifying the file format; must be
+ *              `"binary"` or `"csv"`. See `binary_sink` and `csv_sink` for
+ *              details.
+ *
+ *  @param [in] chunk_size An R numeric vector with one element specifying the
+ *              number of rows written to the file at a time
+ *
+ *  The other arguments are identical to those of `R_run_biocro()`.
+ *
+ *  @return The R null pointer
+ */
+SEXP R_run_biocro_to_file(
+    SEXP initial_values,
+    SEXP parameters,
+    SEXP drivers,
+    SEXP direct_mc_vec,
+    SEXP differential_mc_vec,
+    SEXP solver_type,
+    SEXP solver_output_step_size,
+    SEXP solver_adaptive_rel_error_tol,
+    SEXP solver_adaptive_abs_error_tol,
+    SEXP solver_adaptive_max_steps,
+    SEXP verbose,
+    SEXP output_quantities,
+    SEXP output_decimation,
+    SEXP filename,
+    SEXP format,
+    SEXP chunk_size)
+{
+    try {
+        state_map iv = map_from_list(initial_values);
+        state_map p = map_from_list(parameters);
+        state_vector_map d = map_vector_from_list(drivers);
+
+        if (d.begin()->second.size() == 0) {
+            return R_NilValue;
+        }
+
+        mc_vector direct_mcs = mc_vector_from_list(direct_mc_vec);
+        mc_vector differential_mcs = mc_vector_from_list(differential_mc_vec);
+
+        bool loquacious = LOGICAL(VECTOR_ELT(verbose, 0))[0];
+        string solver_type_string = CHAR(STRING_ELT(solver_type, 0));
+        double output_step_size = REAL(solver_output_step_size)[0];
+        double adaptive_rel_error_tol = REAL(solver_adaptive_rel_error_tol)[0];
+        double adaptive_abs_error_tol = REAL(solver_adaptive_abs_error_tol)[0];
+        int adaptive_max_steps = (int)REAL(solver_adaptive_max_steps)[0];
+        string_vector output_patterns = make_vector(output_quantities);
+        size_t decimation = (size_t)REAL(output_decimation)[0];
+        string filename_string = CHAR(STRING_ELT(filename, 0));
+        string format_string = CHAR(STRING_ELT(format, 0));
+        size_t rows_per_chunk = (size_t)REAL(chunk_size)[0];
+
+        // Open the file before running the simulation so any problems with
+        // it are reported right away
+        std::unique_ptr<result_sink> sink;
+        if (format_string == "binary") {
+            sink.reset(new binary_sink(filename_string));
+        } else if (format_string == "csv") {
+            sink.reset(new csv_sink(filename_string));
+        } else {
+            throw std::runtime_error(
+                "`" + format_string + "` is not a valid output file format");
+        }
+
+        dispatching_simulation gro(iv, p, d,
+                                   direct_mcs, differential_mcs,
+                                   solver_type_string, output_step_size,
+                                   adaptive_rel_error_tol, adaptive_abs_error_tol,
+                                   adaptive_max_steps);
+
+        // The simulation has its own copy of the drivers
+        state_vector_map().swap(d);
+
+        // Rows are written to the file in chunks as the simulation produces
+        // them, when the ODE solver allows it. As with `run_biocro`, the `doy`
+        // and `hour` columns are calculated from `time`.
+        chunked_result_writer writer(
+            *sink, output_patterns, decimation, rows_per_chunk, true);
+
+        gro.run_simulation(writer);
+
+        if (loquacious) {
+            Rprintf("%s", gro.generate_report().c_str());
+        }
+
+        return R_NilValue;
+    } catch (std::exception const& e) {
+        Rf_error("%s", string(string("Caught exception in R_run_biocro_to_file: ") + e.what()).c_str());
+    } catch (...) {
+        Rf_error("Caught unhandled exception in R_run_biocro_to_file.");
+    }
+}
+
+/**
+ *  @brief Runs a batch of simulations that differ only in the values of some
+ *  initial values or parameters, using multiple threads
+ *
+ *  @param [in] override_controls An R vector of strings indicating the
+ *              location of each overridden quantity; each element must be
+ *              `"initial_values"` or `"parameters"`
+ *
+ *  @param [in] override_names An R vector of strings specifying the names of
+ *              the overridden quantities
+ *
+ *  @param [in] override_values An R numeric matrix where each row contains the
+ *              values of the overridden quantities for one run, and each
+ *              column corresponds to one element of `override_names`
+ *
+ *  @param [in] n_threads An R numeric vector with one element specifying the
+ *              number of threads to use
+ *
+ *  The other arguments are identical to those of `R_run_biocro()`. The output
+ *  quantities and decimation are applied to each run as soon as it finishes,
+ *  so the unselected quantities of different runs are never stored together.
+ *
+ *  @return An R data frame representing the stacked results of all runs,
+ *          including a `run_id` column that identifies the run that produced
+ *          each row
+ */
+SEXP R_run_biocro_batch(
+    SEXP initial_values,
+    SEXP parameters,
+    SEXP drivers,
+    SEXP direct_mc_vec,
+    SEXP differential_mc_vec,
+    SEXP solver_type,
+    SEXP solver_output_step_size,
+    SEXP solver_adaptive_rel_error_tol,
+    SEXP solver_adaptive_abs_error_tol,
+    SEXP solver_adaptive_max_steps,
+    SEXP override_controls,
+    SEXP override_names,
+    SEXP override_values,
+    SEXP n_threads,
+    SEXP output_quantities,
+    SEXP output_decimation)
+{
+    try {
+        state_map iv = map_from_list(initial_values);
+        state_map p = map_from_list(parameters);
+        state_vector_map d = map_vector_from_list(drivers);
+
+        if (d.begin()->second.size() == 0) {
+            return R_NilValue;
+        }
+
+        mc_vector direct_mcs = mc_vector_from_list(direct_mc_vec);
+        mc_vector differential_mcs = mc_vector_from_list(differential_mc_vec);
+
+        string solver_type_string = CHAR(STRING_ELT(solver_type, 0));
+        double output_step_size = REAL(solver_output_step_size)[0];
+        double adaptive_rel_error_tol = REAL(solver_adaptive_rel_error_tol)[0];
+        double adaptive_abs_error_tol = REAL(solver_adaptive_abs_error_tol)[0];
+        int adaptive_max_steps = (int)REAL(solver_adaptive_max_steps)[0];
+
+        string_vector controls = make_vector(override_controls);
+        string_vector names = make_vector(override_names);
+
+        // Split the matrix (stored in column-major order) into rows
+        size_t const ncol = names.size();
+        size_t const nruns = ncol > 0 ? XLENGTH(override_values) / ncol : 0;
+        double const* values = REAL(override_values);
+
+        std::vector<std::vector<double>> run_values(nruns, std::vector<double>(ncol));
+        for (size_t i = 0; i < nruns; ++i) {
+            for (size_t j = 0; j < ncol; ++j) {
+                run_values[i][j] = values[i + j * nruns];
+            }
+        }
+
+        size_t nthreads = (size_t)REAL(n_threads)[0];
+        string_vector output_patterns = make_vector(output_quantities);
+        size_t decimation = (size_t)REAL(output_decimation)[0];
+
+        state_vector_map result = run_simulation_batch(
+            iv, p, d, direct_mcs, differential_mcs, solver_type_string,
+            output_step_size, adaptive_rel_error_tol, adaptive_abs_error_tol,
+            adaptive_max_steps, controls, names, run_values, nthreads,
+            output_patterns, decimation);
+
+        return data_frame_from_result(result);
+    } catch (std::exception const& e) {
+        Rf_error("%s", string(string("Caught exception in R_run_biocro_batch: ") + e.what()).c_str());
+    } catch (...) {
+        Rf_error("Caught unhandled exception in R_run_biocro_batch.");
+    }
+}
+
+/**
+ *  @brief Runs a simulation while integrating the forward sensitivities of
+ *  the differential quantities with respect to some initial values or
+ *  parameters; see `sensitivity_simulation` for details
+ *
+ *  @param [in] initial_values An R list of named elements representing the
+ *              initial values of the differential quantities. The order of the
+ *              elements determines the order of the quantities in the output.
+ *
+ *  @param [in] arg_names An R vector of strings specifying the initial values
+ *              and parameters for which sensitivities are calculated
+ *
+ *  The other arguments are identical to those of `R_run_biocro()`.
+ *
+ *  @return An R list with two elements: `values`, a numeric matrix of the
+ *          differential quantities at each time, and `sensitivities`, a
+ *          numeric array whose element `[t, i, j]` is the derivative of
+ *          quantity `i` at time `t` with respect to argument `j`
+ */
+SEXP R_run_biocro_sensitivity(
+    SEXP initial_values,
+    SEXP parameters,
+    SEXP drivers,
+    SEXP direct_mc_vec,
+    SEXP differential_mc_vec,
+    SEXP solver_type,
+    SEXP arg_names)
+{
+    try {
+        state_map iv = map_from_list(initial_values);
+        string_vector iv_order =
+            make_vector(Rf_getAttrib(initial_values, R_NamesSymbol));
+        state_map p = map_from_list(parameters);
+        state_vector_map d = map_vector_from_list(drivers);
+
+        if (d.begin()->second.size() == 0) {
+            return R_NilValue;
+        }
+
+        mc_vector direct_mcs = mc_vector_from_list(direct_mc_vec);
+        mc_vector differential_mcs = mc_vector_from_list(differential_mc_vec);
+
+        string solver_type_string = CHAR(STRING_ELT(solver_type, 0));
+        string_vector args = make_vector(arg_names);
+
+        sensitivity_simulation sim(
+            iv, iv_order, p, d, direct_mcs, differential_mcs,
+            solver_type_string, args);
+
+        std::vector<double> values, sensitivities;
+        sim.run(values, sensitivities);
+
+        size_t const ntimes = sim.get_ntimes();
+        size_t const n = sim.get_nquantities();
+        size_t const m = sim.get_nargs();
+
+        SEXP values_matrix = PROTECT(Rf_allocMatrix(REALSXP, ntimes, n));
+        std::copy(values.begin(), values.end(), REAL(values_matrix));
+
+        SEXP dims = PROTECT(Rf_allocVector(INTSXP, 3));
+        INTEGER(dims)[0] = ntimes;
+        INTEGER(dims)[1] = n;
+        INTEGER(dims)[2] = m;
+
+        SEXP sensitivity_array = PROTECT(Rf_allocArray(REALSXP, dims));
+        std::copy(sensitivities.begin(), sensitivities.end(), REAL(sensitivity_array));
+
+        SEXP quantity_names = PROTECT(r_string_vector_from_vector(sim.get_quantity_names()));
+        SEXP value_dimnames = PROTECT(Rf_allocVector(VECSXP, 2));
+        SET_VECTOR_ELT(value_dimnames, 1, quantity_names);
+        Rf_setAttrib(values_matrix, R_DimNamesSymbol, value_dimnames);
+
+        SEXP sensitivity_dimnames = PROTECT(Rf_allocVector(VECSXP, 3));
+        SET_VECTOR_ELT(sensitivity_dimnames, 1, quantity_names);
+        SET_VECTOR_ELT(sensitivity_dimnames, 2, arg_names);
+        Rf_setAttrib(sensitivity_array, R_DimNamesSymbol, sensitivity_dimnames);
+
+        SEXP result = PROTECT(Rf_allocVector(VECSXP, 2));
+        SET_VECTOR_ELT(result, 0, values_matrix);
+        SET_VECTOR_ELT(result, 1, sensitivity_array);
+
+        SEXP result_names = PROTECT(Rf_allocVector(STRSXP, 2));
+        SET_STRING_ELT(result_names, 0, Rf_mkChar("values"));
+        SET_STRING_ELT(result_names, 1, Rf_mkChar("sensitivities"));
+        Rf_setAttrib(result, R_NamesSymbol, result_names);
+
+        UNPROTECT(8);  // UNPROTECT values_matrix, dims, sensitivity_array,
+                       // quantity_names, value_dimnames, sensitivity_dimnames,
+                       // result, and result_names
+        return result;
+    } catch (std::exception const& e) {
+        Rf_error("%s", string(string("Caught exception in R_run_biocro_sensitivity: ") + e.what()).c_str());
+    } catch (...) {
+        Rf_error("Caught unhandled exception in R_run_biocro_sensitivity.");
+    }
+}
+
 }  // extern "C"
@@ -14,6 +14,58 @@ extern "C" SEXP R_run_biocro(
     SEXP solver_adaptive_rel_error_tol,
     SEXP solver_adaptive_abs_error_tol,
     SEXP solver_adaptive_max_steps,
-    SEXP verbose);
+    SEXP verbose,
+    SEXP output_quantities,
+    SEXP output_decimation,
+    SEXP profile,
+    SEXP hoist_modules,
+    SEXP n_threads,
+    SEXP events,
+    SEXP fuse_modules);
+
+extern "C" SEXP R_run_biocro_to_file(
+    SEXP initial_values,
+    SEXP parameters,
+    SEXP drivers,
+    SEXP direct_mc_vec,
+    SEXP differential_mc_vec,
+    SEXP solver_type,
+    SEXP solver_output_step_size,
+    SEXP solver_adaptive_rel_error_tol,
+    SEXP solver_adaptive_abs_error_tol,
+    SEXP solver_adaptive_max_steps,
+    SEXP verbose,
+    SEXP output_quantities,
+    SEXP output_decimation,
+    SEXP filename,
+    SEXP format,
+    SEXP chunk_size);
+
+extern "C" SEXP R_run_biocro_batch(
+    SEXP initial_values,
+    SEXP parameters,
+    SEXP drivers,
+    SEXP direct_mc_vec,
+    SEXP differential_mc_vec,
+    SEXP solver_type,
+    SEXP solver_output_step_size,
+    SEXP solver_adaptive_rel_error_tol,
+    SEXP solver_adaptive_abs_error_tol,
+    SEXP solver_adaptive_max_steps,
+    SEXP override_controls,
+    SEXP override_names,
+    SEXP override_values,
+    SEXP n_threads,
+    SEXP output_quantities,
+    SEXP output_decimation);
+
+extern "C" SEXP R_run_biocro_sensitivity(
+    SEXP initial_values,
+    SEXP parameters,
+    SEXP drivers,
+    SEXP direct_mc_vec,
+    SEXP differential_mc_vec,
+    SEXP solver_type,
+    SEXP arg_names);
 
 #endif
@@ -0,0 +1,178 @@
+#include <string>
+#include <vector>
+#include <exception>                       // for std::exception
+#include <stdexcept>                       // for std::runtime_error
+#include <Rinternals.h>                    // for Rf_error and Rprintf
+#include "framework/R_helper_functions.h"  // for map_from_list, map_vector_from_list, mc_vector_from_list, make_vector
+#include "R_data_frame.h"                  // for data_frame_from_result
+#include "framework/state_map.h"           // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"      // for mc_vector
+#include "simulation_handle.h"
+#include "R_simulation_handle.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+void finalize_simulation_handle(SEXP handle)
+{
+    simulation_handle* h = static_cast<simulation_handle*>(R_ExternalPtrAddr(handle));
+    delete h;
+    R_ClearExternalPtr(handle);
+}
+
+simulation_handle* handle_from_pointer(SEXP handle)
+{
+    simulation_handle* h = static_cast<simulation_handle*>(R_ExternalPtrAddr(handle));
+    if (!h) {
+        throw std::runtime_error(
+            "The simulation handle is no longer valid; it may have been "
+            "restored from a saved R session");
+    }
+    return h;
+}
+}  // namespace
+
+extern "C" {
+
+/**
+ *  @brief Creates an "R external pointer" object that points to a
+ *  `simulation_handle` object
+ *
+ *  The handle stores copies of all the simulation inputs, so they only need to
+ *  be converted from R objects once. The R external pointer takes ownership of
+ *  the handle, and a finalizer is registered to delete it when the pointer is
+ *  garbage collected, following the same approach used for the
+ *  `module_creator` pointers in `R_module_creators()`.
+ *
+ *  The handle does not own its `module_creator` objects. To keep them from
+ *  being garbage collected while the handle is still in use, the R lists of
+ *  module creator pointers are stored in the `prot` field of the handle's
+ *  external pointer.
+ *
+ *  @param [in] slot_controls An R vector of strings indicating where each
+ *              slot is located; each element must be `"initial_values"`,
+ *              `"parameters"`, or `"drivers"`
+ *
+ *  @param [in] slot_names An R vector of strings indicating the name of the
+ *              quantity associated with each slot
+ *
+ *  @param [in] slot_indices An R numeric vector indicating the (one-based)
+ *              index of each slot within its quantity
+ *
+ *  The other arguments are identical to those of `R_run_biocro()`.
+ *
+ *  @return An "R external pointer" object
+ */
+SEXP R_simulation_handle(
+    SEXP initial_values,
+    SEXP parameters,
+    SEXP drivers,
+    SEXP direct_mc_vec,
+    SEXP differential_mc_vec,
+    SEXP solver_type,
+    SEXP solver_output_step_size,
+    SEXP solver_adaptive_rel_error_tol,
+    SEXP solver_adaptive_abs_error_tol,
+    SEXP solver_adaptive_max_steps,
+    SEXP slot_controls,
+    SEXP slot_names,
+    SEXP slot_indices)
+{
+    try {
+        state_map iv = map_from_list(initial_values);
+        state_map p = map_from_list(parameters);
+        state_vector_map d = map_vector_from_list(drivers);
+
+        mc_vector direct_mcs = mc_vector_from_list(direct_mc_vec);
+        mc_vector differential_mcs = mc_vector_from_list(differential_mc_vec);
+
+        string solver_type_string = CHAR(STRING_ELT(solver_type, 0));
+        double output_step_size = REAL(solver_output_step_size)[0];
+        double adaptive_rel_error_tol = REAL(solver_adaptive_rel_error_tol)[0];
+        double adaptive_abs_error_tol = REAL(solver_adaptive_abs_error_tol)[0];
+        int adaptive_max_steps = (int)REAL(solver_adaptive_max_steps)[0];
+
+        string_vector controls = make_vector(slot_controls);
+        string_vector names = make_vector(slot_names);
+
+        // Convert from R's one-based indexing
+        vector<size_t> indices;
+        for (R_xlen_t i = 0; i < XLENGTH(slot_indices); ++i) {
+            indices.push_back((size_t)REAL(slot_indices)[i] - 1);
+        }
+
+        simulation_handle* h = new simulation_handle(
+            iv, p, d, direct_mcs, differential_mcs, solver_type_string,
+            output_step_size, adaptive_rel_error_tol, adaptive_abs_error_tol,
+            adaptive_max_steps, controls, names, indices);
+
+        SEXP prot = PROTECT(Rf_allocVector(VECSXP, 2));
+        SET_VECTOR_ELT(prot, 0, direct_mc_vec);
+        SET_VECTOR_ELT(prot, 1, differential_mc_vec);
+
+        SEXP handle = PROTECT(R_MakeExternalPtr(h, R_NilValue, prot));
+
+        R_RegisterCFinalizerEx(
+            handle,
+            (R_CFinalizer_t)finalize_simulation_handle,
+            TRUE);
+
+        UNPROTECT(2);  // UNPROTECT prot and handle
+        return handle;
+
+    } catch (std::exception const& e) {
+        Rf_error("%s", string(string("Caught exception in R_simulation_handle: ") + e.what()).c_str());
+    } catch (...) {
+        Rf_error("Caught unhandled exception in R_simulation_handle.");
+    }
+}
+
+/**
+ *  @brief Updates the slots of a simulation handle and then runs a simulation
+ *
+ *  @param [in] handle An "R external pointer" created by
+ *              `R_simulation_handle()`
+ *
+ *  @param [in] slot_values An R numeric vector of new values for the slots, in
+ *              the same order as they were specified when creating the handle
+ *
+ *  @param [in] verbose An R logical vector with one element indicating whether
+ *              the simulation report should be printed
+ *
+ *  @return An R data frame representing the simulation result, identical in
+ *          form to the output from `R_run_biocro()`
+ */
+SEXP R_run_simulation_handle(
+    SEXP handle,
+    SEXP slot_values,
+    SEXP verbose)
+{
+    try {
+        simulation_handle* h = handle_from_pointer(handle);
+
+        double const* v = REAL(slot_values);
+        h->set_slots(vector<double>(v, v + XLENGTH(slot_values)));
+
+        if (h->get_ntimes() == 0) {
+            return R_NilValue;
+        }
+
+        bool loquacious = LOGICAL(verbose)[0];
+        string report;
+        state_vector_map result = h->run(loquacious, report);
+
+        if (loquacious) {
+            Rprintf("%s", report.c_str());
+        }
+
+        return data_frame_from_result(result);
+    } catch (std::exception const& e) {
+        Rf_error("%s", string(string("Caught exception in R_run_simulation_handle: ") + e.what()).c_str());
+    } catch (...) {
+        Rf_error("Caught unhandled exception in R_run_simulation_handle.");
+    }
+}
+
+}  // extern "C"
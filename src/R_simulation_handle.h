@@ -0,0 +1,26 @@
+#ifndef R_SIMULATION_HANDLE_H
+#define R_SIMULATION_HANDLE_H
+
+#include <Rinternals.h>  // for SEXP
+
+extern "C" SEXP R_simulation_handle(
+    SEXP initial_values,
+    SEXP parameters,
+    SEXP drivers,
+    SEXP direct_mc_vec,
+    SEXP differential_mc_vec,
+    SEXP solver_type,
+    SEXP solver_output_step_size,
+    SEXP solver_adaptive_rel_error_tol,
+    SEXP solver_adaptive_abs_error_tol,
+    SEXP solver_adaptive_max_steps,
+    SEXP slot_controls,
+    SEXP slot_names,
+    SEXP slot_indices);
+
+extern "C" SEXP R_run_simulation_handle(
+    SEXP handle,
+    SEXP slot_values,
+    SEXP verbose);
+
+#endif
@@ -1,27 +1,72 @@
 #include <vector>
+#include <algorithm>                       // for std::copy, std::fill
 #include <string>
 #include <exception>                       // for std::exception
+#include <stdexcept>                       // for std::runtime_error
 #include <Rinternals.h>                    // for Rf_error
-#include "framework/R_helper_functions.h"  // for map_from_list, map_vector_from_list, mc_vector_from_list, list_from_map
+#include "framework/R_helper_functions.h"  // for map_from_list, map_vector_from_list, mc_vector_from_list, make_vector
 #include "framework/state_map.h"           // for state_map, state_vector_map, string_vector
-#include "framework/dynamical_system.h"
+#include "persistent_system.h"
+#include "jacobian_sparsity.h"              // for jacobian_sparsity
+#include "R_system_derivatives.h"
 
 using std::string;
 using std::vector;
 
+namespace
+{
+void finalize_persistent_system(SEXP handle)
+{
+    persistent_system* sys = static_cast<persistent_system*>(R_ExternalPtrAddr(handle));
+    delete sys;
+    R_ClearExternalPtr(handle);
+}
+
+// Gets the system from a handle and checks that the number of differential
+// quantities is correct
+persistent_system* checked_system(SEXP handle, SEXP differential_quantities)
+{
+    if (TYPEOF(handle) != EXTPTRSXP) {
+        throw std::runtime_error("The system handle is not an external pointer");
+    }
+
+    persistent_system* sys = static_cast<persistent_system*>(R_ExternalPtrAddr(handle));
+
+    if (!sys) {
+        throw std::runtime_error(
+            "The system is no longer valid; it may have been restored "
+            "from a saved R session");
+    }
+
+    if ((size_t)XLENGTH(differential_quantities) != sys->size()) {
+        throw std::runtime_error(
+            "The number of differential quantities does not match the "
+            "number used to create the system");
+    }
+
+    return sys;
+}
+}  // namespace
+
 extern "C" {
 
 /**
- *  @brief Creates a `dynamical_system` object from the differential quantities,
- *         parameters, drivers, and modules, and then uses the system object to
- *         determine the derivatives of the differential quantities at the
- *         specified time
+ *  @brief Creates an "R external pointer" object that points to a
+ *  `persistent_system` object, which can be passed to `R_system_derivatives()`
+ *  to calculate derivatives
  *
- *  @param [in] differential_quantities An R list of named elements
- *              representing the current values of the differential quantities
+ *  The system is created once from the differential quantities, parameters,
+ *  drivers, and modules; afterwards, only the values of the differential
+ *  quantities and the time need to be supplied to calculate a derivative.
  *
- *  @param [in] time An R numeric vector with one element specifying the time
- *              index
+ *  As in `R_simulation_handle()`, the R lists of module creator pointers are
+ *  stored in the `prot` field of the external pointer, and a finalizer is
+ *  registered to delete the system when the pointer is garbage collected.
+ *
+ *  @param [in] differential_quantities An R list of named elements
+ *              representing the initial values of the differential
+ *              quantities. The order of the elements determines the order of
+ *              the values passed to and returned from `R_system_derivatives()`.
  *
  *  @param [in] parameters An R list of named elements representing the
  *              parameters
@@ -32,15 +77,14 @@ extern "C" {
  *  @param [in] direct_mc_vec An R vector of pointers to module wrapper objects
  *              representing the direct modules
  *
- *  @param [in] differential_module_names An R vector of pointers to module
- *              wrapper objects representing the differential modules
+ *  @param [in] differential_mc_vec An R vector of pointers to module wrapper
+ *              objects representing the differential modules
  *
- *  @return An R list of named elements representing the derivatives of the
- *          differential quantities
+ *  @return An "R external pointer" object. An error is thrown if the drivers
+ *          have no rows, since the system cannot be evaluated at any time.
  */
-SEXP R_system_derivatives(
+SEXP R_system_derivatives_handle(
     SEXP differential_quantities,
-    SEXP time,
     SEXP parameters,
     SEXP drivers,
     SEXP direct_mc_vec,
@@ -49,51 +93,89 @@ SEXP R_system_derivatives(
     try {
         // Convert the inputs into the proper format
         state_map iv = map_from_list(differential_quantities);
+        string_vector iv_order =
+            make_vector(Rf_getAttrib(differential_quantities, R_NamesSymbol));
         state_map p = map_from_list(parameters);
         state_vector_map d = map_vector_from_list(drivers);
 
         if (d.begin()->second.size() == 0) {
-            return R_NilValue;
+            throw std::runtime_error(
+                "The drivers must have at least one row to calculate "
+                "derivatives");
         }
 
         mc_vector direct_mcs = mc_vector_from_list(direct_mc_vec);
         mc_vector differential_mcs = mc_vector_from_list(differential_mc_vec);
 
-        double t = REAL(time)[0];
+        persistent_system* sys = new persistent_system(
+            iv, iv_order, p, d, direct_mcs, differential_mcs);
+
+        SEXP prot = PROTECT(Rf_allocVector(VECSXP, 2));
+        SET_VECTOR_ELT(prot, 0, direct_mc_vec);
+        SET_VECTOR_ELT(prot, 1, differential_mc_vec);
+
+        SEXP handle = PROTECT(R_MakeExternalPtr(sys, R_NilValue, prot));
+
+        R_RegisterCFinalizerEx(
+            handle,
+            (R_CFinalizer_t)finalize_persistent_system,
+            TRUE);
 
-        // Create a dynamical system
-        dynamical_system sys(iv, p, d, direct_mcs, differential_mcs);
+        UNPROTECT(2);  // UNPROTECT prot and handle
+        return handle;
 
-        // Ask the system object for a vector of the current values of the
-        // differential quantities. The system hasn't been modified since its
-        // creation, so these will be the values from the input argument
-        // `differential_quantities`. This step is necessary to ensure they are
-        // arranged in the same order as expected by the system, since it may
-        // reorder them.
-        vector<double> x;
-        sys.get_differential_quantities(x);
+    } catch (std::exception const& e) {
+        Rf_error("%s", (string("Caught exception in R_system_derivatives_handle: ") + e.what()).c_str());
+    } catch (...) {
+        Rf_error("Caught unhandled exception in R_system_derivatives_handle.");
+    }
+}
 
-        // Get the differential quantity names in the order used by the system,
-        // which may in general be different than the original order of the
-        // quantities in the `differential_quantities` input.
-        string_vector differential_quantity_names =
-            sys.get_differential_quantity_names();
+/**
+ *  @brief Uses a persistent system object to determine the derivatives of the
+ *         differential quantities at the specified time
+ *
+ *  @param [in] handle An "R external pointer" created by
+ *              `R_system_derivatives_handle()`
+ *
+ *  @param [in] differential_quantities An R numeric vector representing the
+ *              current values of the differential quantities, in the same
+ *              order used when creating the handle
+ *
+ *  @param [in] time An R numeric vector with one element specifying the time
+ *              index
+ *
+ *  @return An R numeric vector of named elements representing the derivatives
+ *          of the differential quantities, in the same order as
+ *          `differential_quantities`
+ */
+SEXP R_system_derivatives(
+    SEXP handle,
+    SEXP differential_quantities,
+    SEXP time)
+{
+    try {
+        persistent_system* sys = checked_system(handle, differential_quantities);
+        size_t n = sys->size();
 
-        // Make a vector to store the values of the derivatives of the
-        // differential quantities
-        vector<double> dxdt(x.size());
+        double const* x_ptr = REAL(differential_quantities);
+        vector<double> x(x_ptr, x_ptr + n);
+        vector<double> dxdt(n);
 
         // Calculate the derivative (sets dxdt)
-        sys.calculate_derivative(x, dxdt, t);
+        sys->calculate_derivative(x, dxdt, REAL(time)[0]);
 
-        // Make the output map
-        state_map result;
-        for (size_t i = 0; i < differential_quantity_names.size(); i++) {
-            result[differential_quantity_names[i]] = dxdt[i];
-        }
+        // Make the output vector
+        SEXP result = PROTECT(Rf_allocVector(REALSXP, n));
+        std::copy(dxdt.begin(), dxdt.end(), REAL(result));
 
-        // Return the resulting derivatives
-        return list_from_map(result);
+        Rf_setAttrib(
+            result,
+            R_NamesSymbol,
+            r_string_vector_from_vector(sys->get_quantity_names()));
+
+        UNPROTECT(1);  // UNPROTECT result
+        return result;
 
     } catch (std::exception const& e) {
         Rf_error("%s", (string("Caught exception in R_system_derivatives: ") + e.what()).c_str());
@@ -102,4 +184,84 @@ SEXP R_system_derivatives(
     }
 }
 
+/**
+ *  @brief Uses a persistent system object to determine the Jacobian matrix of
+ *         the system at the specified time
+ *
+ *  See `persistent_system::calculate_jacobian()` for details about how the
+ *  Jacobian is calculated.
+ *
+ *  @param [in] handle An "R external pointer" created by
+ *              `R_system_derivatives_handle()`
+ *
+ *  @param [in] differential_quantities An R numeric vector representing the
+ *              current values of the differential quantities, in the same
+ *              order used when creating the handle
+ *
+ *  @param [in] time An R numeric vector with one element specifying the time
+ *              index
+ *
+ *  @return An R numeric matrix whose rows and columns are named after the
+ *          differential quantities, in the same order as
+ *          `differential_quantities`. It has two additional attributes:
+ *          `sparsity`, a logical matrix indicating which elements may be
+ *          nonzero, and `colors`, an integer vector specifying the (1-based)
+ *          color of each column.
+ */
+SEXP R_system_jacobian(
+    SEXP handle,
+    SEXP differential_quantities,
+    SEXP time)
+{
+    try {
+        persistent_system* sys = checked_system(handle, differential_quantities);
+        size_t n = sys->size();
+
+        double const* x_ptr = REAL(differential_quantities);
+        vector<double> x(x_ptr, x_ptr + n);
+        vector<double> jacobian;
+
+        // Calculate the Jacobian (sets jacobian)
+        sys->calculate_jacobian(x, jacobian, REAL(time)[0]);
+
+        jacobian_sparsity const& sparsity = sys->get_jacobian_sparsity();
+
+        // Make the output matrix and its attributes
+        SEXP result = PROTECT(Rf_allocMatrix(REALSXP, n, n));
+        std::copy(jacobian.begin(), jacobian.end(), REAL(result));
+
+        SEXP pattern = PROTECT(Rf_allocMatrix(LGLSXP, n, n));
+        std::fill(LOGICAL(pattern), LOGICAL(pattern) + n * n, FALSE);
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t i : sparsity.column_rows[j]) {
+                LOGICAL(pattern)[i + j * n] = TRUE;
+            }
+        }
+
+        SEXP colors = PROTECT(Rf_allocVector(INTSXP, n));
+        for (size_t j = 0; j < n; ++j) {
+            INTEGER(colors)[j] = (int)sparsity.column_colors[j] + 1;
+        }
+
+        SEXP names = PROTECT(r_string_vector_from_vector(sys->get_quantity_names()));
+        SEXP dimnames = PROTECT(Rf_allocVector(VECSXP, 2));
+        SET_VECTOR_ELT(dimnames, 0, names);
+        SET_VECTOR_ELT(dimnames, 1, names);
+
+        Rf_setAttrib(result, R_DimNamesSymbol, dimnames);
+        Rf_setAttrib(pattern, R_DimNamesSymbol, dimnames);
+        Rf_setAttrib(colors, R_NamesSymbol, names);
+        Rf_setAttrib(result, Rf_install("sparsity"), pattern);
+        Rf_setAttrib(result, Rf_install("colors"), colors);
+
+        UNPROTECT(5);  // UNPROTECT result, pattern, colors, names, and dimnames
+        return result;
+
+    } catch (std::exception const& e) {
+        Rf_error("%s", (string("Caught exception in R_system_jacobian: ") + e.what()).c_str());
+    } catch (...) {
+        Rf_error("Caught unhandled exception in R_system_jacobian.");
+    }
+}
+
 }  // extern "C"
@@ -3,12 +3,21 @@
 
 #include <Rinternals.h>  // for SEXP
 
-extern "C" SEXP R_system_derivatives(
+extern "C" SEXP R_system_derivatives_handle(
     SEXP differential_quantities,
-    SEXP time,
     SEXP parameters,
     SEXP drivers,
     SEXP direct_mc_vec,
     SEXP differential_mc_vec);
 
+extern "C" SEXP R_system_derivatives(
+    SEXP handle,
+    SEXP differential_quantities,
+    SEXP time);
+
+extern "C" SEXP R_system_jacobian(
+    SEXP handle,
+    SEXP differential_quantities,
+    SEXP time);
+
 #endif
@@ -0,0 +1,361 @@
+#include <algorithm>  // for std::min
+#include <memory>     // for std::unique_ptr
+#include <stdexcept>  // for std::runtime_error
+#include <vector>
+#include "framework/module.h"  // for module
+#include "parallel_for.h"      // for parallel_for
+#include "direct_module_hoisting.h"
+
+namespace
+{
+bool all_inputs_known(module_creator* mc, string_set const& known)
+{
+    for (std::string const& name : mc->get_inputs()) {
+        if (known.count(name) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void add_outputs(module_creator* mc, string_set& known)
+{
+    for (std::string const& name : mc->get_outputs()) {
+        known.insert(name);
+    }
+}
+
+// Returns true if any direct module output has the same name as an initial
+// value, parameter, driver, or the output of another direct module. Such a
+// system is invalid, but the framework reports this with a more detailed
+// message, so hoisting is simply skipped in that case.
+bool has_duplicated_quantities(
+    state_map const& initial_values,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs)
+{
+    string_set defined;
+    for (auto const& x : initial_values) {
+        defined.insert(x.first);
+    }
+    for (auto const& x : parameters) {
+        defined.insert(x.first);
+    }
+    for (auto const& x : drivers) {
+        defined.insert(x.first);
+    }
+
+    for (module_creator* mc : direct_mcs) {
+        for (std::string const& name : mc->get_outputs()) {
+            if (!defined.insert(name).second) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// The objects a worker thread needs to run the driver-only modules: a map
+// holding the parameters, the values of the drivers at one time point, and the
+// outputs of the driver-only modules; pointers to the driver values and
+// outputs in the map; and module objects that read from and write to the map
+struct driver_only_worker {
+    state_map quantities;
+    std::vector<double*> driver_ptrs;
+    std::vector<double const*> output_ptrs;
+    std::vector<std::unique_ptr<module>> modules;
+};
+
+// The number of consecutive driver rows processed by a worker at a time
+constexpr size_t driver_block_size = 512;
+
+string_vector module_names(mc_vector const& mcs)
+{
+    string_vector names;
+    for (module_creator* mc : mcs) {
+        names.push_back(mc->get_name());
+    }
+    return names;
+}
+}  // namespace
+
+/**
+ *  @brief Classifies direct modules as constant, driver-only, or
+ *  state-dependent based on the names of their inputs and outputs; see
+ *  `direct_module_classes` for details.
+ */
+direct_module_classes classify_direct_modules(
+    mc_vector const& direct_mcs,
+    string_vector const& parameter_names,
+    string_vector const& driver_names)
+{
+    string_set constant_quantities(parameter_names.begin(), parameter_names.end());
+    string_set known_quantities = constant_quantities;
+    known_quantities.insert(driver_names.begin(), driver_names.end());
+
+    direct_module_classes classes;
+    std::vector<bool> classified(direct_mcs.size(), false);
+
+    // First find the constant modules, repeating the search until no more are
+    // found, since a module may depend on constant modules listed after it
+    bool found = true;
+    while (found) {
+        found = false;
+        for (size_t i = 0; i < direct_mcs.size(); ++i) {
+            if (!classified[i] && all_inputs_known(direct_mcs[i], constant_quantities)) {
+                classes.constant.push_back(direct_mcs[i]);
+                add_outputs(direct_mcs[i], constant_quantities);
+                add_outputs(direct_mcs[i], known_quantities);
+                classified[i] = true;
+                found = true;
+            }
+        }
+    }
+
+    // Then find the driver-only modules in the same way
+    found = true;
+    while (found) {
+        found = false;
+        for (size_t i = 0; i < direct_mcs.size(); ++i) {
+            if (!classified[i] && all_inputs_known(direct_mcs[i], known_quantities)) {
+                classes.driver_only.push_back(direct_mcs[i]);
+                add_outputs(direct_mcs[i], known_quantities);
+                classified[i] = true;
+                found = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < direct_mcs.size(); ++i) {
+        if (!classified[i]) {
+            classes.state_dependent.push_back(direct_mcs[i]);
+        }
+    }
+
+    return classes;
+}
+
+/**
+ *  @brief Runs driver-only modules once for each row of the drivers, adding
+ *  their outputs to the drivers as new columns.
+ *
+ *  The rows are divided into blocks that are distributed among up to
+ *  `nthreads` threads. Each thread creates its own copies of the modules, so
+ *  nothing except the (read-only) driver columns and the (disjoint) rows of
+ *  the output columns is shared between threads, and the outputs do not
+ *  depend on the number of threads.
+ *
+ *  @param [in] parameters The system parameters, including the outputs of any
+ *              constant modules
+ *
+ *  @param [in, out] drivers The system drivers
+ *
+ *  @param [in] driver_only_mcs The driver-only modules, ordered so that each
+ *              module follows the modules that supply its inputs
+ *
+ *  @param [in] nthreads The number of threads to use
+ */
+void precompute_driver_only_outputs(
+    state_map const& parameters,
+    state_vector_map& drivers,
+    mc_vector const& driver_only_mcs,
+    size_t nthreads)
+{
+    if (drivers.empty() || driver_only_mcs.empty()) {
+        return;
+    }
+
+    size_t const nrow = drivers.begin()->second.size();
+    size_t const nblocks = (nrow + driver_block_size - 1) / driver_block_size;
+
+    string_vector driver_names;
+    std::vector<std::vector<double> const*> driver_columns;
+    for (auto const& x : drivers) {
+        driver_names.push_back(x.first);
+        driver_columns.push_back(&x.second);
+    }
+
+    string_vector output_names;
+    for (module_creator* mc : driver_only_mcs) {
+        for (std::string const& name : mc->get_outputs()) {
+            output_names.push_back(name);
+        }
+    }
+
+    std::vector<std::vector<double>> output_columns(
+        output_names.size(), std::vector<double>(nrow));
+
+    std::vector<std::unique_ptr<driver_only_worker>> workers(nthreads);
+
+    auto setup = [&](size_t w) {
+        std::unique_ptr<driver_only_worker> dw(new driver_only_worker);
+        dw->quantities = parameters;
+
+        // Pointers to elements of an unordered_map remain valid until the
+        // element is erased, so they can be stored once all the elements
+        // have been added
+        for (std::string const& name : driver_names) {
+            dw->quantities[name] = 0.0;
+        }
+        for (std::string const& name : output_names) {
+            dw->quantities[name] = 0.0;
+        }
+        for (std::string const& name : driver_names) {
+            dw->driver_ptrs.push_back(&dw->quantities.at(name));
+        }
+        for (std::string const& name : output_names) {
+            dw->output_ptrs.push_back(&dw->quantities.at(name));
+        }
+
+        for (module_creator* mc : driver_only_mcs) {
+            dw->modules.push_back(mc->create_module(dw->quantities, &dw->quantities));
+        }
+
+        workers[w] = std::move(dw);
+    };
+
+    auto task = [&](size_t w, size_t block) {
+        driver_only_worker& dw = *workers[w];
+        size_t const first = block * driver_block_size;
+        size_t const last = std::min(first + driver_block_size, nrow);
+
+        for (size_t i = first; i < last; ++i) {
+            for (size_t j = 0; j < dw.driver_ptrs.size(); ++j) {
+                *dw.driver_ptrs[j] = (*driver_columns[j])[i];
+            }
+
+            for (auto const& m : dw.modules) {
+                m->run();
+            }
+
+            for (size_t j = 0; j < dw.output_ptrs.size(); ++j) {
+                output_columns[j][i] = *dw.output_ptrs[j];
+            }
+        }
+    };
+
+    parallel_for(nblocks, nthreads, setup, task);
+
+    for (size_t j = 0; j < output_names.size(); ++j) {
+        drivers[output_names[j]].swap(output_columns[j]);
+    }
+}
+
+/**
+ *  @brief Removes the constant and driver-only modules from a set of direct
+ *  modules, running them before the simulation instead of during every
+ *  derivative calculation.
+ *
+ *  The constant modules are run once and their outputs are added to the
+ *  `parameters`. The driver-only modules are run once for each row of the
+ *  `drivers` and their outputs are added as new driver columns.
+ *
+ *  Note that an ODE solver that evaluates derivatives between the driver
+ *  rows will then interpolate the outputs of the driver-only modules, just
+ *  like any other driver, rather than calculating them from interpolated
+ *  inputs; for solvers that only use the driver times, the simulation result
+ *  is unchanged.
+ *
+ *  @param [in] initial_values The initial values of the differential
+ *              quantities; only their names are used
+ *
+ *  @param [in, out] parameters The system parameters
+ *
+ *  @param [in, out] drivers The system drivers
+ *
+ *  @param [in, out] direct_mcs The direct modules; only the state-dependent
+ *                   modules remain afterwards
+ *
+ *  @param [in] nthreads The number of threads used to run the driver-only
+ *              modules
+ *
+ *  @return A summary of the changes
+ */
+hoisting_summary hoist_direct_modules(
+    state_map const& initial_values,
+    state_map& parameters,
+    state_vector_map& drivers,
+    mc_vector& direct_mcs,
+    size_t nthreads)
+{
+    hoisting_summary summary;
+
+    if (drivers.empty() ||
+        has_duplicated_quantities(initial_values, parameters, drivers, direct_mcs)) {
+        return summary;
+    }
+
+    direct_module_classes const classes =
+        classify_direct_modules(direct_mcs, keys(parameters), keys(drivers));
+
+    // Run each constant module once, in order, adding its outputs to the
+    // parameters so they are available to the following modules
+    for (module_creator* mc : classes.constant) {
+        state_map outputs;
+        for (std::string const& name : mc->get_outputs()) {
+            outputs[name] = 0.0;
+        }
+
+        mc->create_module(parameters, &outputs)->run();
+
+        for (auto const& x : outputs) {
+            parameters[x.first] = x.second;
+            summary.constant_outputs[x.first] = x.second;
+        }
+    }
+
+    if (!classes.driver_only.empty()) {
+        precompute_driver_only_outputs(
+            parameters, drivers, classes.driver_only, nthreads);
+    }
+
+    summary.constant_module_names = module_names(classes.constant);
+    summary.driver_only_module_names = module_names(classes.driver_only);
+    direct_mcs = classes.state_dependent;
+
+    return summary;
+}
+
+/**
+ *  @brief Adds the outputs of constant modules to a simulation result as
+ *  columns with the same value at every time point, so the result includes
+ *  the same quantities as it would have if the modules had not been hoisted.
+ */
+void add_constant_outputs(
+    state_vector_map& result,
+    state_map const& constant_outputs)
+{
+    if (result.empty()) {
+        return;
+    }
+
+    size_t const nrow = result.begin()->second.size();
+
+    for (auto const& x : constant_outputs) {
+        result[x.first] = std::vector<double>(nrow, x.second);
+    }
+}
+
+/**
+ *  @brief Formats a summary of the hoisted modules as a human-readable list,
+ *  in the style of the `biocro_simulation` report
+ */
+std::string hoisting_report(hoisting_summary const& summary)
+{
+    std::string report = "\nDirect modules evaluated before the simulation:\n";
+
+    auto add_list = [&report](std::string const& label, string_vector const& names) {
+        report += "  " + label + " (" + std::to_string(names.size()) + "):";
+        for (std::string const& name : names) {
+            report += " " + name;
+        }
+        report += "\n";
+    };
+
+    add_list("Constant modules", summary.constant_module_names);
+    add_list("Driver-only modules", summary.driver_only_module_names);
+
+    return report;
+}
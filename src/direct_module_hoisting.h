@@ -0,0 +1,72 @@
+#ifndef DIRECT_MODULE_HOISTING_H
+#define DIRECT_MODULE_HOISTING_H
+
+#include <string>
+#include "framework/state_map.h"       // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"  // for mc_vector
+
+/**
+ *  @brief Direct modules sorted by the kinds of quantities their outputs
+ *  depend on.
+ *
+ *  - A _constant_ module only depends on parameters and the outputs of other
+ *    constant modules, so its outputs never change during a simulation.
+ *
+ *  - A _driver-only_ module depends on at least one driver or the output of
+ *    another driver-only module, but not on any differential quantities or
+ *    outputs of state-dependent modules. Its outputs can be determined for
+ *    every row of the drivers before the simulation begins.
+ *
+ *  - A _state-dependent_ module depends on at least one differential
+ *    quantity, or on a quantity that is not supplied by the parameters,
+ *    drivers, or direct modules, and must be run during every derivative
+ *    calculation.
+ *
+ *  The constant and driver-only modules are listed in an order where every
+ *  module follows the modules that supply its inputs. The state-dependent
+ *  modules are listed in their original order.
+ */
+struct direct_module_classes {
+    mc_vector constant;
+    mc_vector driver_only;
+    mc_vector state_dependent;
+};
+
+direct_module_classes classify_direct_modules(
+    mc_vector const& direct_mcs,
+    string_vector const& parameter_names,
+    string_vector const& driver_names);
+
+/**
+ *  @brief Information about the direct modules removed from a system by
+ *  `hoist_direct_modules()`.
+ */
+struct hoisting_summary {
+    string_vector constant_module_names;
+    string_vector driver_only_module_names;
+
+    // The outputs of the constant modules, which have been added to the
+    // parameters and therefore will not be included in the simulation result
+    state_map constant_outputs;
+};
+
+void precompute_driver_only_outputs(
+    state_map const& parameters,
+    state_vector_map& drivers,
+    mc_vector const& driver_only_mcs,
+    size_t nthreads);
+
+hoisting_summary hoist_direct_modules(
+    state_map const& initial_values,
+    state_map& parameters,
+    state_vector_map& drivers,
+    mc_vector& direct_mcs,
+    size_t nthreads);
+
+void add_constant_outputs(
+    state_vector_map& result,
+    state_map const& constant_outputs);
+
+std::string hoisting_report(hoisting_summary const& summary);
+
+#endif
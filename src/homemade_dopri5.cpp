@@ -0,0 +1,539 @@
+#include <stdexcept>  // for std::runtime_error, std::out_of_range
+#include <algorithm>  // for std::min, std::max, std::find
+#include <cmath>      // for std::abs, std::pow, std::sqrt
+#include <sstream>    // for std::ostringstream
+#include "homemade_dopri5.h"
+
+namespace
+{
+// The Dormand-Prince coefficients; the last stage uses the weights of the
+// fifth-order solution
+double const c2 = 1.0 / 5.0, c3 = 3.0 / 10.0, c4 = 4.0 / 5.0, c5 = 8.0 / 9.0;
+
+double const a21 = 1.0 / 5.0;
+double const a31 = 3.0 / 40.0, a32 = 9.0 / 40.0;
+double const a41 = 44.0 / 45.0, a42 = -56.0 / 15.0, a43 = 32.0 / 9.0;
+double const a51 = 19372.0 / 6561.0, a52 = -25360.0 / 2187.0,
+             a53 = 64448.0 / 6561.0, a54 = -212.0 / 729.0;
+double const a61 = 9017.0 / 3168.0, a62 = -355.0 / 33.0,
+             a63 = 46732.0 / 5247.0, a64 = 49.0 / 176.0,
+             a65 = -5103.0 / 18656.0;
+double const b1 = 35.0 / 384.0, b3 = 500.0 / 1113.0, b4 = 125.0 / 192.0,
+             b5 = -2187.0 / 6784.0, b6 = 11.0 / 84.0;
+
+// The differences between the fifth- and fourth-order weights
+double const e1 = 71.0 / 57600.0, e3 = -71.0 / 16695.0, e4 = 71.0 / 1920.0,
+             e5 = -17253.0 / 339200.0, e6 = 22.0 / 525.0, e7 = -1.0 / 40.0;
+
+// The coefficients of the continuous extension (Hairer, Norsett, and Wanner,
+// Solving Ordinary Differential Equations I, section II.6)
+double const d1 = -12715105075.0 / 11282082432.0,
+             d3 = 87487479700.0 / 32700410799.0,
+             d4 = -10690763975.0 / 1880347072.0,
+             d5 = 701980252875.0 / 199316789632.0,
+             d6 = -1453857185.0 / 822651844.0,
+             d7 = 69997945.0 / 29380423.0;
+
+// Limits on the factor by which the step size changes after each step
+double const safety = 0.9;
+double const min_factor = 0.2;
+double const max_factor = 10.0;
+
+// The weight of the previous error in the step size controller
+double const beta = 0.04;
+
+std::vector<double> ordered_values(
+    state_map const& values,
+    string_vector const& names)
+{
+    std::vector<double> result;
+    for (std::string const& name : names) {
+        result.push_back(values.at(name));
+    }
+    return result;
+}
+
+/**
+ *  @brief Returns the factor by which to multiply the step size, given the
+ *  error norms of the last attempted step and the last accepted step.
+ *
+ *  This is the proportional-integral controller used by Hairer's DOPRI5,
+ *  which causes fewer rejected steps than one based only on the last error.
+ */
+double step_factor(double error, double previous_error)
+{
+    double const factor = safety * std::pow(previous_error, beta) /
+                          std::pow(std::max(error, 1e-10), 0.2 - 0.75 * beta);
+
+    return std::min(max_factor, std::max(min_factor, factor));
+}
+}  // namespace
+
+homemade_dopri5_simulation::homemade_dopri5_simulation(
+    state_map const& initial_values,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs,
+    double output_step_size,
+    double rel_tol,
+    double abs_tol,
+    int max_steps)
+    : sys{initial_values, keys(initial_values), parameters, drivers,
+          direct_mcs, differential_mcs},
+      ntimes{drivers.begin()->second.size()},
+      output_step_size{output_step_size},
+      rel_tol{rel_tol},
+      abs_tol{abs_tol},
+      max_steps{max_steps},
+      y0{ordered_values(initial_values, sys.get_quantity_names())},
+      output_quantity_names{sys.get_output_quantity_names()},
+      output_decimation{1}
+{
+    if (!(output_step_size > 0.0)) {
+        throw std::runtime_error(
+            "The output step size of the homemade_dopri5 ODE solver must be positive");
+    }
+
+    if (!(rel_tol >= 0.0) || !(abs_tol > 0.0)) {
+        throw std::runtime_error(
+            "The homemade_dopri5 ODE solver requires a positive absolute error "
+            "tolerance and a non-negative relative error tolerance");
+    }
+
+    if (max_steps < 1) {
+        throw std::runtime_error(
+            "The homemade_dopri5 ODE solver requires a positive maximum number of steps");
+    }
+
+    size_t const n = y0.size();
+
+    k.assign(7, std::vector<double>(n, 0.0));
+    dense.assign(5, std::vector<double>(n, 0.0));
+    y_stage.resize(n);
+    y_new.resize(n);
+}
+
+void homemade_dopri5_simulation::calculate_derivative(
+    std::vector<double> const& x,
+    double time,
+    std::vector<double>& dxdt)
+{
+    sys.calculate_derivative(x, dxdt, time);
+    ++nderivatives;
+}
+
+/**
+ *  @brief Sets the events that are checked after each step; see
+ *  `simulation_event`.
+ */
+void homemade_dopri5_simulation::set_events(
+    std::vector<simulation_event> const& new_events)
+{
+    detector = event_detector(new_events, sys.get_quantity_names());
+}
+
+/**
+ *  @brief Chooses the size of the first step from the magnitudes of the state
+ *  and its first two derivatives, following Hairer, Norsett, and Wanner.
+ *
+ *  Requires `k[0]` to hold the derivative at the initial time.
+ */
+double homemade_dopri5_simulation::initial_step()
+{
+    size_t const n = y0.size();
+    double const h_max = ntimes - 1.0;
+
+    double y_norm = 0.0;
+    double f_norm = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double const scale = abs_tol + rel_tol * std::abs(y[i]);
+        y_norm += (y[i] / scale) * (y[i] / scale);
+        f_norm += (k[0][i] / scale) * (k[0][i] / scale);
+    }
+    y_norm = std::sqrt(y_norm / n);
+    f_norm = std::sqrt(f_norm / n);
+
+    double h0 = (y_norm <= 1e-10 || f_norm <= 1e-10) ? 1e-6 : 0.01 * y_norm / f_norm;
+    h0 = std::min(h0, h_max);
+
+    // Estimate the second derivative using an explicit Euler step
+    for (size_t i = 0; i < n; ++i) {
+        y_stage[i] = y[i] + h0 * k[0][i];
+    }
+    calculate_derivative(y_stage, t + h0, k[1]);
+
+    double second = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double const scale = abs_tol + rel_tol * std::abs(y[i]);
+        second += ((k[1][i] - k[0][i]) / scale) * ((k[1][i] - k[0][i]) / scale);
+    }
+    second = std::sqrt(second / n) / h0;
+
+    double const largest = std::max(second, f_norm);
+    double const h1 = largest <= 1e-15 ? std::max(1e-6, h0 * 1e-3)
+                                       : std::pow(0.01 / largest, 0.2);
+
+    return std::min({100.0 * h0, h1, h_max});
+}
+
+/**
+ *  @brief Calculates the stages of a step of size `h` from `t` without
+ *  passing `t_end`, storing the new state in `y_new` and the derivative there
+ *  in `k[6]`.
+ *
+ *  Requires `k[0]` to hold the derivative at `t`.
+ *
+ *  @return The weighted norm of the local error estimate; the step should
+ *          only be accepted if it is no larger than 1
+ */
+double homemade_dopri5_simulation::attempt_step(double t_end)
+{
+    size_t const n = y0.size();
+
+    if (t + h > t_end) {
+        h = t_end - t;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        y_stage[i] = y[i] + h * a21 * k[0][i];
+    }
+    calculate_derivative(y_stage, t + c2 * h, k[1]);
+
+    for (size_t i = 0; i < n; ++i) {
+        y_stage[i] = y[i] + h * (a31 * k[0][i] + a32 * k[1][i]);
+    }
+    calculate_derivative(y_stage, t + c3 * h, k[2]);
+
+    for (size_t i = 0; i < n; ++i) {
+        y_stage[i] = y[i] + h * (a41 * k[0][i] + a42 * k[1][i] + a43 * k[2][i]);
+    }
+    calculate_derivative(y_stage, t + c4 * h, k[3]);
+
+    for (size_t i = 0; i < n; ++i) {
+        y_stage[i] = y[i] + h * (a51 * k[0][i] + a52 * k[1][i] +
+                                 a53 * k[2][i] + a54 * k[3][i]);
+    }
+    calculate_derivative(y_stage, t + c5 * h, k[4]);
+
+    for (size_t i = 0; i < n; ++i) {
+        y_stage[i] = y[i] + h * (a61 * k[0][i] + a62 * k[1][i] +
+                                 a63 * k[2][i] + a64 * k[3][i] +
+                                 a65 * k[4][i]);
+    }
+    calculate_derivative(y_stage, t + h, k[5]);
+
+    for (size_t i = 0; i < n; ++i) {
+        y_new[i] = y[i] + h * (b1 * k[0][i] + b3 * k[2][i] + b4 * k[3][i] +
+                               b5 * k[4][i] + b6 * k[5][i]);
+    }
+    calculate_derivative(y_new, t + h, k[6]);
+
+    double error = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double const estimate =
+            h * (e1 * k[0][i] + e3 * k[2][i] + e4 * k[3][i] + e5 * k[4][i] +
+                 e6 * k[5][i] + e7 * k[6][i]);
+        double const scale =
+            abs_tol + rel_tol * std::max(std::abs(y[i]), std::abs(y_new[i]));
+        error += (estimate / scale) * (estimate / scale);
+    }
+
+    return std::sqrt(error / n);
+}
+
+/**
+ *  @brief Stores the coefficients of the continuous extension for a step that
+ *  has just been accepted, before `y` and `k[0]` are updated.
+ */
+void homemade_dopri5_simulation::prepare_dense_output()
+{
+    size_t const n = y0.size();
+
+    for (size_t i = 0; i < n; ++i) {
+        double const difference = y_new[i] - y[i];
+        double const first = h * k[0][i] - difference;
+
+        dense[0][i] = y[i];
+        dense[1][i] = difference;
+        dense[2][i] = first;
+        dense[3][i] = difference - h * k[6][i] - first;
+        dense[4][i] = h * (d1 * k[0][i] + d3 * k[2][i] + d4 * k[3][i] +
+                           d5 * k[4][i] + d6 * k[5][i] + d7 * k[6][i]);
+    }
+}
+
+/**
+ *  @brief Finds one differential quantity at a time within the last step
+ *  using the continuous extension.
+ */
+double homemade_dopri5_simulation::interpolate_component(
+    double t_out,
+    size_t i) const
+{
+    double const theta = (t_out - t_old) / (t - t_old);
+    double const theta1 = 1.0 - theta;
+
+    return dense[0][i] +
+           theta * (dense[1][i] +
+                    theta1 * (dense[2][i] +
+                              theta * (dense[3][i] + theta1 * dense[4][i])));
+}
+
+/**
+ *  @brief Finds the differential quantities at a time within the last step
+ *  using the continuous extension.
+ */
+void homemade_dopri5_simulation::interpolate(
+    double t_out,
+    std::vector<double>& y_out) const
+{
+    for (size_t i = 0; i < y_out.size(); ++i) {
+        y_out[i] = interpolate_component(t_out, i);
+    }
+}
+
+/**
+ *  @brief Chooses the quantities and output times that are stored by
+ *  `run_simulation()` when no writer is used.
+ *
+ *  @param [in] quantity_names The names of the quantities to store; each must
+ *              be one of the names returned by `get_output_quantity_names()`
+ *
+ *  @param [in] decimation Only every `decimation`-th output time is stored,
+ *              starting with the first; a value of 1 stores all of them
+ */
+void homemade_dopri5_simulation::set_output_quantities(
+    string_vector const& quantity_names,
+    size_t decimation)
+{
+    if (decimation < 1) {
+        throw std::runtime_error("The output decimation must be at least 1");
+    }
+
+    string_vector const all_names = sys.get_output_quantity_names();
+    for (std::string const& name : quantity_names) {
+        if (std::find(all_names.begin(), all_names.end(), name) == all_names.end()) {
+            throw std::out_of_range(
+                "`" + name + "` is not an output quantity of the system");
+        }
+    }
+
+    output_quantity_names = quantity_names;
+    output_decimation = decimation;
+}
+
+/**
+ *  @brief Returns a pointer to the initial value of a differential quantity,
+ *  which can be used to change it before the next run.
+ */
+double* homemade_dopri5_simulation::get_initial_value_ptr(std::string const& name)
+{
+    string_vector const& names = sys.get_quantity_names();
+    auto const it = std::find(names.begin(), names.end(), name);
+
+    if (it == names.end()) {
+        throw std::out_of_range(
+            "`" + name + "` is not a differential quantity of the system");
+    }
+
+    return &y0[it - names.begin()];
+}
+
+/**
+ *  @brief Runs the simulation, returning the values of the selected
+ *  quantities at the selected output times; see `set_output_quantities()`.
+ *
+ *  When a writer is used, every quantity is passed to it at every output
+ *  time, since the writer performs its own selection.
+ */
+state_vector_map homemade_dopri5_simulation::run_simulation(
+    chunked_result_writer* writer)
+{
+    size_t const n = y0.size();
+    double const t_end = ntimes - 1.0;
+
+    t = t_old = 0.0;
+    y = y_old = y0;
+    naccepted = nrejected = nderivatives = 0;
+    largest_step = 0.0;
+    failed = false;
+    failure_time = 0.0;
+    occurrences.clear();
+    terminal_event_name.clear();
+    terminal_event_time = 0.0;
+
+    string_vector const all_names = sys.get_output_quantity_names();
+    string_vector const& names = writer ? all_names : output_quantity_names;
+    size_t const decimation = writer ? 1 : output_decimation;
+    std::vector<const double*> const ptrs = sys.get_quantity_access_ptrs(names);
+    std::vector<std::vector<double>> columns(writer ? 0 : names.size());
+
+    if (writer) {
+        writer->begin(names);
+    }
+
+    // Evaluates the system at an output time so all its quantities are
+    // up to date, then stores them or passes them to the writer; output
+    // times that are not kept are skipped without evaluating the system
+    std::vector<double> y_out = y0;
+    std::vector<double> f_out(n);
+    size_t output_index = 0;
+    auto record = [&](double time) {
+        if (output_index++ % decimation != 0) {
+            return;
+        }
+
+        sys.calculate_derivative(y_out, f_out, time);
+
+        if (writer) {
+            writer->add_row(ptrs);
+            return;
+        }
+
+        for (size_t j = 0; j < ptrs.size(); ++j) {
+            columns[j].push_back(*ptrs[j]);
+        }
+    };
+
+    // Events report the value of `time` when it is available
+    auto const time_name = std::find(all_names.begin(), all_names.end(), "time");
+    const double* time_ptr =
+        time_name == all_names.end()
+            ? nullptr
+            : sys.get_quantity_access_ptrs({"time"})[0];
+
+    detector.reset(y0);
+
+    // Checks for events during the last step
+    auto check_events = [&]() {
+        auto const component = [this](double time, size_t i) {
+            return interpolate_component(time, i);
+        };
+
+        for (auto const& c : detector.check_step(t_old, t, y, component)) {
+            simulation_event const& e = detector.get_event(c.event);
+
+            double event_time = c.time;
+            if (time_ptr) {
+                interpolate(c.time, y_out);
+                sys.calculate_derivative(y_out, f_out, c.time);
+                event_time = *time_ptr;
+            }
+
+            occurrences.push_back({e.name, event_time});
+
+            if (e.terminal) {
+                terminal_event_name = e.name;
+                terminal_event_time = c.time;
+            }
+        }
+    };
+
+    record(0.0);
+
+    if (n > 0) {
+        calculate_derivative(y, t, k[0]);
+        h = initial_step();
+    }
+
+    int attempts = 0;
+    bool last_rejected = false;
+    double previous_error = 1e-4;
+
+    for (size_t k_out = 1; k_out * output_step_size <= t_end + 1e-9; ++k_out) {
+        double const t_out = std::min(k_out * output_step_size, t_end);
+
+        // Take steps until the output time is within the last step
+        while (n > 0 && t < t_out) {
+            if (attempts >= max_steps || !(h > 1e-12)) {
+                failed = true;
+                failure_time = t;
+                break;
+            }
+            ++attempts;
+
+            double const error = attempt_step(t_end);
+
+            if (error > 1.0) {
+                ++nrejected;
+                last_rejected = true;
+                h *= std::min(1.0, safety * std::pow(error, -0.2));
+                continue;
+            }
+
+            ++naccepted;
+            largest_step = std::max(largest_step, h);
+
+            prepare_dense_output();
+            t_old = t;
+            t = t + h >= t_end ? t_end : t + h;
+            y_old.swap(y);
+            y.swap(y_new);
+            k[0].swap(k[6]);
+
+            if (!detector.empty() && terminal_event_name.empty()) {
+                check_events();
+            }
+
+            // The step size is not increased right after a rejection
+            double const factor = step_factor(error, previous_error);
+            h *= last_rejected ? std::min(1.0, factor) : factor;
+            last_rejected = false;
+            previous_error = std::max(error, 1e-4);
+        }
+
+        if (failed) {
+            break;
+        }
+
+        if (n > 0) {
+            interpolate(t_out, y_out);
+        }
+
+        record(t_out);
+        attempts = 0;
+
+        if (!terminal_event_name.empty() && t_out >= terminal_event_time) {
+            break;
+        }
+    }
+
+    state_vector_map result;
+
+    if (writer) {
+        writer->end();
+        return result;
+    }
+
+    for (size_t j = 0; j < names.size(); ++j) {
+        result[names[j]] = std::move(columns[j]);
+    }
+
+    return result;
+}
+
+std::string homemade_dopri5_simulation::generate_report() const
+{
+    std::ostringstream report;
+
+    report << "\nThe homemade_dopri5 ODE solver ";
+
+    if (failed) {
+        report << "stopped at time index " << failure_time
+               << " because it required more than " << max_steps
+               << " steps between two output times.\n";
+    } else if (!terminal_event_name.empty()) {
+        report << "stopped after the terminal event `" << terminal_event_name
+               << "` occurred at time index " << terminal_event_time << ".\n";
+    } else {
+        report << "reached the end of the drivers.\n";
+    }
+
+    report << "  Accepted steps: " << naccepted << "\n"
+           << "  Rejected steps: " << nrejected << "\n"
+           << "  Largest step: " << largest_step << " rows\n"
+           << "  Derivative calculations: " << nderivatives << "\n";
+
+    return report.str();
+}
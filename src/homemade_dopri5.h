@@ -0,0 +1,158 @@
+#ifndef HOMEMADE_DOPRI5_H
+#define HOMEMADE_DOPRI5_H
+
+#include <string>
+#include <vector>
+#include "framework/state_map.h"       // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"  // for mc_vector
+#include "persistent_system.h"         // for persistent_system
+#include "result_sink.h"               // for chunked_result_writer
+#include "simulation_events.h"         // for simulation_event, event_occurrence, event_detector
+
+/**
+ *  @class homemade_dopri5_simulation
+ *
+ *  @brief Runs a BioCro simulation using the Dormand-Prince 5(4) explicit
+ *  Runge-Kutta method with dense output.
+ *
+ *  Each step uses seven derivative calculations, one of which is reused by
+ *  the next step since the last stage is evaluated at the new state. The
+ *  difference between the fifth- and fourth-order solutions estimates the
+ *  local error, which is kept below the tolerances using the weighted
+ *  root-mean-square norm with weights
+ *  `1 / (rel_tol max(|y_old_i|, |y_new_i|) + abs_tol)`.
+ *
+ *  Unlike the framework's adaptive solvers, the steps are not shortened to
+ *  land on the output times. Instead, the results at the output times within
+ *  each step are found from the method's continuous extension, a polynomial
+ *  of degree four that uses the stages of the step, so smooth stretches of
+ *  the drivers can be covered by steps of many rows. The direct module
+ *  outputs are found by evaluating the system only at the output times.
+ *
+ *  If more than `max_steps` steps are attempted between two output times,
+ *  the integration stops and the result only includes the times that were
+ *  reached, as for the framework's adaptive solvers.
+ *
+ *  Events can be specified using `set_events()`. They are checked after each
+ *  step by an `event_detector` that locates crossings on the continuous
+ *  extension. The integration stops at the first output time at or after a
+ *  terminal event.
+ *
+ *  If a `chunked_result_writer` is passed to `run_simulation()`, each row of
+ *  the result is passed to it as soon as it has been calculated rather than
+ *  being stored, and the returned result is empty.
+ *
+ *  Otherwise, the returned result includes every quantity of the system at
+ *  each output time, unless a subset of the quantities and output times has
+ *  been chosen using `set_output_quantities()`. In that case, only the
+ *  selected quantities are stored, and the system is only evaluated at the
+ *  output times that are kept.
+ *
+ *  Each run starts from the stored initial values, so the simulation can be
+ *  run many times. The initial values and parameters can be changed between
+ *  runs through the pointers returned by `get_initial_value_ptr()` and
+ *  `get_parameter_ptr()`.
+ *
+ *  The module creators are not owned by this class; the code creating a
+ *  `homemade_dopri5_simulation` must make sure that they outlive it.
+ */
+class homemade_dopri5_simulation
+{
+   public:
+    homemade_dopri5_simulation(
+        state_map const& initial_values,
+        state_map const& parameters,
+        state_vector_map const& drivers,
+        mc_vector const& direct_mcs,
+        mc_vector const& differential_mcs,
+        double output_step_size,
+        double rel_tol,
+        double abs_tol,
+        int max_steps);
+
+    state_vector_map run_simulation(chunked_result_writer* writer = nullptr);
+
+    std::string generate_report() const;
+
+    void set_events(std::vector<simulation_event> const& new_events);
+
+    std::vector<event_occurrence> const& get_event_occurrences() const
+    {
+        return occurrences;
+    }
+
+    string_vector get_output_quantity_names() const
+    {
+        return sys.get_output_quantity_names();
+    }
+
+    void set_output_quantities(
+        string_vector const& quantity_names,
+        size_t decimation);
+
+    double* get_initial_value_ptr(std::string const& name);
+
+    double* get_parameter_ptr(std::string const& name)
+    {
+        return sys.get_parameter_ptr(name);
+    }
+
+    static std::string get_name() { return "homemade_dopri5"; }
+
+   private:
+    persistent_system sys;
+    size_t const ntimes;
+    double const output_step_size;
+    double const rel_tol;
+    double const abs_tol;
+    int const max_steps;
+    std::vector<double> y0;
+
+    // The quantities and output times that are stored
+    string_vector output_quantity_names;
+    size_t output_decimation;
+
+    // The state at the start and end of the last step
+    double t_old;
+    double t;
+    double h;
+    std::vector<double> y_old;
+    std::vector<double> y;
+
+    // The stages of the current step; `k[0]` is the derivative at the start
+    // of the step, and `k[6]` is the derivative at its end
+    std::vector<std::vector<double>> k;
+    std::vector<double> y_stage;
+    std::vector<double> y_new;
+
+    // The coefficients of the continuous extension for the last step
+    std::vector<std::vector<double>> dense;
+
+    // Events and the events that occurred
+    event_detector detector;
+    std::vector<event_occurrence> occurrences;
+    std::string terminal_event_name;
+    double terminal_event_time;
+
+    // Statistics for the report
+    int naccepted;
+    int nrejected;
+    int nderivatives;
+    double largest_step;
+    bool failed;
+    double failure_time;
+
+    void calculate_derivative(std::vector<double> const& x, double time, std::vector<double>& dxdt);
+
+    double initial_step();
+
+    double attempt_step(double t_end);
+
+    void prepare_dense_output();
+
+    void interpolate(double t_out, std::vector<double>& y_out) const;
+
+    double interpolate_component(double t_out, size_t i) const;
+};
+
+#endif
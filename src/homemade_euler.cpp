@@ -0,0 +1,230 @@
+#include <stdexcept>  // for std::runtime_error, std::out_of_range
+#include <algorithm>  // for std::find
+#include <sstream>    // for std::ostringstream
+#include <utility>    // for std::move
+#include "homemade_euler.h"
+
+namespace
+{
+std::vector<double> ordered_values(
+    state_map const& values,
+    string_vector const& names)
+{
+    std::vector<double> result;
+    for (std::string const& name : names) {
+        result.push_back(values.at(name));
+    }
+    return result;
+}
+
+// The name of the quantity holding the number of derivative calculations,
+// which the framework's solvers add to their results
+std::string const ncalls_name = "ncalls";
+}  // namespace
+
+homemade_euler_simulation::homemade_euler_simulation(
+    state_map const& initial_values,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs)
+    : sys{initial_values, keys(initial_values), parameters, drivers,
+          direct_mcs, differential_mcs},
+      ntimes{drivers.begin()->second.size()},
+      y0{ordered_values(initial_values, sys.get_quantity_names())},
+      output_quantity_names{get_output_quantity_names()},
+      output_decimation{1},
+      terminal_event_time{0.0},
+      nderivatives{0}
+{
+}
+
+/**
+ *  @brief Sets the events that are checked after each step; see
+ *  `simulation_event`.
+ */
+void homemade_euler_simulation::set_events(
+    std::vector<simulation_event> const& new_events)
+{
+    detector = event_detector(new_events, sys.get_quantity_names());
+}
+
+/**
+ *  @brief Returns the names of the quantities included in the result: the
+ *  quantities of the system, followed by `ncalls`.
+ */
+string_vector homemade_euler_simulation::get_output_quantity_names() const
+{
+    string_vector names = sys.get_output_quantity_names();
+    names.push_back(ncalls_name);
+    return names;
+}
+
+/**
+ *  @brief Chooses the quantities and rows that are stored by
+ *  `run_simulation()`.
+ *
+ *  @param [in] quantity_names The names of the quantities to store; each must
+ *              be one of the names returned by `get_output_quantity_names()`
+ *
+ *  @param [in] decimation Only every `decimation`-th row is stored, starting
+ *              with the first; a value of 1 stores all of them
+ */
+void homemade_euler_simulation::set_output_quantities(
+    string_vector const& quantity_names,
+    size_t decimation)
+{
+    if (decimation < 1) {
+        throw std::runtime_error("The output decimation must be at least 1");
+    }
+
+    string_vector const all_names = get_output_quantity_names();
+    for (std::string const& name : quantity_names) {
+        if (std::find(all_names.begin(), all_names.end(), name) == all_names.end()) {
+            throw std::out_of_range(
+                "`" + name + "` is not an output quantity of the system");
+        }
+    }
+
+    output_quantity_names = quantity_names;
+    output_decimation = decimation;
+}
+
+/**
+ *  @brief Returns a pointer to the initial value of a differential quantity,
+ *  which can be used to change it before the next run.
+ */
+double* homemade_euler_simulation::get_initial_value_ptr(std::string const& name)
+{
+    string_vector const& names = sys.get_quantity_names();
+    auto const it = std::find(names.begin(), names.end(), name);
+
+    if (it == names.end()) {
+        throw std::out_of_range(
+            "`" + name + "` is not a differential quantity of the system");
+    }
+
+    return &y0[it - names.begin()];
+}
+
+/**
+ *  @brief Runs the simulation, returning the values of the selected
+ *  quantities at the selected rows; see `set_output_quantities()`.
+ */
+state_vector_map homemade_euler_simulation::run_simulation()
+{
+    size_t const n = y0.size();
+
+    std::vector<double> y = y0;
+    std::vector<double> y_old = y0;
+    std::vector<double> dxdt(n);
+    nderivatives = 0;
+    occurrences.clear();
+    terminal_event_name.clear();
+    terminal_event_time = 0.0;
+
+    // The number of derivative calculations is only known at the end, so it
+    // is added to the result separately
+    string_vector names;
+    bool include_ncalls = false;
+    for (std::string const& name : output_quantity_names) {
+        if (name == ncalls_name) {
+            include_ncalls = true;
+        } else {
+            names.push_back(name);
+        }
+    }
+
+    std::vector<const double*> const ptrs = sys.get_quantity_access_ptrs(names);
+    std::vector<std::vector<double>> columns(names.size());
+    size_t nrows = 0;
+
+    // Events report the value of `time` when it is available
+    string_vector const all_names = sys.get_output_quantity_names();
+    auto const time_name = std::find(all_names.begin(), all_names.end(), "time");
+    const double* time_ptr =
+        time_name == all_names.end()
+            ? nullptr
+            : sys.get_quantity_access_ptrs({"time"})[0];
+
+    detector.reset(y0);
+    double time_old = 0.0;
+
+    for (size_t row = 0; row < ntimes; ++row) {
+        double const t = row;
+
+        // Calculating the derivative also updates all the quantities in this
+        // row, so they can be stored right away
+        sys.calculate_derivative(y, dxdt, t);
+        ++nderivatives;
+
+        if (row % output_decimation == 0) {
+            for (size_t j = 0; j < ptrs.size(); ++j) {
+                columns[j].push_back(*ptrs[j]);
+            }
+            ++nrows;
+        }
+
+        double const time_value = time_ptr ? *time_ptr : t;
+
+        if (row > 0 && !detector.empty()) {
+            double const t_old = t - 1.0;
+
+            auto const component = [&](double time, size_t i) {
+                return y_old[i] + (time - t_old) * (y[i] - y_old[i]);
+            };
+
+            for (auto const& c : detector.check_step(t_old, t, y, component)) {
+                simulation_event const& e = detector.get_event(c.event);
+
+                occurrences.push_back(
+                    {e.name, time_old + (c.time - t_old) * (time_value - time_old)});
+
+                if (e.terminal) {
+                    terminal_event_name = e.name;
+                    terminal_event_time = c.time;
+                }
+            }
+        }
+
+        if (!terminal_event_name.empty() || row + 1 == ntimes) {
+            break;
+        }
+
+        time_old = time_value;
+        y_old = y;
+        for (size_t i = 0; i < n; ++i) {
+            y[i] += dxdt[i];
+        }
+    }
+
+    state_vector_map result;
+
+    for (size_t j = 0; j < names.size(); ++j) {
+        result[names[j]] = std::move(columns[j]);
+    }
+
+    if (include_ncalls) {
+        result[ncalls_name] = std::vector<double>(nrows, nderivatives);
+    }
+
+    return result;
+}
+
+std::string homemade_euler_simulation::generate_report() const
+{
+    std::ostringstream report;
+
+    report << "\nThe homemade_euler ODE solver ";
+
+    if (!terminal_event_name.empty()) {
+        report << "stopped after the terminal event `" << terminal_event_name
+               << "` occurred at time index " << terminal_event_time << ".\n";
+    } else {
+        report << "reached the end of the drivers.\n";
+    }
+
+    report << "  Derivative calculations: " << nderivatives << "\n";
+
+    return report.str();
+}
@@ -0,0 +1,98 @@
+#ifndef HOMEMADE_EULER_H
+#define HOMEMADE_EULER_H
+
+#include <string>
+#include <vector>
+#include "framework/state_map.h"       // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"  // for mc_vector
+#include "persistent_system.h"         // for persistent_system
+#include "simulation_events.h"         // for simulation_event, event_occurrence, event_detector
+
+/**
+ *  @class homemade_euler_simulation
+ *
+ *  @brief Runs a BioCro simulation using the Euler method with a fixed step of
+ *  one row of the drivers, reproducing the framework's `homemade_euler` ODE
+ *  solver with a `persistent_system`.
+ *
+ *  As with the framework's solver, the output step size is ignored, the
+ *  derivative is calculated once at each row of the drivers (including the
+ *  last one), and the result includes an `ncalls` quantity holding the number
+ *  of derivative calculations. The direct module outputs in each row are the
+ *  ones found while calculating the derivative there, so no additional
+ *  derivative calculations are needed to produce the result.
+ *
+ *  Events can be specified using `set_events()`. Since the Euler method moves
+ *  in a straight line between rows, they are located by linear interpolation
+ *  between rows, as done by `find_events_in_result()` for the framework's
+ *  solvers. The integration stops at the first row at or after a terminal
+ *  event.
+ *
+ *  The returned result includes every quantity of the system at each row,
+ *  unless a subset of the quantities and rows has been chosen using
+ *  `set_output_quantities()`.
+ *
+ *  Each run starts from the stored initial values, so the simulation can be
+ *  run many times. The initial values and parameters can be changed between
+ *  runs through the pointers returned by `get_initial_value_ptr()` and
+ *  `get_parameter_ptr()`.
+ *
+ *  The module creators are not owned by this class; the code creating a
+ *  `homemade_euler_simulation` must make sure that they outlive it.
+ */
+class homemade_euler_simulation
+{
+   public:
+    homemade_euler_simulation(
+        state_map const& initial_values,
+        state_map const& parameters,
+        state_vector_map const& drivers,
+        mc_vector const& direct_mcs,
+        mc_vector const& differential_mcs);
+
+    state_vector_map run_simulation();
+
+    std::string generate_report() const;
+
+    void set_events(std::vector<simulation_event> const& new_events);
+
+    std::vector<event_occurrence> const& get_event_occurrences() const
+    {
+        return occurrences;
+    }
+
+    string_vector get_output_quantity_names() const;
+
+    void set_output_quantities(
+        string_vector const& quantity_names,
+        size_t decimation);
+
+    double* get_initial_value_ptr(std::string const& name);
+
+    double* get_parameter_ptr(std::string const& name)
+    {
+        return sys.get_parameter_ptr(name);
+    }
+
+    static std::string get_name() { return "homemade_euler"; }
+
+   private:
+    persistent_system sys;
+    size_t const ntimes;
+    std::vector<double> y0;
+
+    // The quantities and rows that are stored
+    string_vector output_quantity_names;
+    size_t output_decimation;
+
+    // Events and the events that occurred
+    event_detector detector;
+    std::vector<event_occurrence> occurrences;
+    std::string terminal_event_name;
+    double terminal_event_time;
+
+    // Statistics for the report
+    int nderivatives;
+};
+
+#endif
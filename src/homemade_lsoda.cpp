@@ -0,0 +1,989 @@
+#include <stdexcept>  // for std::runtime_error, std::out_of_range
+#include <algorithm>  // for std::min, std::max, std::swap, std::find
+#include <cmath>      // for std::abs, std::pow, std::sqrt
+#include <limits>     // for std::numeric_limits
+#include <sstream>    // for std::ostringstream
+#include "homemade_lsoda.h"
+
+namespace
+{
+int const max_order = 5;
+
+// The maximum number of corrector iterations in each step
+int const max_iterations = 3;
+
+// The number of consecutive steps favoring the other method that cause a
+// switch between Adams and BDF
+int const switch_threshold = 5;
+
+// The Adams functional iteration converges when `h l_0 ||df/dx||` is below
+// 1; keeping it below this value ensures it converges quickly
+double const adams_rate_limit = 0.5;
+
+// The BDF Jacobian is recalculated after this many steps
+int const max_steps_per_jacobian = 20;
+
+/**
+ *  @brief Multiplies a polynomial, stored as a vector of coefficients in order
+ *  of increasing degree, by `a + b x`.
+ */
+void multiply_linear(std::vector<double>& p, double a, double b)
+{
+    p.push_back(0.0);
+    for (size_t k = p.size() - 1; k > 0; --k) {
+        p[k] = a * p[k] + b * p[k - 1];
+    }
+    p[0] *= a;
+}
+
+/**
+ *  @brief Returns the Nordsieck correction vector `l` for a method and order,
+ *  normalized so that `l_1 = 1`.
+ *
+ *  For BDF of order `q`, `l` holds the coefficients of the polynomial
+ *  `prod_{j = 1}^q (1 + x / j)`. For Adams-Moulton of order `q`, it holds the
+ *  coefficients of the polynomial `L(x)` with `L(-1) = 0` whose derivative is
+ *  `prod_{j = 1}^{q - 1} (1 + x / j)`.
+ */
+std::vector<double> nordsieck_coefficients(bool bdf, int q)
+{
+    std::vector<double> p{1.0};
+
+    if (bdf) {
+        for (int j = 1; j <= q; ++j) {
+            multiply_linear(p, 1.0, 1.0 / j);
+        }
+    } else {
+        for (int j = 1; j < q; ++j) {
+            multiply_linear(p, 1.0, 1.0 / j);
+        }
+
+        // Integrate, choosing the constant term so that L(-1) = 0
+        std::vector<double> integral{0.0};
+        double value_at_minus_one = 0.0;
+        for (size_t k = 0; k < p.size(); ++k) {
+            integral.push_back(p[k] / (k + 1));
+            value_at_minus_one += integral.back() * ((k + 1) % 2 == 0 ? 1.0 : -1.0);
+        }
+        integral[0] = -value_at_minus_one;
+        p = integral;
+    }
+
+    double const l1 = p[1];
+    for (double& c : p) {
+        c /= l1;
+    }
+
+    return p;
+}
+
+/**
+ *  @brief Returns the magnitude of the error constant `C` of a method and
+ *  order, such that its local truncation error is `C h^(q + 1) y^(q + 1)`.
+ */
+double error_constant(bool bdf, int q)
+{
+    if (bdf) {
+        return nordsieck_coefficients(true, q)[0] / (q + 1);
+    }
+
+    // For Adams-Moulton, C is the integral of binomial(1 - s, q) from s = 0
+    // to s = 1
+    std::vector<double> p{1.0};
+    for (int j = 0; j < q; ++j) {
+        multiply_linear(p, (1.0 - j) / (j + 1), -1.0 / (j + 1));
+    }
+
+    double integral = 0.0;
+    for (size_t k = 0; k < p.size(); ++k) {
+        integral += p[k] / (k + 1);
+    }
+
+    return std::abs(integral);
+}
+
+double factorial(int q)
+{
+    double result = 1.0;
+    for (int j = 2; j <= q; ++j) {
+        result *= j;
+    }
+    return result;
+}
+
+/**
+ *  @brief Returns the weighted root-mean-square norm of a vector.
+ */
+double weighted_norm(
+    std::vector<double> const& v,
+    std::vector<double> const& weights)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < v.size(); ++i) {
+        double const x = v[i] * weights[i];
+        sum += x * x;
+    }
+    return std::sqrt(sum / v.size());
+}
+
+double max_norm(std::vector<double> const& v)
+{
+    double result = 0.0;
+    for (double x : v) {
+        result = std::max(result, std::abs(x));
+    }
+    return result;
+}
+
+// Returns the factor by which the step size can change so that the error
+// estimate of a method of order `q` would meet the tolerances, divided by a
+// safety factor `bias` as in LSODE
+double step_factor(double error, double bias, int q)
+{
+    return 1.0 / (bias * std::pow(error, 1.0 / (q + 1)) + 1e-6);
+}
+
+/**
+ *  @brief Calculates the LU factorization of a square matrix with partial
+ *  pivoting, in place. Returns `false` if the matrix is singular.
+ */
+bool lu_factor(std::vector<double>& a, std::vector<size_t>& pivots, size_t n)
+{
+    pivots.resize(n);
+
+    for (size_t k = 0; k < n; ++k) {
+        size_t p = k;
+        for (size_t i = k + 1; i < n; ++i) {
+            if (std::abs(a[i + k * n]) > std::abs(a[p + k * n])) {
+                p = i;
+            }
+        }
+
+        pivots[k] = p;
+
+        if (a[p + k * n] == 0.0) {
+            return false;
+        }
+
+        if (p != k) {
+            for (size_t j = 0; j < n; ++j) {
+                std::swap(a[k + j * n], a[p + j * n]);
+            }
+        }
+
+        for (size_t i = k + 1; i < n; ++i) {
+            a[i + k * n] /= a[k + k * n];
+        }
+
+        for (size_t j = k + 1; j < n; ++j) {
+            double const akj = a[k + j * n];
+            if (akj != 0.0) {
+                for (size_t i = k + 1; i < n; ++i) {
+                    a[i + j * n] -= a[i + k * n] * akj;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ *  @brief Solves `A x = b` in place using the factorization from
+ *  `lu_factor()`.
+ */
+void lu_solve(
+    std::vector<double> const& a,
+    std::vector<size_t> const& pivots,
+    std::vector<double>& b)
+{
+    size_t const n = b.size();
+
+    for (size_t k = 0; k < n; ++k) {
+        std::swap(b[k], b[pivots[k]]);
+        for (size_t i = k + 1; i < n; ++i) {
+            b[i] -= a[i + k * n] * b[k];
+        }
+    }
+
+    for (size_t k = n; k-- > 0;) {
+        b[k] /= a[k + k * n];
+        for (size_t i = 0; i < k; ++i) {
+            b[i] -= a[i + k * n] * b[k];
+        }
+    }
+}
+
+std::vector<double> ordered_values(
+    state_map const& values,
+    string_vector const& names)
+{
+    std::vector<double> result;
+    for (std::string const& name : names) {
+        result.push_back(values.at(name));
+    }
+    return result;
+}
+}  // namespace
+
+homemade_lsoda_simulation::homemade_lsoda_simulation(
+    state_map const& initial_values,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs,
+    double output_step_size,
+    double rel_tol,
+    double abs_tol,
+    int max_steps)
+    : sys{initial_values, keys(initial_values), parameters, drivers,
+          direct_mcs, differential_mcs},
+      ntimes{drivers.begin()->second.size()},
+      output_step_size{output_step_size},
+      rel_tol{rel_tol},
+      abs_tol{abs_tol},
+      max_steps{max_steps},
+      y0{ordered_values(initial_values, sys.get_quantity_names())},
+      output_quantity_names{sys.get_output_quantity_names()},
+      output_decimation{1}
+{
+    if (!(output_step_size > 0.0)) {
+        throw std::runtime_error(
+            "The output step size of the homemade_lsoda ODE solver must be positive");
+    }
+
+    if (!(rel_tol >= 0.0) || !(abs_tol > 0.0)) {
+        throw std::runtime_error(
+            "The homemade_lsoda ODE solver requires a positive absolute error "
+            "tolerance and a non-negative relative error tolerance");
+    }
+
+    if (max_steps < 1) {
+        throw std::runtime_error(
+            "The homemade_lsoda ODE solver requires a positive maximum number of steps");
+    }
+
+    size_t const n = y0.size();
+
+    z.assign(max_order + 2, std::vector<double>(n, 0.0));
+    z_saved = z;
+    weights.resize(n);
+    y.resize(n);
+    f.resize(n);
+    delta.resize(n);
+    delta_prev.resize(n);
+    correction.resize(n);
+}
+
+void homemade_lsoda_simulation::calculate_derivative(
+    std::vector<double> const& x,
+    double time)
+{
+    sys.calculate_derivative(x, f, time);
+    ++nderivatives;
+}
+
+void homemade_lsoda_simulation::update_jacobian()
+{
+    size_t const n = y0.size();
+
+    sys.calculate_jacobian(z[0], jacobian, t);
+    nderivatives += 1 + sys.get_jacobian_sparsity().ncolors();
+    ++njacobians;
+
+    // The infinity norm bounds the magnitude of the Jacobian's eigenvalues
+    jacobian_norm = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double row_sum = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            row_sum += std::abs(jacobian[i + j * n]);
+        }
+        jacobian_norm = std::max(jacobian_norm, row_sum);
+    }
+
+    jacobian_current = true;
+    steps_since_jacobian = 0;
+    hl0_at_lu = 0.0;  // Forces a new factorization
+}
+
+bool homemade_lsoda_simulation::factor_iteration_matrix(double hl0)
+{
+    if (hl0 == hl0_at_lu) {
+        return true;
+    }
+
+    size_t const n = y0.size();
+
+    lu.resize(n * n);
+    for (size_t k = 0; k < n * n; ++k) {
+        lu[k] = -hl0 * jacobian[k];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        lu[i + i * n] += 1.0;
+    }
+
+    hl0_at_lu = hl0;
+
+    if (!lu_factor(lu, pivots, n)) {
+        hl0_at_lu = 0.0;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ *  @brief Changes the step size by a factor of `eta`, rescaling the Nordsieck
+ *  array accordingly.
+ */
+void homemade_lsoda_simulation::rescale(double eta)
+{
+    double factor = 1.0;
+    for (int j = 1; j <= order; ++j) {
+        factor *= eta;
+        for (double& v : z[j]) {
+            v *= factor;
+        }
+    }
+
+    // delta is proportional to h^(q + 1)
+    factor *= eta;
+    for (double& v : delta_prev) {
+        v *= factor;
+    }
+
+    h *= eta;
+}
+
+/**
+ *  @brief Solves the corrector equation `delta = h f(z_0 + l_0 delta) - z_1`
+ *  for the predicted Nordsieck array, using functional iteration for Adams
+ *  and a modified Newton iteration for BDF.
+ *
+ *  @return Whether the iteration converged
+ */
+bool homemade_lsoda_simulation::correct(
+    double t_new,
+    std::vector<double> const& l)
+{
+    size_t const n = y0.size();
+    double const hl0 = h * l[0];
+    double const error_coefficient =
+        error_constant(meth == method::bdf, order) * factorial(order) * l[order];
+
+    if (meth == method::bdf && !factor_iteration_matrix(hl0)) {
+        return false;
+    }
+
+    std::fill(delta.begin(), delta.end(), 0.0);
+    y = z[0];
+
+    double rate = 1.0;
+    double previous_norm = 0.0;
+    double previous_max = 0.0;
+
+    for (size_t i = 0; i < n; ++i) {
+        correction[i] = std::abs(z[0][i]);
+    }
+    double const roundoff_norm = 100.0 *
+                                 std::numeric_limits<double>::epsilon() *
+                                 weighted_norm(correction, weights);
+
+    for (int m = 0; m < max_iterations; ++m) {
+        calculate_derivative(y, t_new);
+
+        for (size_t i = 0; i < n; ++i) {
+            correction[i] = h * f[i] - z[1][i] - delta[i];
+        }
+
+        if (meth == method::bdf) {
+            lu_solve(lu, pivots, correction);
+        }
+
+        double const norm = weighted_norm(correction, weights);
+        double const max = max_norm(correction);
+
+        // Once the corrections are as small as the rounding errors in the
+        // state, their ratio says nothing about the rate of convergence
+        if (m > 0 && norm <= roundoff_norm) {
+            return true;
+        }
+
+        if (m > 0) {
+            double const ratio = norm / previous_norm;
+            rate = std::max(0.2 * rate, ratio);
+
+            // For functional iteration, the ratio of successive corrections
+            // is approximately h l_0 ||df/dx||. The unweighted norm is used
+            // here since the weights can make the first ratio much larger
+            // than the spectral radius of df/dx.
+            if (meth == method::adams && previous_max > 0.0) {
+                adams_rho = max / previous_max / hl0;
+            }
+
+            // As in LSODE, the first ratio is not used to detect divergence,
+            // since corrections can be transferred between quantities with
+            // very different weights before they decrease
+            if (m > 1 && ratio > 2.0) {
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            delta[i] += correction[i];
+            y[i] = z[0][i] + l[0] * delta[i];
+        }
+
+        if (error_coefficient * norm * std::min(1.0, 1.5 * rate) <= 0.1) {
+            return true;
+        }
+
+        previous_norm = norm;
+        previous_max = max;
+    }
+
+    return false;
+}
+
+/**
+ *  @brief Attempts to take one step without passing `t_end`, retrying with
+ *  smaller steps or lower orders as necessary.
+ *
+ *  @param [in, out] attempts The number of attempted steps since the last
+ *                   output time, which is increased for each attempt
+ *
+ *  @return Whether a step was taken before `max_steps` attempts were made
+ */
+bool homemade_lsoda_simulation::take_step(double t_end, int& attempts)
+{
+    size_t const n = y0.size();
+    int error_failures = 0;
+    bool clipped = false;
+
+    if (t + h >= t_end) {
+        rescale((t_end - t) / h);
+        clipped = true;
+    }
+
+    while (true) {
+        if (attempts >= max_steps || !(h > 1e-12)) {
+            return false;
+        }
+        ++attempts;
+
+        bool const bdf = meth == method::bdf;
+        std::vector<double> const l = nordsieck_coefficients(bdf, order);
+
+        for (size_t i = 0; i < n; ++i) {
+            weights[i] = 1.0 / (rel_tol * std::abs(z[0][i]) + abs_tol);
+        }
+
+        if (bdf && steps_since_jacobian >= max_steps_per_jacobian) {
+            update_jacobian();
+        }
+
+        // Predict the Nordsieck array at the new time using Pascal's triangle
+        for (int j = 0; j <= order; ++j) {
+            z_saved[j] = z[j];
+        }
+
+        for (int k = 0; k < order; ++k) {
+            for (int j = order; j > k; --j) {
+                for (size_t i = 0; i < n; ++i) {
+                    z[j - 1][i] += z[j][i];
+                }
+            }
+        }
+
+        double const t_new = clipped ? t_end : t + h;
+
+        if (!correct(t_new, l)) {
+            ++nconvergence_failures;
+
+            for (int j = 0; j <= order; ++j) {
+                z[j] = z_saved[j];
+            }
+
+            delta_prev_valid = false;
+
+            if (bdf && !jacobian_current) {
+                // Try again with a new Jacobian before reducing the step
+                update_jacobian();
+            } else {
+                if (!bdf) {
+                    // Convergence failures of the functional iteration are a
+                    // sign of stiffness
+                    ++switch_count;
+                }
+                rescale(0.25);
+                steps_since_change = 0;
+                clipped = false;
+            }
+
+            continue;
+        }
+
+        double const error =
+            error_constant(bdf, order) * factorial(order) * l[order] *
+            weighted_norm(delta, weights);
+
+        if (error > 1.0) {
+            ++nerror_failures;
+            ++error_failures;
+
+            for (int j = 0; j <= order; ++j) {
+                z[j] = z_saved[j];
+            }
+
+            delta_prev_valid = false;
+
+            if (error_failures >= 3 && order > 1) {
+                // Restart from first order using the current derivative
+                calculate_derivative(z[0], t);
+                for (size_t i = 0; i < n; ++i) {
+                    z[1][i] = h * f[i];
+                }
+                order = 1;
+                rescale(0.1);
+            } else {
+                double const eta = step_factor(error, 1.2, order);
+                rescale(std::max(0.1, std::min(0.9, eta)));
+            }
+
+            steps_since_change = 0;
+
+            clipped = false;
+            continue;
+        }
+
+        // The step is accepted
+        for (int j = 0; j <= order; ++j) {
+            for (size_t i = 0; i < n; ++i) {
+                z[j][i] += l[j] * delta[i];
+            }
+        }
+
+        t = t_new;
+        ++nsteps;
+        ++steps_since_change;
+        ++steps_since_jacobian;
+        jacobian_current = false;
+
+        if (bdf) {
+            ++nsteps_bdf;
+        } else {
+            ++nsteps_adams;
+        }
+
+        select_step_and_order(l, error_failures > 0 ? std::max(error, 1.0) : error);
+
+        return true;
+    }
+}
+
+/**
+ *  @brief Chooses the step size, order, and method for the next step after a
+ *  successful one.
+ *
+ *  As in LSODE, the step size and order are only reconsidered once `q + 1`
+ *  steps have been taken since they last changed, so the higher columns of
+ *  the Nordsieck array have time to settle. The step size factor for the
+ *  current order comes from its error estimate; factors for orders `q - 1`
+ *  and `q + 1` are estimated from the last column of the Nordsieck array and
+ *  the difference between the last two corrections, and the order with the
+ *  largest factor is used. Nothing changes unless the step size would
+ *  increase by at least 10%, so the BDF iteration matrix can be reused.
+ *
+ *  @param [in] error The error estimate of the step; when the step followed
+ *              a failed attempt, it is at least 1 so the step size does not
+ *              increase
+ */
+void homemade_lsoda_simulation::select_step_and_order(
+    std::vector<double> const& l,
+    double error)
+{
+    size_t const n = y0.size();
+    bool const bdf = meth == method::bdf;
+    double const eta_same = step_factor(error, 1.2, order);
+
+    // Count the steps favoring the other method
+    double h_limit = std::numeric_limits<double>::infinity();
+    if (!bdf) {
+        // The step size is limited by the convergence of the functional
+        // iteration rather than by accuracy; a limit of more than one row of
+        // the drivers is irrelevant since steps never exceed one row
+        if (adams_rho > 0.0) {
+            h_limit = adams_rate_limit / (l[0] * adams_rho);
+        }
+        bool const limited = h_limit < 1.0 && h * eta_same > h_limit;
+        switch_count = limited ? switch_count + 1 : 0;
+    } else {
+        // The functional iteration would converge at the current step size
+        double const adams_l0 = nordsieck_coefficients(false, order)[0];
+        bool const adams_would_converge =
+            h * adams_l0 * jacobian_norm < 0.5 * adams_rate_limit;
+        switch_count = adams_would_converge ? switch_count + 1 : 0;
+    }
+
+    if (switch_count >= switch_threshold) {
+        meth = bdf ? method::adams : method::bdf;
+        switch_count = 0;
+        steps_since_change = 0;
+        delta_prev_valid = false;
+        adams_rho = 0.0;
+        ++nswitches;
+
+        if (meth == method::bdf) {
+            update_jacobian();
+        }
+
+        return;
+    }
+
+    double eta = eta_same;
+    int new_order = order;
+
+    if (steps_since_change > order) {
+        if (order > 1) {
+            double const error_down =
+                error_constant(bdf, order - 1) * factorial(order) *
+                weighted_norm(z[order], weights);
+            double const eta_down = step_factor(error_down, 1.3, order - 1);
+            if (eta_down > eta) {
+                eta = eta_down;
+                new_order = order - 1;
+            }
+        }
+
+        if (order < max_order && delta_prev_valid) {
+            for (size_t i = 0; i < n; ++i) {
+                correction[i] = delta[i] - delta_prev[i];
+            }
+            double const error_up =
+                error_constant(bdf, order + 1) * factorial(order) * l[order] *
+                weighted_norm(correction, weights);
+            double const eta_up = step_factor(error_up, 1.4, order + 1);
+            if (eta_up > eta) {
+                eta = eta_up;
+                new_order = order + 1;
+            }
+        }
+    } else {
+        eta = 1.0;
+    }
+
+    delta_prev = delta;
+    delta_prev_valid = true;
+
+    // The step size is capped at one row of the drivers (a step may still
+    // cross a row boundary), and Adams steps must allow the functional
+    // iteration to converge
+    eta = std::min({eta, 10.0, 1.0 / h, h_limit / h});
+
+    if (eta < 1.1 && h <= h_limit) {
+        return;
+    }
+
+    if (new_order > order) {
+        for (size_t i = 0; i < n; ++i) {
+            z[new_order][i] = l[order] * delta[i] / new_order;
+        }
+    }
+
+    if (new_order != order) {
+        order = new_order;
+        delta_prev_valid = false;
+    }
+
+    steps_since_change = 0;
+    rescale(eta);
+}
+
+/**
+ *  @brief Finds the differential quantities at a time within the last step by
+ *  evaluating the polynomial represented by the Nordsieck array.
+ */
+void homemade_lsoda_simulation::interpolate(
+    double t_out,
+    std::vector<double>& y_out) const
+{
+    double const s = (t_out - t) / h;
+
+    y_out = z[order];
+    for (int j = order - 1; j >= 0; --j) {
+        for (size_t i = 0; i < y_out.size(); ++i) {
+            y_out[i] = y_out[i] * s + z[j][i];
+        }
+    }
+}
+
+/**
+ *  @brief Finds one differential quantity at a time within the last step; see
+ *  `interpolate()`.
+ */
+double homemade_lsoda_simulation::interpolate_component(
+    double t_out,
+    size_t i) const
+{
+    double const s = (t_out - t) / h;
+
+    double value = z[order][i];
+    for (int j = order - 1; j >= 0; --j) {
+        value = value * s + z[j][i];
+    }
+
+    return value;
+}
+
+/**
+ *  @brief Sets the events that are checked after each step; see
+ *  `simulation_event`.
+ */
+void homemade_lsoda_simulation::set_events(
+    std::vector<simulation_event> const& new_events)
+{
+    detector = event_detector(new_events, sys.get_quantity_names());
+}
+
+/**
+ *  @brief Chooses the quantities and output times that are stored by
+ *  `run_simulation()` when no writer is used.
+ *
+ *  @param [in] quantity_names The names of the quantities to store; each must
+ *              be one of the names returned by `get_output_quantity_names()`
+ *
+ *  @param [in] decimation Only every `decimation`-th output time is stored,
+ *              starting with the first; a value of 1 stores all of them
+ */
+void homemade_lsoda_simulation::set_output_quantities(
+    string_vector const& quantity_names,
+    size_t decimation)
+{
+    if (decimation < 1) {
+        throw std::runtime_error("The output decimation must be at least 1");
+    }
+
+    string_vector const all_names = sys.get_output_quantity_names();
+    for (std::string const& name : quantity_names) {
+        if (std::find(all_names.begin(), all_names.end(), name) == all_names.end()) {
+            throw std::out_of_range(
+                "`" + name + "` is not an output quantity of the system");
+        }
+    }
+
+    output_quantity_names = quantity_names;
+    output_decimation = decimation;
+}
+
+/**
+ *  @brief Returns a pointer to the initial value of a differential quantity,
+ *  which can be used to change it before the next run.
+ */
+double* homemade_lsoda_simulation::get_initial_value_ptr(std::string const& name)
+{
+    string_vector const& names = sys.get_quantity_names();
+    auto const it = std::find(names.begin(), names.end(), name);
+
+    if (it == names.end()) {
+        throw std::out_of_range(
+            "`" + name + "` is not a differential quantity of the system");
+    }
+
+    return &y0[it - names.begin()];
+}
+
+/**
+ *  @brief Runs the simulation, returning the values of the selected
+ *  quantities at the selected output times; see `set_output_quantities()`.
+ *
+ *  When a writer is used, every quantity is passed to it at every output
+ *  time, since the writer performs its own selection.
+ */
+state_vector_map homemade_lsoda_simulation::run_simulation(
+    chunked_result_writer* writer)
+{
+    size_t const n = y0.size();
+    double const t_end = ntimes - 1.0;
+
+    meth = method::adams;
+    order = 1;
+    t = 0.0;
+    delta_prev_valid = false;
+    steps_since_change = 0;
+    jacobian_norm = 0.0;
+    hl0_at_lu = 0.0;
+    jacobian_current = false;
+    steps_since_jacobian = 0;
+    adams_rho = 0.0;
+    switch_count = 0;
+    nsteps = nsteps_adams = nsteps_bdf = 0;
+    nerror_failures = nconvergence_failures = nswitches = 0;
+    nderivatives = njacobians = 0;
+    failed = false;
+    failure_time = 0.0;
+    occurrences.clear();
+    terminal_event_name.clear();
+    terminal_event_time = 0.0;
+
+    string_vector const all_names = sys.get_output_quantity_names();
+    string_vector const& names = writer ? all_names : output_quantity_names;
+    size_t const decimation = writer ? 1 : output_decimation;
+    std::vector<const double*> const ptrs = sys.get_quantity_access_ptrs(names);
+    std::vector<std::vector<double>> columns(writer ? 0 : names.size());
+
+    if (writer) {
+        writer->begin(names);
+    }
+
+    // Evaluates the system at an output time so all its quantities are
+    // up to date, then stores them or passes them to the writer; output
+    // times that are not kept are skipped without evaluating the system
+    std::vector<double> y_out = y0;
+    std::vector<double> f_out(n);
+    size_t output_index = 0;
+    auto record = [&](double time) {
+        if (output_index++ % decimation != 0) {
+            return;
+        }
+
+        sys.calculate_derivative(y_out, f_out, time);
+
+        if (writer) {
+            writer->add_row(ptrs);
+            return;
+        }
+
+        for (size_t k = 0; k < ptrs.size(); ++k) {
+            columns[k].push_back(*ptrs[k]);
+        }
+    };
+
+    record(0.0);
+
+    // Events report the value of `time` when it is available
+    auto const time_name = std::find(all_names.begin(), all_names.end(), "time");
+    const double* time_ptr =
+        time_name == all_names.end()
+            ? nullptr
+            : sys.get_quantity_access_ptrs({"time"})[0];
+
+    detector.reset(y0);
+
+    // Checks for events during the last step, which began at `t_prev`
+    auto check_events = [&](double t_prev) {
+        auto const component = [this](double time, size_t i) {
+            return interpolate_component(time, i);
+        };
+
+        for (auto const& c : detector.check_step(t_prev, t, z[0], component)) {
+            simulation_event const& e = detector.get_event(c.event);
+
+            double event_time = c.time;
+            if (time_ptr) {
+                interpolate(c.time, y_out);
+                sys.calculate_derivative(y_out, f_out, c.time);
+                event_time = *time_ptr;
+            }
+
+            occurrences.push_back({e.name, event_time});
+
+            if (e.terminal) {
+                terminal_event_name = e.name;
+                terminal_event_time = c.time;
+            }
+        }
+    };
+
+    if (n > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            weights[i] = 1.0 / (rel_tol * std::abs(y0[i]) + abs_tol);
+        }
+
+        // Choose an initial step that would change the state by a small
+        // fraction of the tolerances
+        calculate_derivative(y0, 0.0);
+        double const f_norm = weighted_norm(f, weights);
+        h = std::min({output_step_size, 1.0, f_norm > 0.0 ? 0.1 / f_norm : 1.0});
+        h = std::max(h, 1e-6);
+
+        z[0] = y0;
+        for (size_t i = 0; i < n; ++i) {
+            z[1][i] = h * f[i];
+        }
+    }
+
+    for (size_t k = 1; k * output_step_size <= t_end + 1e-9; ++k) {
+        double const t_out = std::min(k * output_step_size, t_end);
+
+        if (n > 0) {
+            int attempts = 0;
+            while (t < t_out) {
+                double const t_prev = t;
+                if (!take_step(t_end, attempts)) {
+                    failed = true;
+                    failure_time = t;
+                    break;
+                }
+
+                if (!detector.empty() && terminal_event_name.empty()) {
+                    check_events(t_prev);
+                }
+            }
+
+            if (failed) {
+                break;
+            }
+
+            interpolate(t_out, y_out);
+        }
+
+        record(t_out);
+
+        if (!terminal_event_name.empty() && t_out >= terminal_event_time) {
+            break;
+        }
+    }
+
+    state_vector_map result;
+
+    if (writer) {
+        writer->end();
+        return result;
+    }
+
+    for (size_t k = 0; k < names.size(); ++k) {
+        result[names[k]] = std::move(columns[k]);
+    }
+
+    return result;
+}
+
+std::string homemade_lsoda_simulation::generate_report() const
+{
+    std::ostringstream report;
+
+    report << "\nThe homemade_lsoda ODE solver ";
+
+    if (failed) {
+        report << "stopped at time index " << failure_time
+               << " because it required more than " << max_steps
+               << " steps between two output times.\n";
+    } else if (!terminal_event_name.empty()) {
+        report << "stopped after the terminal event `" << terminal_event_name
+               << "` occurred at time index " << terminal_event_time << ".\n";
+    } else {
+        report << "reached the end of the drivers.\n";
+    }
+
+    report << "  Steps taken: " << nsteps
+           << " (" << nsteps_adams << " Adams, " << nsteps_bdf << " BDF)\n"
+           << "  Error test failures: " << nerror_failures << "\n"
+           << "  Convergence failures: " << nconvergence_failures << "\n"
+           << "  Switches between Adams and BDF: " << nswitches << "\n"
+           << "  Jacobian calculations: " << njacobians << "\n"
+           << "  Derivative calculations: " << nderivatives << "\n"
+           << "  Final method and order: "
+           << (meth == method::bdf ? "BDF " : "Adams ") << order << "\n";
+
+    return report.str();
+}
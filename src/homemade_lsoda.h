@@ -0,0 +1,210 @@
+#ifndef HOMEMADE_LSODA_H
+#define HOMEMADE_LSODA_H
+
+#include <string>
+#include <vector>
+#include "framework/state_map.h"       // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"  // for mc_vector
+#include "persistent_system.h"         // for persistent_system
+#include "result_sink.h"               // for chunked_result_writer
+#include "simulation_events.h"         // for simulation_event, event_occurrence, event_detector
+
+/**
+ *  @class homemade_lsoda_simulation
+ *
+ *  @brief Runs a BioCro simulation using a variable-order, variable-step
+ *  integrator that switches automatically between Adams methods for
+ *  non-stiff problems and backward differentiation formulas (BDF) for stiff
+ *  ones, in the spirit of LSODA.
+ *
+ *  Both families are implemented in Nordsieck form: the history is stored as
+ *  the array `z_j = h^j y^(j) / j!` for `j = 0, ..., q`, where `h` is the step
+ *  size and `q` is the order. Each step predicts the array at the new time by
+ *  Taylor expansion and then corrects it by `l * delta`, where `l` is a vector
+ *  of coefficients that depends on the method and order, and `delta` is found
+ *  by solving the corrector equation `delta = h f(z_0) - z_1`. Since the
+ *  array has the same meaning for both families, switching between them only
+ *  requires changing `l` and the way the corrector equation is solved:
+ *
+ *  - Adams-Moulton (orders 1 to 5) uses functional iteration, which needs no
+ *    Jacobian but only converges when `h l_0 ||df/dx||` is small. The rate of
+ *    convergence of the iteration provides an estimate of `||df/dx||`, which
+ *    limits the step size.
+ *
+ *  - BDF (orders 1 to 5) uses a modified Newton iteration with the matrix
+ *    `I - h l_0 J`. The Jacobian `J` is calculated by the `persistent_system`
+ *    using its sparsity pattern, so it only requires one derivative
+ *    calculation per column color, and it is reused over many steps.
+ *
+ *  When the Adams step size has been limited by the iteration's convergence
+ *  for several consecutive steps while the error estimate would allow larger
+ *  ones, the problem is considered stiff and BDF is used; conversely, when
+ *  the Jacobian shows that the Adams iteration would converge at the current
+ *  BDF step size for several consecutive steps, Adams is used again.
+ *
+ *  The step size and order are chosen to keep the local error estimate below
+ *  the tolerances, using the weighted root-mean-square norm with weights
+ *  `1 / (rel_tol |y_i| + abs_tol)`. The step size is capped at one row of the
+ *  drivers, since the drivers are only piecewise linear in time; steps are not
+ *  aligned with the rows, so a step may still cross a row boundary. Results are
+ *  reported every `output_step_size` rows by interpolating the Nordsieck
+ *  array, and the direct module outputs are found by evaluating the system
+ *  at each output time.
+ *
+ *  If more than `max_steps` steps are attempted between two output times,
+ *  the integration stops and the result only includes the times that were
+ *  reached, as for the framework's adaptive solvers.
+ *
+ *  Events can be specified using `set_events()`. They are checked after each
+ *  step by an `event_detector` that locates crossings on the Nordsieck
+ *  polynomial for the step. The integration stops at the first output time at
+ *  or after a terminal event.
+ *
+ *  If a `chunked_result_writer` is passed to `run_simulation()`, each row of
+ *  the result is passed to it as soon as it has been calculated rather than
+ *  being stored, and the returned result is empty.
+ *
+ *  Otherwise, the returned result includes every quantity of the system at
+ *  each output time, unless a subset of the quantities and output times has
+ *  been chosen using `set_output_quantities()`. In that case, only the
+ *  selected quantities are stored, and the system is only evaluated at the
+ *  output times that are kept.
+ *
+ *  Each run starts from the stored initial values, so the simulation can be
+ *  run many times. The initial values and parameters can be changed between
+ *  runs through the pointers returned by `get_initial_value_ptr()` and
+ *  `get_parameter_ptr()`.
+ *
+ *  The module creators are not owned by this class; the code creating a
+ *  `homemade_lsoda_simulation` must make sure that they outlive it.
+ */
+class homemade_lsoda_simulation
+{
+   public:
+    homemade_lsoda_simulation(
+        state_map const& initial_values,
+        state_map const& parameters,
+        state_vector_map const& drivers,
+        mc_vector const& direct_mcs,
+        mc_vector const& differential_mcs,
+        double output_step_size,
+        double rel_tol,
+        double abs_tol,
+        int max_steps);
+
+    state_vector_map run_simulation(chunked_result_writer* writer = nullptr);
+
+    std::string generate_report() const;
+
+    void set_events(std::vector<simulation_event> const& new_events);
+
+    std::vector<event_occurrence> const& get_event_occurrences() const
+    {
+        return occurrences;
+    }
+
+    string_vector get_output_quantity_names() const
+    {
+        return sys.get_output_quantity_names();
+    }
+
+    void set_output_quantities(
+        string_vector const& quantity_names,
+        size_t decimation);
+
+    double* get_initial_value_ptr(std::string const& name);
+
+    double* get_parameter_ptr(std::string const& name)
+    {
+        return sys.get_parameter_ptr(name);
+    }
+
+    static std::string get_name() { return "homemade_lsoda"; }
+
+   private:
+    enum class method { adams,
+                        bdf };
+
+    persistent_system sys;
+    size_t const ntimes;
+    double const output_step_size;
+    double const rel_tol;
+    double const abs_tol;
+    int const max_steps;
+    std::vector<double> y0;
+
+    // The quantities and output times that are stored
+    string_vector output_quantity_names;
+    size_t output_decimation;
+
+    // The current state of the integrator
+    method meth;
+    int order;
+    double t;
+    double h;
+    std::vector<std::vector<double>> z;
+
+    // Storage for one step
+    std::vector<std::vector<double>> z_saved;
+    std::vector<double> weights;
+    std::vector<double> y;
+    std::vector<double> f;
+    std::vector<double> delta;
+    std::vector<double> delta_prev;
+    std::vector<double> correction;
+    bool delta_prev_valid;
+    int steps_since_change;
+
+    // The Jacobian and the LU factors of `I - h l_0 J`, in column-major order
+    std::vector<double> jacobian;
+    std::vector<double> lu;
+    std::vector<size_t> pivots;
+    double jacobian_norm;
+    double hl0_at_lu;
+    bool jacobian_current;
+    int steps_since_jacobian;
+
+    // An estimate of ||df/dx|| from the Adams functional iteration
+    double adams_rho;
+
+    // Counts of steps that favored switching to the other method
+    int switch_count;
+
+    // Statistics for the report
+    int nsteps;
+    int nsteps_adams;
+    int nsteps_bdf;
+    int nerror_failures;
+    int nconvergence_failures;
+    int nswitches;
+    int nderivatives;
+    int njacobians;
+    bool failed;
+    double failure_time;
+
+    // Events and the events that occurred
+    event_detector detector;
+    std::vector<event_occurrence> occurrences;
+    std::string terminal_event_name;
+    double terminal_event_time;
+
+    void calculate_derivative(std::vector<double> const& x, double time);
+
+    void update_jacobian();
+
+    bool factor_iteration_matrix(double hl0);
+
+    void rescale(double eta);
+
+    bool correct(double t_new, std::vector<double> const& l);
+
+    bool take_step(double t_end, int& attempts);
+
+    void select_step_and_order(std::vector<double> const& l, double error);
+
+    void interpolate(double t_out, std::vector<double>& y_out) const;
+
+    double interpolate_component(double t_out, size_t i) const;
+};
+
+#endif
@@ -16,22 +16,32 @@
 
 #include "R_dynamical_system.h"
 #include "R_get_all_ode_solvers.h"
+#include "R_kernel_derivatives.h"
 #include "R_module_library.h"
 #include "R_modules.h"
 #include "R_run_biocro.h"
+#include "R_simulation_handle.h"
 #include "R_system_derivatives.h"
 #include "R_framework_version.h"
 
 extern "C" {
 static const R_CallMethodDef callMethods[] = {
+    {"R_check_kernel_derivatives",         (DL_FUNC) &R_check_kernel_derivatives,         0},
     {"R_evaluate_module",                  (DL_FUNC) &R_evaluate_module,                  2},
     {"R_get_all_modules",                  (DL_FUNC) &R_get_all_modules,                  0},
     {"R_get_all_ode_solvers",              (DL_FUNC) &R_get_all_ode_solvers,              0},
     {"R_get_all_quantities",               (DL_FUNC) &R_get_all_quantities,               0},
     {"R_module_creators",                  (DL_FUNC) &R_module_creators,                  1},
     {"R_module_info",                      (DL_FUNC) &R_module_info,                      2},
-    {"R_run_biocro",                       (DL_FUNC) &R_run_biocro,                       11},
-    {"R_system_derivatives",               (DL_FUNC) &R_system_derivatives,               6},
+    {"R_run_biocro",                       (DL_FUNC) &R_run_biocro,                       18},
+    {"R_run_biocro_batch",                 (DL_FUNC) &R_run_biocro_batch,                 16},
+    {"R_run_biocro_sensitivity",           (DL_FUNC) &R_run_biocro_sensitivity,           7},
+    {"R_run_biocro_to_file",               (DL_FUNC) &R_run_biocro_to_file,               16},
+    {"R_run_simulation_handle",            (DL_FUNC) &R_run_simulation_handle,            3},
+    {"R_simulation_handle",                (DL_FUNC) &R_simulation_handle,                13},
+    {"R_system_derivatives",               (DL_FUNC) &R_system_derivatives,               3},
+    {"R_system_derivatives_handle",        (DL_FUNC) &R_system_derivatives_handle,        5},
+    {"R_system_jacobian",                  (DL_FUNC) &R_system_jacobian,                  3},
     {"R_validate_dynamical_system_inputs", (DL_FUNC) &R_validate_dynamical_system_inputs, 6},
     {"R_framework_version",                (DL_FUNC) &R_framework_version,                0},
     {NULL,                                 NULL,                                          0}
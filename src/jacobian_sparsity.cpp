@@ -0,0 +1,184 @@
+#include <algorithm>  // for std::sort, std::stable_sort
+#include "jacobian_sparsity.h"
+
+namespace
+{
+bool any_input_in(string_vector const& inputs, string_set const& quantities)
+{
+    for (std::string const& name : inputs) {
+        if (quantities.count(name) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+}  // namespace
+
+/**
+ *  @brief Determines the sparsity pattern of a system's Jacobian matrix from
+ *  the inputs and outputs of its modules, and colors its columns.
+ *
+ *  For each differential quantity, the set of quantities that depend on it is
+ *  found by repeatedly adding the outputs of any direct module with an input
+ *  in the set, until no more are added; the direct modules do not need to be
+ *  sorted. The rows of the corresponding column are then the outputs of any
+ *  differential module with an input in the set.
+ *
+ *  The pattern is conservative: an element is only treated as zero if the
+ *  module graph guarantees that it is, but an element treated as nonzero may
+ *  still be zero at some (or all) values of the differential quantities.
+ *
+ *  @param [in] quantity_names The names of the differential quantities; this
+ *              determines the order of the rows and columns
+ *
+ *  @param [in] direct_mcs The direct modules
+ *
+ *  @param [in] differential_mcs The differential modules
+ *
+ *  @return The sparsity pattern and column coloring
+ */
+jacobian_sparsity find_jacobian_sparsity(
+    string_vector const& quantity_names,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs)
+{
+    size_t const n = quantity_names.size();
+
+    // The module inputs and outputs are only retrieved once, since some
+    // modules generate them each time
+    std::vector<string_vector> direct_inputs;
+    std::vector<string_vector> direct_outputs;
+    for (module_creator* mc : direct_mcs) {
+        direct_inputs.push_back(mc->get_inputs());
+        direct_outputs.push_back(mc->get_outputs());
+    }
+
+    std::vector<string_vector> diff_inputs;
+    for (module_creator* mc : differential_mcs) {
+        diff_inputs.push_back(mc->get_inputs());
+    }
+
+    // diff_rows[k] holds the rows of the quantities whose derivatives are
+    // calculated by the k-th differential module
+    std::vector<std::vector<size_t>> diff_rows;
+    for (module_creator* mc : differential_mcs) {
+        std::vector<size_t> rows;
+        for (std::string const& name : mc->get_outputs()) {
+            for (size_t i = 0; i < n; ++i) {
+                if (quantity_names[i] == name) {
+                    rows.push_back(i);
+                }
+            }
+        }
+        diff_rows.push_back(rows);
+    }
+
+    jacobian_sparsity sparsity;
+    sparsity.size = n;
+    sparsity.column_rows.resize(n);
+
+    for (size_t j = 0; j < n; ++j) {
+        string_set dependent{quantity_names[j]};
+        std::vector<bool> used(direct_mcs.size(), false);
+
+        bool found = true;
+        while (found) {
+            found = false;
+            for (size_t k = 0; k < direct_mcs.size(); ++k) {
+                if (!used[k] && any_input_in(direct_inputs[k], dependent)) {
+                    dependent.insert(direct_outputs[k].begin(), direct_outputs[k].end());
+                    used[k] = true;
+                    found = true;
+                }
+            }
+        }
+
+        std::vector<bool> is_nonzero(n, false);
+        for (size_t k = 0; k < differential_mcs.size(); ++k) {
+            if (any_input_in(diff_inputs[k], dependent)) {
+                for (size_t i : diff_rows[k]) {
+                    is_nonzero[i] = true;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            if (is_nonzero[i]) {
+                sparsity.column_rows[j].push_back(i);
+            }
+        }
+    }
+
+    color_jacobian_columns(sparsity);
+
+    return sparsity;
+}
+
+/**
+ *  @brief Assigns colors to the columns of a Jacobian sparsity pattern such
+ *  that no two columns with the same color have a nonzero element in the same
+ *  row.
+ *
+ *  A greedy algorithm is used, with the columns considered in order of
+ *  decreasing number of nonzero elements; each column receives the lowest
+ *  color not already used by a column that shares one of its rows. This does
+ *  not always find the smallest possible number of colors, but it is fast and
+ *  works well for the block-structured Jacobians of typical crop models.
+ *
+ *  @param [in, out] sparsity A sparsity pattern whose `column_rows` have been
+ *                   set; its `column_colors` and `color_columns` are
+ *                   replaced
+ */
+void color_jacobian_columns(jacobian_sparsity& sparsity)
+{
+    size_t const n = sparsity.size;
+
+    std::vector<size_t> order(n);
+    for (size_t j = 0; j < n; ++j) {
+        order[j] = j;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&sparsity](size_t a, size_t b) {
+        return sparsity.column_rows[a].size() > sparsity.column_rows[b].size();
+    });
+
+    // row_colors[i] holds the colors of the columns already assigned that
+    // have a nonzero element in row i
+    std::vector<std::vector<bool>> row_colors(n);
+
+    sparsity.column_colors.assign(n, 0);
+    sparsity.color_columns.clear();
+
+    for (size_t j : order) {
+        size_t color = 0;
+        bool conflict = true;
+        while (conflict) {
+            conflict = false;
+            for (size_t i : sparsity.column_rows[j]) {
+                if (color < row_colors[i].size() && row_colors[i][color]) {
+                    conflict = true;
+                    ++color;
+                    break;
+                }
+            }
+        }
+
+        sparsity.column_colors[j] = color;
+
+        for (size_t i : sparsity.column_rows[j]) {
+            if (row_colors[i].size() <= color) {
+                row_colors[i].resize(color + 1, false);
+            }
+            row_colors[i][color] = true;
+        }
+
+        if (sparsity.color_columns.size() <= color) {
+            sparsity.color_columns.resize(color + 1);
+        }
+        sparsity.color_columns[color].push_back(j);
+    }
+
+    for (auto& columns : sparsity.color_columns) {
+        std::sort(columns.begin(), columns.end());
+    }
+}
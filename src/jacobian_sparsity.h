@@ -0,0 +1,53 @@
+#ifndef JACOBIAN_SPARSITY_H
+#define JACOBIAN_SPARSITY_H
+
+#include <vector>
+#include "framework/state_map.h"       // for string_vector
+#include "framework/module_creator.h"  // for mc_vector
+
+/**
+ *  @class jacobian_sparsity
+ *
+ *  @brief Describes which elements of a system's Jacobian matrix can be
+ *  nonzero and how its columns can be grouped for finite-difference
+ *  calculations.
+ *
+ *  Element `(i, j)` of the Jacobian is the derivative of the `i`-th
+ *  component of `dx/dt` with respect to the `j`-th differential quantity. It
+ *  can only be nonzero if the `j`-th quantity is an input to a differential
+ *  module that calculates the derivative of the `i`-th quantity, either
+ *  directly or through a chain of direct modules. Every other element is
+ *  known to be zero without calculating it.
+ *
+ *  Two columns without nonzero elements in any common row can be calculated
+ *  with a single finite difference, by perturbing both quantities at once:
+ *  each changed component of `dx/dt` can be attributed to exactly one of the
+ *  perturbed quantities. The columns are assigned _colors_ such that no two
+ *  columns with the same color share a row, so a full Jacobian only requires
+ *  one extra derivative calculation per color rather than one per column.
+ */
+struct jacobian_sparsity {
+    // The number of rows and columns
+    size_t size = 0;
+
+    // column_rows[j] holds the rows that may be nonzero in column j, in
+    // increasing order
+    std::vector<std::vector<size_t>> column_rows;
+
+    // column_colors[j] is the color of column j
+    std::vector<size_t> column_colors;
+
+    // color_columns[c] holds the columns with color c, in increasing order
+    std::vector<std::vector<size_t>> color_columns;
+
+    size_t ncolors() const { return color_columns.size(); }
+};
+
+jacobian_sparsity find_jacobian_sparsity(
+    string_vector const& quantity_names,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs);
+
+void color_jacobian_columns(jacobian_sparsity& sparsity);
+
+#endif
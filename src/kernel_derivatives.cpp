@@ -0,0 +1,321 @@
+#include <algorithm>  // for std::max
+#include <cmath>      // for std::abs
+#include "module_library/BioCro.h"               // for EvapoTrans2
+#include "module_library/c3photo.h"              // for c3photoC, c3_solver_method
+#include "module_library/c4photo.h"              // for c4photoC, c4_solver_method
+#include "module_library/dual_number.h"          // for dual
+#include "module_library/partitioning_growth.h"  // for standardBML::partitioning_growth
+#include "module_library/sunML.h"                // for sunML
+#include "kernel_derivatives.h"
+
+namespace
+{
+/**
+ *  @brief Evaluates `c3photoC()` with the inputs in `x`, in the order of its
+ *  arguments, and returns its net assimilation rate, stomatal conductance, and
+ *  intercellular CO2 concentration.
+ */
+struct c3photoC_kernel {
+    c3_solver_method solver;
+
+    template <typename scalar>
+    std::vector<scalar> operator()(std::vector<scalar> const& x) const
+    {
+        basic_photosynthesis_outputs<scalar> const r = c3photoC<scalar>(
+            x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7], x[8], x[9], x[10],
+            x[11], x[12], x[13], x[14], x[15], x[16], x[17], x[18], x[19],
+            solver);
+
+        return {r.Assim, r.Gs, r.Ci};
+    }
+};
+
+/**
+ *  @brief Evaluates `c4photoC()` with the inputs in `x`, in the order of its
+ *  arguments, and returns its net assimilation rate, stomatal conductance, and
+ *  intercellular CO2 concentration.
+ */
+struct c4photoC_kernel {
+    c4_solver_method solver;
+
+    template <typename scalar>
+    std::vector<scalar> operator()(std::vector<scalar> const& x) const
+    {
+        basic_photosynthesis_outputs<scalar> const r = c4photoC<scalar>(
+            x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7], x[8], x[9], x[10],
+            x[11], x[12], x[13], x[14], x[15], x[16], x[17], x[18],
+            solver);
+
+        return {r.Assim, r.Gs, r.Ci};
+    }
+};
+
+/**
+ *  @brief Evaluates `partitioning_growth::calculate_rates()` with the inputs in
+ *  `x`, in the order of its arguments, and returns all of its rates.
+ */
+struct partitioning_growth_kernel {
+    template <typename scalar>
+    std::vector<scalar> operator()(std::vector<scalar> const& x) const
+    {
+        standardBML::partitioning_growth::rates<scalar> const r =
+            standardBML::partitioning_growth::calculate_rates<scalar>(
+                x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7], x[8], x[9],
+                x[10], x[11], x[12], x[13], x[14], x[15], x[16], x[17]);
+
+        return {r.Leaf, r.Stem, r.Root, r.Rhizome, r.Grain, r.Shell};
+    }
+};
+
+/**
+ *  @brief Evaluates `EvapoTrans2()` with the inputs in `x`, in the order of its
+ *  arguments, and returns its transpiration rate, leaf temperature offset, and
+ *  boundary layer conductance.
+ */
+struct EvapoTrans2_kernel {
+    int eteq;
+
+    template <typename scalar>
+    std::vector<scalar> operator()(std::vector<scalar> const& x) const
+    {
+        basic_ET_Str<scalar> const r = EvapoTrans2<scalar>(
+            x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7], x[8], eteq);
+
+        return {r.TransR, r.Deltat, r.boundary_layer_conductance};
+    }
+};
+
+/**
+ *  @brief Evaluates `sunML()` for a canopy with `nlayers` layers with the other
+ *  inputs in `x`, in the order of its arguments, and returns the absorbed PPFD,
+ *  absorbed shortwave radiation, and sunlit fraction in the top and bottom
+ *  layers, along with the fraction of direct light transmitted by the canopy.
+ */
+struct sunML_kernel {
+    int nlayers;
+
+    template <typename scalar>
+    std::vector<scalar> operator()(std::vector<scalar> const& x) const
+    {
+        basic_light_profile<scalar> const r = sunML<scalar>(
+            x[0], x[1], x[2], nlayers, x[3], x[4], x[5], x[6], x[7], x[8],
+            x[9], x[10], x[11]);
+
+        int const b = nlayers - 1;
+
+        return {
+            r.sunlit_absorbed_ppfd[0], r.shaded_absorbed_ppfd[0],
+            r.sunlit_absorbed_shortwave[0], r.sunlit_fraction[0],
+            r.sunlit_absorbed_ppfd[b], r.shaded_absorbed_ppfd[b],
+            r.sunlit_absorbed_shortwave[b], r.sunlit_fraction[b],
+            r.canopy_direct_transmission_fraction};
+    }
+};
+
+/**
+ *  @brief Compares the derivatives of a kernel's outputs calculated with dual
+ *  numbers to central finite differences, for each of the inputs named in
+ *  `inputs_to_check`, and appends the comparisons to `checks`.
+ *
+ *  The step for input `x_j` is `1e-4 max(1, |x_j|)`.
+ */
+template <typename kernel_type>
+void check_kernel(
+    std::string const& description,
+    kernel_type const& kernel,
+    string_vector const& input_names,
+    std::vector<double> const& x0,
+    string_vector const& inputs_to_check,
+    string_vector const& output_names,
+    double tolerance,
+    std::vector<derivative_check>& checks)
+{
+    for (size_t j = 0; j < input_names.size(); ++j) {
+        bool checked = false;
+        for (std::string const& name : inputs_to_check) {
+            checked = checked || name == input_names[j];
+        }
+        if (!checked) {
+            continue;
+        }
+
+        std::vector<dual> x_dual(x0.begin(), x0.end());
+        x_dual[j].derivative = 1.0;
+        std::vector<dual> const y_dual = kernel(x_dual);
+
+        double const h = 1e-4 * std::max(1.0, std::abs(x0[j]));
+        std::vector<double> x_plus = x0;
+        std::vector<double> x_minus = x0;
+        x_plus[j] += h;
+        x_minus[j] -= h;
+        std::vector<double> const y_plus = kernel(x_plus);
+        std::vector<double> const y_minus = kernel(x_minus);
+
+        for (size_t k = 0; k < output_names.size(); ++k) {
+            double const fd = (y_plus[k] - y_minus[k]) / (x_plus[j] - x_minus[j]);
+            double const ad = y_dual[k].derivative;
+
+            checks.push_back({description, output_names[k], input_names[j],
+                              ad, fd,
+                              std::abs(ad - fd) / std::max(1.0, std::abs(fd)),
+                              tolerance});
+        }
+    }
+}
+
+string_vector const c3_input_names = {
+    "absorbed_ppfd", "Tleaf", "Tambient", "RH", "Vcmax0", "Jmax0",
+    "TPU_rate_max", "Rd0", "b0", "b1", "Gs_min", "Ca", "AP", "O2", "thet",
+    "StomWS", "electrons_per_carboxylation", "electrons_per_oxygenation",
+    "beta_PSII", "gbw"};
+
+string_vector const c4_input_names = {
+    "Qp", "leaf_temperature", "ambient_temperature", "relative_humidity",
+    "vmax", "alpha", "kparm", "theta", "beta", "Rd", "bb0", "bb1", "Gs_min",
+    "StomaWS", "Ca", "atmospheric_pressure", "upperT", "lowerT", "gbw"};
+
+string_vector const partitioning_growth_input_names = {
+    "retrans", "retrans_rhizome", "kLeaf", "kStem", "kRoot", "kRhizome",
+    "kGrain", "kShell", "net_assimilation_rate_leaf",
+    "net_assimilation_rate_stem", "net_assimilation_rate_root",
+    "net_assimilation_rate_rhizome", "net_assimilation_rate_grain",
+    "net_assimilation_rate_shell", "Leaf", "Stem", "Root", "Rhizome"};
+
+string_vector const EvapoTrans2_input_names = {
+    "absorbed_shortwave_radiation_et", "absorbed_shortwave_radiation_lt",
+    "airTemp", "RH", "WindSpeed", "stomatal_conductance", "leaf_width",
+    "specific_heat_of_air", "minimum_gbw"};
+
+string_vector const sunML_input_names = {
+    "ambient_ppfd_beam", "ambient_ppfd_diffuse", "lai", "cosine_zenith_angle",
+    "kd", "chil", "absorptivity", "heightf", "par_energy_content",
+    "par_energy_fraction", "leaf_transmittance", "leaf_reflectance"};
+
+string_vector const photosynthesis_output_names = {"Assim", "Gs", "Ci"};
+
+string_vector const EvapoTrans2_output_names = {
+    "TransR", "Deltat", "boundary_layer_conductance"};
+
+string_vector const sunML_output_names = {
+    "sunlit_absorbed_ppfd (top)", "shaded_absorbed_ppfd (top)",
+    "sunlit_absorbed_shortwave (top)", "sunlit_fraction (top)",
+    "sunlit_absorbed_ppfd (bottom)", "shaded_absorbed_ppfd (bottom)",
+    "sunlit_absorbed_shortwave (bottom)", "sunlit_fraction (bottom)",
+    "canopy_direct_transmission_fraction"};
+
+// Inputs of the photosynthesis kernels whose derivatives are checked; these
+// change continuously during a simulation
+string_vector const c3_inputs_to_check = {
+    "absorbed_ppfd", "Tleaf", "RH", "Vcmax0", "Jmax0", "Ca", "gbw"};
+
+string_vector const c4_inputs_to_check = {
+    "Qp", "leaf_temperature", "relative_humidity", "vmax", "Ca", "gbw"};
+
+string_vector const EvapoTrans2_inputs_to_check = {
+    "absorbed_shortwave_radiation_et", "absorbed_shortwave_radiation_lt",
+    "airTemp", "RH", "WindSpeed", "stomatal_conductance"};
+
+string_vector const sunML_inputs_to_check = {
+    "ambient_ppfd_beam", "ambient_ppfd_diffuse", "lai", "cosine_zenith_angle",
+    "kd", "chil", "absorptivity"};
+
+// Light-limited, Rubisco-limited, and dry-air conditions for a C3 leaf, and
+// a hot leaf with a low CO2 concentration, where Brent's method in
+// `c3_solve_bracketed()` stops after a few steps
+std::vector<std::vector<double>> const c3_cases = {
+    {200, 25, 25, 0.7, 100, 180, 23, 1.1, 0.08, 5, 1e-3, 400, 101325, 210, 0.7, 1, 4.5, 5.25, 0.5, 1.2},
+    {1800, 30, 28, 0.7, 60, 180, 23, 1.1, 0.08, 5, 1e-3, 400, 101325, 210, 0.7, 1, 4.5, 5.25, 0.5, 1.2},
+    {1000, 20, 22, 0.3, 100, 180, 23, 1.1, 0.08, 5, 1e-3, 400, 101325, 210, 0.7, 1, 4.5, 5.25, 0.5, 0.5},
+    {130, 37.85, 37.85, 0.615, 31.5, 56.75, 23, 1.1, 0.08, 5, 1e-3, 175.5, 101325, 210, 0.7, 1, 4.5, 5.25, 0.5, 1.42}};
+
+// Light-limited, light-saturated, and dry-air conditions for a C4 leaf
+std::vector<std::vector<double>> const c4_cases = {
+    {200, 28, 25, 0.7, 39, 0.04, 0.7, 0.83, 0.93, 0.8, 0.08, 3, 1e-3, 1, 400, 101325, 37.5, 3, 1.2},
+    {1800, 32, 30, 0.7, 39, 0.04, 0.7, 0.83, 0.93, 0.8, 0.08, 3, 1e-3, 1, 400, 101325, 37.5, 3, 1.2},
+    {1000, 25, 25, 0.3, 39, 0.04, 0.7, 0.83, 0.93, 0.8, 0.08, 3, 1e-3, 1, 400, 101325, 37.5, 3, 0.5}};
+
+// A sunlit leaf in dry air and a shaded leaf in humid air with little wind
+std::vector<std::vector<double>> const EvapoTrans2_cases = {
+    {300, 300, 25, 0.6, 2, 300, 0.04, 1010, 0.08},
+    {50, 50, 20, 0.8, 0.5, 100, 0.04, 1010, 0.08}};
+
+// High and low sun over a dense canopy, and high sun over a sparse canopy
+std::vector<std::vector<double>> const sunML_cases = {
+    {1500, 300, 4, 0.8, 0.7, 1, 0.8, 3, 0.235, 0.5, 0.05, 0.1},
+    {400, 150, 4, 0.2, 0.7, 1, 0.8, 3, 0.235, 0.5, 0.05, 0.1},
+    {1500, 300, 0.5, 0.8, 0.7, 1, 0.8, 3, 0.235, 0.5, 0.05, 0.1}};
+
+// Growing and senescing leaves
+std::vector<std::vector<double>> const partitioning_growth_cases = {
+    {0.9, 0.6, 0.3, 0.3, 0.2, 0.1, 0.05, 0.05, 0.2, 0.3, 0.1, 0.1, 0.05, 0.02, 2, 3, 1, 1},
+    {0.9, 0.6, -0.1, 0.3, 0.3, -0.2, 0.1, 0.1, 0.2, 0.3, 0.1, 0.1, 0.05, 0.02, 2, 3, 1, 1}};
+}  // namespace
+
+/**
+ *  @brief Compares the derivatives of the photosynthesis, transpiration, canopy
+ *  light, and growth kernels calculated with dual numbers (see `dual_number.h`) to central finite
+ *  differences.
+ *
+ *  Each kernel is evaluated with several sets of inputs, chosen to cover
+ *  different limiting conditions and the branches of its solvers.
+ *
+ *  @return One comparison for each kernel, set of inputs, output, and checked
+ *          input
+ */
+std::vector<derivative_check> check_kernel_derivatives()
+{
+    std::vector<derivative_check> checks;
+
+    for (size_t i = 0; i < c3_cases.size(); ++i) {
+        check_kernel(
+            "c3photoC, fixed point, case " + std::to_string(i + 1),
+            c3photoC_kernel{c3_solver_method::fixed_point}, c3_input_names,
+            c3_cases[i], c3_inputs_to_check, photosynthesis_output_names,
+            1e-5, checks);
+
+        check_kernel(
+            "c3photoC, bracketed, case " + std::to_string(i + 1),
+            c3photoC_kernel{c3_solver_method::bracketed}, c3_input_names,
+            c3_cases[i], c3_inputs_to_check, photosynthesis_output_names,
+            1e-5, checks);
+    }
+
+    for (size_t i = 0; i < c4_cases.size(); ++i) {
+        check_kernel(
+            "c4photoC, fixed point, case " + std::to_string(i + 1),
+            c4photoC_kernel{c4_solver_method::fixed_point}, c4_input_names,
+            c4_cases[i], c4_inputs_to_check, photosynthesis_output_names,
+            1e-5, checks);
+
+        check_kernel(
+            "c4photoC, Newton, case " + std::to_string(i + 1),
+            c4photoC_kernel{c4_solver_method::newton}, c4_input_names,
+            c4_cases[i], c4_inputs_to_check, photosynthesis_output_names,
+            1e-5, checks);
+    }
+
+    for (size_t i = 0; i < EvapoTrans2_cases.size(); ++i) {
+        check_kernel(
+            "EvapoTrans2, case " + std::to_string(i + 1),
+            EvapoTrans2_kernel{0}, EvapoTrans2_input_names,
+            EvapoTrans2_cases[i], EvapoTrans2_inputs_to_check,
+            EvapoTrans2_output_names, 1e-5, checks);
+    }
+
+    for (size_t i = 0; i < sunML_cases.size(); ++i) {
+        check_kernel(
+            "sunML, case " + std::to_string(i + 1),
+            sunML_kernel{10}, sunML_input_names, sunML_cases[i],
+            sunML_inputs_to_check, sunML_output_names, 1e-5, checks);
+    }
+
+    for (size_t i = 0; i < partitioning_growth_cases.size(); ++i) {
+        check_kernel(
+            "partitioning_growth, case " + std::to_string(i + 1),
+            partitioning_growth_kernel{}, partitioning_growth_input_names,
+            partitioning_growth_cases[i], partitioning_growth_input_names,
+            {"Leaf", "Stem", "Root", "Rhizome", "Grain", "Shell"}, 1e-8, checks);
+    }
+
+    return checks;
+}
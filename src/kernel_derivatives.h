@@ -0,0 +1,28 @@
+#ifndef KERNEL_DERIVATIVES_H
+#define KERNEL_DERIVATIVES_H
+
+#include <string>
+#include <vector>
+#include "framework/state_map.h"  // for string_vector
+
+/**
+ *  @brief A comparison of one derivative of a kernel's output calculated with
+ *  dual numbers to a central finite difference.
+ *
+ *  The relative error is the difference between the two derivatives divided
+ *  by the larger of 1 and the magnitude of the finite difference; the check
+ *  passes if it is at most `tolerance`.
+ */
+struct derivative_check {
+    std::string kernel;
+    std::string output;
+    std::string input;
+    double dual;
+    double finite_difference;
+    double relative_error;
+    double tolerance;
+};
+
+std::vector<derivative_check> check_kernel_derivatives();
+
+#endif
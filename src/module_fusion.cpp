@@ -0,0 +1,33 @@
+#include "module_library/module_library.h"  // for standardBML::module_library
+#include "module_fusion.h"
+
+/**
+ *  @brief Replaces a list of direct module creators with the creator for a
+ *  single fused module when the list matches one of the fused modules in the
+ *  module library.
+ *
+ *  The fused module runs exactly the same modules, so the simulation result is
+ *  unchanged; only the way the modules are called differs. See
+ *  `fused_direct_module` for more details.
+ *
+ *  @param [in] direct_mcs The direct module creators
+ *
+ *  @param [in, out] storage A vector that takes ownership of the new creator,
+ *                   if there is one; it must outlive any use of the returned
+ *                   vector
+ *
+ *  @return A vector holding the fused module creator, or `direct_mcs` if no
+ *          fused module matches it
+ */
+mc_vector fuse_direct_modules(
+    mc_vector const& direct_mcs,
+    std::vector<std::unique_ptr<module_creator>>& storage)
+{
+    for (auto const& entry : standardBML::module_library::fused_entries) {
+        if (entry.replaces(direct_mcs) && entry.is_valid_order()) {
+            storage.emplace_back(entry.create());
+            return {storage.back().get()};
+        }
+    }
+    return direct_mcs;
+}
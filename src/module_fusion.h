@@ -0,0 +1,12 @@
+#ifndef MODULE_FUSION_H
+#define MODULE_FUSION_H
+
+#include <memory>                      // for std::unique_ptr
+#include <vector>
+#include "framework/module_creator.h"  // for module_creator, mc_vector
+
+mc_vector fuse_direct_modules(
+    mc_vector const& direct_mcs,
+    std::vector<std::unique_ptr<module_creator>>& storage);
+
+#endif
@@ -192,241 +192,6 @@ void LNprof(double LeafN, double LAI, double kpLN, vector<double>& leafN_profile
     }
 }
 
-ET_Str EvapoTrans2(
-    double absorbed_shortwave_radiation_et,  // J / m^2 / s (used to calculate evapotranspiration rate)
-    double absorbed_shortwave_radiation_lt,  // J / m^2 / s (used to calculate leaf temperature)
-    double airTemp,                          // degrees C
-    double RH,                               // dimensionless from Pa / Pa
-    double WindSpeed,                        // m / s
-    double stomatal_conductance,             // mmol / m^2 / s
-    double leaf_width,                       // meter
-    double specific_heat_of_air,             // J / kg / K
-    double minimum_gbw,                      // mol / m^2 / s
-    int eteq                                 // unitless parameter
-)
-{
-    const double DdryA = TempToDdryA(airTemp);               // kg / m^3. Density of dry air.,
-    const double LHV = TempToLHV(airTemp);                   // J / kg
-    const double SlopeFS = TempToSFS(airTemp);               // kg / m^3 / K
-    const double SWVP = saturation_vapor_pressure(airTemp);  // Pa.
-
-    // TODO: This is for about 20 degrees C at 100000 Pa. Change it to use the
-    // model state. (1 * R * temperature) / pressure
-    double constexpr volume_of_one_mole_of_air = 24.39e-3;  // m^3 / mol
-
-    double minimum_gbw_in_m_per_s = minimum_gbw * volume_of_one_mole_of_air;  // m / s
-
-    if (stomatal_conductance <= 0) {
-        throw std::range_error("Thrown in EvapoTrans2: stomatal conductance is not positive.");
-    }
-
-    double conductance_in_m_per_s = stomatal_conductance * 1e-3 * volume_of_one_mole_of_air;  // m / s
-
-    if (RH > 1) {
-        throw std::range_error("Thrown in EvapoTrans2: RH (relative humidity) is greater than 1.");
-    }
-
-    // Convert from vapor pressure to vapor density using the ideal gas law.
-    // This is approximately right for temperatures what won't kill plants.
-    const double SWVC =
-        SWVP / physical_constants::ideal_gas_constant /
-        (airTemp + conversion_constants::celsius_to_kelvin) * physical_constants::molar_mass_of_water;  // kg / m^3
-
-    if (SWVC < 0) {
-        throw std::range_error("Thrown in EvapoTrans2: SWVC is less than 0.");
-    }
-
-    const double PsycParam = DdryA * specific_heat_of_air / LHV;  // kg / m^3 / K
-
-    const double vapor_density_deficit = SWVC * (1 - RH);  // kg / m^3
-
-    const double ActualVaporPressure = RH * SWVP;  // Pa
-
-    /* This is the original from WIMOVAC*/
-    double Deltat = 0.01;  // degrees C
-    double ga;
-    double rlc; /* Long wave radiation for iterative calculation */
-    {
-        double ChangeInLeafTemp = 10.0;  // degrees C
-        double Counter = 0;
-        do {
-            ga = leaf_boundary_layer_conductance_nikolov(
-                WindSpeed, leaf_width, airTemp, Deltat, conductance_in_m_per_s,
-                ActualVaporPressure, minimum_gbw_in_m_per_s);  // m / s
-
-            /* In WIMOVAC, ga was added to the canopy conductance */
-            /* ga = (ga * gbcW)/(ga + gbcW); */
-
-            double OldDeltaT = Deltat;
-
-            rlc = 4 * physical_constants::stefan_boltzmann * pow(conversion_constants::celsius_to_kelvin + airTemp, 3) * Deltat;  // W / m^2
-
-            /* rlc = net long wave radiation emittted per second
-             *     = radiation emitted per second - radiation absorbed per second
-             *     = sigma * (Tair + deltaT)^4 - sigma * Tair^4
-             *
-             * To make it a linear function of deltaT, do a Taylor series about
-             * deltaT = 0 and keep only the zero and first order terms.
-             *
-             * rlc = sigma * Tair^4 + deltaT * (4 * sigma * Tair^3) - sigma * Tair^4
-             *     = 4 * sigma * Tair^3 * deltaT
-             *
-             * where 4 * sigma * Tair^3 is the derivative of
-             * sigma * (Tair + deltaT)^4 evaluated at deltaT = 0
-             */
-
-            const double PhiN2 = absorbed_shortwave_radiation_lt - rlc;  // W / m^2
-
-            /* This equation is from Thornley and Johnson pg. 418 */
-            const double TopValue = PhiN2 * (1 / ga + 1 / conductance_in_m_per_s) - LHV * vapor_density_deficit;  // J / m^3
-            const double BottomValue = LHV * (SlopeFS + PsycParam * (1 + ga / conductance_in_m_per_s));           // J / m^3 / K
-            Deltat = fmin(fmax(TopValue / BottomValue, -10), 10);                                                 // kelvin. Confine Deltat to the interval [-10, 10]:
-
-            ChangeInLeafTemp = std::abs(OldDeltaT - Deltat);  // kelvin
-        } while ((++Counter <= 10) && (ChangeInLeafTemp > 0.5));
-    }
-
-    /* Net radiation */
-    const double PhiN = fmax(0, absorbed_shortwave_radiation_et - rlc);  // W / m^2
-
-    // Thornley and Johnson. 1990. Plant and Crop Modeling. Equation 14.4k. Page
-    // 408.
-    const double penman_monteith =
-        (SlopeFS * PhiN + LHV * PsycParam * ga * vapor_density_deficit) /
-        (LHV * (SlopeFS + PsycParam * (1 + ga / conductance_in_m_per_s)));  // kg / m^2 / s.
-
-    const double EPen =
-        (SlopeFS * PhiN + LHV * PsycParam * ga * vapor_density_deficit) /
-        (LHV * (SlopeFS + PsycParam));  // kg / m^2 / s
-
-    const double EPries = 1.26 * SlopeFS * PhiN / (LHV * (SlopeFS + PsycParam));  // kg / m^2 / s
-
-    /* Choose equation to report */
-    double TransR;
-    switch (eteq) {
-        case 1:
-            TransR = EPen;
-            break;
-        case 2:
-            TransR = EPries;
-            break;
-        default:
-            TransR = penman_monteith;
-            break;
-    }
-
-    // TransR has units of kg / m^2 / s. Convert to mmol / m^2 / s using the
-    // molar mass of water (in kg / mol) and noting that 1e3 mmol = 1 mol
-    double cf = 1e3 / physical_constants::molar_mass_of_water;  // mmol / kg for water
-
-    ET_Str et_results;
-    et_results.TransR = TransR * cf;                                         // mmol / m^2 / s
-    et_results.EPenman = EPen * cf;                                          // mmol / m^2 / s
-    et_results.EPriestly = EPries * cf;                                      // mmol / m^2 / s
-    et_results.Deltat = Deltat;                                              // degrees C
-    et_results.boundary_layer_conductance = ga / volume_of_one_mole_of_air;  // mol / m^2 / s
-
-    return et_results;
-}
-
-/**
- *  @brief Calculates the conductance for water vapor flow from the leaf across
- *  its boundary layer using a model described in Nikolov, Massman, and
- *  Schoettle (1995).
- *
- *  Note that for an isolated leaf, this conductance characterizes the entire
- *  path from the leaf surface to the ambient air. For a leaf within a canopy,
- *  there is an additional boundary layer separating the canopy from the
- *  atmosphere; this canopy boundary layer conductance must be calculated using
- *  a separate model.
- *
- *  In this model, two types of gas flow are considered: "forced" flow driven
- *  by wind-created eddy currents and "free" flow driven by temperature-related
- *  buoyancy effects. The overall conductance is determined to be the larger of
- *  the free and forced conductances.
- *
- *  In this function, we use equations 29, 33, 34, and 35 to calculate boundary
- *  layer conductance. This is the same approach taken in the `MLcan` model of
- *  Drewry et al. (2010).
- *
- *  In this model, the minimum possible boundary layer conductance that could
- *  occur is zero. This would happen if wind speed is zero and the air and leaf
- *  temperatures are the same. In realistic field conditions, boundary layer
- *  conductance can never truly be zero. To accomodate this, an option is
- *  provided for setting a minimum value for the boundary layer counductance.
- *
- *  References:
- *
- *  - [Nikolov, N. T., Massman, W. J. & Schoettle, A. W. "Coupling biochemical and biophysical processes at the
- *    leaf level: an equilibrium photosynthesis model for leaves of C3 plants" Ecological Modelling 80, 205–235 (1995)]
- *    (https://doi.org/10.1016/0304-3800(94)00072-P)
- *
- *  - [Drewry, D. T. et al. "Ecohydrological responses of dense canopies to environmental variability: 1. Interplay between
- *    vertical structure and photosynthetic pathway" Journal of Geophysical Research: Biogeosciences 115, (2010)]
- *    (https://doi.org/10.1029/2010JG001340)
- *
- *  @param [in] windspeed The wind speed in m / s
- *
- *  @param [in] leafwidth The characteristic leaf dimension in m
- *
- *  @param [in] air_temperature The air temperature in degrees C
- *
- *  @param [in] delta_t The temperature difference between the leaf and air in
- *              degrees C
- *
- *  @param [in] stomcond The stomatal conductance in m / s
- *
- *  @param [in] water_vapor_pressure The partial pressure of water vapor in the
- *              atmosphere in Pa
- *
- *  @param [in] minimum_gbw The lowest possible value for boundary layer
- *              conductance in m / s that should be returned
- *
- *  @return The boundary layer conductance in m / s
- */
-double leaf_boundary_layer_conductance_nikolov(
-    double windspeed,             // m / s
-    double leafwidth,             // m
-    double air_temperature,       // degrees C
-    double delta_t,               // degrees C
-    double stomcond,              // m / s
-    double water_vapor_pressure,  // Pa
-    double minimum_gbw            // m / s
-)
-{
-    constexpr double p = physical_constants::atmospheric_pressure_at_sea_level;  // Pa
-
-    double leaftemp = air_temperature + delta_t;                             // degrees C
-    double gsv = stomcond;                                                   // m / s
-    double Tak = air_temperature + conversion_constants::celsius_to_kelvin;  // K
-    double Tlk = leaftemp + conversion_constants::celsius_to_kelvin;         // K
-    double ea = water_vapor_pressure;                                        // Pa
-    double lw = leafwidth;                                                   // m
-
-    double esTl = saturation_vapor_pressure(leaftemp);  // Pa.
-
-    // Forced convection
-    constexpr double cf = 1.6361e-3;  // TODO: Nikolov et. al equation 29 use cf = 4.322e-3, not cf = 1.6e-3 as is used here.
-
-    double gbv_forced = cf * pow(Tak, 0.56) * pow((Tak + 120) * ((windspeed / lw) / p), 0.5);  // m / s.
-
-    // Free convection
-    double gbv_free = gbv_forced;
-    double eb = (gsv * esTl + gbv_free * ea) / (gsv + gbv_free);  // Pa. Eq 35
-
-    double Tvdiff = (Tlk / (1 - 0.378 * eb / p)) - (Tak / (1 - 0.378 * ea / p));  // kelvin. It is also degrees C since it is a temperature difference. Eq. 34
-
-    if (Tvdiff < 0) Tvdiff = -Tvdiff;
-
-    gbv_free = cf * pow(Tlk, 0.56) * pow((Tlk + 120) / p, 0.5) * pow(Tvdiff / lw, 0.25);  // m / s. Eq. 33
-
-    // Overall conductance
-    double gbv = std::max(gbv_forced, gbv_free);  // m / s
-
-    // Apply the minimum
-    return std::max(gbv, minimum_gbw);  // m / s
-}
-
 /**
  *  @brief Calculates the conductance for water vapor flow from the leaf across
  *  its boundary layer using a model described in Thornley and Johnson (1990).
@@ -3,7 +3,13 @@
 
 #include <map>
 #include <vector>
-#include "../framework/constants.h" // for ideal_gas_constant
+#include <algorithm>                   // for std::max
+#include <cmath>                       // for pow
+#include "../framework/constants.h"    // for ideal_gas_constant,
+                                       // atmospheric_pressure_at_sea_level,
+                                       // celsius_to_kelvin
+#include "dual_number.h"               // for non_deduced_t
+#include "water_and_air_properties.h"  // for saturation_vapor_pressure
 
 /* This file will contain functions which are common to several */
 /* routines in the BioCro package. These are functions needed */
@@ -12,14 +18,17 @@
 
 #define MAXLAY    200 /* Maximum number of layers */
 
-struct ET_Str {
-  double TransR;
-  double EPenman;
-  double EPriestly;
-  double Deltat;
-  double boundary_layer_conductance;
+template <typename scalar>
+struct basic_ET_Str {
+  scalar TransR;
+  scalar EPenman;
+  scalar EPriestly;
+  scalar Deltat;
+  scalar boundary_layer_conductance;
 };
 
+using ET_Str = basic_ET_Str<double>;
+
 struct ws_str {
   double awc;
   double psim;
@@ -98,16 +107,6 @@ struct crop_phenology {
       }leaf,stem,root,rhiz;
 };
 
-double leaf_boundary_layer_conductance_nikolov(
-    double windspeed,
-    double leafwidth,
-    double air_temperature,
-    double delta_t,
-    double stomcond,
-    double water_vapor_pressure,
-    double minimum_gbw
-);
-
 double leaf_boundary_layer_conductance_thornley(
     double CanopyHeight,
     double WindSpeed,
@@ -151,15 +150,118 @@ void LNprof(double LeafN, double LAI, double kpLN, std::vector<double>& leafNla)
  *
  *  @return Return The Arrhenius exponential `e^(c - E_a / R / T)`
  */
-inline double arrhenius_exponential(
-    double c,                  // dimensionless
-    double activation_energy,  // J / mol
-    double temperature         // Kelvin
+template <typename scalar = double>
+scalar arrhenius_exponential(
+    non_deduced_t<scalar> c,                  // dimensionless
+    non_deduced_t<scalar> activation_energy,  // J / mol
+    non_deduced_t<scalar> temperature         // Kelvin
 )
 {
     using physical_constants::ideal_gas_constant;  // J / k / mol
     return exp(c - activation_energy / (ideal_gas_constant * temperature));
 }
 
+/**
+ *  @brief Calculates the conductance for water vapor flow from the leaf across
+ *  its boundary layer using a model described in Nikolov, Massman, and
+ *  Schoettle (1995).
+ *
+ *  Note that for an isolated leaf, this conductance characterizes the entire
+ *  path from the leaf surface to the ambient air. For a leaf within a canopy,
+ *  there is an additional boundary layer separating the canopy from the
+ *  atmosphere; this canopy boundary layer conductance must be calculated using
+ *  a separate model.
+ *
+ *  In this model, two types of gas flow are considered: "forced" flow driven
+ *  by wind-created eddy currents and "free" flow driven by temperature-related
+ *  buoyancy effects. The overall conductance is determined to be the larger of
+ *  the free and forced conductances.
+ *
+ *  In this function, we use equations 29, 33, 34, and 35 to calculate boundary
+ *  layer conductance. This is the same approach taken in the `MLcan` model of
+ *  Drewry et al. (2010).
+ *
+ *  In this model, the minimum possible boundary layer conductance that could
+ *  occur is zero. This would happen if wind speed is zero and the air and leaf
+ *  temperatures are the same. In realistic field conditions, boundary layer
+ *  conductance can never truly be zero. To accomodate this, an option is
+ *  provided for setting a minimum value for the boundary layer counductance.
+ *
+ *  References:
+ *
+ *  - [Nikolov, N. T., Massman, W. J. & Schoettle, A. W. "Coupling biochemical and biophysical processes at the
+ *    leaf level: an equilibrium photosynthesis model for leaves of C3 plants" Ecological Modelling 80, 205–235 (1995)]
+ *    (https://doi.org/10.1016/0304-3800(94)00072-P)
+ *
+ *  - [Drewry, D. T. et al. "Ecohydrological responses of dense canopies to environmental variability: 1. Interplay between
+ *    vertical structure and photosynthetic pathway" Journal of Geophysical Research: Biogeosciences 115, (2010)]
+ *    (https://doi.org/10.1029/2010JG001340)
+ *
+ *  @param [in] windspeed The wind speed in m / s
+ *
+ *  @param [in] leafwidth The characteristic leaf dimension in m
+ *
+ *  @param [in] air_temperature The air temperature in degrees C
+ *
+ *  @param [in] delta_t The temperature difference between the leaf and air in
+ *              degrees C
+ *
+ *  @param [in] stomcond The stomatal conductance in m / s
+ *
+ *  @param [in] water_vapor_pressure The partial pressure of water vapor in the
+ *              atmosphere in Pa
+ *
+ *  @param [in] minimum_gbw The lowest possible value for boundary layer
+ *              conductance in m / s that should be returned
+ *
+ *  @return The boundary layer conductance in m / s
+ *
+ *  This function is templated on the scalar type used for its calculations so
+ *  it can be used with automatic differentiation; see `dual_number.h`.
+ */
+template <typename scalar = double>
+scalar leaf_boundary_layer_conductance_nikolov(
+    non_deduced_t<scalar> windspeed,             // m / s
+    non_deduced_t<scalar> leafwidth,             // m
+    non_deduced_t<scalar> air_temperature,       // degrees C
+    non_deduced_t<scalar> delta_t,               // degrees C
+    non_deduced_t<scalar> stomcond,              // m / s
+    non_deduced_t<scalar> water_vapor_pressure,  // Pa
+    non_deduced_t<scalar> minimum_gbw            // m / s
+)
+{
+    constexpr double p = physical_constants::atmospheric_pressure_at_sea_level;  // Pa
+
+    scalar leaftemp = air_temperature + delta_t;                             // degrees C
+    scalar gsv = stomcond;                                                   // m / s
+    scalar Tak = air_temperature + conversion_constants::celsius_to_kelvin;  // K
+    scalar Tlk = leaftemp + conversion_constants::celsius_to_kelvin;         // K
+    scalar ea = water_vapor_pressure;                                        // Pa
+    scalar lw = leafwidth;                                                   // m
+
+    scalar esTl = saturation_vapor_pressure<scalar>(leaftemp);  // Pa.
+
+    // Forced convection
+    constexpr double cf = 1.6361e-3;  // TODO: Nikolov et. al equation 29 use cf = 4.322e-3, not cf = 1.6e-3 as is used here.
+
+    scalar gbv_forced = cf * pow(Tak, 0.56) * pow((Tak + 120) * ((windspeed / lw) / p), 0.5);  // m / s.
+
+    // Free convection
+    scalar gbv_free = gbv_forced;
+    scalar eb = (gsv * esTl + gbv_free * ea) / (gsv + gbv_free);  // Pa. Eq 35
+
+    scalar Tvdiff = (Tlk / (1 - 0.378 * eb / p)) - (Tak / (1 - 0.378 * ea / p));  // kelvin. It is also degrees C since it is a temperature difference. Eq. 34
+
+    if (Tvdiff < 0) Tvdiff = -Tvdiff;
+
+    gbv_free = cf * pow(Tlk, 0.56) * pow((Tlk + 120) / p, 0.5) * pow(Tvdiff / lw, 0.25);  // m / s. Eq. 33
+
+    // Overall conductance
+    scalar gbv = std::max(gbv_forced, gbv_free);  // m / s
+
+    // Apply the minimum
+    return std::max(gbv, minimum_gbw);  // m / s
+}
+
 #endif
 
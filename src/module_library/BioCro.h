@@ -2,7 +2,16 @@
 #define BIOCRO_H
 
 #include <vector>
-#include "AuxBioCro.h"
+#include <cmath>                       // for fmax, fmin, pow, std::abs
+#include <stdexcept>                   // for std::range_error
+#include "AuxBioCro.h"                 // for basic_ET_Str,
+                                       // leaf_boundary_layer_conductance_nikolov
+#include "dual_number.h"               // for non_deduced_t, value_of
+#include "water_and_air_properties.h"  // for saturation_vapor_pressure,
+                                       // TempToDdryA, TempToLHV, TempToSFS
+#include "../framework/constants.h"    // for ideal_gas_constant,
+                                       // molar_mass_of_water, stefan_boltzmann,
+                                       // celsius_to_kelvin
 
 double resp(double comp, double mrc, double temp);
 
@@ -31,19 +40,6 @@ void WINDprof(double WindSpeed, double LAI, std::vector<double>& wind_speed_prof
 
 double AbiotEff(double smoist, double stemp);
 
-ET_Str EvapoTrans2(
-    double absorbed_shortwave_radiation_et,
-    double absorbed_shortwave_radiation_lt,
-    double airTemp,
-    double RH,
-    double WindSpeed,
-    double stomatal_conductance,
-    double leaf_width,
-    double specific_heat_of_air,
-    double minimum_gbw,
-    int eteq
-);
-
 ET_Str c3EvapoTrans(
     double absorbed_shortwave_radiation,
     double air_temperature,
@@ -56,5 +52,152 @@ ET_Str c3EvapoTrans(
     double WindSpeedHeight
 );
 
+/**
+ *  @brief Calculates the transpiration rate and the difference between the
+ *  leaf and air temperatures, finding the leaf temperature by iterating the
+ *  leaf energy balance and `leaf_boundary_layer_conductance_nikolov()`.
+ *
+ *  This function is templated on the scalar type used for its calculations so
+ *  it can be used with automatic differentiation, e.g. `EvapoTrans2<dual>()`;
+ *  see `dual_number.h`.
+ */
+template <typename scalar = double>
+basic_ET_Str<scalar> EvapoTrans2(
+    non_deduced_t<scalar> absorbed_shortwave_radiation_et,  // J / m^2 / s (used to calculate evapotranspiration rate)
+    non_deduced_t<scalar> absorbed_shortwave_radiation_lt,  // J / m^2 / s (used to calculate leaf temperature)
+    non_deduced_t<scalar> airTemp,                          // degrees C
+    non_deduced_t<scalar> RH,                               // dimensionless from Pa / Pa
+    non_deduced_t<scalar> WindSpeed,                        // m / s
+    non_deduced_t<scalar> stomatal_conductance,             // mmol / m^2 / s
+    non_deduced_t<scalar> leaf_width,                       // meter
+    non_deduced_t<scalar> specific_heat_of_air,             // J / kg / K
+    non_deduced_t<scalar> minimum_gbw,                      // mol / m^2 / s
+    int eteq                                                // unitless parameter
+)
+{
+    const scalar DdryA = TempToDdryA<scalar>(airTemp);               // kg / m^3. Density of dry air.,
+    const scalar LHV = TempToLHV<scalar>(airTemp);                   // J / kg
+    const scalar SlopeFS = TempToSFS<scalar>(airTemp);               // kg / m^3 / K
+    const scalar SWVP = saturation_vapor_pressure<scalar>(airTemp);  // Pa.
+
+    // TODO: This is for about 20 degrees C at 100000 Pa. Change it to use the
+    // model state. (1 * R * temperature) / pressure
+    double constexpr volume_of_one_mole_of_air = 24.39e-3;  // m^3 / mol
+
+    scalar minimum_gbw_in_m_per_s = minimum_gbw * volume_of_one_mole_of_air;  // m / s
+
+    if (stomatal_conductance <= 0) {
+        throw std::range_error("Thrown in EvapoTrans2: stomatal conductance is not positive.");
+    }
+
+    scalar conductance_in_m_per_s = stomatal_conductance * 1e-3 * volume_of_one_mole_of_air;  // m / s
+
+    if (RH > 1) {
+        throw std::range_error("Thrown in EvapoTrans2: RH (relative humidity) is greater than 1.");
+    }
+
+    // Convert from vapor pressure to vapor density using the ideal gas law.
+    // This is approximately right for temperatures what won't kill plants.
+    const scalar SWVC =
+        SWVP / physical_constants::ideal_gas_constant /
+        (airTemp + conversion_constants::celsius_to_kelvin) * physical_constants::molar_mass_of_water;  // kg / m^3
+
+    if (SWVC < 0) {
+        throw std::range_error("Thrown in EvapoTrans2: SWVC is less than 0.");
+    }
+
+    const scalar PsycParam = DdryA * specific_heat_of_air / LHV;  // kg / m^3 / K
+
+    const scalar vapor_density_deficit = SWVC * (1 - RH);  // kg / m^3
+
+    const scalar ActualVaporPressure = RH * SWVP;  // Pa
+
+    /* This is the original from WIMOVAC*/
+    scalar Deltat = 0.01;  // degrees C
+    scalar ga;
+    scalar rlc; /* Long wave radiation for iterative calculation */
+    {
+        double ChangeInLeafTemp = 10.0;  // degrees C
+        double Counter = 0;
+        do {
+            ga = leaf_boundary_layer_conductance_nikolov<scalar>(
+                WindSpeed, leaf_width, airTemp, Deltat, conductance_in_m_per_s,
+                ActualVaporPressure, minimum_gbw_in_m_per_s);  // m / s
+
+            /* In WIMOVAC, ga was added to the canopy conductance */
+            /* ga = (ga * gbcW)/(ga + gbcW); */
+
+            scalar OldDeltaT = Deltat;
+
+            rlc = 4 * physical_constants::stefan_boltzmann * pow(conversion_constants::celsius_to_kelvin + airTemp, 3) * Deltat;  // W / m^2
+
+            /* rlc = net long wave radiation emittted per second
+             *     = radiation emitted per second - radiation absorbed per second
+             *     = sigma * (Tair + deltaT)^4 - sigma * Tair^4
+             *
+             * To make it a linear function of deltaT, do a Taylor series about
+             * deltaT = 0 and keep only the zero and first order terms.
+             *
+             * rlc = sigma * Tair^4 + deltaT * (4 * sigma * Tair^3) - sigma * Tair^4
+             *     = 4 * sigma * Tair^3 * deltaT
+             *
+             * where 4 * sigma * Tair^3 is the derivative of
+             * sigma * (Tair + deltaT)^4 evaluated at deltaT = 0
+             */
+
+            const scalar PhiN2 = absorbed_shortwave_radiation_lt - rlc;  // W / m^2
+
+            /* This equation is from Thornley and Johnson pg. 418 */
+            const scalar TopValue = PhiN2 * (1 / ga + 1 / conductance_in_m_per_s) - LHV * vapor_density_deficit;  // J / m^3
+            const scalar BottomValue = LHV * (SlopeFS + PsycParam * (1 + ga / conductance_in_m_per_s));           // J / m^3 / K
+            Deltat = fmin(fmax(TopValue / BottomValue, scalar(-10)), scalar(10));                                 // kelvin. Confine Deltat to the interval [-10, 10]:
+
+            ChangeInLeafTemp = std::abs(value_of(OldDeltaT - Deltat));  // kelvin
+        } while ((++Counter <= 10) && (ChangeInLeafTemp > 0.5));
+    }
+
+    /* Net radiation */
+    const scalar PhiN = fmax(scalar(0), absorbed_shortwave_radiation_et - rlc);  // W / m^2
+
+    // Thornley and Johnson. 1990. Plant and Crop Modeling. Equation 14.4k. Page
+    // 408.
+    const scalar penman_monteith =
+        (SlopeFS * PhiN + LHV * PsycParam * ga * vapor_density_deficit) /
+        (LHV * (SlopeFS + PsycParam * (1 + ga / conductance_in_m_per_s)));  // kg / m^2 / s.
+
+    const scalar EPen =
+        (SlopeFS * PhiN + LHV * PsycParam * ga * vapor_density_deficit) /
+        (LHV * (SlopeFS + PsycParam));  // kg / m^2 / s
+
+    const scalar EPries = 1.26 * SlopeFS * PhiN / (LHV * (SlopeFS + PsycParam));  // kg / m^2 / s
+
+    /* Choose equation to report */
+    scalar TransR;
+    switch (eteq) {
+        case 1:
+            TransR = EPen;
+            break;
+        case 2:
+            TransR = EPries;
+            break;
+        default:
+            TransR = penman_monteith;
+            break;
+    }
+
+    // TransR has units of kg / m^2 / s. Convert to mmol / m^2 / s using the
+    // molar mass of water (in kg / mol) and noting that 1e3 mmol = 1 mol
+    double cf = 1e3 / physical_constants::molar_mass_of_water;  // mmol / kg for water
+
+    basic_ET_Str<scalar> et_results;
+    et_results.TransR = TransR * cf;                                         // mmol / m^2 / s
+    et_results.EPenman = EPen * cf;                                          // mmol / m^2 / s
+    et_results.EPriestly = EPries * cf;                                      // mmol / m^2 / s
+    et_results.Deltat = Deltat;                                              // degrees C
+    et_results.boundary_layer_conductance = ga / volume_of_one_mole_of_air;  // mol / m^2 / s
+
+    return et_results;
+}
+
 #endif
 
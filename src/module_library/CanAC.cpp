@@ -1,7 +1,7 @@
 #include <vector>
 #include "CanAC.h"
 #include "BioCro.h"                  // for WINDprof, EvapoTrans2
-#include "c4photo.h"                 // for c4photoC
+#include "c4photo_batch.h"           // for c4photoC_batch
 #include "lightME.h"                 // for lightME
 #include "sunML.h"                   // for sunML
 #include "../framework/constants.h"  // for molar_mass_of_water, molar_mass_of_glucose
@@ -44,7 +44,8 @@ canopy_photosynthesis_outputs CanAC(
     double par_energy_fraction,        // dimensionless
     double leaf_transmittance,         // dimensionless
     double leaf_reflectance,           // dimensionless
-    double minimum_gbw                 // mol / m^2 / s
+    double minimum_gbw,                // mol / m^2 / s
+    photosynthesis_warm_start* warm_start  // may be nullptr
 )
 {
     Light_model light_model = lightME(
@@ -83,108 +84,113 @@ canopy_photosynthesis_outputs CanAC(
 
     double gbw_guess{1.2};  // mol / m^2 / s
 
+    // The sunlit and shaded leaves of all the layers are evaluated together
+    // using `c4photoC_batch()`; the sunlit leaves of layer `i` are stored at
+    // index `2 * i` and the shaded leaves at index `2 * i + 1`, where `i`
+    // counts layers from the top of the canopy
+    size_t const nleaves = 2 * nlayers;
+    c4photoC_batch_inputs leaves(nleaves);
+    photosynthesis_batch_outputs photo;
+    std::vector<ET_Str> et(nleaves);
+    std::vector<double> incident_ppfd(nleaves);       // micromol / m^2 / s
+    std::vector<double> absorbed_shortwave(nleaves);  // J / m^2 / s
+    std::vector<double> leaf_area(nleaves);           // dimensionless
+
+    // Calculations that are the same for sunlit and shaded leaves
+    std::vector<double> vmax1(nlayers);             // micromol / m^2 / s
+    std::vector<double> layer_alpha(nlayers);       // mol / mol
+    std::vector<double> layer_rd(nlayers);          // micromol / m^2 / s
+    std::vector<double> layer_wind_speed(nlayers);  // m / s
+    std::vector<double> j_avg(nlayers);             // J / m^2 / s
+
     for (int i = 0; i < nlayers; ++i) {
-        // Calculations that are the same for sunlit and shaded leaves
         int current_layer = nlayers - 1 - i;
         double leafN_lay = leafN_profile[current_layer];
 
-        double vmax1;
         if (lnfun == 0) {
-            vmax1 = Vmax;
+            vmax1[i] = Vmax;
         } else {
-            vmax1 = nitroP.Vmaxb1 * leafN_lay + nitroP.Vmaxb0;
-            if (vmax1 < 0) {
-                vmax1 = 0.0;
+            vmax1[i] = nitroP.Vmaxb1 * leafN_lay + nitroP.Vmaxb0;
+            if (vmax1[i] < 0) {
+                vmax1[i] = 0.0;
             }
-            if (vmax1 > Vmax) {
-                vmax1 = Vmax;
+            if (vmax1[i] > Vmax) {
+                vmax1[i] = Vmax;
             }
             Alpha = nitroP.alphab1 * leafN_lay + nitroP.alphab0;
             Rd = nitroP.Rdb1 * leafN_lay + nitroP.Rdb0;
         }
+        layer_alpha[i] = Alpha;
+        layer_rd[i] = Rd;
+
+        layer_wind_speed[i] = wind_speed_profile[current_layer];             // m / s
+        j_avg[i] = light_profile.average_absorbed_shortwave[current_layer];  // J / m^2 / s
+
+        incident_ppfd[2 * i] = light_profile.sunlit_incident_ppfd[current_layer];      // micromole / m^2 / s
+        incident_ppfd[2 * i + 1] = light_profile.shaded_incident_ppfd[current_layer];  // micromole / m^2 / s
+
+        absorbed_shortwave[2 * i] = light_profile.sunlit_absorbed_shortwave[current_layer];      // J / m^2 / s
+        absorbed_shortwave[2 * i + 1] = light_profile.shaded_absorbed_shortwave[current_layer];  // J / m^2 / s
 
-        double layer_wind_speed = wind_speed_profile[current_layer];             // m / s
-        double j_avg = light_profile.average_absorbed_shortwave[current_layer];  // J / m^2 / s
-
-        // Calculations for sunlit leaves. First, estimate stomatal conductance
-        // by assuming the leaf has the same temperature as the air. Then, use
-        // energy balance to get a better temperature estimate using that value
-        // of stomatal conductance. Get the final estimate of stomatal
-        // conductance using the new value of the leaf temperature.
-        double i_dir = light_profile.sunlit_incident_ppfd[current_layer];       // micromole / m^2 / s
-        double j_dir = light_profile.sunlit_absorbed_shortwave[current_layer];  // J / m^2 / s
-        double pLeafsun = light_profile.sunlit_fraction[current_layer];         // dimensionless. Fraction of LAI that is sunlit.
-        double Leafsun = LAIc * pLeafsun;                                       // dimensionless
-
-        double direct_gsw_estimate =
-            c4photoC(
-                i_dir, ambient_temperature, ambient_temperature,
-                RH, vmax1, Alpha, Kparm,
-                theta, beta, Rd, b0, b1, Gs_min, StomataWS, Catm,
-                atmospheric_pressure, upperT, lowerT,
-                gbw_guess)
-                .Gs;  // mmol / m^2 / s
-
-        ET_Str et_direct =
-            EvapoTrans2(
-                j_dir, j_avg, ambient_temperature, RH, layer_wind_speed,
-                direct_gsw_estimate, leafwidth, specific_heat_of_air,
-                minimum_gbw, eteq);
-
-        double leaf_temperature_dir = ambient_temperature + et_direct.Deltat;  // degrees C
-
-        photosynthesis_outputs direct_photo =
-            c4photoC(
-                i_dir, leaf_temperature_dir, ambient_temperature,
-                RH, vmax1, Alpha, Kparm,
-                theta, beta, Rd, b0, b1, Gs_min, StomataWS, Catm,
-                atmospheric_pressure, upperT, lowerT,
-                et_direct.boundary_layer_conductance);
-
-        // Calculations for shaded leaves. First, estimate stomatal conductance
-        // by assuming the leaf has the same temperature as the air. Then, use
-        // energy balance to get a better temperature estimate using that value
-        // of stomatal conductance. Get the final estimate of stomatal
-        // conductance using the new value of the leaf temperature.
-        double i_diff = light_profile.shaded_incident_ppfd[current_layer];       // micromole / m^2 / s
-        double j_diff = light_profile.shaded_absorbed_shortwave[current_layer];  // J / m^2 / s
-        double pLeafshade = light_profile.shaded_fraction[current_layer];        // dimensionless. Fraction of LAI that is shaded.
-        double Leafshade = LAIc * pLeafshade;                                    // dimensionless
-
-        double diffuse_gsw_estimate =
-            c4photoC(
-                i_diff, ambient_temperature, ambient_temperature,
-                RH, vmax1, Alpha, Kparm,
-                theta, beta, Rd, b0, b1, Gs_min, StomataWS, Catm,
-                atmospheric_pressure, upperT, lowerT,
-                gbw_guess)
-                .Gs;  // mmol / m^2 / s
-
-        ET_Str et_diffuse =
-            EvapoTrans2(
-                j_diff, j_avg, ambient_temperature, RH, layer_wind_speed,
-                diffuse_gsw_estimate, leafwidth, specific_heat_of_air,
-                minimum_gbw, eteq);
-
-        double leaf_temperature_diff = ambient_temperature + et_diffuse.Deltat;  // degrees C
-
-        photosynthesis_outputs diffuse_photo =
-            c4photoC(
-                i_diff, leaf_temperature_diff, ambient_temperature,
-                RH, vmax1, Alpha, Kparm,
-                theta, beta, Rd, b0, b1, Gs_min, StomataWS, Catm,
-                atmospheric_pressure, upperT, lowerT,
-                et_diffuse.boundary_layer_conductance);
+        leaf_area[2 * i] = LAIc * light_profile.sunlit_fraction[current_layer];      // dimensionless
+        leaf_area[2 * i + 1] = LAIc * light_profile.shaded_fraction[current_layer];  // dimensionless
+    }
+
+    // First, estimate stomatal conductance by assuming each leaf has the same
+    // temperature as the air. With a warm start, the iteration for each leaf
+    // starts from its results at an earlier evaluation of the canopy, if
+    // they are available; see `photosynthesis_warm_start`.
+    for (size_t k = 0; k < nleaves; ++k) {
+        size_t const i = k / 2;
+        leaves.set(
+            k, incident_ppfd[k], ambient_temperature, ambient_temperature,
+            RH, vmax1[i], layer_alpha[i], Kparm,
+            theta, beta, layer_rd[i], b0, b1, Gs_min, StomataWS, Catm,
+            atmospheric_pressure, upperT, lowerT,
+            gbw_guess);
+    }
+    c4photoC_batch(
+        leaves, photo,
+        warm_start ? warm_start->initial_guess(nleaves) : nullptr);
+
+    // Then, use energy balance to get a better temperature estimate using that
+    // value of stomatal conductance.
+    for (size_t k = 0; k < nleaves; ++k) {
+        size_t const i = k / 2;
+        et[k] = EvapoTrans2(
+            absorbed_shortwave[k], j_avg[i], ambient_temperature, RH,
+            layer_wind_speed[i], photo.Gs[k], leafwidth, specific_heat_of_air,
+            minimum_gbw, eteq);
+
+        leaves.leaf_temperature[k] = ambient_temperature + et[k].Deltat;  // degrees C
+        leaves.gbw[k] = et[k].boundary_layer_conductance;                 // mol / m^2 / s
+    }
+
+    // Get the final estimate of stomatal conductance using the new value of
+    // the leaf temperature. With a warm start, the iteration for each leaf
+    // starts from its first estimate, and the final results are stored for
+    // later evaluations.
+    c4photoC_batch(leaves, photo, warm_start ? &photo : nullptr);
+
+    if (warm_start) {
+        warm_start->store(photo);
+    }
+
+    for (int i = 0; i < nlayers; ++i) {
+        size_t const sun = 2 * i;
+        size_t const shade = 2 * i + 1;
+        double const Leafsun = leaf_area[sun];      // dimensionless
+        double const Leafshade = leaf_area[shade];  // dimensionless
 
         // Combine sunlit and shaded leaves
-        CanopyA += Leafsun * direct_photo.Assim + Leafshade * diffuse_photo.Assim;             // micromol / m^2 / s
-        CanopyT += Leafsun * et_direct.TransR + Leafshade * et_diffuse.TransR;                 // mmol / m^2 / s
-        GCanopyA += Leafsun * direct_photo.GrossAssim + Leafshade * diffuse_photo.GrossAssim;  // micromol / m^2 / s
-        canopy_rp += Leafsun * direct_photo.Rp + Leafshade * diffuse_photo.Rp;                 // micromol / m^2 / s
-
-        CanopyPe += Leafsun * et_direct.EPenman + Leafshade * et_diffuse.EPenman;        // mmol / m^2 / s
-        CanopyPr += Leafsun * et_direct.EPriestly + Leafshade * et_diffuse.EPriestly;    // mmol / m^2 / s
-        canopy_conductance += Leafsun * direct_photo.Gs + Leafshade * diffuse_photo.Gs;  // mmol / m^2 / s
+        CanopyA += Leafsun * photo.Assim[sun] + Leafshade * photo.Assim[shade];             // micromol / m^2 / s
+        CanopyT += Leafsun * et[sun].TransR + Leafshade * et[shade].TransR;                 // mmol / m^2 / s
+        GCanopyA += Leafsun * photo.GrossAssim[sun] + Leafshade * photo.GrossAssim[shade];  // micromol / m^2 / s
+        canopy_rp += Leafsun * photo.Rp[sun] + Leafshade * photo.Rp[shade];                 // micromol / m^2 / s
+
+        CanopyPe += Leafsun * et[sun].EPenman + Leafshade * et[shade].EPenman;        // mmol / m^2 / s
+        CanopyPr += Leafsun * et[sun].EPriestly + Leafshade * et[shade].EPriestly;    // mmol / m^2 / s
+        canopy_conductance += Leafsun * photo.Gs[sun] + Leafshade * photo.Gs[shade];  // mmol / m^2 / s
     }
 
     // For assimilation, we need to convert micromol / m^2 / s into
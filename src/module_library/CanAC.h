@@ -3,6 +3,7 @@
 
 #include "AuxBioCro.h"                      // for nitroParms
 #include "canopy_photosynthesis_outputs.h"  // for canopy_photosynthesis_outputs
+#include "photosynthesis_warm_start.h"      // for photosynthesis_warm_start
 
 canopy_photosynthesis_outputs CanAC(
     double LAI,
@@ -42,6 +43,7 @@ canopy_photosynthesis_outputs CanAC(
     double par_energy_fraction,
     double leaf_transmittance,
     double leaf_reflectance,
-    double minimum_gbw);
+    double minimum_gbw,
+    photosynthesis_warm_start* warm_start = nullptr);
 
 #endif
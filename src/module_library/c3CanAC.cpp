@@ -1,7 +1,7 @@
 #include <vector>
 #include "c3CanAC.h"
 #include "BioCro.h"                  // for WINDprof, c3EvapoTrans
-#include "c3photo.h"                 // for c3photoC
+#include "c3photo_batch.h"           // for c3photoC_batch
 #include "lightME.h"                 // for lightME
 #include "sunML.h"                   // for sunML
 #include "../framework/constants.h"  // for molar_mass_of_water, molar_mass_of_glucose
@@ -47,7 +47,8 @@ canopy_photosynthesis_outputs c3CanAC(
     double leaf_reflectance,             // dimensionless
     double minimum_gbw,                  // mol / m^2 / s
     double WindSpeedHeight,              // m
-    double beta_PSII                     // dimensionless (fraction of absorbed light that reaches photosystem II)
+    double beta_PSII,                    // dimensionless (fraction of absorbed light that reaches photosystem II)
+    photosynthesis_warm_start* warm_start  // may be nullptr
 )
 {
     struct Light_model light_model = lightME(
@@ -61,7 +62,7 @@ canopy_photosynthesis_outputs c3CanAC(
     double q_dir = light_model.direct_fraction * solarR;    // micromol / m^2 / s
     double q_diff = light_model.diffuse_fraction * solarR;  // micromol / m^2 / s
 
-    struct Light_profile light_profile =
+    Light_profile light_profile =
         sunML(q_dir, q_diff, LAI, nlayers, cosine_zenith_angle, kd, chil, absorptivity_par,
               heightf, par_energy_content, par_energy_fraction,
               leaf_transmittance, leaf_reflectance);
@@ -84,104 +85,100 @@ canopy_photosynthesis_outputs c3CanAC(
 
     double gbw_guess{1.2};  // mol / m^2 / s
 
+    // The sunlit and shaded leaves of all the layers are evaluated together
+    // using `c3photoC_batch()`; the sunlit leaves of layer `i` are stored at
+    // index `2 * i` and the shaded leaves at index `2 * i + 1`, where `i`
+    // counts layers from the top of the canopy
+    size_t const nleaves = 2 * nlayers;
+    c3photoC_batch_inputs leaves(nleaves);
+    photosynthesis_batch_outputs photo;
+    std::vector<ET_Str> et(nleaves);
+    std::vector<double> iabs(nleaves);       // micromol / m^2 / s
+    std::vector<double> leaf_area(nleaves);  // dimensionless
+
+    // Calculations that are the same for sunlit and shaded leaves
+    std::vector<double> vmax1(nlayers);
+    std::vector<double> layer_wind_speed(nlayers);  // m / s
+    std::vector<double> CanHeight(nlayers);         // m
+    std::vector<double> j_avg(nlayers);             // J / m^2 / s
+
     for (int i = 0; i < nlayers; ++i) {
-        // Calculations that are the same for sunlit and shaded leaves
         int current_layer = nlayers - 1 - i;
         double leafN_lay = leafN_profile[current_layer];
 
-        double vmax1;
         if (lnfun == 0) {
-            vmax1 = Vmax;
+            vmax1[i] = Vmax;
         } else {
-            vmax1 = leafN_lay * lnb1 + lnb0;
+            vmax1[i] = leafN_lay * lnb1 + lnb0;
         }
 
-        double layer_wind_speed = wind_speed_profile[current_layer];             // m / s
-        double CanHeight = light_profile.height[current_layer];                  // m
-        double j_avg = light_profile.average_absorbed_shortwave[current_layer];  // J / m^2 / s
-
-        // Calculations for sunlit leaves. First, estimate stomatal conductance
-        // by assuming the leaf has the same temperature as the air. Then, use
-        // energy balance to get a better temperature estimate using that value
-        // of stomatal conductance. Get the final estimate of stomatal
-        // conductance using the new value of the leaf temperature.
-        double iabs_dir = light_profile.sunlit_absorbed_ppfd[current_layer];  // micromole / m^2 / s
-        double pLeafsun = light_profile.sunlit_fraction[current_layer];       // dimensionless
-        double Leafsun = LAIc * pLeafsun;                                     // dimensionless
-
-        double direct_gsw_estimate =
-            c3photoC(
-                iabs_dir, ambient_temperature, ambient_temperature,
-                RH, vmax1, Jmax,
-                tpu_rate_max, Rd, b0, b1, Gs_min, Catm, atmospheric_pressure,
-                o2, theta, StomataWS,
-                electrons_per_carboxylation, electrons_per_oxygenation,
-                beta_PSII, gbw_guess)
-                .Gs;  // mmol / m^2 / s
-
-        struct ET_Str et_direct =
-            c3EvapoTrans(
-                j_avg, ambient_temperature, RH, layer_wind_speed,
-                CanHeight, specific_heat_of_air, direct_gsw_estimate,
-                minimum_gbw, WindSpeedHeight);
-
-        double leaf_temperature_dir = ambient_temperature + et_direct.Deltat;  // degrees C
-
-        photosynthesis_outputs direct_photo =
-            c3photoC(
-                iabs_dir, leaf_temperature_dir, ambient_temperature,
-                RH, vmax1, Jmax,
-                tpu_rate_max, Rd, b0, b1, Gs_min, Catm, atmospheric_pressure,
-                o2, theta, StomataWS,
-                electrons_per_carboxylation, electrons_per_oxygenation,
-                beta_PSII, et_direct.boundary_layer_conductance);
-
-        // Calculations for shaded leaves. First, estimate stomatal conductance
-        // by assuming the leaf has the same temperature as the air. Then, use
-        // energy balance to get a better temperature estimate using that value
-        // of stomatal conductance. Get the final estimate of stomatal
-        // conductance using the new value of the leaf temperature.
-        double iabs_diff = light_profile.shaded_absorbed_ppfd[current_layer];  // micromole / m^2 /s
-        double pLeafshade = light_profile.shaded_fraction[current_layer];      // dimensionless
-        double Leafshade = LAIc * pLeafshade;                                  // dimensionless
-
-        double diffuse_gsw_estimate =
-            c3photoC(
-                iabs_diff, ambient_temperature, ambient_temperature,
-                RH, vmax1, Jmax,
-                tpu_rate_max, Rd, b0, b1, Gs_min, Catm, atmospheric_pressure,
-                o2, theta, StomataWS,
-                electrons_per_carboxylation, electrons_per_oxygenation,
-                beta_PSII, gbw_guess)
-                .Gs;  // mmol / m^2 / s
-
-        struct ET_Str et_diffuse =
-            c3EvapoTrans(
-                j_avg, ambient_temperature, RH, layer_wind_speed,
-                CanHeight, specific_heat_of_air, diffuse_gsw_estimate,
-                minimum_gbw, WindSpeedHeight);
-
-        double leaf_temperature_Idiffuse = ambient_temperature + et_diffuse.Deltat;  // degrees C
-
-        photosynthesis_outputs diffuse_photo =
-            c3photoC(
-                iabs_diff, leaf_temperature_Idiffuse, ambient_temperature,
-                RH, vmax1,
-                Jmax, tpu_rate_max, Rd, b0, b1, Gs_min, Catm,
-                atmospheric_pressure, o2, theta, StomataWS,
-                electrons_per_carboxylation,
-                electrons_per_oxygenation, beta_PSII,
-                et_diffuse.boundary_layer_conductance);
+        layer_wind_speed[i] = wind_speed_profile[current_layer];             // m / s
+        CanHeight[i] = light_profile.height[current_layer];                  // m
+        j_avg[i] = light_profile.average_absorbed_shortwave[current_layer];  // J / m^2 / s
+
+        iabs[2 * i] = light_profile.sunlit_absorbed_ppfd[current_layer];      // micromol / m^2 / s
+        iabs[2 * i + 1] = light_profile.shaded_absorbed_ppfd[current_layer];  // micromol / m^2 / s
+
+        leaf_area[2 * i] = LAIc * light_profile.sunlit_fraction[current_layer];      // dimensionless
+        leaf_area[2 * i + 1] = LAIc * light_profile.shaded_fraction[current_layer];  // dimensionless
+    }
+
+    // First, estimate stomatal conductance by assuming each leaf has the same
+    // temperature as the air. With a warm start, the iteration for each leaf
+    // starts from its results at an earlier evaluation of the canopy, if
+    // they are available; see `photosynthesis_warm_start`.
+    for (size_t k = 0; k < nleaves; ++k) {
+        size_t const i = k / 2;
+        leaves.set(
+            k, iabs[k], ambient_temperature, ambient_temperature,
+            RH, vmax1[i], Jmax,
+            tpu_rate_max, Rd, b0, b1, Gs_min, Catm, atmospheric_pressure,
+            o2, theta, StomataWS,
+            electrons_per_carboxylation, electrons_per_oxygenation,
+            beta_PSII, gbw_guess);
+    }
+    c3photoC_batch(
+        leaves, photo,
+        warm_start ? warm_start->initial_guess(nleaves) : nullptr);
+
+    // Then, use energy balance to get a better temperature estimate using that
+    // value of stomatal conductance.
+    for (size_t k = 0; k < nleaves; ++k) {
+        size_t const i = k / 2;
+        et[k] = c3EvapoTrans(
+            j_avg[i], ambient_temperature, RH, layer_wind_speed[i],
+            CanHeight[i], specific_heat_of_air, photo.Gs[k],
+            minimum_gbw, WindSpeedHeight);
+
+        leaves.Tleaf[k] = ambient_temperature + et[k].Deltat;  // degrees C
+        leaves.gbw[k] = et[k].boundary_layer_conductance;      // mol / m^2 / s
+    }
+
+    // Get the final estimate of stomatal conductance using the new value of
+    // the leaf temperature. With a warm start, the iteration for each leaf
+    // starts from its first estimate, and the final results are stored for
+    // later evaluations.
+    c3photoC_batch(leaves, photo, warm_start ? &photo : nullptr);
+
+    if (warm_start) {
+        warm_start->store(photo);
+    }
+
+    for (int i = 0; i < nlayers; ++i) {
+        size_t const sun = 2 * i;
+        size_t const shade = 2 * i + 1;
+        double const Leafsun = leaf_area[sun];      // dimensionless
+        double const Leafshade = leaf_area[shade];  // dimensionless
 
         // Combine sunlit and shaded leaves
-        CanopyA += Leafsun * direct_photo.Assim + Leafshade * diffuse_photo.Assim;             // micromol / m^2 / s
-        CanopyT += Leafsun * et_direct.TransR + Leafshade * et_diffuse.TransR;                 // mmol / m^2 / s
-        GCanopyA += Leafsun * direct_photo.GrossAssim + Leafshade * diffuse_photo.GrossAssim;  // micromol / m^2 / s
-        canopy_rp += Leafsun * direct_photo.Rp + Leafshade * diffuse_photo.Rp;                 // micromol / m^2 / s
-
-        CanopyPe += Leafsun * et_direct.EPenman + Leafshade * et_diffuse.EPenman;        // mmol / m^2 / s
-        CanopyPr += Leafsun * et_direct.EPriestly + Leafshade * et_diffuse.EPriestly;    // mmol / m^2 / s
-        canopy_conductance += Leafsun * direct_photo.Gs + Leafshade * diffuse_photo.Gs;  // mmol / m^2 / s
+        CanopyA += Leafsun * photo.Assim[sun] + Leafshade * photo.Assim[shade];             // micromol / m^2 / s
+        CanopyT += Leafsun * et[sun].TransR + Leafshade * et[shade].TransR;                 // mmol / m^2 / s
+        GCanopyA += Leafsun * photo.GrossAssim[sun] + Leafshade * photo.GrossAssim[shade];  // micromol / m^2 / s
+        canopy_rp += Leafsun * photo.Rp[sun] + Leafshade * photo.Rp[shade];                 // micromol / m^2 / s
+
+        CanopyPe += Leafsun * et[sun].EPenman + Leafshade * et[shade].EPenman;        // mmol / m^2 / s
+        CanopyPr += Leafsun * et[sun].EPriestly + Leafshade * et[shade].EPriestly;    // mmol / m^2 / s
+        canopy_conductance += Leafsun * photo.Gs[sun] + Leafshade * photo.Gs[shade];  // mmol / m^2 / s
     }
 
     // For assimilation, we need to convert micromol / m^2 / s into
@@ -2,6 +2,7 @@
 #define C3CANAC_H
 
 #include "canopy_photosynthesis_outputs.h"  // for canopy_photosynthesis_outputs
+#include "photosynthesis_warm_start.h"      // for photosynthesis_warm_start
 
 canopy_photosynthesis_outputs c3CanAC(
     double LAI,
@@ -44,6 +45,7 @@ canopy_photosynthesis_outputs c3CanAC(
     double leaf_reflectance,
     double minimum_gbw,
     double WindSpeedHeight,
-    double beta_PSII);
+    double beta_PSII,
+    photosynthesis_warm_start* warm_start = nullptr);
 
 #endif
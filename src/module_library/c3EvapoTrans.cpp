@@ -13,7 +13,7 @@
  * Thornley, J.H.M. and Johnson, I.R. (1990) Plant and Crop Modelling. A
  * Mathematical Approach to Plant and Crop Physiology.
  */
-struct ET_Str c3EvapoTrans(
+ET_Str c3EvapoTrans(
     double absorbed_shortwave_radiation,  // J / m^2 / s
     double air_temperature,               // degrees C
     double RH,                            // Pa / Pa
@@ -139,7 +139,7 @@ struct ET_Str c3EvapoTrans(
     // molar mass of water (in kg / mol) and noting that 1e3 mmol = 1 mol
     double cf = 1e3 / physical_constants::molar_mass_of_water;  // mmol / kg for water
 
-    struct ET_Str et_results;
+    ET_Str et_results;
     et_results.TransR = TransR * cf;                                         // mmol / m^2 / s
     et_results.EPenman = EPen * cf;                                          // mmol / m^2 / s
     et_results.EPriestly = EPries * cf;                                      // mmol / m^2 / s
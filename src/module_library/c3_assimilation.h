@@ -70,8 +70,26 @@ class c3_assimilation : public direct_module
     c3_assimilation(
         state_map const& input_quantities,
         state_map* output_quantities)
+        : c3_assimilation{
+              input_quantities,
+              output_quantities,
+              c3_solver_method::fixed_point}
+    {
+    }
+    static string_vector get_inputs();
+    static string_vector get_outputs();
+    static std::string get_name() { return "c3_assimilation"; }
+
+   protected:
+    c3_assimilation(
+        state_map const& input_quantities,
+        state_map* output_quantities,
+        c3_solver_method solver)
         : direct_module{},
 
+          // Store the solver method
+          solver{solver},
+
           // Get pointers to input quantities
           Qabs{get_input(input_quantities, "Qabs")},
           Tleaf{get_input(input_quantities, "Tleaf")},
@@ -106,11 +124,11 @@ class c3_assimilation : public direct_module
           iterations_op{get_op(output_quantities, "iterations")}
     {
     }
-    static string_vector get_inputs();
-    static string_vector get_outputs();
-    static std::string get_name() { return "c3_assimilation"; }
 
    private:
+    // Method for solving the coupled equations
+    c3_solver_method const solver;
+
     // References to input quantities
     double const& Qabs;
     double const& Tleaf;
@@ -211,7 +229,8 @@ void c3_assimilation::do_operation() const
         electrons_per_carboxylation,
         electrons_per_oxygenation,
         beta_PSII,
-        gbw);
+        gbw,
+        solver);
 
     // Update the output quantity list
     update(Assim_op, c3_results.Assim);
@@ -225,5 +244,35 @@ void c3_assimilation::do_operation() const
     update(iterations_op, c3_results.iterations);
 }
 
+/**
+ * @class c3_assimilation_bracketed
+ *
+ * @brief A child class of c3_assimilation that solves the coupled equations by
+ * finding the root of the assimilation rate residual with Brent's method
+ * rather than by fixed point iteration; see `c3_solve_bracketed()`.
+ *
+ * This module has the same inputs and outputs as `c3_assimilation`, and its
+ * results agree with those of `c3_assimilation` to within the tolerance of the
+ * fixed point iteration whenever the iteration converges. Here, ``'iterations'``
+ * is the number of residual evaluations needed to find the root once it has
+ * been bracketed, which is usually fewer than ten. An error is thrown if the
+ * root cannot be found, so a simulation never continues with an unconverged
+ * result.
+ */
+class c3_assimilation_bracketed : public c3_assimilation
+{
+   public:
+    c3_assimilation_bracketed(
+        state_map const& input_quantities,
+        state_map* output_quantities)
+        : c3_assimilation{
+              input_quantities,
+              output_quantities,
+              c3_solver_method::bracketed}
+    {
+    }
+    static std::string get_name() { return "c3_assimilation_bracketed"; }
+};
+
 }  // namespace standardBML
 #endif
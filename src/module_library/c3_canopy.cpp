@@ -3,6 +3,7 @@
 #include <cmath>      // For floor
 
 using standardBML::c3_canopy;
+using standardBML::c3_canopy_warm_start;
 
 string_vector c3_canopy::get_inputs()
 {
@@ -64,6 +65,13 @@ string_vector c3_canopy::get_outputs()
 
 void c3_canopy::do_operation() const
 {
+    // Warm starts are only used when a pointer to the time is available
+    photosynthesis_warm_start* ws = nullptr;
+    if (time_ip) {
+        warm_start.update(*time_ip, lai);
+        ws = &warm_start;
+    }
+
     canopy_photosynthesis_outputs can_result = c3CanAC(
         lai, cosine_zenith_angle, solar, temp, rh, windspeed, nlayers, vmax,
         jmax, tpu_rate_max, Rd, Catm, O2, b0, b1, Gs_min, theta, kd, heightf,
@@ -72,7 +80,7 @@ void c3_canopy::do_operation() const
         growth_respiration_fraction, electrons_per_carboxylation,
         electrons_per_oxygenation, absorptivity_par, par_energy_content,
         par_energy_fraction, leaf_transmittance, leaf_reflectance, minimum_gbw,
-        windspeed_height, beta_PSII);
+        windspeed_height, beta_PSII, ws);
 
     // Update the output quantity list
     update(canopy_assimilation_rate_op, can_result.Assim);         // Mg / ha / hr
@@ -81,3 +89,10 @@ void c3_canopy::do_operation() const
     update(GrossAssim_op, can_result.GrossAssim);                  // Mg / ha / hr
     update(canopy_photorespiration_rate_op, can_result.Rp);        // Mg / ha / hr
 }
+
+string_vector c3_canopy_warm_start::get_inputs()
+{
+    string_vector inputs = c3_canopy::get_inputs();
+    inputs.push_back("time");  // days
+    return inputs;
+}
@@ -3,6 +3,7 @@
 
 #include "../framework/module.h"
 #include "../framework/state_map.h"
+#include "photosynthesis_warm_start.h"  // for photosynthesis_warm_start
 
 namespace standardBML
 {
@@ -12,8 +13,23 @@ class c3_canopy : public direct_module
     c3_canopy(
         state_map const& input_quantities,
         state_map* output_quantities)
+        : c3_canopy{input_quantities, output_quantities, nullptr}
+    {
+    }
+    static string_vector get_inputs();
+    static string_vector get_outputs();
+    static std::string get_name() { return "c3_canopy"; }
+
+   protected:
+    c3_canopy(
+        state_map const& input_quantities,
+        state_map* output_quantities,
+        double const* time_ip)
         : direct_module{},
 
+          // Store the pointer to the time, which is only needed for warm starts
+          time_ip{time_ip},
+
           // Get references to input quantities
           lai{get_input(input_quantities, "lai")},
           cosine_zenith_angle{get_input(input_quantities, "cosine_zenith_angle")},
@@ -65,11 +81,14 @@ class c3_canopy : public direct_module
           canopy_photorespiration_rate_op{get_op(output_quantities, "canopy_photorespiration_rate")}
     {
     }
-    static string_vector get_inputs();
-    static string_vector get_outputs();
-    static std::string get_name() { return "c3_canopy"; }
 
    private:
+    // Pointer to the time, or nullptr if warm starts are disabled
+    double const* const time_ip;
+
+    // Converged photosynthesis results for each leaf class and layer
+    photosynthesis_warm_start mutable warm_start;
+
     // References to input quantities
     double const& lai;
     double const& cosine_zenith_angle;
@@ -124,5 +143,34 @@ class c3_canopy : public direct_module
     void do_operation() const;
 };
 
+/**
+ * @class c3_canopy_warm_start
+ *
+ * @brief A child class of c3_canopy that starts the photosynthesis iteration
+ * for each leaf class and layer from its results at an earlier time,
+ * rather than from a fixed guess; see `photosynthesis_warm_start`.
+ *
+ * This module has the same inputs as `c3_canopy`, along with ``'time'``, which
+ * is used to discard the previous results whenever time goes backwards. Its
+ * outputs agree with those of `c3_canopy` to within the tolerance of the
+ * photosynthesis iteration. The number of iterations is recorded in the
+ * simulation profile under `c3photoC_batch (warm start)`.
+ */
+class c3_canopy_warm_start : public c3_canopy
+{
+   public:
+    c3_canopy_warm_start(
+        state_map const& input_quantities,
+        state_map* output_quantities)
+        : c3_canopy{
+              input_quantities,
+              output_quantities,
+              get_ip(input_quantities, "time")}
+    {
+    }
+    static string_vector get_inputs();
+    static std::string get_name() { return "c3_canopy_warm_start"; }
+};
+
 }  // namespace standardBML
 #endif
@@ -1,8 +1,10 @@
 #ifndef C3_LEAF_PHOTOSYNTHESIS_H
 #define C3_LEAF_PHOTOSYNTHESIS_H
 
+#include <cstddef>  // for size_t
 #include "../framework/state_map.h"
 #include "../framework/module.h"
+#include "photosynthesis_warm_start.h"  // for photosynthesis_warm_start
 
 namespace standardBML
 {
@@ -65,6 +67,15 @@ class c3_leaf_photosynthesis : public direct_module
     static string_vector get_outputs();
     static std::string get_name() { return "c3_leaf_photosynthesis"; }
 
+    static void run_batch(
+        size_t nleaves,
+        size_t ninputs,
+        size_t noutputs,
+        const double* input_values,
+        const size_t* input_slots,
+        double* output_values,
+        photosynthesis_warm_start* warm_start = nullptr);
+
    private:
     // References to input quantities
     double const& absorbed_ppfd;
@@ -1,31 +1,613 @@
 #ifndef C3PHOTO_H
 #define C3PHOTO_H
 
-#include "photosynthesis_outputs.h"  // for photosynthesis_outputs
-
-photosynthesis_outputs c3photoC(
-    double const absorbed_ppfd,
-    double const Tleaf,
-    double const Tambient,
-    double const RH,
-    double const Vcmax0,
-    double const Jmax0,
-    double const TPU_rate_max,
-    double const Rd0,
-    double const bb0,
-    double const bb1,
-    double const Gs_min,
-    double Ca,
-    double const AP,
-    double const O2,
-    double const thet,
-    double const StomWS,
-    double const electrons_per_carboxylation,
-    double const electrons_per_oxygenation,
-    double const beta_PSII,
-    double const gbw);
+#include <cmath>                        // for pow, sqrt, std::abs
+#include <algorithm>                    // for std::min, std::max, std::swap
+#include <limits>                       // for std::numeric_limits
+#include <stdexcept>                    // for std::runtime_error
+#include "ball_berry_gs.h"              // for ball_berry_gs
+#include "FvCB_assim.h"                 // for FvCB_assim
+#include "conductance_limited_assim.h"  // for conductance_limited_assim
+#include "AuxBioCro.h"                  // for arrhenius_exponential
+#include "../framework/constants.h"     // for ideal_gas_constant,
+                                        //     celsius_to_kelvin, dr_stomata,
+                                        //     dr_boundary
+#include "module_profiler.h"            // for profile_timer,
+                                        //     record_iterations
+#include "dual_number.h"                // for non_deduced_t
+#include "photosynthesis_outputs.h"     // for photosynthesis_outputs
 
 double solc(double LeafT);
-double solo(double LeafT);
+
+// This function returns the solubility of O2 in H2O relative to its value at
+// 25 degrees C. The equation used here was developed by forming a polynomial
+// fit to tabulated solubility values from a reference book, and then a
+// subsequent normalization to the return value at 25 degrees C. For more
+// details, See Long, Plant, Cell & Environment 14, 729–739 (1991)
+// (https://doi.org/10.1111/j.1365-3040.1991.tb01439.x).
+template <typename scalar = double>
+scalar solo(
+    non_deduced_t<scalar> LeafT  // degrees C
+)
+{
+    return (0.047 - 0.0013087 * LeafT + 2.5603e-05 * pow(LeafT, 2) - 2.1441e-07 * pow(LeafT, 3)) / 0.026934;
+}
+
+/**
+ *  @brief Methods for solving the coupled equations in `c3photoC()`.
+ */
+enum class c3_solver_method {
+    fixed_point,  //!< Alternately apply the FvCB and Ball-Berry models until the assimilation rate stops changing
+    bracketed     //!< Find the root of the assimilation rate residual using Brent's method
+};
+
+/**
+ *  @brief The quantities of a C3 leaf at a trial value of its net CO2
+ *  assimilation rate, as found by `c3_coupled_equations::evaluate()`.
+ */
+template <typename scalar>
+struct c3_coupled_state {
+    scalar assimilation;                 // micromol / m^2 / s
+    scalar residual;                     // micromol / m^2 / s
+    scalar an_conductance;               // micromol / m^2 / s
+    scalar Gs;                           // mol / m^2 / s
+    scalar Ci;                           // micromol / mol
+    basic_FvCB_outputs<scalar> FvCB_res;
+    basic_stomata_outputs<scalar> BB_res;
+};
+
+/**
+ *  @brief The FvCB model, the Ball-Berry model, and CO2 diffusion across the
+ *  boundary layer and stomata, viewed as a single equation for the net CO2
+ *  assimilation rate `A` of a C3 leaf.
+ *
+ *  For a trial value of `A`, the Ball-Berry model determines the stomatal
+ *  conductance `Gs(A)`, which determines the intercellular CO2 concentration
+ *  `Ci(A) = Ca - A * (dr_boundary / gbw + dr_stomata / Gs(A))`. The FvCB model
+ *  then gives the net assimilation rate that the leaf can support at that
+ *  `Ci`, and the solution of the coupled equations is the root of the
+ *  residual
+ *
+ *  `R(A) = A - FvCB(max(Ci(A), 0))`.
+ *
+ *  This has the same root as
+ *  `A - min(FvCB(Ci(A)), conductance_limited_assim(Gs(A)))`, the residual of
+ *  the fixed point iteration, since `A` is below the conductance-limited rate
+ *  exactly when `Ci(A) > 0`. However, it has no corner where the two rates
+ *  cross, which would slow the convergence of Brent's method. When
+ *  `Ci(A) < 0`, the residual is positive, since `A` is positive and the FvCB
+ *  rate at `Ci = 0` is negative.
+ */
+template <typename scalar>
+struct c3_coupled_equations {
+    scalar Ca;                           // micromol / mol
+    scalar RH;                           // dimensionless
+    scalar b0_adj;                       // mol / m^2 / s
+    scalar b1_adj;                       // dimensionless
+    scalar gbw;                          // mol / m^2 / s
+    scalar Tleaf;                        // degrees C
+    scalar Tambient;                     // degrees C
+    scalar Gstar;                        // micromol / mol
+    scalar J;                            // micromol / m^2 / s
+    scalar Kc;                           // micromol / mol
+    scalar Ko;                           // mmol / mol
+    scalar Oi;                           // mmol / mol
+    scalar Rd;                           // micromol / m^2 / s
+    scalar TPU;                          // micromol / m^2 / s
+    scalar Vcmax;                        // micromol / m^2 / s
+    double alpha_TPU;                    // dimensionless
+    scalar electrons_per_carboxylation;  // self-explanatory units
+    scalar electrons_per_oxygenation;    // self-explanatory units
+
+    basic_FvCB_outputs<scalar> FvCB(scalar const& Ci) const
+    {
+        return FvCB_assim<scalar>(
+            Ci, Gstar, J, Kc, Ko, Oi, Rd, TPU, Vcmax, alpha_TPU,
+            electrons_per_carboxylation, electrons_per_oxygenation);
+    }
+
+    /**
+     *  @brief Returns the net assimilation rate for a fixed stomatal
+     *  conductance `Gs` (mol / m^2 / s), or NaN if it cannot be found.
+     *
+     *  When the total resistance `r = dr_boundary / gbw + dr_stomata / Gs` is
+     *  fixed, `Ci = Ca - A * r` and the Rubisco- and RuBP-limited rates
+     *  `A = W * (Ci - Gstar) / (Ci + K) - Rd` are the smaller roots of
+     *
+     *  `r A^2 - (Ca + K + (W - Rd) r) A + W (Ca - Gstar) - Rd (Ca + K) = 0`,
+     *
+     *  where `W = Vcmax` and `K = Kc (1 + Oi / Ko)` for the Rubisco-limited
+     *  rate, and `W = J / e_c` and `K = 2 e_o Gstar / e_c` for the
+     *  RuBP-limited rate. The smaller of the two rates is returned.
+     */
+    double fixed_conductance_assim(double Gs) const
+    {
+        using physical_constants::dr_boundary;
+        using physical_constants::dr_stomata;
+
+        double const r = value_of(dr_boundary / gbw) + dr_stomata / Gs;  // m^2 * s / mol
+        double const ca = value_of(Ca);                                   // micromol / mol
+        double const gstar = value_of(Gstar);                             // micromol / mol
+        double const rd = value_of(Rd);                                   // micromol / m^2 / s
+
+        auto limited_rate = [&](double W, double K) {
+            double const b = ca + K + (W - rd) * r;
+            double const c = W * (ca - gstar) - rd * (ca + K);
+            double const root_term = b * b - 4.0 * r * c;
+            return root_term < 0 ? std::numeric_limits<double>::quiet_NaN()
+                                 : (b - sqrt(root_term)) / (2.0 * r);
+        };
+
+        double const ec = value_of(electrons_per_carboxylation);
+
+        return std::min(
+            limited_rate(value_of(Vcmax), value_of(Kc * (1.0 + Oi / Ko))),
+            limited_rate(value_of(J) / ec, 2.0 * value_of(electrons_per_oxygenation) * gstar / ec));
+    }
+
+    c3_coupled_state<scalar> evaluate(scalar const& A) const
+    {
+        using physical_constants::dr_boundary;
+        using physical_constants::dr_stomata;
+
+        c3_coupled_state<scalar> s;
+        s.assimilation = A;
+
+        s.BB_res = ball_berry_gs<scalar>(
+            A * 1e-6, Ca * 1e-6, RH, b0_adj, b1_adj, gbw, Tleaf, Tambient);
+
+        s.Gs = 1e-3 * s.BB_res.gsw;  // mol / m^2 / s
+
+        s.an_conductance =
+            conductance_limited_assim<scalar>(Ca, gbw, s.Gs);  // micromol / m^2 / s
+
+        s.Ci = Ca - A * (dr_boundary / gbw + dr_stomata / s.Gs);  // micromol / mol
+
+        s.FvCB_res = FvCB(std::max<scalar>(s.Ci, 0.0));
+
+        s.residual = A - s.FvCB_res.An;  // micromol / m^2 / s
+
+        return s;
+    }
+
+    /**
+     *  @brief Returns a copy of these equations with the values of their
+     *  coefficients stored as dual numbers, so the residual can be
+     *  differentiated with respect to `A`.
+     */
+    c3_coupled_equations<dual> as_dual() const
+    {
+        return c3_coupled_equations<dual>{
+            value_of(Ca), value_of(RH), value_of(b0_adj), value_of(b1_adj),
+            value_of(gbw), value_of(Tleaf), value_of(Tambient),
+            value_of(Gstar), value_of(J), value_of(Kc), value_of(Ko),
+            value_of(Oi), value_of(Rd), value_of(TPU), value_of(Vcmax),
+            alpha_TPU, value_of(electrons_per_carboxylation),
+            value_of(electrons_per_oxygenation)};
+    }
+};
+
+/**
+ *  @brief Solves the coupled equations of a C3 leaf by finding the root of the
+ *  residual defined in `c3_coupled_equations` using Brent's method.
+ *
+ *  The root is first bracketed using bounds that follow from the FvCB model:
+ *  - Since `Ci(A) > Ca` for `A < 0`, and the FvCB rate never falls below its
+ *    value at `Ci = 0`, the residual is negative at `A = -Rd` whenever `Ca` is
+ *    above the CO2 compensation point, and otherwise at one unit below the
+ *    FvCB rate at `Ci = 0`.
+ *  - Since `Ci(A) <= Ca` for `A >= 0`, and the FvCB rate increases with `Ci`,
+ *    the residual is positive just above the larger of 0 and the FvCB rate at
+ *    `Ci = Ca`; a margin of `Tol` keeps rounding errors from spoiling this
+ *    bound when the root is on the TPU-limited plateau, where the FvCB rate
+ *    does not depend on `Ci`. The upper bound is also limited to stay just
+ *    below the rate at which the CO2 concentration at the leaf surface would
+ *    become negative.
+ *
+ *  The bracket is then narrowed using up to two closed-form estimates from
+ *  `c3_coupled_equations::fixed_conductance_assim()`, the first using the
+ *  stomatal conductance at the upper bound and the second using the
+ *  conductance at the first estimate. Because the stomatal conductance changes
+ *  much more slowly with `A` than the FvCB rate does, these estimates are
+ *  usually close to the root. A closed-form solution of the full coupled
+ *  equations is not available, since the leaf surface humidity in the
+ *  Ball-Berry model is itself the root of a quadratic equation that depends on
+ *  `A`, so Brent's method finishes the job.
+ *
+ *  Brent's method combines bisection with secant and inverse quadratic
+ *  interpolation steps, so it always converges for a bracketed root and
+ *  usually does so superlinearly. It stops when the bracket is narrower than
+ *  `Tol` or the residual is smaller than `Tol`. Its steps are taken in
+ *  `double` arithmetic; the root is then refined by one Newton step, using
+ *  the derivative of the residual at the best estimate found with a dual
+ *  number. This step is carried out with the `scalar` type, so that
+ *  derivatives computed with dual numbers are those of the exact solution,
+ *  even if the step itself is rejected for leaving the bracket.
+ *
+ *  Unlike the fixed point iteration, this method never returns an unconverged
+ *  result: a `std::runtime_error` is thrown if the root cannot be bracketed or
+ *  the iteration limit is reached.
+ *
+ *  @param [in] eqs The coupled equations to solve.
+ *
+ *  @param [out] iterations The number of residual evaluations after the root
+ *              was bracketed.
+ *
+ *  @return The state of the leaf at the root.
+ */
+template <typename scalar>
+c3_coupled_state<scalar> c3_solve_bracketed(
+    c3_coupled_equations<scalar> const& eqs,
+    int& iterations)
+{
+    using physical_constants::dr_boundary;
+    using std::abs;
+
+    double const Tol{1e-6};  // micromol / m^2 / s
+    int const max_iter{100};
+    double const eps = std::numeric_limits<double>::epsilon();
+
+    auto R = [&eqs](double A) {
+        return value_of(eqs.evaluate(scalar(A)).residual);
+    };
+
+    // Lower end of the bracket
+    double a = -value_of(eqs.Rd);  // micromol / m^2 / s
+    double fa = R(a);              // micromol / m^2 / s
+    if (fa > 0) {
+        a = value_of(eqs.FvCB(0.0).An) - 1.0;
+        fa = R(a);
+    }
+
+    // Upper end of the bracket; `A_cs` is the rate where Cs would be 0
+    double const A_cs = value_of(eqs.Ca * eqs.gbw / dr_boundary);  // micromol / m^2 / s
+    double b = std::min(
+        std::max(value_of(eqs.FvCB(eqs.Ca).An), 0.0) + Tol,
+        A_cs * (1.0 - 1e-9));  // micromol / m^2 / s
+    c3_coupled_state<scalar> const sb = eqs.evaluate(scalar(b));
+    double fb = value_of(sb.residual);  // micromol / m^2 / s
+
+    if (fa > 0 || fb < 0) {
+        throw std::runtime_error(
+            "Thrown in c3photoC: the assimilation rate could not be bracketed.");
+    }
+
+    iterations = 0;
+
+    // Narrow the bracket using closed-form solutions for fixed values of the
+    // stomatal conductance, starting from its value at the upper bound
+    double Gs = value_of(sb.Gs);  // mol / m^2 / s
+    for (int k = 0; k < 2; ++k) {
+        double const A0 = eqs.fixed_conductance_assim(Gs);  // micromol / m^2 / s
+        if (!(A0 > a && A0 < b)) {
+            break;
+        }
+        c3_coupled_state<scalar> const s0 = eqs.evaluate(scalar(A0));
+        double const f0 = value_of(s0.residual);
+        Gs = value_of(s0.Gs);
+        ++iterations;
+        if (f0 < 0) {
+            a = A0;
+            fa = f0;
+        } else {
+            b = A0;
+            fb = f0;
+        }
+    }
+
+    // Brent's method, where `b` is the best estimate of the root and `c` is
+    // the other end of the bracket
+    double c = a, fc = fa;
+    double d = b - a, e = d;
+
+    while (fb != 0.0) {
+        if ((fb > 0) == (fc > 0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+
+        if (abs(fc) < abs(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        double const tol1 = 2.0 * eps * abs(b) + 0.5 * Tol;
+        double const xm = 0.5 * (c - b);
+
+        if (abs(xm) <= tol1 || abs(fb) < Tol) {
+            break;
+        }
+
+        if (iterations >= max_iter) {
+            throw std::runtime_error(
+                "Thrown in c3photoC: the assimilation rate did not converge.");
+        }
+
+        if (abs(e) >= tol1 && abs(fa) > abs(fb)) {
+            // Attempt an interpolation step
+            double p, q;
+            double const s = fb / fa;
+            if (a == c) {
+                // Secant
+                p = 2.0 * xm * s;
+                q = 1.0 - s;
+            } else {
+                // Inverse quadratic
+                double const qa = fa / fc;
+                double const r = fb / fc;
+                p = s * (2.0 * xm * qa * (qa - r) - (b - a) * (r - 1.0));
+                q = (qa - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0) {
+                q = -q;
+            }
+            p = abs(p);
+
+            if (2.0 * p < std::min(3.0 * xm * q - abs(tol1 * q), abs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = xm;
+                e = d;
+            }
+        } else {
+            // Bisection
+            d = xm;
+            e = d;
+        }
+
+        a = b;
+        fa = fb;
+        b += abs(d) > tol1 ? d : (xm > 0 ? tol1 : -tol1);
+        fb = R(b);
+        ++iterations;
+    }
+
+    // Refine the root with a Newton step in the `scalar` type, using the
+    // derivative of the residual at `b`. If the step would leave the final
+    // bracket, `b` is kept, but the part of the step that depends on the
+    // derivatives of the coefficients is still applied, so the derivatives of
+    // the result are those given by the implicit function theorem
+    double const slope =
+        eqs.as_dual().evaluate(dual(b, 1.0)).residual.derivative;  // dimensionless
+    c3_coupled_state<scalar> const s = eqs.evaluate(scalar(b));
+
+    if (!(slope > 0)) {
+        return s;
+    }
+
+    double const b_refined = b - fb / slope;  // micromol / m^2 / s
+
+    scalar const step_residual =
+        b_refined >= std::min(b, c) && b_refined <= std::max(b, c)
+            ? s.residual
+            : s.residual - fb;  // micromol / m^2 / s
+
+    return eqs.evaluate(scalar(b) - step_residual / slope);
+}
+
+/**
+ *  @brief Determines the net CO2 assimilation rate, stomatal conductance, and
+ *  intercellular CO2 concentration for a C3 leaf by solving the coupled FvCB
+ *  model (`FvCB_assim()`), Ball-Berry model (`ball_berry_gs()`), and CO2
+ *  diffusion equations.
+ *
+ *  By default, the equations are solved by iterating the FvCB and Ball-Berry
+ *  models until the assimilation rate converges. This is simple but may take
+ *  hundreds of iterations, and the result is returned without warning if the
+ *  iteration limit is reached. Alternatively, the root of the assimilation rate
+ *  residual can be found using `c3_solve_bracketed()`, which usually takes
+ *  fewer than ten steps and throws an exception if it fails.
+ *
+ *  This function is templated on the scalar type used for its calculations so
+ *  it can be used with automatic differentiation, e.g. `c3photoC<dual>()`;
+ *  see `dual_number.h`.
+ */
+template <typename scalar = double>
+basic_photosynthesis_outputs<scalar> c3photoC(
+    non_deduced_t<scalar> const absorbed_ppfd,                // micromol / m^2 / s
+    non_deduced_t<scalar> const Tleaf,                        // degrees C
+    non_deduced_t<scalar> const Tambient,                     // degrees C
+    non_deduced_t<scalar> const RH,                           // dimensionless
+    non_deduced_t<scalar> const Vcmax0,                       // micromol / m^2 / s
+    non_deduced_t<scalar> const Jmax0,                        // micromol / m^2 / s
+    non_deduced_t<scalar> const TPU_rate_max,                 // micromol / m^2 / s
+    non_deduced_t<scalar> const Rd0,                          // micromol / m^2 / s
+    non_deduced_t<scalar> const b0,                           // mol / m^2 / s
+    non_deduced_t<scalar> const b1,                           // dimensionless
+    non_deduced_t<scalar> const Gs_min,                       // mol / m^2 / s
+    non_deduced_t<scalar> const Ca,                           // micromol / mol
+    non_deduced_t<scalar> const AP,                           // Pa (TEMPORARILY UNUSED)
+    non_deduced_t<scalar> const O2,                           // millimol / mol (atmospheric oxygen mole fraction)
+    non_deduced_t<scalar> const thet,                         // dimensionless
+    non_deduced_t<scalar> const StomWS,                       // dimensionless
+    non_deduced_t<scalar> const electrons_per_carboxylation,  // self-explanatory units
+    non_deduced_t<scalar> const electrons_per_oxygenation,    // self-explanatory units
+    non_deduced_t<scalar> const beta_PSII,                    // dimensionless (fraction of absorbed light that reaches photosystem II)
+    non_deduced_t<scalar> const gbw,                          // mol / m^2 / s
+    c3_solver_method const solver = c3_solver_method::fixed_point)
+{
+    using conversion_constants::celsius_to_kelvin;
+    using physical_constants::dr_boundary;
+    using physical_constants::dr_stomata;
+    using physical_constants::ideal_gas_constant;
+    using std::abs;
+
+    standardBML::profile_timer timer("c3photoC");
+
+    // Get leaf temperature in Kelvin
+    scalar const Tleaf_K = Tleaf + celsius_to_kelvin;  // K
+
+    // Temperature corrections are from the following sources:
+    // - Bernacchi et al. (2003) Plant, Cell and Environment, 26(9), 1419-1430.
+    //   https://doi.org/10.1046/j.0016-8025.2003.01050.x
+    // - Bernacchi et al. (2001) Plant, Cell and Environment, 24(2), 253-259.
+    //   https://doi.org/10.1111/j.1365-3040.2001.00668.x
+    // Note: Values in Dubois and Bernacchi are incorrect.
+    scalar const Kc = arrhenius_exponential<scalar>(38.05, 79.43e3, Tleaf_K);              // micromol / mol
+    scalar const Ko = arrhenius_exponential<scalar>(20.30, 36.38e3, Tleaf_K);              // mmol / mol
+    scalar const Gstar = arrhenius_exponential<scalar>(19.02, 37.83e3, Tleaf_K);           // micromol / mol
+    scalar const Vcmax = Vcmax0 * arrhenius_exponential<scalar>(26.35, 65.33e3, Tleaf_K);  // micromol / m^2 / s
+    scalar const Jmax = Jmax0 * arrhenius_exponential<scalar>(17.57, 43.54e3, Tleaf_K);    // micromol / m^2 / s
+    scalar const Rd = Rd0 * arrhenius_exponential<scalar>(18.72, 46.39e3, Tleaf_K);        // micromol / m^2 / s
+
+    scalar const theta = thet + 0.018 * Tleaf - 3.7e-4 * pow(Tleaf, 2);  // dimensionless
+
+    // Light limited
+    scalar const dark_adapted_phi_PSII =
+        0.352 + 0.022 * Tleaf - 3.4 * pow(Tleaf, 2) / 1e4;  // dimensionless (Bernacchi et al. (2003))
+
+    // The variable that we call `I2` here has been described as "the useful
+    // light absorbed by photosystem II" (S. von Caemmerer (2002)) and "the
+    // maximum fraction of incident quanta that could be utilized in electron
+    // transport" (Bernacchi et al. (2003)). Here we calculate its value using
+    // Equation 3 from Bernacchi et al. (2003), except that we have replaced the
+    // factor `Q * alpha_leaf` (the product of the incident PPFD `Q` and the
+    // leaf absorptance) with the absorbed PPFD, as this is clearly the intended
+    // meaning of the `Q * alpha_leaf` factor. See also Equation 8 from the
+    // original FvCB paper, where `J` (equivalent to our `I2`) is proportional
+    // to the absorbed PPFD rather than the incident PPFD.
+    scalar const I2 =
+        absorbed_ppfd * dark_adapted_phi_PSII * beta_PSII;  // micromol / m^2 / s
+
+    scalar const J =
+        (Jmax + I2 - sqrt(pow(Jmax + I2, 2) - 4.0 * theta * I2 * Jmax)) /
+        (2.0 * theta);  // micromol / m^2 / s
+
+    scalar const Oi = O2 * solo<scalar>(Tleaf);  // mmol / mol
+
+    // TPU rate temperature dependence from Figure 7, Yang et al. (2016) Planta,
+    // 243, 687-698. https://doi.org/10.1007/s00425-015-2436-8
+    //
+    // In Yang et al., the equation in the caption of Figure 7 calculates the
+    // maximum rate of TPU utilization, but here we need the rate relative to
+    // its value at 25 degrees C (as shown in the figure itself). Using the
+    // equation, the rate at 25 degrees C can be found to have the value
+    // 306.742, so here we normalize the equation by this value.
+    double const TPU_c = 25.5;                                                       // dimensionless (fitted constant)
+    double const Ha = 62.99e3;                                                       // J / mol (enthalpy of activation)
+    double const S = 0.588e3;                                                        // J / K / mol (entropy)
+    double const Hd = 182.14e3;                                                      // J / mol (enthalpy of deactivation)
+    double const R = ideal_gas_constant;                                             // J / K / mol (ideal gas constant)
+    scalar const top = Tleaf_K * arrhenius_exponential<scalar>(TPU_c, Ha, Tleaf_K);  // dimensionless
+    scalar const bot = 1.0 + arrhenius_exponential<scalar>(S / R, Hd, Tleaf_K);      // dimensionless
+    scalar TPU_rate_multiplier = (top / bot) / 306.742;                              // dimensionless
+
+    scalar TPU = TPU_rate_max * TPU_rate_multiplier;  // micromol / m^2 / s
+
+    // The alpha constant for calculating Ap is from Eq. 2.26, von Caemmerer, S.
+    // Biochemical models of leaf photosynthesis.
+    double const alpha_TPU = 0.0;  // dimensionless. Without more information, alpha=0 is often assumed.
+
+    // Adjust Ball-Berry parameters in response to water stress
+    scalar const b0_adj = StomWS * b0 + Gs_min * (1.0 - StomWS);
+    scalar const b1_adj = StomWS * b1;
+
+    if (solver == c3_solver_method::bracketed) {
+        c3_coupled_equations<scalar> const eqs{
+            Ca, RH, b0_adj, b1_adj, gbw, Tleaf, Tambient,
+            Gstar, J, Kc, Ko, Oi, Rd, TPU, Vcmax, alpha_TPU,
+            electrons_per_carboxylation, electrons_per_oxygenation};
+
+        int iterations{0};
+        c3_coupled_state<scalar> const s = c3_solve_bracketed(eqs, iterations);
+
+        standardBML::record_iterations("c3photoC_bracketed", iterations);
+
+        return basic_photosynthesis_outputs<scalar>{
+            /* .Assim = */ s.assimilation,                 // micromol / m^2 / s
+            /* .Assim_conductance = */ s.an_conductance,   // micromol / m^2 / s
+            /* .Ci = */ s.Ci,                              // micromol / mol
+            /* .GrossAssim = */ s.FvCB_res.Vc,             // micromol / m^2 / s
+            /* .Gs = */ s.Gs * 1e3,                        // mmol / m^2 / s
+            /* .Cs = */ s.BB_res.cs,                       // micromol / m^2 / s
+            /* .RHs = */ s.BB_res.hs,                      // dimensionless from Pa / Pa
+            /* .Rp = */ s.FvCB_res.Vc * Gstar / s.Ci,      // micromol / m^2 / s
+            /* .iterations = */ iterations                 // not a physical quantity
+        };
+    }
+
+    // Initialize variables before running fixed point iteration in a loop
+    basic_FvCB_outputs<scalar> FvCB_res;
+    basic_stomata_outputs<scalar> BB_res;
+    scalar an_conductance{};            // micromol / m^2 / s
+    scalar Gs{1e3};                     // mol / m^2 / s      (initial guess)
+    scalar Ci{0.0};                     // micromol / mol     (initial guess)
+    scalar co2_assimilation_rate{0.0};  // micromol / m^2 / s (initial guess)
+    double const Tol{0.01};             // micromol / m^2 / s
+    int iterCounter{0};
+    int max_iter{1000};
+
+    // Run iteration loop
+    while (iterCounter < max_iter) {
+        scalar OldAssim = co2_assimilation_rate;  // micromol / m^2 / s
+
+        // The net CO2 assimilation is the smaller of the biochemistry-limited
+        // and conductance-limited rates. This will prevent the calculated Ci
+        // value from ever being < 0. This seems to be an important restriction
+        // to prevent numerical errors during the convergence loop, but does not
+        // actually limit the net assimilation rate if the loop converges.
+        an_conductance =
+            conductance_limited_assim<scalar>(Ca, gbw, Gs);  // micromol / m^2 / s
+
+        FvCB_res = FvCB_assim<scalar>(
+            Ci,
+            Gstar,
+            J,
+            Kc,
+            Ko,
+            Oi,
+            Rd,
+            TPU,
+            Vcmax,
+            alpha_TPU,
+            electrons_per_carboxylation,
+            electrons_per_oxygenation);
+
+        co2_assimilation_rate = std::min(FvCB_res.An, an_conductance);  // micromol / m^2 / s
+
+        BB_res = ball_berry_gs<scalar>(
+            co2_assimilation_rate * 1e-6,
+            Ca * 1e-6,
+            RH,
+            b0_adj,
+            b1_adj,
+            gbw,
+            Tleaf,
+            Tambient);
+
+        Gs = 1e-3 * BB_res.gsw;  // mol / m^2 / s
+
+        // Calculate Ci using the total conductance across the boundary layer
+        // and stomata
+        Ci = Ca - co2_assimilation_rate *
+                      (dr_boundary / gbw + dr_stomata / Gs);  // micromol / mol
+
+        if (abs(OldAssim - co2_assimilation_rate) < Tol) {
+            break;
+        }
+
+        ++iterCounter;
+    }
+
+    standardBML::record_iterations("c3photoC", iterCounter);
+
+    return basic_photosynthesis_outputs<scalar>{
+        /* .Assim = */ co2_assimilation_rate,       // micromol / m^2 / s
+        /* .Assim_conductance = */ an_conductance,  // micromol / m^2 / s
+        /* .Ci = */ Ci,                             // micromol / mol
+        /* .GrossAssim = */ FvCB_res.Vc,            // micromol / m^2 / s
+        /* .Gs = */ Gs * 1e3,                       // mmol / m^2 / s
+        /* .Cs = */ BB_res.cs,                      // micromol / m^2 / s
+        /* .RHs = */ BB_res.hs,                     // dimensionless from Pa / Pa
+        /* .Rp = */ FvCB_res.Vc * Gstar / Ci,       // micromol / m^2 / s
+        /* .iterations = */ iterCounter             // not a physical quantity
+    };
+}
 
 #endif
@@ -0,0 +1,322 @@
+#include <cmath>                          // for pow, sqrt, std::abs
+#include <limits>                         // for std::numeric_limits
+#include <stdexcept>                      // for std::range_error
+#include "c3photo_batch.h"
+#include "c3photo.h"                      // for solo
+#include "AuxBioCro.h"                    // for arrhenius_exponential
+#include "water_and_air_properties.h"     // for saturation_vapor_pressure
+#include "../framework/constants.h"       // for ideal_gas_constant,
+                                          //     celsius_to_kelvin, dr_stomata,
+                                          //     dr_boundary
+#include "../framework/quadratic_root.h"  // for quadratic_root_plus
+#include "module_profiler.h"              // for profile_timer,
+                                          //     record_iterations
+
+void c3photoC_batch_inputs::resize(size_t n)
+{
+    for (std::vector<double>* v :
+         {&absorbed_ppfd, &Tleaf, &Tambient, &RH, &Vcmax0, &Jmax0,
+          &TPU_rate_max, &Rd0, &b0, &b1, &Gs_min, &Ca, &AP, &O2, &thet,
+          &StomWS, &electrons_per_carboxylation, &electrons_per_oxygenation,
+          &beta_PSII, &gbw}) {
+        v->resize(n);
+    }
+}
+
+void c3photoC_batch_inputs::set(
+    size_t i,
+    double absorbed_ppfd_i,
+    double Tleaf_i,
+    double Tambient_i,
+    double RH_i,
+    double Vcmax0_i,
+    double Jmax0_i,
+    double TPU_rate_max_i,
+    double Rd0_i,
+    double b0_i,
+    double b1_i,
+    double Gs_min_i,
+    double Ca_i,
+    double AP_i,
+    double O2_i,
+    double thet_i,
+    double StomWS_i,
+    double electrons_per_carboxylation_i,
+    double electrons_per_oxygenation_i,
+    double beta_PSII_i,
+    double gbw_i)
+{
+    absorbed_ppfd[i] = absorbed_ppfd_i;
+    Tleaf[i] = Tleaf_i;
+    Tambient[i] = Tambient_i;
+    RH[i] = RH_i;
+    Vcmax0[i] = Vcmax0_i;
+    Jmax0[i] = Jmax0_i;
+    TPU_rate_max[i] = TPU_rate_max_i;
+    Rd0[i] = Rd0_i;
+    b0[i] = b0_i;
+    b1[i] = b1_i;
+    Gs_min[i] = Gs_min_i;
+    Ca[i] = Ca_i;
+    AP[i] = AP_i;
+    O2[i] = O2_i;
+    thet[i] = thet_i;
+    StomWS[i] = StomWS_i;
+    electrons_per_carboxylation[i] = electrons_per_carboxylation_i;
+    electrons_per_oxygenation[i] = electrons_per_oxygenation_i;
+    beta_PSII[i] = beta_PSII_i;
+    gbw[i] = gbw_i;
+}
+
+void c3photoC_batch(
+    c3photoC_batch_inputs const& inputs,
+    photosynthesis_batch_outputs& outputs,
+    photosynthesis_batch_outputs const* initial_guess)
+{
+    using conversion_constants::celsius_to_kelvin;
+    using physical_constants::dr_boundary;
+    using physical_constants::dr_stomata;
+    using physical_constants::ideal_gas_constant;
+    using std::abs;
+
+    // Warm-started calls are profiled separately so their iteration counts
+    // can be compared with those of calls using the fixed initial guess
+    bool const warm = initial_guess != nullptr;
+    char const* const profile_name =
+        warm ? "c3photoC_batch (warm start)" : "c3photoC_batch";
+
+    standardBML::profile_timer timer(profile_name);
+
+    size_t const n = inputs.size();
+    outputs.resize(n);
+
+    // Quantities that do not change during the iteration; see `c3photoC()`
+    // for a description of each one
+    std::vector<double> Kc(n), Ko(n), Gstar(n), Vcmax(n), Rd(n), J(n), Oi(n),
+        TPU(n), b0_adj(n), b1_adj(n), swvp_ratio(n);
+
+    double const TPU_c = 25.5;            // dimensionless (fitted constant)
+    double const Ha = 62.99e3;            // J / mol (enthalpy of activation)
+    double const S = 0.588e3;             // J / K / mol (entropy)
+    double const Hd = 182.14e3;           // J / mol (enthalpy of deactivation)
+    double const R = ideal_gas_constant;  // J / K / mol (ideal gas constant)
+    double const alpha_TPU = 0.0;         // dimensionless
+
+    for (size_t i = 0; i < n; ++i) {
+        double const Tleaf = inputs.Tleaf[i];
+        double const Tleaf_K = Tleaf + celsius_to_kelvin;  // K
+
+        Kc[i] = arrhenius_exponential(38.05, 79.43e3, Tleaf_K);                       // micromol / mol
+        Ko[i] = arrhenius_exponential(20.30, 36.38e3, Tleaf_K);                       // mmol / mol
+        Gstar[i] = arrhenius_exponential(19.02, 37.83e3, Tleaf_K);                    // micromol / mol
+        Vcmax[i] = inputs.Vcmax0[i] * arrhenius_exponential(26.35, 65.33e3, Tleaf_K);  // micromol / m^2 / s
+        Rd[i] = inputs.Rd0[i] * arrhenius_exponential(18.72, 46.39e3, Tleaf_K);        // micromol / m^2 / s
+
+        double const Jmax = inputs.Jmax0[i] * arrhenius_exponential(17.57, 43.54e3, Tleaf_K);  // micromol / m^2 / s
+
+        double const theta = inputs.thet[i] + 0.018 * Tleaf - 3.7e-4 * pow(Tleaf, 2);  // dimensionless
+
+        double const dark_adapted_phi_PSII =
+            0.352 + 0.022 * Tleaf - 3.4 * pow(Tleaf, 2) / 1e4;  // dimensionless
+
+        double const I2 =
+            inputs.absorbed_ppfd[i] * dark_adapted_phi_PSII * inputs.beta_PSII[i];  // micromol / m^2 / s
+
+        J[i] = (Jmax + I2 - sqrt(pow(Jmax + I2, 2) - 4.0 * theta * I2 * Jmax)) /
+               (2.0 * theta);  // micromol / m^2 / s
+
+        Oi[i] = inputs.O2[i] * solo(Tleaf);  // mmol / mol
+
+        double const top = Tleaf_K * arrhenius_exponential(TPU_c, Ha, Tleaf_K);  // dimensionless
+        double const bot = 1.0 + arrhenius_exponential(S / R, Hd, Tleaf_K);      // dimensionless
+        TPU[i] = inputs.TPU_rate_max[i] * ((top / bot) / 306.742);               // micromol / m^2 / s
+
+        double const StomWS = inputs.StomWS[i];
+        b0_adj[i] = StomWS * inputs.b0[i] + inputs.Gs_min[i] * (1.0 - StomWS);
+        b1_adj[i] = StomWS * inputs.b1[i];
+
+        // The saturation vapor pressures used by `ball_berry_gs()` only depend
+        // on the temperatures, so their ratio is found here
+        swvp_ratio[i] =
+            saturation_vapor_pressure(inputs.Tambient[i]) /
+            saturation_vapor_pressure(Tleaf);  // dimensionless
+    }
+
+    // Quantities that are updated during the iteration
+    double* const Assim = outputs.Assim.data();
+    double* const an_conductance = outputs.Assim_conductance.data();
+    double* const Ci = outputs.Ci.data();
+    double* const Vc = outputs.GrossAssim.data();
+    double* const Gs = outputs.Gs.data();
+    double* const Cs = outputs.Cs.data();
+    double* const hs = outputs.RHs.data();
+    int* const iterations = outputs.iterations.data();
+
+    // The fixed initial guess used by `c3photoC()`
+    double const Assim_guess{0.0};  // micromol / m^2 / s
+    double const Ci_guess{0.0};     // micromol / mol
+    double const Gs_guess{1e3};     // mol / m^2 / s
+
+    for (size_t i = 0; i < n; ++i) {
+        // The initial guess is read before anything is written, since it may
+        // be stored in `outputs`
+        double const Assim0 = warm ? initial_guess->Assim[i] : Assim_guess;  // micromol / m^2 / s
+        double const Ci0 = warm ? initial_guess->Ci[i] : Ci_guess;           // micromol / mol
+        double const Gs0 = warm ? 1e-3 * initial_guess->Gs[i] : Gs_guess;    // mol / m^2 / s
+
+        Assim[i] = Assim0;        // micromol / m^2 / s (initial guess)
+        an_conductance[i] = 0.0;  // micromol / m^2 / s
+        Ci[i] = Ci0;              // micromol / mol     (initial guess)
+        Vc[i] = 0.0;              // micromol / m^2 / s
+        Gs[i] = Gs0;              // mol / m^2 / s      (initial guess)
+        Cs[i] = 0.0;              // micromol / mol
+        hs[i] = 0.0;              // dimensionless
+        iterations[i] = 0;
+    }
+
+    // Storage for each pass; `active` is the mask of leaves that have not
+    // converged, `warm_leaf` is the mask of leaves that are still iterating
+    // from a warm start, and `change` is the change in the assimilation rate
+    std::vector<char> active(n, 1), warm_leaf(n, warm);
+    std::vector<double> change(n), Cs_mol(n), a(n), b(n), c(n), root(n, 0.0);
+
+    double const inf = std::numeric_limits<double>::infinity();
+    double const Tol{0.01};  // micromol / m^2 / s
+    int const max_iter{1000};
+
+    // A warm start is abandoned if it has not converged after this many
+    // passes, since the iteration can oscillate near the transitions between
+    // the limiting rates of the FvCB model
+    int const max_warm_iter{20};
+    int restarted_iterations{0};
+
+    size_t nactive = n;
+    while (nactive > 0) {
+        // Find the new assimilation rates from the FvCB model (as in
+        // `FvCB_assim()`) and the conductance limit, and set up the quadratic
+        // equation for the relative humidity at the leaf surface (as in
+        // `ball_berry_gs()`). Both branches of the FvCB model are evaluated
+        // and the appropriate one is selected, and only active leaves are
+        // updated.
+        bool Cs_negative = false;
+        for (size_t i = 0; i < n; ++i) {
+            bool const on = active[i];
+            double const Ca = inputs.Ca[i];
+            double const gbw = inputs.gbw[i];
+            double const C = Ci[i];
+
+            double const an_c =
+                Ca / (dr_boundary / gbw + dr_stomata / Gs[i]);  // micromol / m^2 / s
+
+            // FvCB rates when Ci is 0
+            double const Ac0 =
+                -Gstar[i] * Vcmax[i] / (Kc[i] * (1 + Oi[i] / Ko[i])) - Rd[i];
+            double const Aj0 =
+                -J[i] / (2.0 * inputs.electrons_per_oxygenation[i]) - Rd[i];
+            double const An0 = Ac0 < Aj0 ? Aj0 : Ac0;
+
+            // FvCB rates when Ci is not 0
+            double const Wc = Vcmax[i] * C / (C + Kc[i] * (1.0 + Oi[i] / Ko[i]));
+            double const Wj = J[i] * C /
+                              (inputs.electrons_per_carboxylation[i] * C +
+                               2.0 * inputs.electrons_per_oxygenation[i] * Gstar[i]);
+            double const Wp =
+                C > Gstar[i] * (1.0 + 3.0 * alpha_TPU)
+                    ? 3.0 * TPU[i] * C / (C - Gstar[i] * (1.0 + 3.0 * alpha_TPU))
+                    : inf;
+            double const a_per_c = (1.0 - Gstar[i] / C);
+            double const Wjp = Wp < Wj ? Wp : Wj;
+            double const Vc_C = Wjp < Wc ? Wjp : Wc;
+            double const An_C = a_per_c * Vc_C - Rd[i];
+
+            bool const zero = C == 0.0;
+            double const An = zero ? An0 : An_C;
+            double const A = an_c < An ? an_c : An;  // micromol / m^2 / s
+
+            // Ball-Berry model
+            double const assimilation = A * 1e-6;  // mol / m^2 / s
+            double const bb_slope = assimilation < 0 ? 0.0 : b1_adj[i];
+            double const Cs_new =
+                Ca * 1e-6 - (dr_boundary / gbw) * assimilation;  // mol / mol
+            double const a_new = bb_slope * (assimilation / Cs_new);
+
+            Cs_negative = Cs_negative || (on && Cs_new < 0.0);
+
+            change[i] = on ? A - Assim[i] : change[i];
+            Assim[i] = on ? A : Assim[i];
+            an_conductance[i] = on ? an_c : an_conductance[i];
+            Vc[i] = on ? (zero ? 0.0 : Vc_C) : Vc[i];
+            Cs_mol[i] = on ? Cs_new : Cs_mol[i];
+            a[i] = on ? a_new : a[i];
+            b[i] = on ? b0_adj[i] + gbw - a_new : b[i];
+            c[i] = on ? -inputs.RH[i] * gbw * swvp_ratio[i] - b0_adj[i] : c[i];
+        }
+
+        if (Cs_negative) {
+            throw std::range_error("Thrown in ball_berry_gs: Cs is less than 0.");
+        }
+
+        // The quadratic root is found one leaf at a time, since it is
+        // calculated by a framework function that may throw
+        for (size_t i = 0; i < n; ++i) {
+            if (active[i]) {
+                root[i] = quadratic_root_plus(a[i], b[i], c[i]);
+            }
+        }
+
+        // Find the new stomatal conductances and Ci values, and update the
+        // mask
+        bool hs_negative = false;
+        nactive = 0;
+        for (size_t i = 0; i < n; ++i) {
+            bool const on = active[i];
+            double const Ca = inputs.Ca[i];
+            double const gbw = inputs.gbw[i];
+
+            // If hs is calculated to be larger than 1, this indicates dew
+            // formation, so it is limited to 1 as in `ball_berry_gs()`
+            double const hs_new = root[i] < 1.0 ? root[i] : 1.0;  // dimensionless
+            hs_negative = hs_negative || (on && hs_new < 0);
+
+            double const Gs_new = 1e-3 * ((a[i] * hs_new + b0_adj[i]) * 1e3);  // mol / m^2 / s
+            double const Ci_new =
+                Ca - Assim[i] * (dr_boundary / gbw + dr_stomata / Gs_new);  // micromol / mol
+
+            hs[i] = on ? hs_new : hs[i];
+            Cs[i] = on ? Cs_mol[i] * 1e6 : Cs[i];
+            Gs[i] = on ? Gs_new : Gs[i];
+            Ci[i] = on ? Ci_new : Ci[i];
+
+            bool const converged = abs(change[i]) < Tol;
+            int const iter = iterations[i] + (on && !converged ? 1 : 0);
+            bool const still_active = on && !converged && iter < max_iter;
+
+            // Restart a slow warm-started leaf from the fixed initial guess;
+            // from then on, it follows exactly the same sequence as it would
+            // without a warm start
+            bool const restart = still_active && warm_leaf[i] && iter >= max_warm_iter;
+            restarted_iterations += restart ? iter : 0;
+            warm_leaf[i] = restart ? 0 : warm_leaf[i];
+            Assim[i] = restart ? Assim_guess : Assim[i];
+            Ci[i] = restart ? Ci_guess : Ci[i];
+            Gs[i] = restart ? Gs_guess : Gs[i];
+
+            iterations[i] = restart ? 0 : iter;
+            active[i] = still_active;
+            nactive += still_active;
+        }
+
+        if (hs_negative) {
+            throw std::range_error("Thrown in ball_berry_gs: hs is less than 0.");
+        }
+    }
+
+    int total_iterations = restarted_iterations;
+    for (size_t i = 0; i < n; ++i) {
+        outputs.Gs[i] = Gs[i] * 1e3;                  // mmol / m^2 / s
+        outputs.Rp[i] = Vc[i] * Gstar[i] / Ci[i];     // micromol / m^2 / s
+        total_iterations += iterations[i];
+    }
+
+    standardBML::record_iterations(profile_name, total_iterations);
+}
@@ -0,0 +1,106 @@
+#ifndef C3PHOTO_BATCH_H
+#define C3PHOTO_BATCH_H
+
+#include <cstddef>                   // for size_t
+#include <vector>                    // for std::vector
+#include "photosynthesis_outputs.h"  // for photosynthesis_batch_outputs
+
+/**
+ *  @brief A structure of arrays holding the `c3photoC()` arguments for a batch
+ *  of leaves, where element `i` of each array belongs to leaf `i`.
+ *
+ *  Values can be set for one leaf at a time using `set()`, whose arguments are
+ *  in the same order as the arguments of `c3photoC()`.
+ */
+struct c3photoC_batch_inputs {
+    std::vector<double> absorbed_ppfd;                // micromol / m^2 / s
+    std::vector<double> Tleaf;                        // degrees C
+    std::vector<double> Tambient;                     // degrees C
+    std::vector<double> RH;                           // dimensionless
+    std::vector<double> Vcmax0;                       // micromol / m^2 / s
+    std::vector<double> Jmax0;                        // micromol / m^2 / s
+    std::vector<double> TPU_rate_max;                 // micromol / m^2 / s
+    std::vector<double> Rd0;                          // micromol / m^2 / s
+    std::vector<double> b0;                           // mol / m^2 / s
+    std::vector<double> b1;                           // dimensionless
+    std::vector<double> Gs_min;                       // mol / m^2 / s
+    std::vector<double> Ca;                           // micromol / mol
+    std::vector<double> AP;                           // Pa (TEMPORARILY UNUSED)
+    std::vector<double> O2;                           // millimol / mol
+    std::vector<double> thet;                         // dimensionless
+    std::vector<double> StomWS;                       // dimensionless
+    std::vector<double> electrons_per_carboxylation;  // self-explanatory units
+    std::vector<double> electrons_per_oxygenation;    // self-explanatory units
+    std::vector<double> beta_PSII;                    // dimensionless
+    std::vector<double> gbw;                          // mol / m^2 / s
+
+    explicit c3photoC_batch_inputs(size_t n = 0) { resize(n); }
+
+    void resize(size_t n);
+
+    size_t size() const { return absorbed_ppfd.size(); }
+
+    void set(
+        size_t i,
+        double absorbed_ppfd,
+        double Tleaf,
+        double Tambient,
+        double RH,
+        double Vcmax0,
+        double Jmax0,
+        double TPU_rate_max,
+        double Rd0,
+        double b0,
+        double b1,
+        double Gs_min,
+        double Ca,
+        double AP,
+        double O2,
+        double thet,
+        double StomWS,
+        double electrons_per_carboxylation,
+        double electrons_per_oxygenation,
+        double beta_PSII,
+        double gbw);
+};
+
+/**
+ *  @brief Evaluates `c3photoC()` for a batch of leaves at once.
+ *
+ *  The calculations are arranged as loops over the leaves of the batch, with
+ *  the data for each quantity stored contiguously, so they can be vectorized by
+ *  the compiler. The temperature responses and other quantities that do not
+ *  change during the fixed point iteration are found once for all the leaves
+ *  before it starts. Then each pass of the iteration updates every leaf that
+ *  has not converged yet, using a mask in place of the early exit from the
+ *  scalar loop, until all of them have converged or reached the iteration
+ *  limit.
+ *
+ *  Each leaf goes through exactly the same operations as in `c3photoC()`, so
+ *  the results are identical to calling it separately for each leaf, unless
+ *  an `initial_guess` is provided.
+ *
+ *  @param [in] inputs The arguments to `c3photoC()` for each leaf.
+ *
+ *  @param [out] outputs The results for each leaf; it is resized to match the
+ *               number of leaves in `inputs`.
+ *
+ *  @param [in] initial_guess Optional results for the same leaves from an
+ *              earlier call, such as those stored by a
+ *              `photosynthesis_warm_start`. If it is provided, the iteration for
+ *              each leaf starts from its assimilation rate, stomatal
+ *              conductance, and intercellular CO2 concentration instead of the
+ *              fixed initial guess used by `c3photoC()`, which usually reduces
+ *              the number of iterations; the results then agree with those of
+ *              `c3photoC()` to within the tolerance of the iteration. A leaf
+ *              that has not converged after 20 passes is restarted from the
+ *              fixed initial guess, so a poor guess cannot prevent convergence.
+ *              It must hold results for the same number of leaves as `inputs`, and it
+ *              may be the same object as `outputs`.
+ */
+void c3photoC_batch(
+    c3photoC_batch_inputs const& inputs,
+    photosynthesis_batch_outputs& outputs,
+    photosynthesis_batch_outputs const* initial_guess = nullptr);
+
+#endif
@@ -70,8 +70,26 @@ class c4_assimilation : public direct_module
     c4_assimilation(
         state_map const& input_quantities,
         state_map* output_quantities)
+        : c4_assimilation{
+              input_quantities,
+              output_quantities,
+              c4_solver_method::fixed_point}
+    {
+    }
+    static string_vector get_inputs();
+    static string_vector get_outputs();
+    static std::string get_name() { return "c4_assimilation"; }
+
+   protected:
+    c4_assimilation(
+        state_map const& input_quantities,
+        state_map* output_quantities,
+        c4_solver_method solver)
         : direct_module{},
 
+          // Store the solver method
+          solver{solver},
+
           // Get pointers to input quantities
           Qp{get_input(input_quantities, "Qp")},
           Tleaf{get_input(input_quantities, "Tleaf")},
@@ -105,11 +123,11 @@ class c4_assimilation : public direct_module
           iterations_op{get_op(output_quantities, "iterations")}
     {
     }
-    static string_vector get_inputs();
-    static string_vector get_outputs();
-    static std::string get_name() { return "c4_assimilation"; }
 
    private:
+    // Method for solving the coupled equations
+    c4_solver_method const solver;
+
     // References to input quantities
     double const& Qp;
     double const& Tleaf;
@@ -207,7 +225,8 @@ void c4_assimilation::do_operation() const
         atmospheric_pressure,
         upperT,
         lowerT,
-        gbw);
+        gbw,
+        solver);
 
     // Update the output quantity list
     update(Assim_op, c4_results.Assim);
@@ -221,5 +240,37 @@ void c4_assimilation::do_operation() const
     update(iterations_op, c4_results.iterations);
 }
 
+/**
+ * @class c4_assimilation_newton
+ *
+ * @brief A child class of c4_assimilation that solves the coupled equations
+ * with a safeguarded Newton method rather than by fixed point iteration; see
+ * `c4_solve_newton()`.
+ *
+ * This module has the same inputs and outputs as `c4_assimilation`, and its
+ * results agree with those of `c4_assimilation` to within the tolerance of the
+ * fixed point iteration whenever the iteration converges. Unlike
+ * `c4_assimilation`, it does not switch to the Ball-Berry intercept when the
+ * iteration is slow to converge, so its results change smoothly with the
+ * inputs, including under water stress. Here, ``'iterations'`` is the number
+ * of residual evaluations, which is usually fewer than ten. An error is thrown
+ * if the root cannot be found, so a simulation never continues with an
+ * unconverged result.
+ */
+class c4_assimilation_newton : public c4_assimilation
+{
+   public:
+    c4_assimilation_newton(
+        state_map const& input_quantities,
+        state_map* output_quantities)
+        : c4_assimilation{
+              input_quantities,
+              output_quantities,
+              c4_solver_method::newton}
+    {
+    }
+    static std::string get_name() { return "c4_assimilation_newton"; }
+};
+
 }  // namespace standardBML
 #endif
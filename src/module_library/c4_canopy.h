@@ -3,7 +3,8 @@
 
 #include "../framework/module.h"
 #include "../framework/state_map.h"
-#include "CanAC.h"  // For CanAC
+#include "CanAC.h"                      // For CanAC
+#include "photosynthesis_warm_start.h"  // for photosynthesis_warm_start
 
 namespace standardBML
 {
@@ -13,8 +14,23 @@ class c4_canopy : public direct_module
     c4_canopy(
         state_map const& input_quantities,
         state_map* output_quantities)
+        : c4_canopy{input_quantities, output_quantities, nullptr}
+    {
+    }
+    static string_vector get_inputs();
+    static string_vector get_outputs();
+    static std::string get_name() { return "c4_canopy"; }
+
+   protected:
+    c4_canopy(
+        state_map const& input_quantities,
+        state_map* output_quantities,
+        double const* time_ip)
         : direct_module{},
 
+          // Store the pointer to the time, which is only needed for warm starts
+          time_ip{time_ip},
+
           // Get pointers to input quantities
           nileafn{get_input(input_quantities, "nileafn")},
           nkln{get_input(input_quantities, "nkln")},
@@ -73,11 +89,14 @@ class c4_canopy : public direct_module
           canopy_photorespiration_rate_op{get_op(output_quantities, "canopy_photorespiration_rate")}
     {
     }
-    static string_vector get_inputs();
-    static string_vector get_outputs();
-    static std::string get_name() { return "c4_canopy"; }
 
    private:
+    // Pointer to the time, or nullptr if warm starts are disabled
+    double const* const time_ip;
+
+    // Converged photosynthesis results for each leaf class and layer
+    photosynthesis_warm_start mutable warm_start;
+
     // References to input quantities
     double const& nileafn;
     double const& nkln;
@@ -220,13 +239,21 @@ void c4_canopy::do_operation() const
     nitroP.lnb0 = nlnb0;
     nitroP.lnb1 = nlnb1;
 
+    // Warm starts are only used when a pointer to the time is available
+    photosynthesis_warm_start* ws = nullptr;
+    if (time_ip) {
+        warm_start.update(*time_ip, lai);
+        ws = &warm_start;
+    }
+
     canopy_photosynthesis_outputs can_result = CanAC(
         lai, cosine_zenith_angle, solar, temp, rh, windspeed, nlayers, vmax1,
         alpha1, kparm, beta, Rd, Catm, b0, b1, Gs_min, theta, kd, chil, LeafN,
         kpLN, lnfun, upperT, lowerT, nitroP, leafwidth, et_equation, StomataWS,
         specific_heat_of_air, atmospheric_pressure, atmospheric_transmittance,
         atmospheric_scattering, absorptivity_par, par_energy_content,
-        par_energy_fraction, leaf_transmittance, leaf_reflectance, minimum_gbw);
+        par_energy_fraction, leaf_transmittance, leaf_reflectance, minimum_gbw,
+        ws);
 
     // Update the parameter list
     update(canopy_assimilation_rate_op, can_result.Assim);         // Mg / ha / hr
@@ -236,5 +263,41 @@ void c4_canopy::do_operation() const
     update(canopy_photorespiration_rate_op, can_result.Rp);        // Mg / ha / hr
 }
 
+/**
+ * @class c4_canopy_warm_start
+ *
+ * @brief A child class of c4_canopy that starts the photosynthesis iteration
+ * for each leaf class and layer from its results at an earlier time,
+ * rather than from a fixed guess; see `photosynthesis_warm_start`.
+ *
+ * This module has the same inputs as `c4_canopy`, along with ``'time'``, which
+ * is used to discard the previous results whenever time goes backwards. Its
+ * outputs agree with those of `c4_canopy` to within the tolerance of the
+ * photosynthesis iteration. The number of iterations is recorded in the
+ * simulation profile under `c4photoC_batch (warm start)`.
+ */
+class c4_canopy_warm_start : public c4_canopy
+{
+   public:
+    c4_canopy_warm_start(
+        state_map const& input_quantities,
+        state_map* output_quantities)
+        : c4_canopy{
+              input_quantities,
+              output_quantities,
+              get_ip(input_quantities, "time")}
+    {
+    }
+    static string_vector get_inputs();
+    static std::string get_name() { return "c4_canopy_warm_start"; }
+};
+
+string_vector c4_canopy_warm_start::get_inputs()
+{
+    string_vector inputs = c4_canopy::get_inputs();
+    inputs.push_back("time");  // days
+    return inputs;
+}
+
 }  // namespace standardBML
 #endif
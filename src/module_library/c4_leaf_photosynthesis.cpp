@@ -1,6 +1,8 @@
+#include <vector>
 #include "c4_leaf_photosynthesis.h"
-#include "c4photo.h"  // for c4photoC
-#include "BioCro.h"   // for EvapoTrans2
+#include "c4photo.h"        // for c4photoC
+#include "c4photo_batch.h"  // for c4photoC_batch
+#include "BioCro.h"         // for EvapoTrans2
 
 using standardBML::c4_leaf_photosynthesis;
 
@@ -100,3 +102,133 @@ void c4_leaf_photosynthesis::do_operation() const
     update(leaf_temperature_op, leaf_temperature);
     update(gbw_op, et.boundary_layer_conductance);
 }
+
+namespace
+{
+// Positions of the quantities in `get_inputs()` and `get_outputs()`, which are
+// needed by `run_batch()`; these must be kept in the same order
+enum input_index : size_t {
+    in_incident_ppfd,
+    in_temp,
+    in_rh,
+    in_vmax1,
+    in_alpha1,
+    in_kparm,
+    in_theta,
+    in_beta,
+    in_Rd,
+    in_b0,
+    in_b1,
+    in_Gs_min,
+    in_StomataWS,
+    in_Catm,
+    in_atmospheric_pressure,
+    in_upperT,
+    in_lowerT,
+    in_average_absorbed_shortwave,
+    in_absorbed_shortwave,
+    in_windspeed,
+    in_leafwidth,
+    in_specific_heat_of_air,
+    in_minimum_gbw,
+    in_et_equation
+};
+
+enum output_index : size_t {
+    out_Assim,
+    out_GrossAssim,
+    out_Rp,
+    out_Ci,
+    out_Gs,
+    out_Cs,
+    out_RHs,
+    out_TransR,
+    out_EPenman,
+    out_EPriestly,
+    out_leaf_temperature,
+    out_gbw
+};
+}  // namespace
+
+/**
+ * @brief Performs the same calculations as `do_operation()` for several leaves
+ * at once, using `c4photoC_batch()` for each of the two photosynthesis
+ * calculations; see `MLCP::leaf_batch` for a description of the arguments.
+ *
+ * If `warm_start` is not `nullptr`, the first calculation for each leaf starts
+ * from its results at the previous call, if they are available, and the second
+ * starts from the first; the final results are then stored in `warm_start`.
+ */
+void c4_leaf_photosynthesis::run_batch(
+    size_t nleaves,
+    size_t ninputs,
+    size_t noutputs,
+    const double* input_values,
+    const size_t* input_slots,
+    double* output_values,
+    photosynthesis_warm_start* warm_start)
+{
+    // Make an initial guess for boundary layer conductance
+    double const gbw_guess{1.2};  // mol / m^2 / s
+
+    auto in = [=](size_t i, input_index j) {
+        return input_values[input_slots[i * ninputs + j]];
+    };
+
+    // Get an initial estimate of stomatal conductance for each leaf, assuming
+    // the leaf is at air temperature
+    c4photoC_batch_inputs leaves(nleaves);
+    for (size_t i = 0; i < nleaves; ++i) {
+        leaves.set(
+            i, in(i, in_incident_ppfd), in(i, in_temp), in(i, in_temp),
+            in(i, in_rh), in(i, in_vmax1), in(i, in_alpha1), in(i, in_kparm),
+            in(i, in_theta), in(i, in_beta), in(i, in_Rd), in(i, in_b0),
+            in(i, in_b1), in(i, in_Gs_min), in(i, in_StomataWS), in(i, in_Catm),
+            in(i, in_atmospheric_pressure), in(i, in_upperT), in(i, in_lowerT),
+            gbw_guess);
+    }
+
+    photosynthesis_batch_outputs photo;
+    c4photoC_batch(
+        leaves, photo,
+        warm_start ? warm_start->initial_guess(nleaves) : nullptr);
+
+    // Calculate a new value for leaf temperature using the estimate for
+    // stomatal conductance
+    std::vector<ET_Str> et(nleaves);
+    for (size_t i = 0; i < nleaves; ++i) {
+        et[i] = EvapoTrans2(
+            in(i, in_absorbed_shortwave), in(i, in_average_absorbed_shortwave),
+            in(i, in_temp), in(i, in_rh), in(i, in_windspeed), photo.Gs[i],
+            in(i, in_leafwidth), in(i, in_specific_heat_of_air),
+            in(i, in_minimum_gbw), in(i, in_et_equation));
+
+        leaves.leaf_temperature[i] = in(i, in_temp) + et[i].Deltat;  // deg. C
+        leaves.gbw[i] = et[i].boundary_layer_conductance;             // mol / m^2 / s
+    }
+
+    // Calculate final values for assimilation, stomatal conductance, and Ci
+    // using the new leaf temperatures
+    c4photoC_batch(leaves, photo, warm_start ? &photo : nullptr);
+
+    if (warm_start) {
+        warm_start->store(photo);
+    }
+
+    // Update the outputs
+    for (size_t i = 0; i < nleaves; ++i) {
+        double* out = output_values + i * noutputs;
+        out[out_Assim] = photo.Assim[i];
+        out[out_GrossAssim] = photo.GrossAssim[i];
+        out[out_Rp] = photo.Rp[i];
+        out[out_Ci] = photo.Ci[i];
+        out[out_Gs] = photo.Gs[i];
+        out[out_Cs] = photo.Cs[i];
+        out[out_RHs] = photo.RHs[i];
+        out[out_TransR] = et[i].TransR;
+        out[out_EPenman] = et[i].EPenman;
+        out[out_EPriestly] = et[i].EPriestly;
+        out[out_leaf_temperature] = leaves.leaf_temperature[i];
+        out[out_gbw] = et[i].boundary_layer_conductance;
+    }
+}
@@ -1,27 +1,487 @@
 #ifndef C4PHOTO_H
 #define C4PHOTO_H
 
-#include "photosynthesis_outputs.h"  // for photosynthesis_outputs
-
-photosynthesis_outputs c4photoC(
-    double const Qp,
-    double const leaf_temperature,
-    double const ambient_temperature,
-    double const relative_humidity,
-    double const vmax,
-    double const alpha,
-    double const kparm,
-    double const theta,
-    double const beta,
-    double const Rd,
-    double const bb0,
-    double const bb1,
-    double const Gs_min,
-    double const StomaWS,
-    double const Ca,
-    double const atmospheric_pressure,
-    double const upperT,
-    double const lowerT,
-    double const gbw);
+#include <cmath>                          // for pow, exp, std::abs
+#include <algorithm>                      // for std::min, std::max
+#include <limits>                         // for std::numeric_limits
+#include <stdexcept>                      // for std::runtime_error
+#include "ball_berry_gs.h"                // for ball_berry_gs
+#include "conductance_limited_assim.h"    // for conductance_limited_assim
+#include "../framework/constants.h"       // for dr_stomata, dr_boundary
+#include "../framework/quadratic_root.h"  // for quadratic_root_min
+#include "module_profiler.h"              // for profile_timer, record_iterations
+#include "dual_number.h"                  // for non_deduced_t, dual, value_of
+#include "photosynthesis_outputs.h"       // for photosynthesis_outputs
+
+/**
+ *  @brief Methods for solving the coupled equations in `c4photoC()`.
+ */
+enum class c4_solver_method {
+    fixed_point,  //!< Alternately apply the Collatz and Ball-Berry models until the assimilation rate stops changing
+    newton        //!< Find the root of the intercellular CO2 residual using a safeguarded Newton method
+};
+
+/**
+ *  @brief The quantities of a C4 leaf at a trial value of its net CO2
+ *  assimilation rate, as found by `c4_coupled_equations::evaluate()`.
+ */
+template <typename scalar>
+struct c4_coupled_state {
+    scalar assimilation;    // micromol / m^2 / s
+    scalar residual;        // micromol / mol
+    scalar an_conductance;  // micromol / m^2 / s
+    scalar Gs;              // mol / m^2 / s
+    scalar Ci;              // micromol / mol
+    basic_stomata_outputs<scalar> BB_res;
+};
+
+/**
+ *  @brief The Collatz et al. (1992) model, the Ball-Berry model, and CO2
+ *  diffusion across the boundary layer and stomata, viewed as a single
+ *  equation for the net CO2 assimilation rate `A` of a C4 leaf.
+ *
+ *  In the Collatz model, the gross assimilation rate `G = A + RT` is the
+ *  smaller root of `beta G^2 - (M + kT Ci) G + M kT Ci = 0`. This equation is
+ *  linear in `Ci`, so it can be solved in closed form for the intercellular CO2
+ *  concentration that supports a given rate:
+ *
+ *  `Ci_bio(A) = G (M - beta G) / (kT (M - G))`,
+ *
+ *  which increases from 0 at `A = -RT` without bound as `G` approaches `M`. On
+ *  the other hand, the Ball-Berry model determines the stomatal conductance
+ *  `Gs(A)`, and diffusion across the boundary layer and stomata requires
+ *
+ *  `Ci_diff(A) = Ca - A * (dr_boundary / gbw + dr_stomata / Gs(A))`,
+ *
+ *  which decreases with `A`. The solution of the coupled equations is the root
+ *  of the smooth, increasing residual `R(A) = Ci_bio(A) - Ci_diff(A)`, and the
+ *  intercellular CO2 concentration stored in the state is `Ci_diff(A)`.
+ *
+ *  Trial values of `A` outside the range where these expressions are defined
+ *  only occur above the root, so there the residual is set to infinity. This
+ *  includes rates where the CO2 concentration at the leaf surface would be
+ *  negative, for which the Ball-Berry model cannot be evaluated; in that case,
+ *  the stomatal conductance is also set to infinity and the other quantities
+ *  are set to zero.
+ */
+template <typename scalar>
+struct c4_coupled_equations {
+    scalar Ca;                   // micromol / mol
+    scalar relative_humidity;    // dimensionless from Pa / Pa
+    scalar bb0_adj;              // mol / m^2 / s
+    scalar bb1_adj;              // dimensionless
+    scalar gbw;                  // mol / m^2 / s
+    scalar leaf_temperature;     // degrees C
+    scalar ambient_temperature;  // degrees C
+    scalar beta;                 // dimensionless
+    scalar kT;                   // mol / m^2 / s
+    scalar M;                    // micromol / m^2 / s
+    scalar RT;                   // micromol / m^2 / s
+
+    /**
+     *  @brief Returns the largest net assimilation rate for which the residual
+     *  is defined: the rate where `G = M`, or where the CO2 concentration at
+     *  the leaf surface would become zero, whichever is smaller.
+     */
+    double max_assimilation() const
+    {
+        using physical_constants::dr_boundary;
+        return std::min(value_of(M - RT), value_of(Ca * gbw / dr_boundary));
+    }
+
+    /**
+     *  @brief Returns the net assimilation rate for a fixed stomatal
+     *  conductance `Gs` (mol / m^2 / s).
+     *
+     *  When the total resistance `r = dr_boundary / gbw + dr_stomata / Gs` is
+     *  fixed, setting `Ci_bio(A) = Ca - A r` and writing `A = G - RT` gives a
+     *  quadratic equation for `G`,
+     *
+     *  `(beta + kT r) G^2 - (M + kT (C + M r)) G + kT M C = 0`,
+     *
+     *  where `C = Ca + RT r`. Its smaller root is the gross assimilation rate.
+     *  NaN is returned if the roots are not real.
+     */
+    double fixed_conductance_assim(double Gs) const
+    {
+        using physical_constants::dr_boundary;
+        using physical_constants::dr_stomata;
+
+        double const r = value_of(dr_boundary / gbw) + dr_stomata / Gs;  // m^2 * s / mol
+        double const kt = value_of(kT);                                   // mol / m^2 / s
+        double const m = value_of(M);                                     // micromol / m^2 / s
+        double const rt = value_of(RT);                                   // micromol / m^2 / s
+        double const C = value_of(Ca) + rt * r;                           // micromol / mol
+
+        double const a = value_of(beta) + kt * r;
+        double const b = -(m + kt * (C + m * r));
+        double const c = kt * m * C;
+        double const root_term = b * b - 4.0 * a * c;
+
+        return root_term < 0 ? std::numeric_limits<double>::quiet_NaN()
+                             : (-b - sqrt(root_term)) / (2.0 * a) - rt;
+    }
+
+    c4_coupled_state<scalar> evaluate(scalar const& A) const
+    {
+        using physical_constants::dr_boundary;
+        using physical_constants::dr_stomata;
+
+        double const inf = std::numeric_limits<double>::infinity();
+
+        c4_coupled_state<scalar> s{};
+        s.assimilation = A;
+
+        if (!(A < Ca * gbw / dr_boundary)) {
+            // The Ball-Berry model cannot be evaluated
+            s.residual = inf;
+            s.Gs = inf;
+            return s;
+        }
+
+        s.BB_res = ball_berry_gs<scalar>(
+            A * 1e-6, Ca * 1e-6, relative_humidity, bb0_adj, bb1_adj, gbw,
+            leaf_temperature, ambient_temperature);
+
+        s.Gs = 1e-3 * s.BB_res.gsw;  // mol / m^2 / s
+
+        s.an_conductance =
+            conductance_limited_assim<scalar>(Ca, gbw, s.Gs);  // micromol / m^2 / s
+
+        s.Ci = Ca - A * (dr_boundary / gbw + dr_stomata / s.Gs);  // micromol / mol
+
+        // Collatz 1992. Appendix B. Equation 3B solved for Ci.
+        scalar const G = A + RT;  // micromol / m^2 / s
+
+        s.residual = G < M ? G * (M - beta * G) / (kT * (M - G)) - s.Ci
+                           : inf;  // micromol / mol
+
+        return s;
+    }
+
+    /**
+     *  @brief Returns a copy of these equations with the values of their
+     *  coefficients stored as dual numbers, so the residual can be
+     *  differentiated with respect to `A`.
+     */
+    c4_coupled_equations<dual> as_dual() const
+    {
+        return c4_coupled_equations<dual>{
+            value_of(Ca), value_of(relative_humidity), value_of(bb0_adj),
+            value_of(bb1_adj), value_of(gbw), value_of(leaf_temperature),
+            value_of(ambient_temperature), value_of(beta), value_of(kT),
+            value_of(M), value_of(RT)};
+    }
+};
+
+/**
+ *  @brief Solves the coupled equations of a C4 leaf by finding the root of the
+ *  residual defined in `c4_coupled_equations` using Newton's method,
+ *  safeguarded by bisection.
+ *
+ *  The root lies between `A = -RT`, where the residual is negative, and
+ *  `c4_coupled_equations::max_assimilation()`. (When `beta = 1`, the residual
+ *  can stay negative up to the upper end of this range, and then the root is
+ *  at the upper end, where `G = M`.) The iteration starts from
+ *  `A_guess`. Since the stomatal conductance changes much more slowly with `A`
+ *  than the residual does, the first step goes to the closed-form solution
+ *  from `c4_coupled_equations::fixed_conductance_assim()` using the
+ *  conductance at `A_guess`. The remaining steps are Newton steps using the
+ *  exact derivative of the residual, found by evaluating it with dual numbers.
+ *  Each residual value shrinks the bracket, and a bisection step is taken
+ *  instead whenever a step would leave the bracket or fails to halve the
+ *  residual, so the method always converges. It stops when a step or the
+ *  residual is smaller than `Tol`. The steps are taken in `double` arithmetic;
+ *  the final Newton step is carried out with the `scalar` type so that
+ *  derivatives computed with dual numbers are those of the exact solution.
+ *
+ *  When there is no light, the bracket is empty and `A = -RT` is returned
+ *  without iterating.
+ *
+ *  Unlike the fixed point iteration, this method never returns an unconverged
+ *  result: a `std::runtime_error` is thrown if the iteration limit is reached.
+ *
+ *  @param [in] eqs The coupled equations to solve.
+ *
+ *  @param [in] A_guess The starting value of `A` in micromol / m^2 / s; the
+ *              middle of the bracket is used instead if it is outside the
+ *              bracket.
+ *
+ *  @param [out] iterations The number of residual evaluations.
+ *
+ *  @return The state of the leaf at the root.
+ */
+template <typename scalar>
+c4_coupled_state<scalar> c4_solve_newton(
+    c4_coupled_equations<scalar> const& eqs,
+    double A_guess,
+    int& iterations)
+{
+    using std::abs;
+
+    double const Tol{1e-6};  // micromol / m^2 / s and micromol / mol
+    int const max_iter{50};
+
+    double lo = -value_of(eqs.RT);        // micromol / m^2 / s
+    double hi = eqs.max_assimilation();  // micromol / m^2 / s
+
+    if (!(lo < hi)) {
+        // Without light, M = 0 and the only possible rate is A = -RT
+        iterations = 0;
+        return eqs.evaluate(-eqs.RT);
+    }
+
+    c4_coupled_equations<dual> const deqs = eqs.as_dual();
+
+    // Safeguarded Newton iteration
+    double A = A_guess > lo && A_guess < hi ? A_guess : 0.5 * (lo + hi);  // micromol / m^2 / s
+    double slope{0.0};                                                    // micromol / mol / (micromol / m^2 / s)
+    double f_old = std::numeric_limits<double>::infinity();               // micromol / mol
+    iterations = 0;
+
+    while (true) {
+        if (iterations >= max_iter) {
+            throw std::runtime_error(
+                "Thrown in c4photoC: the assimilation rate did not converge.");
+        }
+
+        c4_coupled_state<dual> const s = deqs.evaluate(dual(A, 1.0));
+        double const f = s.residual.value;
+        slope = s.residual.derivative;
+        ++iterations;
+
+        if (abs(f) < Tol) {
+            break;
+        }
+
+        if (f < 0) {
+            lo = A;
+        } else {
+            hi = A;
+        }
+
+        // The first step goes to the closed-form solution for the stomatal
+        // conductance at the starting point, and later steps are Newton steps.
+        // A step is replaced by bisection if it would leave the bracket or if
+        // the residual is not decreasing quickly enough.
+        double A_new = iterations == 1
+                           ? eqs.fixed_conductance_assim(s.Gs.value)
+                           : A - f / slope;  // micromol / m^2 / s
+
+        if (!(A_new > lo && A_new < hi) || abs(f) > 0.5 * abs(f_old)) {
+            A_new = 0.5 * (lo + hi);
+        }
+
+        f_old = f;
+
+        bool const converged = abs(A_new - A) < Tol;
+        A = A_new;
+
+        if (converged) {
+            break;
+        }
+    }
+
+    // Refine the root with a Newton step in the `scalar` type, as long as the
+    // step stays within the bracket
+    c4_coupled_state<scalar> const s = eqs.evaluate(scalar(A));
+    double const A_refined = A - value_of(s.residual) / slope;  // micromol / m^2 / s
+
+    return slope > 0 && A_refined > lo && A_refined < hi
+               ? eqs.evaluate(scalar(A) - s.residual / slope)
+               : s;
+}
+
+/**
+ *  @brief Determines the net CO2 assimilation rate, stomatal conductance, and
+ *  intercellular CO2 concentration for a C4 leaf by solving the coupled
+ *  Collatz et al. (1992) model, Ball-Berry model (`ball_berry_gs()`), and CO2
+ *  diffusion equations.
+ *
+ *  By default, the equations are solved by iterating the Collatz and
+ *  Ball-Berry models until the assimilation rate converges. If this has not
+ *  happened after 40 iterations, the stomatal conductance is replaced by the
+ *  Ball-Berry intercept, and the result is returned without warning if the
+ *  iteration limit is reached. Alternatively, the root of the intercellular
+ *  CO2 residual can be found using `c4_solve_newton()`, which usually takes a
+ *  few steps and throws an exception if it fails.
+ *
+ *  This function is templated on the scalar type used for its calculations so
+ *  it can be used with automatic differentiation, e.g. `c4photoC<dual>()`;
+ *  see `dual_number.h`.
+ */
+template <typename scalar = double>
+basic_photosynthesis_outputs<scalar> c4photoC(
+    non_deduced_t<scalar> const Qp,                    // micromol / m^2 / s
+    non_deduced_t<scalar> const leaf_temperature,      // degrees C
+    non_deduced_t<scalar> const ambient_temperature,   // degrees C
+    non_deduced_t<scalar> const relative_humidity,     // dimensionless from Pa / Pa
+    non_deduced_t<scalar> const vmax,                  // micromol / m^2 / s
+    non_deduced_t<scalar> const alpha,                 // mol / mol
+    non_deduced_t<scalar> const kparm,                 // mol / m^2 / s
+    non_deduced_t<scalar> const theta,                 // dimensionless
+    non_deduced_t<scalar> const beta,                  // dimensionless
+    non_deduced_t<scalar> const Rd,                    // micromol / m^2 / s
+    non_deduced_t<scalar> const bb0,                   // mol / m^2 / s
+    non_deduced_t<scalar> const bb1,                   // dimensionless from [mol / m^2 / s] / [mol / m^2 / s]
+    non_deduced_t<scalar> const Gs_min,                // mol / m^2 / s
+    non_deduced_t<scalar> const StomaWS,               // dimensionless
+    non_deduced_t<scalar> const Ca,                    // micromol / mol
+    non_deduced_t<scalar> const atmospheric_pressure,  // Pa
+    non_deduced_t<scalar> const upperT,                // degrees C
+    non_deduced_t<scalar> const lowerT,                // degrees C
+    non_deduced_t<scalar> const gbw,                   // mol / m^2 / s
+    c4_solver_method const solver = c4_solver_method::fixed_point)
+{
+    using physical_constants::dr_boundary;
+    using physical_constants::dr_stomata;
+    using std::abs;
+
+    standardBML::profile_timer timer("c4photoC");
+
+    constexpr double k_Q10 = 2;  // dimensionless. Increase in a reaction rate per temperature increase of 10 degrees Celsius.
+
+    scalar Ca_pa = Ca * 1e-6 * atmospheric_pressure;  // Pa
+
+    scalar kT = kparm * pow(k_Q10, (leaf_temperature - 25.0) / 10.0);  // dimensionless
+
+    // Collatz 1992. Appendix B. Equation set 5B.
+    scalar Vtn = vmax * pow(2, (leaf_temperature - 25.0) / 10.0);                                              // micromole / m^2 / s
+    scalar Vtd = (1 + exp(0.3 * (lowerT - leaf_temperature))) * (1 + exp(0.3 * (leaf_temperature - upperT)));  // dimensionless
+    scalar VT = Vtn / Vtd;                                                                                     // micromole / m^2 / s
+
+    // Collatz 1992. Appendix B. Equation set 5B.
+    scalar Rtn = Rd * pow(2, (leaf_temperature - 25) / 10);  // micromole / m^2 / s
+    scalar Rtd = 1 + exp(1.3 * (leaf_temperature - 55));     // dimensionless
+    scalar RT = Rtn / Rtd;                                   // micromole / m^2 / s
+
+    // Collatz 1992. Appendix B. Quadratic coefficients from Equation 2B.
+    scalar b0 = VT * alpha * Qp;
+    scalar b1 = -(VT + alpha * Qp);
+    scalar b2 = theta;
+
+    // Calculate the smaller of the two quadratic roots, as mentioned following
+    // Equation 3B in Collatz 1992.
+    scalar M = quadratic_root_min(b2, b1, b0);  // micromol / m^2 / s
+
+    // Adjust Ball-Berry parameters in response to water stress
+    scalar const bb0_adj = StomaWS * bb0 + Gs_min * (1.0 - StomaWS);
+    scalar const bb1_adj = StomaWS * bb1;
+
+    if (solver == c4_solver_method::newton) {
+        c4_coupled_equations<scalar> const eqs{
+            Ca, relative_humidity, bb0_adj, bb1_adj, gbw, leaf_temperature,
+            ambient_temperature, beta, kT, M, RT};
+
+        // Start from the assimilation rate at the initial guess of the fixed
+        // point iteration, Ci = 0.4 * Ca
+        double const A_guess = value_of(
+            quadratic_root_min(beta, -(M + kT * 0.4 * Ca), M * kT * 0.4 * Ca) - RT);  // micromol / m^2 / s
+
+        int iterations{0};
+        c4_coupled_state<scalar> const s = c4_solve_newton(eqs, A_guess, iterations);
+
+        standardBML::record_iterations("c4photoC_newton", iterations);
+
+        return basic_photosynthesis_outputs<scalar>{
+            /* .Assim = */ s.assimilation,                // micromol / m^2 /s
+            /* .Assim_conductance = */ s.an_conductance,  // micromol / m^2 / s
+            /* .Ci = */ s.Ci,                             // micromol / mol
+            /* .GrossAssim = */ s.assimilation + RT,      // micromol / m^2 / s
+            /* .Gs = */ s.Gs * 1e3,                       // mmol / m^2 / s
+            /* .Cs = */ s.BB_res.cs,                      // micromol / m^2 / s
+            /* .RHs = */ s.BB_res.hs,                     // dimensionless from Pa / Pa
+            /* .Rp = */ 0,                                // micromol / m^2 / s
+            /* .iterations = */ iterations                // not a physical quantity
+        };
+    }
+
+    // Initialize loop variables. Here we make an initial guess that
+    // Ci = 0.4 * Ca.
+    basic_stomata_outputs<scalar> BB_res;
+    scalar InterCellularCO2{0.4 * Ca_pa};  // Pa
+    scalar Assim{};                        // micromol / m^2 / s
+    scalar Gs{1e6};                        // mmol / m^2 / s
+    scalar an_conductance{};               // micromol / m^2 / s
+
+    // Start the loop
+    scalar OldAssim = 0.0, diff;
+    double const Tol = 0.1;
+    int iterCounter = 0;
+    int constexpr max_iterations = 50;
+    do {
+        // Collatz 1992. Appendix B. Quadratic coefficients from Equation 3B.
+        scalar kT_IC_P = kT * InterCellularCO2 / atmospheric_pressure * 1e6;  // micromole / m^2 / s
+        scalar a = beta;
+        scalar b = -(M + kT_IC_P);
+        scalar c = M * kT_IC_P;
+
+        // Calculate the smaller of the two quadratic roots, as mentioned
+        // following Equation 3B in Collatz 1992.
+        scalar gross_assim = quadratic_root_min(a, b, c);  // micromol / m^2 / s
+
+        Assim = gross_assim - RT;  // micromole / m^2 / s.
+
+        // The net CO2 assimilation is the smaller of the biochemistry-limited
+        // and conductance-limited rates. This will prevent the calculated Ci
+        // value from ever being < 0. This seems to be an important restriction
+        // to prevent numerical errors during the convergence loop, but does not
+        // actually limit the net assimilation rate if the loop converges.
+        an_conductance =
+            conductance_limited_assim<scalar>(Ca, gbw, Gs * 1e-3);  // micromol / m^2 / s
+
+        Assim = std::min(
+            Assim,
+            an_conductance);  // micromol / m^2 / s
+
+        BB_res = ball_berry_gs<scalar>(
+            Assim * 1e-6,
+            Ca * 1e-6,
+            relative_humidity,
+            bb0_adj,
+            bb1_adj,
+            gbw,
+            leaf_temperature,
+            ambient_temperature);
+
+        Gs = BB_res.gsw;  // mmol / m^2 / s
+
+        // If it has gone through this many iterations, the convergence is not
+        // stable. This convergence is inapproriate for high water stress
+        // conditions, so use the minimum gs to try to get a stable system.
+        if (iterCounter > max_iterations - 10) {
+            Gs = bb0 * 1e3;  // mmol / m^2 / s
+        }
+
+        // Calculate Ci using the total conductance across the boundary
+        // layer and stomata
+        InterCellularCO2 =
+            Ca_pa - atmospheric_pressure * (Assim * 1e-6) *
+                        (dr_boundary / gbw + dr_stomata / (Gs * 1e-3));  // Pa
+
+        diff = abs(OldAssim - Assim);  // micromole / m^2 / s
+
+        OldAssim = Assim;  // micromole / m^2 / s
+
+    } while (diff >= Tol && ++iterCounter < max_iterations);
+    //if (iterCounter > 49)
+    //Rprintf("Counter %i; Ci %f; Assim %f; Gs %f; leaf_temperature %f\n", iterCounter, InterCellularCO2 / atmospheric_pressure * 1e6, Assim, Gs, leaf_temperature);
+
+    scalar Ci = InterCellularCO2 / atmospheric_pressure * 1e6;  // micromole / mol
+
+    standardBML::record_iterations("c4photoC", iterCounter);
+
+    return basic_photosynthesis_outputs<scalar>{
+        /* .Assim = */ Assim,                       // micromol / m^2 /s
+        /* .Assim_conductance = */ an_conductance,  // micromol / m^2 / s
+        /* .Ci = */ Ci,                             // micromol / mol
+        /* .GrossAssim = */ Assim + RT,             // micromol / m^2 / s
+        /* .Gs = */ Gs,                             // mmol / m^2 / s
+        /* .Cs = */ BB_res.cs,                      // micromol / m^2 / s
+        /* .RHs = */ BB_res.hs,                     // dimensionless from Pa / Pa
+        /* .Rp = */ 0,                              // micromol / m^2 / s
+        /* .iterations = */ iterCounter             // not a physical quantity
+    };
+}
 
 #endif
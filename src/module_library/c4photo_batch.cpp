@@ -0,0 +1,295 @@
+#include <cmath>                          // for pow, exp, std::abs
+#include <stdexcept>                      // for std::range_error
+#include "c4photo_batch.h"
+#include "water_and_air_properties.h"     // for saturation_vapor_pressure
+#include "../framework/constants.h"       // for dr_stomata, dr_boundary
+#include "../framework/quadratic_root.h"  // for quadratic_root_min,
+                                          //     quadratic_root_plus
+#include "module_profiler.h"              // for profile_timer,
+                                          //     record_iterations
+
+void c4photoC_batch_inputs::resize(size_t n)
+{
+    for (std::vector<double>* v :
+         {&Qp, &leaf_temperature, &ambient_temperature,
+          &relative_humidity, &vmax, &alpha, &kparm, &theta, &beta,
+          &Rd, &bb0, &bb1, &Gs_min, &StomaWS, &Ca,
+          &atmospheric_pressure, &upperT, &lowerT, &gbw}) {
+        v->resize(n);
+    }
+}
+
+void c4photoC_batch_inputs::set(
+    size_t i,
+    double Qp_i,
+    double leaf_temperature_i,
+    double ambient_temperature_i,
+    double relative_humidity_i,
+    double vmax_i,
+    double alpha_i,
+    double kparm_i,
+    double theta_i,
+    double beta_i,
+    double Rd_i,
+    double bb0_i,
+    double bb1_i,
+    double Gs_min_i,
+    double StomaWS_i,
+    double Ca_i,
+    double atmospheric_pressure_i,
+    double upperT_i,
+    double lowerT_i,
+    double gbw_i)
+{
+    Qp[i] = Qp_i;
+    leaf_temperature[i] = leaf_temperature_i;
+    ambient_temperature[i] = ambient_temperature_i;
+    relative_humidity[i] = relative_humidity_i;
+    vmax[i] = vmax_i;
+    alpha[i] = alpha_i;
+    kparm[i] = kparm_i;
+    theta[i] = theta_i;
+    beta[i] = beta_i;
+    Rd[i] = Rd_i;
+    bb0[i] = bb0_i;
+    bb1[i] = bb1_i;
+    Gs_min[i] = Gs_min_i;
+    StomaWS[i] = StomaWS_i;
+    Ca[i] = Ca_i;
+    atmospheric_pressure[i] = atmospheric_pressure_i;
+    upperT[i] = upperT_i;
+    lowerT[i] = lowerT_i;
+    gbw[i] = gbw_i;
+}
+
+void c4photoC_batch(
+    c4photoC_batch_inputs const& inputs,
+    photosynthesis_batch_outputs& outputs,
+    photosynthesis_batch_outputs const* initial_guess)
+{
+    using physical_constants::dr_boundary;
+    using physical_constants::dr_stomata;
+    using std::abs;
+
+    // Warm-started calls are profiled separately so their iteration counts
+    // can be compared with those of calls using the fixed initial guess
+    bool const warm = initial_guess != nullptr;
+    char const* const profile_name =
+        warm ? "c4photoC_batch (warm start)" : "c4photoC_batch";
+
+    standardBML::profile_timer timer(profile_name);
+
+    size_t const n = inputs.size();
+    outputs.resize(n);
+
+    // Quantities that do not change during the iteration; see `c4photoC()`
+    // for a description of each one
+    std::vector<double> Ca_pa(n), kT(n), RT(n), M(n), bb0_adj(n), bb1_adj(n),
+        swvp_ratio(n);
+
+    constexpr double k_Q10 = 2;  // dimensionless
+
+    for (size_t i = 0; i < n; ++i) {
+        double const T = inputs.leaf_temperature[i];  // degrees C
+
+        Ca_pa[i] = inputs.Ca[i] * 1e-6 * inputs.atmospheric_pressure[i];  // Pa
+        kT[i] = inputs.kparm[i] * pow(k_Q10, (T - 25.0) / 10.0);          // dimensionless
+
+        // Collatz 1992. Appendix B. Equation set 5B.
+        double const Vtn = inputs.vmax[i] * pow(2, (T - 25.0) / 10.0);  // micromole / m^2 / s
+        double const Vtd = (1 + exp(0.3 * (inputs.lowerT[i] - T))) *
+                           (1 + exp(0.3 * (T - inputs.upperT[i])));  // dimensionless
+        double const VT = Vtn / Vtd;                                 // micromole / m^2 / s
+
+        double const Rtn = inputs.Rd[i] * pow(2, (T - 25) / 10);  // micromole / m^2 / s
+        double const Rtd = 1 + exp(1.3 * (T - 55));               // dimensionless
+        RT[i] = Rtn / Rtd;                                        // micromole / m^2 / s
+
+        double const StomaWS = inputs.StomaWS[i];
+        bb0_adj[i] = StomaWS * inputs.bb0[i] + inputs.Gs_min[i] * (1.0 - StomaWS);
+        bb1_adj[i] = StomaWS * inputs.bb1[i];
+
+        // The saturation vapor pressures used by `ball_berry_gs()` only depend
+        // on the temperatures, so their ratio is found here
+        swvp_ratio[i] =
+            saturation_vapor_pressure(inputs.ambient_temperature[i]) /
+            saturation_vapor_pressure(T);  // dimensionless
+
+        // Collatz 1992. Appendix B. Quadratic coefficients from Equation 2B.
+        double const b0 = VT * inputs.alpha[i] * inputs.Qp[i];
+        double const b1 = -(VT + inputs.alpha[i] * inputs.Qp[i]);
+        double const b2 = inputs.theta[i];
+
+        M[i] = quadratic_root_min(b2, b1, b0);  // micromol / m^2 / s
+    }
+
+    // Quantities that are updated during the iteration
+    double* const Assim = outputs.Assim.data();
+    double* const an_conductance = outputs.Assim_conductance.data();
+    double* const Gs = outputs.Gs.data();
+    double* const Cs = outputs.Cs.data();
+    double* const hs = outputs.RHs.data();
+    int* const iterations = outputs.iterations.data();
+
+    // The intercellular CO2 partial pressure; without a warm start, we make an
+    // initial guess that Ci = 0.4 * Ca
+    std::vector<double> InterCellularCO2(n);  // Pa
+
+    // The rest of the fixed initial guess used by `c4photoC()`
+    double const Assim_guess{0.0};  // micromol / m^2 / s
+    double const Gs_guess{1e6};     // mmol / m^2 / s
+
+    for (size_t i = 0; i < n; ++i) {
+        // The initial guess is read before anything is written, since it may
+        // be stored in `outputs`
+        double const IC0 =
+            warm ? initial_guess->Ci[i] * 1e-6 * inputs.atmospheric_pressure[i]
+                 : 0.4 * Ca_pa[i];                                            // Pa
+        double const Assim0 = warm ? initial_guess->Assim[i] : Assim_guess;  // micromol / m^2 / s
+        double const Gs0 = warm ? initial_guess->Gs[i] : Gs_guess;           // mmol / m^2 / s
+
+        InterCellularCO2[i] = IC0;
+        Assim[i] = Assim0;        // micromol / m^2 / s
+        an_conductance[i] = 0.0;  // micromol / m^2 / s
+        Gs[i] = Gs0;              // mmol / m^2 / s
+        Cs[i] = 0.0;              // micromol / mol
+        hs[i] = 0.0;              // dimensionless
+        iterations[i] = 0;
+    }
+
+    // Storage for each pass; `active` is the mask of leaves that have not
+    // converged, `warm_leaf` is the mask of leaves that are still iterating
+    // from a warm start, and `diff` is the change in the assimilation rate
+    std::vector<char> active(n, 1), warm_leaf(n, warm);
+    std::vector<double> gross_assim(n, 0.0), diff(n), Cs_mol(n), a(n), b(n),
+        c(n), root(n, 0.0);
+
+    double const Tol = 0.1;
+    int constexpr max_iterations = 50;
+
+    // A warm start is abandoned if it has not converged after this many
+    // passes, well before the minimum conductance would be used
+    int const max_warm_iterations{20};
+    int restarted_iterations{0};
+
+    size_t nactive = n;
+    while (nactive > 0) {
+        // Collatz 1992. Appendix B. Quadratic coefficients from Equation 3B;
+        // the roots are found one leaf at a time, since they are calculated by
+        // a framework function that may throw
+        for (size_t i = 0; i < n; ++i) {
+            if (active[i]) {
+                double const kT_IC_P =
+                    kT[i] * InterCellularCO2[i] / inputs.atmospheric_pressure[i] * 1e6;  // micromole / m^2 / s
+                gross_assim[i] = quadratic_root_min(
+                    inputs.beta[i], -(M[i] + kT_IC_P), M[i] * kT_IC_P);  // micromol / m^2 / s
+            }
+        }
+
+        // Find the new assimilation rates, limited by conductance, and set up
+        // the quadratic equation for the relative humidity at the leaf surface
+        // (as in `ball_berry_gs()`); only active leaves are updated
+        bool Cs_negative = false;
+        for (size_t i = 0; i < n; ++i) {
+            bool const on = active[i];
+            double const Ca = inputs.Ca[i];
+            double const gbw = inputs.gbw[i];
+
+            double const An = gross_assim[i] - RT[i];  // micromole / m^2 / s
+            double const an_c =
+                Ca / (dr_boundary / gbw + dr_stomata / (Gs[i] * 1e-3));  // micromol / m^2 / s
+            double const A = an_c < An ? an_c : An;                      // micromol / m^2 / s
+
+            double const assimilation = A * 1e-6;  // mol / m^2 / s
+            double const bb_slope = assimilation < 0 ? 0.0 : bb1_adj[i];
+            double const Cs_new =
+                Ca * 1e-6 - (dr_boundary / gbw) * assimilation;  // mol / mol
+            double const a_new = bb_slope * (assimilation / Cs_new);
+
+            Cs_negative = Cs_negative || (on && Cs_new < 0.0);
+
+            diff[i] = on ? abs(Assim[i] - A) : diff[i];
+            Assim[i] = on ? A : Assim[i];
+            an_conductance[i] = on ? an_c : an_conductance[i];
+            Cs_mol[i] = on ? Cs_new : Cs_mol[i];
+            a[i] = on ? a_new : a[i];
+            b[i] = on ? bb0_adj[i] + gbw - a_new : b[i];
+            c[i] = on ? -inputs.relative_humidity[i] * gbw * swvp_ratio[i] - bb0_adj[i] : c[i];
+        }
+
+        if (Cs_negative) {
+            throw std::range_error("Thrown in ball_berry_gs: Cs is less than 0.");
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            if (active[i]) {
+                root[i] = quadratic_root_plus(a[i], b[i], c[i]);
+            }
+        }
+
+        // Find the new stomatal conductances and intercellular CO2 partial
+        // pressures, and update the mask
+        bool hs_negative = false;
+        nactive = 0;
+        for (size_t i = 0; i < n; ++i) {
+            bool const on = active[i];
+            double const gbw = inputs.gbw[i];
+            double const P = inputs.atmospheric_pressure[i];
+            int const iter = iterations[i];
+
+            // If hs is calculated to be larger than 1, this indicates dew
+            // formation, so it is limited to 1 as in `ball_berry_gs()`
+            double const hs_new = root[i] < 1.0 ? root[i] : 1.0;  // dimensionless
+            hs_negative = hs_negative || (on && hs_new < 0);
+
+            // As in `c4photoC()`, the minimum conductance is used if the
+            // iteration has not converged after many passes
+            double const Gs_new =
+                iter > max_iterations - 10
+                    ? inputs.bb0[i] * 1e3
+                    : ((a[i] * hs_new + bb0_adj[i]) * 1e3);  // mmol / m^2 / s
+
+            double const IC_new =
+                Ca_pa[i] - P * (Assim[i] * 1e-6) *
+                               (dr_boundary / gbw + dr_stomata / (Gs_new * 1e-3));  // Pa
+
+            hs[i] = on ? hs_new : hs[i];
+            Cs[i] = on ? Cs_mol[i] * 1e6 : Cs[i];
+            Gs[i] = on ? Gs_new : Gs[i];
+            InterCellularCO2[i] = on ? IC_new : InterCellularCO2[i];
+
+            bool const converged = diff[i] < Tol;
+            int const next_iter = iter + (on && !converged ? 1 : 0);
+            bool const still_active = on && !converged && next_iter < max_iterations;
+
+            // Restart a slow warm-started leaf from the fixed initial guess;
+            // from then on, it follows exactly the same sequence as it would
+            // without a warm start
+            bool const restart =
+                still_active && warm_leaf[i] && next_iter >= max_warm_iterations;
+            restarted_iterations += restart ? next_iter : 0;
+            warm_leaf[i] = restart ? 0 : warm_leaf[i];
+            InterCellularCO2[i] = restart ? 0.4 * Ca_pa[i] : InterCellularCO2[i];
+            Assim[i] = restart ? Assim_guess : Assim[i];
+            Gs[i] = restart ? Gs_guess : Gs[i];
+
+            iterations[i] = restart ? 0 : next_iter;
+            active[i] = still_active;
+            nactive += still_active;
+        }
+
+        if (hs_negative) {
+            throw std::range_error("Thrown in ball_berry_gs: hs is less than 0.");
+        }
+    }
+
+    int total_iterations = restarted_iterations;
+    for (size_t i = 0; i < n; ++i) {
+        outputs.Ci[i] = InterCellularCO2[i] / inputs.atmospheric_pressure[i] * 1e6;  // micromole / mol
+        outputs.GrossAssim[i] = Assim[i] + RT[i];                                    // micromol / m^2 / s
+        outputs.Rp[i] = 0;                                                           // micromol / m^2 / s
+        total_iterations += iterations[i];
+    }
+
+    standardBML::record_iterations(profile_name, total_iterations);
+}
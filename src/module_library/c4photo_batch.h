@@ -0,0 +1,104 @@
+#ifndef C4PHOTO_BATCH_H
+#define C4PHOTO_BATCH_H
+
+#include <cstddef>                   // for size_t
+#include <vector>                    // for std::vector
+#include "photosynthesis_outputs.h"  // for photosynthesis_batch_outputs
+
+/**
+ *  @brief A structure of arrays holding the `c4photoC()` arguments for a batch
+ *  of leaves, where element `i` of each array belongs to leaf `i`.
+ *
+ *  Values can be set for one leaf at a time using `set()`, whose arguments are
+ *  in the same order as the arguments of `c4photoC()`.
+ */
+struct c4photoC_batch_inputs {
+    std::vector<double> Qp;                   // micromol / m^2 / s
+    std::vector<double> leaf_temperature;     // degrees C
+    std::vector<double> ambient_temperature;  // degrees C
+    std::vector<double> relative_humidity;    // dimensionless from Pa / Pa
+    std::vector<double> vmax;                 // micromol / m^2 / s
+    std::vector<double> alpha;                // mol / mol
+    std::vector<double> kparm;                // mol / m^2 / s
+    std::vector<double> theta;                // dimensionless
+    std::vector<double> beta;                 // dimensionless
+    std::vector<double> Rd;                   // micromol / m^2 / s
+    std::vector<double> bb0;                  // mol / m^2 / s
+    std::vector<double> bb1;                  // dimensionless from [mol / m^2 / s] / [mol / m^2 / s]
+    std::vector<double> Gs_min;               // mol / m^2 / s
+    std::vector<double> StomaWS;              // dimensionless
+    std::vector<double> Ca;                   // micromol / mol
+    std::vector<double> atmospheric_pressure; // Pa
+    std::vector<double> upperT;               // degrees C
+    std::vector<double> lowerT;               // degrees C
+    std::vector<double> gbw;                  // mol / m^2 / s
+
+    explicit c4photoC_batch_inputs(size_t n = 0) { resize(n); }
+
+    void resize(size_t n);
+
+    size_t size() const { return Qp.size(); }
+
+    void set(
+        size_t i,
+        double Qp,
+        double leaf_temperature,
+        double ambient_temperature,
+        double relative_humidity,
+        double vmax,
+        double alpha,
+        double kparm,
+        double theta,
+        double beta,
+        double Rd,
+        double bb0,
+        double bb1,
+        double Gs_min,
+        double StomaWS,
+        double Ca,
+        double atmospheric_pressure,
+        double upperT,
+        double lowerT,
+        double gbw);
+};
+
+/**
+ *  @brief Evaluates `c4photoC()` for a batch of leaves at once.
+ *
+ *  As in `c3photoC_batch()`, the calculations are arranged as loops over the
+ *  leaves of the batch so they can be vectorized by the compiler. The
+ *  temperature responses of the Collatz et al. (1992) model, which require
+ *  several calls to `pow()` and `exp()`, and the light-limited rate `M` are
+ *  found once for all the leaves before the iteration starts. Then each pass
+ *  of the iteration updates every leaf that has not converged yet, using a
+ *  mask in place of the loop condition of `c4photoC()`, until all of them have
+ *  converged or reached the iteration limit.
+ *
+ *  Each leaf goes through exactly the same operations as in `c4photoC()`, so
+ *  the results are identical to calling it separately for each leaf, unless
+ *  an `initial_guess` is provided.
+ *
+ *  @param [in] inputs The arguments to `c4photoC()` for each leaf.
+ *
+ *  @param [out] outputs The results for each leaf; it is resized to match the
+ *               number of leaves in `inputs`.
+ *
+ *  @param [in] initial_guess Optional results for the same leaves from an
+ *              earlier call, such as those stored by a
+ *              `photosynthesis_warm_start`. If it is provided, the iteration for
+ *              each leaf starts from its assimilation rate, stomatal
+ *              conductance, and intercellular CO2 concentration instead of the
+ *              fixed initial guess used by `c4photoC()`, which usually reduces
+ *              the number of iterations; the results then agree with those of
+ *              `c4photoC()` to within the tolerance of the iteration. A leaf
+ *              that has not converged after 20 passes is restarted from the
+ *              fixed initial guess, so a poor guess cannot prevent convergence.
+ *              It must hold results for the same number of leaves as `inputs`, and it
+ *              may be the same object as `outputs`.
+ */
+void c4photoC_batch(
+    c4photoC_batch_inputs const& inputs,
+    photosynthesis_batch_outputs& outputs,
+    photosynthesis_batch_outputs const* initial_guess = nullptr);
+
+#endif
@@ -2,6 +2,7 @@
 #define CONDUCTANCE_LIMITED_ASSIM_H
 
 #include "../framework/constants.h"  // for dr_boundary, dr_stomata
+#include "dual_number.h"             // for non_deduced_t
 
 /**
  *  @brief Computes the conductance-limited net CO2 assimilation rate.
@@ -66,10 +67,11 @@
  *  @return The conductance-limited net CO2 assimilation rate in units of
  *              micromol / m^2 / s.
  */
-inline double conductance_limited_assim(
-    double Ca,   // micromol / mol
-    double gbw,  // mol / m^2 / s
-    double gsw   // mol / m^2 / s
+template <typename scalar = double>
+scalar conductance_limited_assim(
+    non_deduced_t<scalar> Ca,   // micromol / mol
+    non_deduced_t<scalar> gbw,  // mol / m^2 / s
+    non_deduced_t<scalar> gsw   // mol / m^2 / s
 )
 {
     return Ca / (physical_constants::dr_boundary / gbw +
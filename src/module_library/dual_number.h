@@ -0,0 +1,224 @@
+#ifndef DUAL_NUMBER_H
+#define DUAL_NUMBER_H
+
+#include <cmath>                          // for acos, exp, log, pow, sqrt, tan,
+                                          // std::abs, std::isnan
+#include "../framework/quadratic_root.h"  // for quadratic_root_plus, quadratic_root_minus
+
+/**
+ *  @brief Prevents template argument deduction for a function parameter.
+ *
+ *  Functions whose numeric core is templated on a scalar type declare their
+ *  parameters as `non_deduced_t<scalar>` and use `double` as the default
+ *  scalar type. This way, existing calls that mix `double` and `int` values
+ *  continue to use the `double` version, and calls that should use another
+ *  scalar type must request it explicitly, e.g. `FvCB_assim<dual>(...)`; any
+ *  `double` arguments of such calls are converted to the requested type.
+ */
+template <typename T>
+struct non_deduced {
+    using type = T;
+};
+
+template <typename T>
+using non_deduced_t = typename non_deduced<T>::type;
+
+namespace dual_numbers
+{
+/**
+ *  @class dual
+ *
+ *  @brief A dual number for forward-mode automatic differentiation.
+ *
+ *  A dual number `x + x' e` stores a value `x` along with its derivative `x'`
+ *  with respect to some independent variable, where `e^2 = 0`. Applying
+ *  arithmetic operations and elementary functions to dual numbers applies the
+ *  chain rule to the derivatives, so evaluating a function `f` with
+ *  `x = x_0 + 1 e` produces `f(x_0) + f'(x_0) e`, exact up to rounding error.
+ *
+ *  Comparisons only use the values, so code that branches on a comparison or
+ *  chooses the smaller of two quantities (e.g. with `std::min`) follows the
+ *  same path as it would for `double` values, and the derivative is the
+ *  derivative of the path that was taken. Likewise, a loop that stops when a
+ *  fixed-point iteration converges produces the derivative of the final
+ *  iterate.
+ *
+ *  A `double` can be implicitly converted to a dual number with a derivative
+ *  of zero, representing a constant.
+ */
+struct dual {
+    double value;       //!< The value `x`
+    double derivative;  //!< The derivative `x'`
+
+    dual(double value = 0.0, double derivative = 0.0)
+        : value{value}, derivative{derivative}
+    {
+    }
+
+    dual& operator+=(dual const& y)
+    {
+        value += y.value;
+        derivative += y.derivative;
+        return *this;
+    }
+
+    dual& operator-=(dual const& y)
+    {
+        value -= y.value;
+        derivative -= y.derivative;
+        return *this;
+    }
+
+    dual& operator*=(dual const& y)
+    {
+        derivative = derivative * y.value + value * y.derivative;
+        value *= y.value;
+        return *this;
+    }
+
+    dual& operator/=(dual const& y)
+    {
+        derivative = (derivative * y.value - value * y.derivative) /
+                     (y.value * y.value);
+        value /= y.value;
+        return *this;
+    }
+};
+
+inline dual operator+(dual const& x) { return x; }
+inline dual operator-(dual const& x) { return dual{-x.value, -x.derivative}; }
+
+inline dual operator+(dual x, dual const& y) { return x += y; }
+inline dual operator-(dual x, dual const& y) { return x -= y; }
+inline dual operator*(dual x, dual const& y) { return x *= y; }
+inline dual operator/(dual x, dual const& y) { return x /= y; }
+
+inline bool operator==(dual const& x, dual const& y) { return x.value == y.value; }
+inline bool operator!=(dual const& x, dual const& y) { return x.value != y.value; }
+inline bool operator<(dual const& x, dual const& y) { return x.value < y.value; }
+inline bool operator>(dual const& x, dual const& y) { return x.value > y.value; }
+inline bool operator<=(dual const& x, dual const& y) { return x.value <= y.value; }
+inline bool operator>=(dual const& x, dual const& y) { return x.value >= y.value; }
+
+inline dual exp(dual const& x)
+{
+    double const e = std::exp(x.value);
+    return dual{e, e * x.derivative};
+}
+
+inline dual log(dual const& x)
+{
+    return dual{std::log(x.value), x.derivative / x.value};
+}
+
+inline dual sqrt(dual const& x)
+{
+    double const s = std::sqrt(x.value);
+    return dual{s, x.derivative / (2.0 * s)};
+}
+
+inline dual abs(dual const& x)
+{
+    return x.value < 0.0 ? -x : x;
+}
+
+inline dual acos(dual const& x)
+{
+    return dual{
+        std::acos(x.value),
+        -x.derivative / std::sqrt(1.0 - x.value * x.value)};
+}
+
+inline dual tan(dual const& x)
+{
+    double const t = std::tan(x.value);
+    return dual{t, (1.0 + t * t) * x.derivative};
+}
+
+// Like `fmin` and `fmax` for `double` values, these return the other argument
+// when one of them is NaN
+
+inline dual fmin(dual const& x, dual const& y)
+{
+    return std::isnan(y.value) || x.value <= y.value ? x : y;
+}
+
+inline dual fmax(dual const& x, dual const& y)
+{
+    return std::isnan(y.value) || x.value >= y.value ? x : y;
+}
+
+inline dual pow(dual const& x, double y)
+{
+    return dual{
+        std::pow(x.value, y),
+        y * std::pow(x.value, y - 1.0) * x.derivative};
+}
+
+inline dual pow(double x, dual const& y)
+{
+    double const p = std::pow(x, y.value);
+    return dual{p, p * std::log(x) * y.derivative};
+}
+
+inline dual pow(dual const& x, dual const& y)
+{
+    // The log(x) term is only needed when the exponent is not constant; this
+    // avoids NaN derivatives when x <= 0 and the exponent is constant
+    double const p = std::pow(x.value, y.value);
+    double const dp_dx = y.value * std::pow(x.value, y.value - 1.0) * x.derivative;
+    return y.derivative == 0.0
+               ? dual{p, dp_dx}
+               : dual{p, dp_dx + p * std::log(x.value) * y.derivative};
+}
+
+/**
+ *  @brief Returns the derivative of a root `r` of `a * r^2 + b * r + c = 0`,
+ *  found by differentiating the equation with respect to the independent
+ *  variable and solving for `r'`.
+ */
+inline double quadratic_root_derivative(
+    double r,
+    dual const& a,
+    dual const& b,
+    dual const& c)
+{
+    return -(a.derivative * r * r + b.derivative * r + c.derivative) /
+           (2.0 * a.value * r + b.value);
+}
+
+// The roots are found using the `double` versions of these functions, so they
+// follow the same conventions and produce the same errors; their derivatives
+// are found by implicit differentiation.
+
+inline dual quadratic_root_plus(dual const& a, dual const& b, dual const& c)
+{
+    double const r = ::quadratic_root_plus(a.value, b.value, c.value);
+    return dual{r, quadratic_root_derivative(r, a, b, c)};
+}
+
+inline dual quadratic_root_minus(dual const& a, dual const& b, dual const& c)
+{
+    double const r = ::quadratic_root_minus(a.value, b.value, c.value);
+    return dual{r, quadratic_root_derivative(r, a, b, c)};
+}
+
+inline dual quadratic_root_min(dual const& a, dual const& b, dual const& c)
+{
+    double const r = ::quadratic_root_min(a.value, b.value, c.value);
+    return dual{r, quadratic_root_derivative(r, a, b, c)};
+}
+
+}  // namespace dual_numbers
+
+using dual_numbers::dual;
+
+/**
+ *  @brief Returns the value of a number, discarding its derivative if it has
+ *  one. This lets templated code carry out comparisons and bookkeeping in
+ *  `double` arithmetic regardless of its scalar type.
+ */
+inline double value_of(double x) { return x; }
+inline double value_of(dual const& x) { return x.value; }
+
+#endif
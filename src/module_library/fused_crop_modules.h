@@ -0,0 +1,109 @@
+#ifndef FUSED_CROP_MODULES_H
+#define FUSED_CROP_MODULES_H
+
+#include "../framework/state_map.h"
+#include "fused_direct_module.h"
+#include "stomata_water_stress_linear.h"
+#include "leaf_water_stress_exponential.h"
+#include "parameter_calculator.h"
+#include "soybean_development_rate_calculator.h"
+#include "partitioning_coefficient_logistic.h"
+#include "senescence_coefficient_logistic.h"
+#include "soil_evaporation.h"
+#include "solar_position_michalsky.h"
+#include "shortwave_atmospheric_scattering.h"
+#include "incident_shortwave_from_ground_par.h"
+#include "multilayer_canopy_properties.h"
+#include "multilayer_c3_canopy.h"
+#include "multilayer_canopy_integrator.h"
+#include "no_leaf_resp_neg_assim_partitioning_growth_calculator.h"
+#include "c3_canopy.h"
+#include "c4_canopy.h"
+#include "partitioning_coefficient_selector.h"
+#include "partitioning_growth_calculator.h"
+
+// This file defines fused versions of the direct modules used by the crop
+// models included with BioCro (see the `soybean`, `miscanthus_x_giganteus`,
+// and `willow` definitions in the `data` directory). When the direct modules
+// passed to `run_biocro()` are the same as the modules in one of these
+// classes, they are replaced by the fused module; see `fuse_direct_modules()`.
+//
+// Like the other module headers, this file should only be included by
+// `module_library.cpp`.
+
+namespace standardBML
+{
+/**
+ * @class soybean_direct_modules
+ *
+ * @brief The direct modules from the `soybean` crop model, fused into a single
+ * module.
+ */
+class soybean_direct_modules
+    : public fused_direct_module<
+          solar_position_michalsky,
+          shortwave_atmospheric_scattering,
+          incident_shortwave_from_ground_par,
+          stomata_water_stress_linear,
+          leaf_water_stress_exponential,
+          parameter_calculator,
+          soybean_development_rate_calculator,
+          partitioning_coefficient_logistic,
+          senescence_coefficient_logistic,
+          soil_evaporation,
+          ten_layer_canopy_properties,
+          ten_layer_c3_canopy,
+          ten_layer_canopy_integrator,
+          no_leaf_resp_neg_assim_partitioning_growth_calculator>
+{
+   public:
+    using fused_direct_module::fused_direct_module;
+    static std::string get_name() { return "soybean_direct_modules"; }
+};
+
+/**
+ * @class miscanthus_x_giganteus_direct_modules
+ *
+ * @brief The direct modules from the `miscanthus_x_giganteus` crop model,
+ * fused into a single module.
+ */
+class miscanthus_x_giganteus_direct_modules
+    : public fused_direct_module<
+          solar_position_michalsky,
+          stomata_water_stress_linear,
+          leaf_water_stress_exponential,
+          parameter_calculator,
+          soil_evaporation,
+          c4_canopy,
+          partitioning_coefficient_selector,
+          partitioning_growth_calculator>
+{
+   public:
+    using fused_direct_module::fused_direct_module;
+    static std::string get_name() { return "miscanthus_x_giganteus_direct_modules"; }
+};
+
+/**
+ * @class willow_direct_modules
+ *
+ * @brief The direct modules from the `willow` crop model, fused into a single
+ * module.
+ */
+class willow_direct_modules
+    : public fused_direct_module<
+          solar_position_michalsky,
+          stomata_water_stress_linear,
+          leaf_water_stress_exponential,
+          parameter_calculator,
+          soil_evaporation,
+          c3_canopy,
+          partitioning_coefficient_selector,
+          partitioning_growth_calculator>
+{
+   public:
+    using fused_direct_module::fused_direct_module;
+    static std::string get_name() { return "willow_direct_modules"; }
+};
+
+}  // namespace standardBML
+#endif
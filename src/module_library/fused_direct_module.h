@@ -0,0 +1,234 @@
+#ifndef FUSED_DIRECT_MODULE_H
+#define FUSED_DIRECT_MODULE_H
+
+#include <string>
+#include <vector>
+#include "../framework/module.h"
+#include "../framework/module_creator.h"  // for module_creator_impl, create_mc_type, create_mc, mc_vector
+#include "../framework/state_map.h"
+
+namespace standardBML
+{
+/**
+ * @class fused_members
+ *
+ * @brief Stores one object of each module type in `module_types` and runs them
+ * in order.
+ *
+ * The modules are stored by value rather than through pointers to the
+ * `module` base class, so the compiler knows the type of each one and can
+ * inline their `do_operation()` functions into a single `run()` function.
+ */
+template <typename... module_types>
+class fused_members;
+
+template <>
+class fused_members<>
+{
+   public:
+    fused_members(state_map const&, state_map*) {}
+
+    void run() const {}
+
+    bool requires_euler_ode_solver() const { return false; }
+
+    static bool is_member(module_creator*) { return false; }
+
+    static bool all_members_in(mc_vector const&) { return true; }
+
+    static void add_quantities(string_vector&, string_vector&) {}
+};
+
+template <typename first_type, typename... rest_types>
+class fused_members<first_type, rest_types...>
+{
+   public:
+    fused_members(
+        state_map const& input_quantities,
+        state_map* output_quantities)
+        : first(input_quantities, output_quantities),
+          rest(input_quantities, output_quantities)
+    {
+    }
+
+    // Some modules define their own `run()` function, so `module::run()` is
+    // called explicitly; since the type of `first` is known, the compiler can
+    // still resolve its `do_operation()` function without a virtual call
+    void run() const
+    {
+        static_cast<module const&>(first).run();
+        rest.run();
+    }
+
+    bool requires_euler_ode_solver() const
+    {
+        return first.requires_euler_ode_solver() ||
+               rest.requires_euler_ode_solver();
+    }
+
+    // Module creators produced by `create_mc<T>()` are `module_creator_impl<T>`
+    // objects, so the type of module a creator produces can be identified
+    // without relying on module names, which may not be unique across
+    // module libraries
+    static bool is_member(module_creator* mc)
+    {
+        return dynamic_cast<module_creator_impl<first_type>*>(mc) != nullptr ||
+               fused_members<rest_types...>::is_member(mc);
+    }
+
+    static bool all_members_in(mc_vector const& mcs)
+    {
+        bool found = false;
+        for (module_creator* mc : mcs) {
+            if (dynamic_cast<module_creator_impl<first_type>*>(mc) != nullptr) {
+                found = true;
+            }
+        }
+        return found && fused_members<rest_types...>::all_members_in(mcs);
+    }
+
+    // Adds the inputs of each module that are not outputs of a previous
+    // module, followed by its outputs
+    static void add_quantities(string_vector& inputs, string_vector& outputs)
+    {
+        for (std::string const& name : first_type::get_inputs()) {
+            if (!contains(inputs, name) && !contains(outputs, name)) {
+                inputs.push_back(name);
+            }
+        }
+
+        for (std::string const& name : first_type::get_outputs()) {
+            outputs.push_back(name);
+        }
+
+        fused_members<rest_types...>::add_quantities(inputs, outputs);
+    }
+
+   private:
+    first_type const first;
+    fused_members<rest_types...> const rest;
+
+    static bool contains(string_vector const& names, std::string const& name)
+    {
+        for (std::string const& n : names) {
+            if (n == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * @class fused_direct_module
+ *
+ * @brief A direct module that runs a fixed list of direct modules, in the
+ * order they are listed, as a single module.
+ *
+ * When a simulation runs the modules individually, each one is called through
+ * the virtual `module::run()` function. Here the module types are known at
+ * compile time, so the whole list can be inlined into one function, avoiding
+ * the virtual calls and allowing the compiler to optimize across module
+ * boundaries.
+ *
+ * The modules must be listed so that each module follows the modules that
+ * calculate its inputs; if not, `is_valid_order()` returns false and the
+ * module should not be used, since its outputs would include some of its own
+ * inputs.
+ *
+ * This class is not used directly. Instead, a child class is defined for each
+ * list of modules that should be fused, which only adds a static `get_name()`
+ * function; see `fused_crop_modules.h` for examples.
+ */
+template <typename... module_types>
+class fused_direct_module : private fused_members<module_types...>,
+                            public direct_module
+{
+    using members = fused_members<module_types...>;
+
+   public:
+    fused_direct_module(
+        state_map const& input_quantities,
+        state_map* output_quantities)
+        : members(input_quantities, output_quantities),
+          direct_module{members::requires_euler_ode_solver()}
+    {
+    }
+
+    static string_vector get_inputs()
+    {
+        string_vector inputs, outputs;
+        members::add_quantities(inputs, outputs);
+        return inputs;
+    }
+
+    static string_vector get_outputs()
+    {
+        string_vector inputs, outputs;
+        members::add_quantities(inputs, outputs);
+        return outputs;
+    }
+
+    /**
+     * @brief Checks whether a list of module creators produces the same
+     * modules as this class, in any order
+     */
+    static bool replaces(mc_vector const& mcs)
+    {
+        if (mcs.size() != sizeof...(module_types)) {
+            return false;
+        }
+
+        for (module_creator* mc : mcs) {
+            if (!members::is_member(mc)) {
+                return false;
+            }
+        }
+
+        return members::all_members_in(mcs);
+    }
+
+    static bool is_valid_order()
+    {
+        string_vector const inputs = get_inputs();
+        for (std::string const& name : get_outputs()) {
+            for (std::string const& input : inputs) {
+                if (name == input) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+   private:
+    void do_operation() const override { members::run(); }
+};
+
+/**
+ * @brief Describes a fused module using pointers to functions that check
+ * whether it replaces a list of module creators, check the order of its
+ * modules, and create a module creator for it.
+ *
+ * Functions are stored rather than their values so that nothing is evaluated
+ * during static initialization.
+ */
+struct fused_module_entry {
+    bool (*replaces)(mc_vector const&);
+    bool (*is_valid_order)();
+    create_mc_type create;
+};
+
+using fused_module_list = std::vector<fused_module_entry>;
+
+template <typename fused_type>
+fused_module_entry make_fused_module_entry()
+{
+    return {
+        &fused_type::replaces,
+        &fused_type::is_valid_order,
+        &create_mc<fused_type>};
+}
+
+}  // namespace standardBML
+#endif
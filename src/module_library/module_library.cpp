@@ -87,6 +87,7 @@
 #include "example_model_partitioning.h"
 #include "litter_cover.h"
 #include "soil_sunlight.h"
+#include "fused_crop_modules.h"
 
 creator_map standardBML::module_library::library_entries =
 {
@@ -99,7 +100,9 @@ creator_map standardBML::module_library::library_entries =
      {"soil_evaporation",                                      &create_mc<soil_evaporation>},
      {"parameter_calculator",                                  &create_mc<parameter_calculator>},
      {"c3_canopy",                                             &create_mc<c3_canopy>},
+     {"c3_canopy_warm_start",                                  &create_mc<c3_canopy_warm_start>},
      {"c4_canopy",                                             &create_mc<c4_canopy>},
+     {"c4_canopy_warm_start",                                  &create_mc<c4_canopy_warm_start>},
      {"varying_Jmax25",                                        &create_mc<varying_Jmax25>},
      {"stomata_water_stress_linear",                           &create_mc<stomata_water_stress_linear>},
      {"stomata_water_stress_exponential",                      &create_mc<stomata_water_stress_exponential>},
@@ -137,13 +140,17 @@ creator_map standardBML::module_library::library_entries =
      {"leaf_shape_factor",                                     &create_mc<leaf_shape_factor>},
      {"rue_leaf_photosynthesis",                               &create_mc<rue_leaf_photosynthesis>},
      {"c3_assimilation",                                       &create_mc<c3_assimilation>},
+     {"c3_assimilation_bracketed",                             &create_mc<c3_assimilation_bracketed>},
      {"c3_leaf_photosynthesis",                                &create_mc<c3_leaf_photosynthesis>},
      {"c4_assimilation",                                       &create_mc<c4_assimilation>},
+     {"c4_assimilation_newton",                                &create_mc<c4_assimilation_newton>},
      {"c4_leaf_photosynthesis",                                &create_mc<c4_leaf_photosynthesis>},
      {"ten_layer_canopy_properties",                           &create_mc<ten_layer_canopy_properties>},
      {"ten_layer_rue_canopy",                                  &create_mc<ten_layer_rue_canopy>},
      {"ten_layer_c3_canopy",                                   &create_mc<ten_layer_c3_canopy>},
+     {"ten_layer_c3_canopy_warm_start",                        &create_mc<ten_layer_c3_canopy_warm_start>},
      {"ten_layer_c4_canopy",                                   &create_mc<ten_layer_c4_canopy>},
+     {"ten_layer_c4_canopy_warm_start",                        &create_mc<ten_layer_c4_canopy_warm_start>},
      {"ten_layer_canopy_integrator",                           &create_mc<ten_layer_canopy_integrator>},
      {"magic_clock",                                           &create_mc<magic_clock>},
      {"poincare_clock",                                        &create_mc<poincare_clock>},
@@ -174,3 +181,10 @@ creator_map standardBML::module_library::library_entries =
      {"litter_cover",                                          &create_mc<litter_cover>},
      {"soil_sunlight",                                         &create_mc<soil_sunlight>}
 };
+
+standardBML::fused_module_list standardBML::module_library::fused_entries =
+{
+     make_fused_module_entry<soybean_direct_modules>(),
+     make_fused_module_entry<miscanthus_x_giganteus_direct_modules>(),
+     make_fused_module_entry<willow_direct_modules>()
+};
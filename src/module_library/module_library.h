@@ -2,6 +2,7 @@
 #define STANDARDBML_H
 
 #include "../framework/module_creator.h"  // for module_creator and creator_map
+#include "fused_direct_module.h"          // for fused_module_list
 
 // When creating a new module library R package, it will be necessary to modify
 // the header guard and the namespace name in this file to reflect the new
@@ -20,6 +21,10 @@ class module_library
 {
    public:
     static creator_map library_entries;
+
+    // Fused versions of frequently used lists of direct modules; see
+    // `fused_direct_module.h` for more details
+    static fused_module_list fused_entries;
 };
 
 }  // namespace standardBML
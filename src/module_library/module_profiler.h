@@ -0,0 +1,135 @@
+#ifndef MODULE_PROFILER_H
+#define MODULE_PROFILER_H
+
+#include <chrono>  // for std::chrono::steady_clock, std::chrono::duration
+#include <map>
+#include <string>
+
+namespace standardBML
+{
+/**
+ * @brief Accumulated profiling information for one named piece of code, such
+ * as a module or a helping function.
+ */
+struct profile_entry {
+    long long calls = 0;       // number of times the code was run
+    double seconds = 0.0;      // cumulative wall-clock time in seconds
+    long long iterations = 0;  // cumulative solver iterations, if applicable
+};
+
+using profile_map = std::map<std::string, profile_entry>;
+
+/**
+ * @brief Returns a reference to the profile that is currently being recorded
+ * by the calling thread, or to `nullptr` if profiling is disabled.
+ *
+ * Profiling is disabled by default. Each thread has its own pointer, so
+ * simulations running on other threads are never affected by a profile that
+ * is active on the current thread.
+ */
+inline profile_map*& active_profile()
+{
+    static thread_local profile_map* profile = nullptr;
+    return profile;
+}
+
+/**
+ * @class profile_scope
+ *
+ * @brief Enables profiling for the calling thread during its lifetime; all
+ * information is recorded in the `profile_map` passed to the constructor.
+ *
+ * The previously active profile (if any) is restored when the scope ends.
+ */
+class profile_scope
+{
+   public:
+    profile_scope(profile_map& profile)
+        : previous{active_profile()}
+    {
+        active_profile() = &profile;
+    }
+
+    ~profile_scope() { active_profile() = previous; }
+
+    profile_scope(profile_scope const&) = delete;
+    profile_scope& operator=(profile_scope const&) = delete;
+
+   private:
+    profile_map* const previous;
+};
+
+/**
+ * @class profile_timer
+ *
+ * @brief Measures the wall-clock time between its construction and
+ * destruction and adds it, along with one call, to the entry called `name` in
+ * the active profile.
+ *
+ * When profiling is disabled, the cost of a timer is a single check of a
+ * thread-local pointer; in particular, the clock is not read and no strings
+ * are constructed.
+ *
+ * Timers can be nested, so the time recorded for a module includes the time
+ * spent in any code it runs.
+ */
+class profile_timer
+{
+    using clock = std::chrono::steady_clock;
+
+   public:
+    profile_timer(char const* name)
+        : profile{active_profile()}, name{name}
+    {
+        if (profile) {
+            start = clock::now();
+        }
+    }
+
+    ~profile_timer()
+    {
+        if (profile) {
+            std::chrono::duration<double> elapsed = clock::now() - start;
+            profile_entry& entry = (*profile)[name];
+            entry.calls += 1;
+            entry.seconds += elapsed.count();
+        }
+    }
+
+    profile_timer(profile_timer const&) = delete;
+    profile_timer& operator=(profile_timer const&) = delete;
+
+   private:
+    profile_map* const profile;
+    char const* const name;
+    clock::time_point start;
+};
+
+/**
+ * @brief Adds a number of solver iterations to the entry called `name` in the
+ * active profile, if there is one.
+ */
+inline void record_iterations(char const* name, int iterations)
+{
+    profile_map* profile = active_profile();
+    if (profile) {
+        (*profile)[name].iterations += iterations;
+    }
+}
+
+/**
+ * @brief Adds the calls, time, and iterations from each entry of `source` to
+ * the entry with the same name in `destination`.
+ */
+inline void merge_profile(profile_map& destination, profile_map const& source)
+{
+    for (auto const& x : source) {
+        profile_entry& entry = destination[x.first];
+        entry.calls += x.second.calls;
+        entry.seconds += x.second.seconds;
+        entry.iterations += x.second.iterations;
+    }
+}
+
+}  // namespace standardBML
+#endif
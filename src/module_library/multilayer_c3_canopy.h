@@ -6,6 +6,32 @@
 #include "multilayer_canopy_properties.h"
 #include "c3_leaf_photosynthesis.h"
 
+namespace MLCP
+{
+/**
+ * @brief Evaluates the `c3_leaf_photosynthesis` module for all leaf classes and
+ * layers at once; see `c3_leaf_photosynthesis::run_batch()`.
+ */
+template <>
+struct leaf_batch<standardBML::c3_leaf_photosynthesis> {
+    static bool const available = true;
+
+    static void run(
+        size_t nleaves,
+        size_t ninputs,
+        size_t noutputs,
+        const double* input_values,
+        const size_t* input_slots,
+        double* output_values,
+        photosynthesis_warm_start* warm_start)
+    {
+        standardBML::c3_leaf_photosynthesis::run_batch(
+            nleaves, ninputs, noutputs, input_values, input_slots, output_values,
+            warm_start);
+    }
+};
+}  // namespace MLCP
+
 namespace standardBML
 {
 using ten_layer_c3_canopy_parent =
@@ -56,5 +82,47 @@ class ten_layer_c3_canopy : public ten_layer_c3_canopy_parent
     void do_operation() const;
 };
 
+/**
+ * @class ten_layer_c3_canopy_warm_start
+ *
+ * @brief A child class of ten_layer_c3_canopy that starts the photosynthesis
+ * iteration for each leaf class and layer from its results at the previous
+ * evaluation, rather than from a fixed guess; see `photosynthesis_warm_start`.
+ *
+ * This module has the same inputs as `ten_layer_c3_canopy`, along with
+ * ``'time'`` and ``'lai'``, which are used to discard the previous results
+ * whenever time goes backwards or the leaf area index jumps. Its outputs agree
+ * with those of `ten_layer_c3_canopy` to within the tolerance of the
+ * photosynthesis iteration. The number of iterations is recorded in the
+ * simulation profile under `c3photoC_batch (warm start)`.
+ */
+class ten_layer_c3_canopy_warm_start : public ten_layer_c3_canopy
+{
+   public:
+    ten_layer_c3_canopy_warm_start(
+        state_map const& input_quantities,
+        state_map* output_quantities)
+        : ten_layer_c3_canopy(input_quantities, output_quantities),
+
+          // Get references to input quantities
+          time{get_input(input_quantities, "time")},
+          lai{get_input(input_quantities, "lai")}
+    {
+    }
+    static string_vector get_inputs();
+    static std::string get_name() { return "ten_layer_c3_canopy_warm_start"; }
+
+   private:
+    // References to input quantities
+    double const& time;
+    double const& lai;
+
+    // Converged photosynthesis results for each leaf class and layer
+    photosynthesis_warm_start mutable warm_start;
+
+    // Main operation
+    void do_operation() const;
+};
+
 }  // namespace standardBML
 #endif
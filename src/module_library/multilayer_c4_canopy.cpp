@@ -2,6 +2,7 @@
 
 using standardBML::ten_layer_c4_canopy;
 using standardBML::ten_layer_c4_canopy_parent;
+using standardBML::ten_layer_c4_canopy_warm_start;
 
 int const ten_layer_c4_canopy::nlayers = 10;  // Set the number of layers
 
@@ -26,3 +27,17 @@ void ten_layer_c4_canopy::do_operation() const
     // Just call the parent class's run operation
     ten_layer_c4_canopy_parent::run();
 }
+
+string_vector ten_layer_c4_canopy_warm_start::get_inputs()
+{
+    string_vector inputs = ten_layer_c4_canopy::get_inputs();
+    inputs.push_back("time");  // days
+    inputs.push_back("lai");   // dimensionless from m^2 / m^2
+    return inputs;
+}
+
+void ten_layer_c4_canopy_warm_start::do_operation() const
+{
+    warm_start.update(time, lai);
+    ten_layer_c4_canopy_parent::run(&warm_start);
+}
@@ -2,8 +2,11 @@
 #define MULTILAYER_CANOPY_PHOTOSYNTHESIS_H
 
 #include <algorithm>  // for std::find
+#include <map>        // for std::map
 #include "../framework/module.h"
 #include "../framework/state_map.h"
+#include "module_profiler.h"            // for profile_timer
+#include "photosynthesis_warm_start.h"  // for photosynthesis_warm_start
 
 namespace MLCP  // helping functions for the MultiLayer Canopy Photosynthesis module
 {
@@ -92,6 +95,49 @@ string_vector get_other_leaf_inputs()
 
     return leaf_inputs_constant_through_canopy;
 }
+
+/**
+ * @brief Allows a leaf module to be evaluated for all leaf classes and layers of
+ * a multilayer canopy at once.
+ *
+ * By default, the multilayer canopy photosynthesis module runs the leaf module
+ * separately for each combination of leaf class and layer. A leaf module can
+ * instead process all of them together by specializing this template with
+ * `available` set to `true` and a `run()` function that calculates the leaf
+ * module's outputs for `nleaves` leaves. For leaf `i`, input `j` is
+ * `input_values[input_slots[i * ninputs + j]]` and output `k` must be stored in
+ * `output_values[i * noutputs + k]`, where the inputs and outputs are in the
+ * order given by the leaf module's `get_inputs()` and `get_outputs()`.
+ *
+ * If `warm_start` is not `nullptr`, `run()` may use it to start any iterative
+ * calculations for each leaf from its results at the previous call; see
+ * `photosynthesis_warm_start`. The leaves are always passed in the same order,
+ * so the stored results for leaf `i` belong to the same leaf class and layer.
+ */
+template <typename leaf_module_type>
+struct leaf_batch {
+    static bool const available = false;
+
+    static void run(
+        size_t /*nleaves*/,
+        size_t /*ninputs*/,
+        size_t /*noutputs*/,
+        const double* /*input_values*/,
+        const size_t* /*input_slots*/,
+        double* /*output_values*/,
+        photosynthesis_warm_start* /*warm_start*/)
+    {
+    }
+};
+
+/**
+ * @brief A helping function for the multilayer canopy photosynthesis module
+ * that checks whether a name is in a vector of names.
+ */
+inline bool contains(string_vector const& names, std::string const& name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
 }  // namespace MLCP
 
 namespace standardBML
@@ -151,6 +197,15 @@ namespace standardBML
  * Note that this module has a non-standard constructor, so it cannot be created
  * using the module_factory. Rather, it is expected that directly-usable
  * classes will be derived from this class.
+ *
+ * ### Warm starts
+ *
+ * A derived class can pass a `photosynthesis_warm_start` object to `run()`,
+ * which is then passed to `MLCP::leaf_batch<leaf_module_type>::run()` so that
+ * the iteration for each leaf class and layer starts from its results at the
+ * previous evaluation. The derived class is responsible for calling
+ * `photosynthesis_warm_start::update()` before each evaluation. Warm starts
+ * have no effect for leaf modules that cannot be run as a batch.
  */
 template <typename canopy_module_type, typename leaf_module_type>
 class multilayer_canopy_photosynthesis : public direct_module
@@ -170,16 +225,40 @@ class multilayer_canopy_photosynthesis : public direct_module
     state_map leaf_module_output_map;
     std::unique_ptr<module> leaf_module;
 
-    // Pointers to input parameters
-    std::vector<std::vector<std::pair<double*, const double*>>> leaf_input_ptr_pairs;
-
-    // Pointers to output parameters
-    std::vector<std::vector<std::pair<double*, const double*>>> leaf_output_ptr_pairs;
+    // Name used to profile the leaf module
+    std::string const leaf_module_profile_name;
+
+    // Number of leaf module runs (one for each combination of leaf class and
+    // layer), and the number of leaf module inputs and outputs for each run
+    size_t nleaves;
+    size_t inputs_per_leaf;
+    size_t outputs_per_leaf;
+
+    // Pointers to the canopy module quantities that supply the leaf module
+    // inputs, with each quantity listed once even if it is used by several
+    // leaves, and the slots where their values are gathered at the start of
+    // each run. Input `j` for leaf `i` is stored in the slot numbered
+    // `input_slots[i * inputs_per_leaf + j]`.
+    std::vector<const double*> canopy_input_ptrs;
+    std::vector<size_t> input_slots;
+    std::vector<double> mutable input_values;
+
+    // Slots for the leaf module outputs, where output `k` for leaf `i` is
+    // `output_values[i * outputs_per_leaf + k]`, and pointers to the canopy
+    // module outputs where they are stored at the end of each run, in the
+    // same order
+    std::vector<double> mutable output_values;
+    std::vector<double*> canopy_output_ptrs;
+
+    // Pointers to the leaf module's own inputs and outputs, which are used
+    // when the leaf module cannot be run as a batch
+    std::vector<double*> leaf_input_ptrs;
+    std::vector<const double*> leaf_output_ptrs;
 
    protected:
     static string_vector generate_inputs(int nlayers);
     static string_vector generate_outputs(int nlayers);
-    void run() const;
+    void run(photosynthesis_warm_start* warm_start = nullptr) const;
 };
 
 /**
@@ -193,7 +272,8 @@ multilayer_canopy_photosynthesis<canopy_module_type, leaf_module_type>::multilay
     state_map const& input_quantities,
     state_map* output_quantities)
     : direct_module{},
-      nlayers(nlayers)
+      nlayers(nlayers),
+      leaf_module_profile_name{leaf_module_type::get_name() + " (nested)"}
 {
     // Define a lambda for making quantity maps from vectors of inputs and outputs
     auto make_quantity_map = [](string_vector input_names, string_vector output_names) -> state_map {
@@ -227,69 +307,71 @@ multilayer_canopy_photosynthesis<canopy_module_type, leaf_module_type>::multilay
     string_vector multilayer_leaf_inputs =
         MLCP::get_pure_multilayer_leaf_inputs<canopy_module_type, leaf_module_type>();
 
-    string_vector other_leaf_inputs =
-        MLCP::get_other_leaf_inputs<canopy_module_type, leaf_module_type>();
-
-    // Create vectors of pointer pairs which will be used for passing inputs to
-    // and getting outputs from the leaf module
-    for (std::string const& class_name : canopy_module_type::define_leaf_classes()) {
-        for (int i = 0; i < nlayers; ++i) {
-            // Get pointer pairs for the leaf module inputs and store them
-            std::vector<std::pair<double*, const double*>> input_ptr_pairs;
-
-            for (std::string const& name : multiclass_multilayer_leaf_inputs) {
-                std::string specific_name =
-                    add_class_prefix_to_quantity_name(
-                        class_name,
-                        add_layer_suffix_to_quantity_name(nlayers, i, name));
-
-                std::pair<double*, const double*> temporary(
-                    get_op(&leaf_module_quantities, name),
-                    get_ip(input_quantities, specific_name));
-
-                input_ptr_pairs.push_back(temporary);
-            }
-
-            for (std::string const& name : multilayer_leaf_inputs) {
-                std::string specific_name =
-                    add_layer_suffix_to_quantity_name(nlayers, i, name);
-
-                std::pair<double*, const double*> temporary(
-                    get_op(&leaf_module_quantities, name),
-                    get_ip(input_quantities, specific_name));
+    // Get pointers to the leaf module inputs that will be set for each run;
+    // their order must match the order of the canopy module quantities below,
+    // and it follows the leaf module's `get_inputs()` so the quantities can
+    // also be passed to `MLCP::leaf_batch<leaf_module_type>::run()`
+    string_vector const leaf_inputs = leaf_module_type::get_inputs();
+    for (std::string const& name : leaf_inputs) {
+        leaf_input_ptrs.push_back(get_op(&leaf_module_quantities, name));
+    }
 
-                input_ptr_pairs.push_back(temporary);
-            }
+    // Get pointers to the leaf module outputs
+    string_vector const leaf_outputs = leaf_module_type::get_outputs();
+    for (std::string const& name : leaf_outputs) {
+        leaf_output_ptrs.push_back(get_ip(leaf_module_output_map, name));
+    }
 
-            for (std::string const& name : other_leaf_inputs) {
-                std::pair<double*, const double*> temporary(
-                    get_op(&leaf_module_quantities, name),
-                    get_ip(input_quantities, name));
+    string_vector const leaf_classes = canopy_module_type::define_leaf_classes();
+    nleaves = leaf_classes.size() * nlayers;
+    inputs_per_leaf = leaf_input_ptrs.size();
+    outputs_per_leaf = leaf_output_ptrs.size();
+
+    input_slots.reserve(nleaves * inputs_per_leaf);
+    canopy_output_ptrs.reserve(nleaves * outputs_per_leaf);
+
+    // Assign a slot to each canopy module quantity the first time it is
+    // needed as a leaf module input; quantities that do not depend on the
+    // leaf class or layer are then gathered only once per run, rather than
+    // once for each leaf
+    std::map<std::string, size_t> slot_of_quantity;
+    auto add_input = [&](std::string const& canopy_name) {
+        auto it = slot_of_quantity.find(canopy_name);
+        if (it == slot_of_quantity.end()) {
+            it = slot_of_quantity.emplace(canopy_name, canopy_input_ptrs.size()).first;
+            canopy_input_ptrs.push_back(get_ip(input_quantities, canopy_name));
+        }
+        input_slots.push_back(it->second);
+    };
 
-                input_ptr_pairs.push_back(temporary);
+    // Store the slots of the leaf module inputs and pointers to the canopy
+    // module outputs for each combination of leaf class and layer
+    for (std::string const& class_name : leaf_classes) {
+        for (int i = 0; i < nlayers; ++i) {
+            for (std::string const& name : leaf_inputs) {
+                if (MLCP::contains(multiclass_multilayer_leaf_inputs, name)) {
+                    add_input(add_class_prefix_to_quantity_name(
+                        class_name,
+                        add_layer_suffix_to_quantity_name(nlayers, i, name)));
+                } else if (MLCP::contains(multilayer_leaf_inputs, name)) {
+                    add_input(add_layer_suffix_to_quantity_name(nlayers, i, name));
+                } else {
+                    add_input(name);
+                }
             }
 
-            leaf_input_ptr_pairs.push_back(input_ptr_pairs);
-
-            // Get pointer pairs to the leaf module outputs and store them
-            std::vector<std::pair<double*, const double*>> output_ptr_pairs;
-
-            for (std::string const& name : leaf_module_type::get_outputs()) {
-                std::string specific_name =
+            for (std::string const& name : leaf_outputs) {
+                canopy_output_ptrs.push_back(get_op(
+                    output_quantities,
                     add_class_prefix_to_quantity_name(
                         class_name,
-                        add_layer_suffix_to_quantity_name(nlayers, i, name));
-
-                std::pair<double*, const double*> temporary(
-                    get_op(output_quantities, specific_name),
-                    get_ip(leaf_module_output_map, name));
-
-                output_ptr_pairs.push_back(temporary);
+                        add_layer_suffix_to_quantity_name(nlayers, i, name))));
             }
-
-            leaf_output_ptr_pairs.push_back(output_ptr_pairs);
         }
     }
+
+    input_values.resize(canopy_input_ptrs.size());
+    output_values.resize(canopy_output_ptrs.size());
 }
 
 template <typename canopy_module_type, typename leaf_module_type>
@@ -335,23 +417,47 @@ string_vector multilayer_canopy_photosynthesis<canopy_module_type, leaf_module_t
 }
 
 template <typename canopy_module_type, typename leaf_module_type>
-void multilayer_canopy_photosynthesis<canopy_module_type, leaf_module_type>::run() const
+void multilayer_canopy_photosynthesis<canopy_module_type, leaf_module_type>::run(
+    photosynthesis_warm_start* warm_start) const
 {
-    // For each combination of leaf class and layer number:
-    for (size_t i = 0; i < leaf_input_ptr_pairs.size(); ++i) {
-        // Update the inputs to the leaf module
-        for (auto const& x : leaf_input_ptr_pairs[i]) {
-            *x.first = *x.second;
-        }
+    // Gather the values of the leaf module inputs
+    for (size_t s = 0; s < canopy_input_ptrs.size(); ++s) {
+        input_values[s] = *canopy_input_ptrs[s];
+    }
 
-        // Run the leaf module
-        leaf_module->run();
+    if (MLCP::leaf_batch<leaf_module_type>::available) {
+        // Process all the leaves at once
+        profile_timer timer(leaf_module_profile_name.c_str());
+        MLCP::leaf_batch<leaf_module_type>::run(
+            nleaves, inputs_per_leaf, outputs_per_leaf, input_values.data(),
+            input_slots.data(), output_values.data(), warm_start);
+    } else {
+        // For each combination of leaf class and layer number:
+        for (size_t i = 0; i < nleaves; ++i) {
+            // Update the inputs to the leaf module
+            size_t const* slots = input_slots.data() + i * inputs_per_leaf;
+            for (size_t j = 0; j < inputs_per_leaf; ++j) {
+                *leaf_input_ptrs[j] = input_values[slots[j]];
+            }
+
+            // Run the leaf module
+            {
+                profile_timer timer(leaf_module_profile_name.c_str());
+                leaf_module->run();
+            }
 
-        // Update the outputs from the leaf module
-        for (auto const& x : leaf_output_ptr_pairs[i]) {
-            *x.first = *x.second;
+            // Get the outputs from the leaf module
+            double* outputs = output_values.data() + i * outputs_per_leaf;
+            for (size_t k = 0; k < outputs_per_leaf; ++k) {
+                outputs[k] = *leaf_output_ptrs[k];
+            }
         }
     }
+
+    // Update the outputs of the canopy module
+    for (size_t k = 0; k < canopy_output_ptrs.size(); ++k) {
+        *canopy_output_ptrs[k] = output_values[k];
+    }
 }
 
 }  // namespace standardBML
@@ -3,6 +3,7 @@
 
 #include "../framework/module.h"
 #include "../framework/state_map.h"
+#include "dual_number.h"  // for non_deduced_t
 
 namespace standardBML
 {
@@ -100,6 +101,38 @@ class partitioning_growth : public differential_module
     static string_vector get_outputs();
     static std::string get_name() { return "partitioning_growth"; }
 
+    // Rates of change of the output quantities
+    template <typename scalar>
+    struct rates {
+        scalar Leaf;
+        scalar Stem;
+        scalar Root;
+        scalar Rhizome;
+        scalar Grain;
+        scalar Shell;
+    };
+
+    template <typename scalar = double>
+    static rates<scalar> calculate_rates(
+        non_deduced_t<scalar> retrans,
+        non_deduced_t<scalar> retrans_rhizome,
+        non_deduced_t<scalar> kLeaf,
+        non_deduced_t<scalar> kStem,
+        non_deduced_t<scalar> kRoot,
+        non_deduced_t<scalar> kRhizome,
+        non_deduced_t<scalar> kGrain,
+        non_deduced_t<scalar> kShell,
+        non_deduced_t<scalar> net_assimilation_rate_leaf,
+        non_deduced_t<scalar> net_assimilation_rate_stem,
+        non_deduced_t<scalar> net_assimilation_rate_root,
+        non_deduced_t<scalar> net_assimilation_rate_rhizome,
+        non_deduced_t<scalar> net_assimilation_rate_grain,
+        non_deduced_t<scalar> net_assimilation_rate_shell,
+        non_deduced_t<scalar> Leaf,
+        non_deduced_t<scalar> Stem,
+        non_deduced_t<scalar> Root,
+        non_deduced_t<scalar> Rhizome);
+
    private:
     // References to input quantities
     const double& retrans;
@@ -169,15 +202,41 @@ string_vector partitioning_growth::get_outputs()
     };
 }
 
-void partitioning_growth::do_operation() const
+/**
+ * @brief Calculates the rates of change of the output quantities.
+ *
+ * This function is templated on the scalar type used for its calculations so
+ * it can be used with automatic differentiation; see `dual_number.h`.
+ */
+template <typename scalar>
+partitioning_growth::rates<scalar> partitioning_growth::calculate_rates(
+    non_deduced_t<scalar> retrans,                        // dimensionless
+    non_deduced_t<scalar> retrans_rhizome,                // dimensionless
+    non_deduced_t<scalar> kLeaf,                          // dimensionless
+    non_deduced_t<scalar> kStem,                          // dimensionless
+    non_deduced_t<scalar> kRoot,                          // dimensionless
+    non_deduced_t<scalar> kRhizome,                       // dimensionless
+    non_deduced_t<scalar> kGrain,                         // dimensionless
+    non_deduced_t<scalar> kShell,                         // dimensionless
+    non_deduced_t<scalar> net_assimilation_rate_leaf,     // Mg / ha / hour
+    non_deduced_t<scalar> net_assimilation_rate_stem,     // Mg / ha / hour
+    non_deduced_t<scalar> net_assimilation_rate_root,     // Mg / ha / hour
+    non_deduced_t<scalar> net_assimilation_rate_rhizome,  // Mg / ha / hour
+    non_deduced_t<scalar> net_assimilation_rate_grain,    // Mg / ha / hour
+    non_deduced_t<scalar> net_assimilation_rate_shell,    // Mg / ha / hour
+    non_deduced_t<scalar> Leaf,                           // Mg / ha
+    non_deduced_t<scalar> Stem,                           // Mg / ha
+    non_deduced_t<scalar> Root,                           // Mg / ha
+    non_deduced_t<scalar> Rhizome                         // Mg / ha
+)
 {
     // Initialize variables
-    double dLeaf{0.0};
-    double dStem{0.0};
-    double dRoot{0.0};
-    double dRhizome{0.0};
-    double dGrain{0.0};
-    double dShell{0.0};
+    scalar dLeaf{0.0};
+    scalar dStem{0.0};
+    scalar dRoot{0.0};
+    scalar dRhizome{0.0};
+    scalar dGrain{0.0};
+    scalar dShell{0.0};
 
     // Determine whether Leaf is growing or decaying
     if (kLeaf > 0.0) {
@@ -240,13 +299,26 @@ void partitioning_growth::do_operation() const
         dShell += net_assimilation_rate_shell;
     }
 
+    return rates<scalar>{dLeaf, dStem, dRoot, dRhizome, dGrain, dShell};
+}
+
+void partitioning_growth::do_operation() const
+{
+    rates<double> const r = calculate_rates(
+        retrans, retrans_rhizome,
+        kLeaf, kStem, kRoot, kRhizome, kGrain, kShell,
+        net_assimilation_rate_leaf, net_assimilation_rate_stem,
+        net_assimilation_rate_root, net_assimilation_rate_rhizome,
+        net_assimilation_rate_grain, net_assimilation_rate_shell,
+        Leaf, Stem, Root, Rhizome);
+
     // Update the output quantity list
-    update(Leaf_op, dLeaf);
-    update(Stem_op, dStem);
-    update(Root_op, dRoot);
-    update(Rhizome_op, dRhizome);
-    update(Grain_op, dGrain);
-    update(Shell_op, dShell);
+    update(Leaf_op, r.Leaf);
+    update(Stem_op, r.Stem);
+    update(Root_op, r.Root);
+    update(Rhizome_op, r.Rhizome);
+    update(Grain_op, r.Grain);
+    update(Shell_op, r.Shell);
 }
 
 }  // namespace standardBML
@@ -1,20 +1,61 @@
 #ifndef PHOTOSYNTHESIS_OUTPUTS_H
 #define PHOTOSYNTHESIS_OUTPUTS_H
 
+#include <cstddef>  // for size_t
+#include <vector>   // for std::vector
+
 /**
  * @brief A simple structure for holding the output of photosynthesis
  * calculations.
  */
-struct photosynthesis_outputs {
-    double Assim;              //!< Net CO2 assimilation rate (micromol / m^2 / s)
-    double Assim_conductance;  //!< Conductance-limited net CO2 assim. rate (micromol / m^2 / s)
-    double Ci;                 //!< CO2 concentration in intercellular spaces (micromol / mol)
-    double GrossAssim;         //!< Gross CO2 assimilation rate (micromol / m^2 / s)
-    double Gs;                 //!< Stomatal conductance to water vapor (mmol / m^2 / s)
-    double Cs;                 //!< CO2 concentration at the leaf surface (micromol / mol)
-    double RHs;                //!< Relative humidity at the leaf surface (dimensionless)
-    double Rp;                 //!< Rate of photorespiration (micromol / m^2 / s)
+template <typename scalar>
+struct basic_photosynthesis_outputs {
+    scalar Assim;              //!< Net CO2 assimilation rate (micromol / m^2 / s)
+    scalar Assim_conductance;  //!< Conductance-limited net CO2 assim. rate (micromol / m^2 / s)
+    scalar Ci;                 //!< CO2 concentration in intercellular spaces (micromol / mol)
+    scalar GrossAssim;         //!< Gross CO2 assimilation rate (micromol / m^2 / s)
+    scalar Gs;                 //!< Stomatal conductance to water vapor (mmol / m^2 / s)
+    scalar Cs;                 //!< CO2 concentration at the leaf surface (micromol / mol)
+    scalar RHs;                //!< Relative humidity at the leaf surface (dimensionless)
+    scalar Rp;                 //!< Rate of photorespiration (micromol / m^2 / s)
     int iterations;            //!< Number of iterations used by convergence loop
 };
 
+using photosynthesis_outputs = basic_photosynthesis_outputs<double>;
+
+/**
+ * @brief A structure of arrays for holding the output of photosynthesis
+ * calculations for a batch of leaves, where element `i` of each array belongs
+ * to leaf `i`.
+ */
+struct photosynthesis_batch_outputs {
+    std::vector<double> Assim;              //!< Net CO2 assimilation rate (micromol / m^2 / s)
+    std::vector<double> Assim_conductance;  //!< Conductance-limited net CO2 assim. rate (micromol / m^2 / s)
+    std::vector<double> Ci;                 //!< CO2 concentration in intercellular spaces (micromol / mol)
+    std::vector<double> GrossAssim;         //!< Gross CO2 assimilation rate (micromol / m^2 / s)
+    std::vector<double> Gs;                 //!< Stomatal conductance to water vapor (mmol / m^2 / s)
+    std::vector<double> Cs;                 //!< CO2 concentration at the leaf surface (micromol / mol)
+    std::vector<double> RHs;                //!< Relative humidity at the leaf surface (dimensionless)
+    std::vector<double> Rp;                 //!< Rate of photorespiration (micromol / m^2 / s)
+    std::vector<int> iterations;            //!< Number of iterations used by convergence loop
+
+    void resize(size_t n)
+    {
+        for (std::vector<double>* v : {&Assim, &Assim_conductance, &Ci,
+                                       &GrossAssim, &Gs, &Cs, &RHs, &Rp}) {
+            v->resize(n);
+        }
+        iterations.resize(n);
+    }
+
+    size_t size() const { return Assim.size(); }
+
+    photosynthesis_outputs operator[](size_t i) const
+    {
+        return photosynthesis_outputs{
+            Assim[i], Assim_conductance[i], Ci[i], GrossAssim[i],
+            Gs[i], Cs[i], RHs[i], Rp[i], iterations[i]};
+    }
+};
+
 #endif
@@ -0,0 +1,123 @@
+#ifndef PHOTOSYNTHESIS_WARM_START_H
+#define PHOTOSYNTHESIS_WARM_START_H
+
+#include <cmath>                     // for std::abs
+#include <cstddef>                   // for size_t
+#include <limits>                    // for std::numeric_limits
+#include <utility>                   // for std::swap
+#include "photosynthesis_outputs.h"  // for photosynthesis_batch_outputs
+
+/**
+ *  @class photosynthesis_warm_start
+ *
+ *  @brief Stores the converged results of `c3photoC_batch()` or
+ *  `c4photoC_batch()` for each leaf of a canopy, so that later evaluations of
+ *  the canopy can start the iteration for each leaf from its previous
+ *  intercellular CO2 concentration, stomatal conductance, and assimilation
+ *  rate rather than from a fixed guess.
+ *
+ *  Only results stored at a strictly earlier time are used as initial guesses.
+ *  Solvers often evaluate the system several times at the same time with
+ *  slightly different states, for example to calculate a Jacobian matrix by
+ *  finite differences, and those evaluations must all start from the same
+ *  guess so that their differences are not dominated by the iteration's
+ *  tolerance. So the results of the first evaluation at each time are held
+ *  back, and they only become the initial guess once the system is evaluated
+ *  at a later time; later evaluations at the same time do not replace them.
+ *
+ *  Adaptive solvers do not evaluate the system in order of increasing time:
+ *  the stages of a Runge-Kutta step are not always in order, and the
+ *  `homemade_lsoda` and `homemade_dopri5` solvers evaluate the system at each
+ *  output time after stepping past it. Such evaluations still use the current
+ *  guess, as long as they are not earlier than the time it was stored at.
+ *
+ *  The leaves are identified by their index in the batch, which the canopy
+ *  modules assign by leaf class and layer, so the stored results for a leaf are
+ *  only ever used for the same leaf class and layer. They are discarded
+ *  whenever:
+ *
+ *  - Time goes back to or before the time at which the current guess was
+ *    stored, as happens when an adaptive ODE solver rejects a step or when a
+ *    simulation is restarted.
+ *
+ *  - The leaf area index changes by more than 10 percent from one evaluation to
+ *    the next, since the light and temperature of each layer depend on it.
+ *
+ *  - The number of leaves changes.
+ *
+ *  A warm start only changes where the iteration begins, so the results agree
+ *  with those of a cold start to within the tolerance of the iteration. (Any
+ *  leaf that converges slowly from its warm start is restarted from the fixed
+ *  guess; see `c3photoC_batch()`.)
+ *  However, they can depend on the order in which a solver evaluates the
+ *  system, so they are not always bitwise reproducible.
+ */
+class photosynthesis_warm_start
+{
+   public:
+    /**
+     *  @brief Records the time and leaf area index of the current evaluation.
+     *
+     *  If the held-back results were stored at an earlier time, they become
+     *  the initial guess. The guess is discarded if time is not later than the
+     *  time it was stored at, and all stored results are discarded if the leaf
+     *  area index has jumped since the previous evaluation.
+     */
+    void update(double time, double lai)
+    {
+        double const max_relative_lai_change = 0.1;  // dimensionless
+
+        if (!(std::abs(lai - last_lai) <= max_relative_lai_change * last_lai)) {
+            guess_valid = false;
+            pending_valid = false;
+        }
+
+        if (pending_valid && pending_time < time) {
+            std::swap(guess, pending);
+            guess_time = pending_time;
+            guess_valid = true;
+            pending_valid = false;
+        }
+
+        if (!(guess_time < time)) {
+            guess_valid = false;
+        }
+
+        last_time = time;
+        last_lai = lai;
+    }
+
+    /**
+     *  @brief Returns the results stored at an earlier time for a batch of
+     *  `nleaves` leaves, or `nullptr` if there are none.
+     */
+    photosynthesis_batch_outputs const* initial_guess(size_t nleaves) const
+    {
+        return guess_valid && guess.Assim.size() == nleaves ? &guess : nullptr;
+    }
+
+    /**
+     *  @brief Holds back the converged results for a batch of leaves, unless
+     *  results have already been stored at the current time.
+     */
+    void store(photosynthesis_batch_outputs const& converged)
+    {
+        if (!pending_valid || pending_time != last_time) {
+            pending = converged;
+            pending_time = last_time;
+            pending_valid = true;
+        }
+    }
+
+   private:
+    bool guess_valid = false;
+    bool pending_valid = false;
+    double guess_time = -std::numeric_limits<double>::infinity();    // days
+    double pending_time = -std::numeric_limits<double>::infinity();  // days
+    double last_time = -std::numeric_limits<double>::infinity();     // days
+    double last_lai = 0.0;                                           // dimensionless from m^2 / m^2
+    photosynthesis_batch_outputs guess;    // stored at `guess_time`
+    photosynthesis_batch_outputs pending;  // stored at `pending_time`
+};
+
+#endif
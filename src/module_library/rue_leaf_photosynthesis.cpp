@@ -142,7 +142,7 @@ void rue_leaf_photosynthesis::do_operation() const
             .Gs;  // mmol / m^2 / s
 
     // Calculate a new value for leaf temperature
-    const struct ET_Str et = c3EvapoTrans(
+    const ET_Str et = c3EvapoTrans(
         average_absorbed_shortwave,
         temp,
         rh,
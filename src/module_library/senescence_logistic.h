@@ -3,6 +3,7 @@
 
 #include "../framework/module.h"
 #include "../framework/state_map.h"
+#include "dual_number.h"  // for non_deduced_t
 
 namespace standardBML
 {
@@ -61,6 +62,39 @@ class senescence_logistic : public differential_module
     static string_vector get_outputs();
     static std::string get_name() { return "senescence_logistic"; }
 
+    // Rates of change of the output quantities
+    template <typename scalar>
+    struct rates {
+        scalar Leaf;
+        scalar LeafLitter;
+        scalar Stem;
+        scalar StemLitter;
+        scalar Root;
+        scalar RootLitter;
+        scalar Rhizome;
+        scalar RhizomeLitter;
+        scalar Grain;
+        scalar Shell;
+    };
+
+    template <typename scalar = double>
+    static rates<scalar> calculate_rates(
+        non_deduced_t<scalar> Leaf,
+        non_deduced_t<scalar> Stem,
+        non_deduced_t<scalar> Root,
+        non_deduced_t<scalar> Rhizome,
+        non_deduced_t<scalar> kSeneLeaf,
+        non_deduced_t<scalar> kSeneStem,
+        non_deduced_t<scalar> kSeneRoot,
+        non_deduced_t<scalar> kSeneRhizome,
+        non_deduced_t<scalar> kLeaf,
+        non_deduced_t<scalar> kStem,
+        non_deduced_t<scalar> kRoot,
+        non_deduced_t<scalar> kRhizome,
+        non_deduced_t<scalar> kGrain,
+        non_deduced_t<scalar> kShell,
+        non_deduced_t<scalar> remobilization_fraction);
+
    private:
     // References to input quantities
     const double& Leaf;
@@ -133,56 +167,100 @@ string_vector senescence_logistic::get_outputs()
     };
 }
 
-void senescence_logistic::do_operation() const
+/**
+ * @brief Calculates the rates of change of the output quantities.
+ *
+ * This function is templated on the scalar type used for its calculations so
+ * it can be used with automatic differentiation; see `dual_number.h`.
+ */
+template <typename scalar>
+senescence_logistic::rates<scalar> senescence_logistic::calculate_rates(
+    non_deduced_t<scalar> Leaf,                    // Mg / ha
+    non_deduced_t<scalar> Stem,                    // Mg / ha
+    non_deduced_t<scalar> Root,                    // Mg / ha
+    non_deduced_t<scalar> Rhizome,                 // Mg / ha
+    non_deduced_t<scalar> kSeneLeaf,               // dimensionless
+    non_deduced_t<scalar> kSeneStem,               // dimensionless
+    non_deduced_t<scalar> kSeneRoot,               // dimensionless
+    non_deduced_t<scalar> kSeneRhizome,            // dimensionless
+    non_deduced_t<scalar> kLeaf,                   // dimensionless
+    non_deduced_t<scalar> kStem,                   // dimensionless
+    non_deduced_t<scalar> kRoot,                   // dimensionless
+    non_deduced_t<scalar> kRhizome,                // dimensionless
+    non_deduced_t<scalar> kGrain,                  // dimensionless
+    non_deduced_t<scalar> kShell,                  // dimensionless
+    non_deduced_t<scalar> remobilization_fraction  // dimensionless
+)
 {
-    double senescence_leaf = kSeneLeaf * Leaf;           // Mg / ha, amount of leaf senesced
-    double senescence_stem = kSeneStem * Stem;           // Mg / ha, amount of stem senesced
-    double senescence_root = kSeneRoot * Root;           // Mg / ha, amount of root senesced
-    double senescence_rhizome = kSeneRhizome * Rhizome;  // Mg / ha, amount of rhizome senesced
+    scalar senescence_leaf = kSeneLeaf * Leaf;           // Mg / ha, amount of leaf senesced
+    scalar senescence_stem = kSeneStem * Stem;           // Mg / ha, amount of stem senesced
+    scalar senescence_root = kSeneRoot * Root;           // Mg / ha, amount of root senesced
+    scalar senescence_rhizome = kSeneRhizome * Rhizome;  // Mg / ha, amount of rhizome senesced
 
     // change in leaf biomass = minus amount senesced + new leaf tissue from
     // remobilized amount (Allows for leaves to start senescing while new leaves
     // are still being produced).
-    double dLeaf = -senescence_leaf + kLeaf * senescence_leaf * remobilization_fraction;  // Mg / ha
+    scalar dLeaf = -senescence_leaf + kLeaf * senescence_leaf * remobilization_fraction;  // Mg / ha
 
     // change in amount of leaf litter
-    double dLeafLitter = senescence_leaf * (1 - remobilization_fraction);  // Mg / ha
+    scalar dLeafLitter = senescence_leaf * (1 - remobilization_fraction);  // Mg / ha
 
     // change in stem biomass = minus amount senesced + new stem tissue from
     // remobilized leaf fraction
-    double dStem = -senescence_stem + kStem * senescence_leaf * remobilization_fraction;  // Mg / ha
+    scalar dStem = -senescence_stem + kStem * senescence_leaf * remobilization_fraction;  // Mg / ha
 
-    double dStemLitter = senescence_stem;  // Mg / ha, change in amount of stem litter
+    scalar dStemLitter = senescence_stem;  // Mg / ha, change in amount of stem litter
 
     // change in root biomass = minus amount senesced + new root tissue from remobilized
     // leaf fraction
-    double dRoot = -senescence_root + kRoot * senescence_leaf * remobilization_fraction;  // Mg / ha
+    scalar dRoot = -senescence_root + kRoot * senescence_leaf * remobilization_fraction;  // Mg / ha
 
-    double dRootLitter = senescence_root;  // Mg / ha, change in amount of root litter
+    scalar dRootLitter = senescence_root;  // Mg / ha, change in amount of root litter
 
     // change in rhizome biomass = minus amount senesced + new rhizome from remobilized
     // leaf fraction
-    double dRhizome = -senescence_rhizome + kRhizome * senescence_leaf * remobilization_fraction;  // Mg / ha
-    double dRhizomeLitter = senescence_rhizome;                                                    // Mg / ha, change in rhizome litter
+    scalar dRhizome = -senescence_rhizome + kRhizome * senescence_leaf * remobilization_fraction;  // Mg / ha
+    scalar dRhizomeLitter = senescence_rhizome;                                                    // Mg / ha, change in rhizome litter
 
     // change in grain biomass = new grain from remobilized leaf fraction.
     // currently do not include grain senescence.
-    double dGrain = kGrain * senescence_leaf * remobilization_fraction;  // Mg / ha
+    scalar dGrain = kGrain * senescence_leaf * remobilization_fraction;  // Mg / ha
 
     // change in shell biomass = new shell from remobilized leaf fraction.
     // currently do not include shell senescence.
-    double dShell = kShell * senescence_leaf * remobilization_fraction;  // Mg / ha
-
-    update(Leaf_op, dLeaf);                    // Mg / ha
-    update(Stem_op, dStem);                    // Mg / ha
-    update(Root_op, dRoot);                    // Mg / ha
-    update(Rhizome_op, dRhizome);              // Mg / ha
-    update(Grain_op, dGrain);                  // Mg / ha
-    update(Shell_op, dShell);                  // Mg / ha
-    update(LeafLitter_op, dLeafLitter);        // Mg / ha
-    update(StemLitter_op, dStemLitter);        // Mg / ha
-    update(RootLitter_op, dRootLitter);        // Mg / ha
-    update(RhizomeLitter_op, dRhizomeLitter);  // Mg / ha
+    scalar dShell = kShell * senescence_leaf * remobilization_fraction;  // Mg / ha
+
+    return rates<scalar>{
+        dLeaf,
+        dLeafLitter,
+        dStem,
+        dStemLitter,
+        dRoot,
+        dRootLitter,
+        dRhizome,
+        dRhizomeLitter,
+        dGrain,
+        dShell};
+}
+
+void senescence_logistic::do_operation() const
+{
+    rates<double> const r = calculate_rates(
+        Leaf, Stem, Root, Rhizome,
+        kSeneLeaf, kSeneStem, kSeneRoot, kSeneRhizome,
+        kLeaf, kStem, kRoot, kRhizome, kGrain, kShell,
+        remobilization_fraction);
+
+    update(Leaf_op, r.Leaf);                    // Mg / ha
+    update(Stem_op, r.Stem);                    // Mg / ha
+    update(Root_op, r.Root);                    // Mg / ha
+    update(Rhizome_op, r.Rhizome);              // Mg / ha
+    update(Grain_op, r.Grain);                  // Mg / ha
+    update(Shell_op, r.Shell);                  // Mg / ha
+    update(LeafLitter_op, r.LeafLitter);        // Mg / ha
+    update(StemLitter_op, r.StemLitter);        // Mg / ha
+    update(RootLitter_op, r.RootLitter);        // Mg / ha
+    update(RhizomeLitter_op, r.RhizomeLitter);  // Mg / ha
 }
 
 }  // namespace standardBML
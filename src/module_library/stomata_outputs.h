@@ -5,10 +5,13 @@
  * @brief A simple structure for holding the output of stomatal conductance
  * calculations.
  */
-struct stomata_outputs {
-    double cs;   //!< CO2 concentration at the leaf surface (micromol / mol)
-    double hs;   //!< Relative humidity at the leaf surface (dimensionless)
-    double gsw;  //!< Stomatal conductance to water vapor (mmol / m^2 / s)
+template <typename scalar>
+struct basic_stomata_outputs {
+    scalar cs;   //!< CO2 concentration at the leaf surface (micromol / mol)
+    scalar hs;   //!< Relative humidity at the leaf surface (dimensionless)
+    scalar gsw;  //!< Stomatal conductance to water vapor (mmol / m^2 / s)
 };
 
+using stomata_outputs = basic_stomata_outputs<double>;
+
 #endif
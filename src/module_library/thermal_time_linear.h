@@ -3,6 +3,7 @@
 
 #include "../framework/module.h"
 #include "../framework/state_map.h"
+#include "dual_number.h"  // for non_deduced_t
 
 namespace standardBML
 {
@@ -89,6 +90,13 @@ class thermal_time_linear : public differential_module
     static string_vector get_outputs();
     static std::string get_name() { return "thermal_time_linear"; }
 
+    template <typename scalar = double>
+    static scalar calculate_rate(
+        non_deduced_t<scalar> time,
+        non_deduced_t<scalar> sowing_time,
+        non_deduced_t<scalar> temp,
+        non_deduced_t<scalar> tbase);
+
    private:
     // References to input quantities
     double const& time;
@@ -120,18 +128,34 @@ string_vector thermal_time_linear::get_outputs()
     };
 }
 
-void thermal_time_linear::do_operation() const
+/**
+ * @brief Calculates the rate of thermal time accumulation in units of
+ * degrees C * day / hr.
+ *
+ * This function is templated on the scalar type used for its calculations so
+ * it can be used with automatic differentiation; see `dual_number.h`.
+ */
+template <typename scalar>
+scalar thermal_time_linear::calculate_rate(
+    non_deduced_t<scalar> time,         // days
+    non_deduced_t<scalar> sowing_time,  // days
+    non_deduced_t<scalar> temp,         // degrees C
+    non_deduced_t<scalar> tbase         // degrees C
+)
 {
     // Find the rate of change on a daily basis
-    double const rate_per_day = time < sowing_time ? 0.0
+    scalar const rate_per_day = time < sowing_time ? 0.0
                                 : temp <= tbase    ? 0.0
                                                    : temp - tbase;  // degrees C
 
     // Convert to an hourly rate
-    double const rate_per_hour = rate_per_day / 24.0;  // degrees C * day / hr
+    return rate_per_day / 24.0;  // degrees C * day / hr
+}
 
+void thermal_time_linear::do_operation() const
+{
     // Update the output quantity list
-    update(TTc_op, rate_per_hour);
+    update(TTc_op, calculate_rate(time, sowing_time, temp, tbase));
 }
 
 }  // namespace standardBML
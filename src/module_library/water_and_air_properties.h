@@ -4,6 +4,7 @@
 #include <cmath>                     // for pow, exp
 #include "../framework/constants.h"  // for ideal_gas_constant,
                                      // molar_mass_of_dry_air
+#include "dual_number.h"             // for non_deduced_t
 
 /**
  * @brief Determine saturation water vapor pressure (Pa) from air temperature
@@ -27,12 +28,13 @@
  *
  *  @return Saturation water vapor pressure in Pa
  */
-inline double saturation_vapor_pressure(
-    double air_temperature  // degrees C
+template <typename scalar = double>
+scalar saturation_vapor_pressure(
+    non_deduced_t<scalar> air_temperature  // degrees C
 )
 {
-    double a = (18.678 - air_temperature / 234.5) * air_temperature;
-    double b = 257.14 + air_temperature;
+    scalar a = (18.678 - air_temperature / 234.5) * air_temperature;
+    scalar b = 257.14 + air_temperature;
     return 611.21 * exp(a / b);  // Pa
 }
 
@@ -61,8 +63,9 @@ inline double saturation_vapor_pressure(
  *
  *  @return Density of dry air in kg / m^3
  */
-inline double TempToDdryA(
-    double air_temperature  // degrees C
+template <typename scalar = double>
+scalar TempToDdryA(
+    non_deduced_t<scalar> air_temperature  // degrees C
 )
 {
     return 1.295163636 + -0.004258182 * air_temperature;  // kg / m^3
@@ -117,8 +120,9 @@ inline double dry_air_density(
  *
  *  @return Latent heat of vaporization for water in J / kg
  */
-inline double TempToLHV(
-    double temperature  // degrees C
+template <typename scalar = double>
+scalar TempToLHV(
+    non_deduced_t<scalar> temperature  // degrees C
 )
 {
     return 2501000 + -2372.727 * temperature;  // J / kg.
@@ -170,8 +174,9 @@ inline double water_latent_heat_of_vaporization_henderson(
  *  @return Derivative of saturation water vapor pressure with respect to
  *  temperature in kg / m^3 / K (equivalent to Pa / K)
  */
-inline double TempToSFS(
-    double air_temperature  // degrees C
+template <typename scalar = double>
+scalar TempToSFS(
+    non_deduced_t<scalar> air_temperature  // degrees C
 )
 {
     return (0.338376068 + 0.011435897 * air_temperature + 0.001111111 * pow(air_temperature, 2)) * 1e-3;  //  kg / m^3 / K
@@ -0,0 +1,66 @@
+#include <cstdio>  // for std::snprintf
+#include "module_profiling.h"
+
+using standardBML::profile_map;
+using standardBML::profile_timer;
+
+void profiled_module::do_operation() const
+{
+    profile_timer timer(name.c_str());
+    wrapped->run();
+}
+
+std::unique_ptr<module> profiled_module_creator::create_module(
+    state_map const& input_quantities,
+    state_map* output_quantities)
+{
+    return std::unique_ptr<module>(new profiled_module(
+        wrapped->create_module(input_quantities, output_quantities),
+        wrapped->get_name()));
+}
+
+/**
+ *  @brief Wraps each module creator in `mcs` with a `profiled_module_creator`
+ *
+ *  @param [in] mcs The module creators to wrap
+ *
+ *  @param [in, out] storage A vector that takes ownership of the new creators;
+ *                   it must outlive any use of the returned vector
+ *
+ *  @return A vector of pointers to the new creators, in the same order as
+ *          `mcs`
+ */
+mc_vector profile_modules(
+    mc_vector const& mcs,
+    std::vector<std::unique_ptr<module_creator>>& storage)
+{
+    mc_vector result;
+    for (module_creator* mc : mcs) {
+        storage.emplace_back(new profiled_module_creator(mc));
+        result.push_back(storage.back().get());
+    }
+    return result;
+}
+
+/**
+ *  @brief Formats a profile as a human-readable table, in the style of the
+ *  `biocro_simulation` report
+ */
+std::string profile_report(profile_map const& profile)
+{
+    std::string report = "\nModule profile (times include any nested entries):\n";
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %-45s %12s %14s %12s\n",
+                  "name", "calls", "seconds", "iterations");
+    report += line;
+
+    for (auto const& x : profile) {
+        std::snprintf(line, sizeof(line), "  %-45s %12lld %14.6f %12lld\n",
+                      x.first.c_str(), x.second.calls, x.second.seconds,
+                      x.second.iterations);
+        report += line;
+    }
+
+    return report;
+}
@@ -0,0 +1,70 @@
+#ifndef MODULE_PROFILING_H
+#define MODULE_PROFILING_H
+
+#include <memory>                            // for std::unique_ptr
+#include <string>
+#include <utility>                           // for std::move
+#include <vector>
+#include "framework/module.h"                // for module
+#include "framework/module_creator.h"        // for module_creator, mc_vector
+#include "framework/state_map.h"             // for state_map, string_vector
+#include "module_library/module_profiler.h"  // for profile_map
+
+/**
+ *  @class profiled_module
+ *
+ *  @brief Runs another module and records the time spent doing so in the
+ *  active profile, under the name of the wrapped module.
+ *
+ *  A profiled module is differential whenever the wrapped module is, so it can
+ *  be used anywhere the wrapped module could be used.
+ */
+class profiled_module : public module
+{
+   public:
+    profiled_module(std::unique_ptr<module> wrapped, std::string name)
+        : module{wrapped->is_differential(), wrapped->requires_euler_ode_solver()},
+          wrapped{std::move(wrapped)},
+          name{name}
+    {
+    }
+
+   private:
+    std::unique_ptr<module> const wrapped;
+    std::string const name;
+
+    void do_operation() const override;
+};
+
+/**
+ *  @class profiled_module_creator
+ *
+ *  @brief A module creator that wraps another one, producing
+ *  `profiled_module` objects in place of the modules it would have created.
+ *
+ *  The wrapped creator is not owned by this object.
+ */
+class profiled_module_creator : public module_creator
+{
+   public:
+    profiled_module_creator(module_creator* wrapped) : wrapped{wrapped} {}
+
+    std::unique_ptr<module> create_module(
+        state_map const& input_quantities,
+        state_map* output_quantities) override;
+
+    string_vector get_inputs() override { return wrapped->get_inputs(); }
+    string_vector get_outputs() override { return wrapped->get_outputs(); }
+    std::string get_name() override { return wrapped->get_name(); }
+
+   private:
+    module_creator* const wrapped;
+};
+
+mc_vector profile_modules(
+    mc_vector const& mcs,
+    std::vector<std::unique_ptr<module_creator>>& storage);
+
+std::string profile_report(standardBML::profile_map const& profile);
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <atomic>     // for std::atomic
+#include <exception>  // for std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <memory>     // for std::unique_ptr
+#include <thread>     // for std::thread
+#include <vector>
+#include "module_library/module_profiler.h"  // for active_profile, profile_map, profile_scope, merge_profile
+
+/**
+ *  @brief Calls `task(worker, i)` for each `i` in `[0, n)` using up to
+ *  `nthreads` threads.
+ *
+ *  Rather than dividing the items into fixed blocks ahead of time, each thread
+ *  repeatedly claims the next unprocessed item from a shared atomic counter
+ *  until none remain. This keeps all threads busy even when the time required
+ *  for each item varies considerably, as it does for simulations using
+ *  adaptive ODE solvers.
+ *
+ *  Before processing any items, each thread calls `setup(worker)` exactly
+ *  once, where `worker` is an index in `[0, nthreads)`. This can be used to
+ *  create any objects that must not be shared between threads. Both `setup`
+ *  and `task` are called from the worker threads, so they must not call any
+ *  functions from the R API.
+ *
+ *  If any call to `setup` or `task` throws an exception, the remaining items
+ *  are skipped and the first exception is rethrown on the calling thread after
+ *  all threads have finished.
+ *
+ *  When `nthreads` is 1, everything is done on the calling thread.
+ *
+ *  If a profile is active on the calling thread, each worker thread records
+ *  into its own profile, and these are merged into the calling thread's
+ *  profile after all threads have finished. The profile therefore includes
+ *  the same calls and iterations regardless of `nthreads`, although the times
+ *  recorded by different threads are added together.
+ */
+template <typename setup_type, typename task_type>
+void parallel_for(size_t n, size_t nthreads, setup_type setup, task_type task)
+{
+    if (nthreads < 1) {
+        nthreads = 1;
+    }
+
+    if (nthreads > n) {
+        nthreads = n > 0 ? n : 1;
+    }
+
+    std::atomic<size_t> next_item{0};
+    std::atomic<bool> failed{false};
+    std::vector<std::exception_ptr> errors(nthreads);
+
+    standardBML::profile_map* const caller_profile = standardBML::active_profile();
+    std::vector<standardBML::profile_map> worker_profiles(
+        caller_profile && nthreads > 1 ? nthreads : 0);
+
+    auto worker_function = [&](size_t worker) {
+        std::unique_ptr<standardBML::profile_scope> scope;
+        if (!worker_profiles.empty()) {
+            scope.reset(new standardBML::profile_scope(worker_profiles[worker]));
+        }
+
+        try {
+            setup(worker);
+            size_t i;
+            while (!failed && (i = next_item++) < n) {
+                task(worker, i);
+            }
+        } catch (...) {
+            errors[worker] = std::current_exception();
+            failed = true;
+        }
+    };
+
+    if (nthreads == 1) {
+        worker_function(0);
+    } else {
+        std::vector<std::thread> threads;
+        try {
+            for (size_t w = 0; w < nthreads; ++w) {
+                threads.emplace_back(worker_function, w);
+            }
+        } catch (...) {
+            // A thread could not be started; stop and wait for the others
+            // before reporting the problem
+            failed = true;
+            for (std::thread& t : threads) {
+                t.join();
+            }
+            throw;
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+    }
+
+    for (standardBML::profile_map const& p : worker_profiles) {
+        standardBML::merge_profile(*caller_profile, p);
+    }
+
+    for (std::exception_ptr const& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+#endif
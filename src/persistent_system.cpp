@@ -0,0 +1,153 @@
+#include <stdexcept>  // for std::runtime_error, std::out_of_range
+#include <algorithm>  // for std::find, std::max
+#include <cmath>      // for std::abs, std::sqrt
+#include <limits>     // for std::numeric_limits
+#include "persistent_system.h"
+
+persistent_system::persistent_system(
+    state_map const& differential_quantities,
+    string_vector const& caller_order,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs)
+    : sys{differential_quantities, parameters, drivers, direct_mcs,
+          differential_mcs},
+      caller_order{caller_order},
+      parameter_names{keys(parameters)},
+      sparsity{find_jacobian_sparsity(caller_order, direct_mcs, differential_mcs)}
+{
+    string_vector const sys_order = sys.get_differential_quantity_names();
+
+    if (sys_order.size() != caller_order.size()) {
+        throw std::runtime_error(
+            "The number of differential quantities (" +
+            std::to_string(caller_order.size()) +
+            ") does not match the number required by the system (" +
+            std::to_string(sys_order.size()) + ")");
+    }
+
+    for (std::string const& name : caller_order) {
+        auto it = std::find(sys_order.begin(), sys_order.end(), name);
+
+        if (it == sys_order.end()) {
+            throw std::runtime_error(
+                "`" + name + "` is not a differential quantity of the system");
+        }
+
+        sys_index.push_back(it - sys_order.begin());
+    }
+
+    sys_x.resize(sys_order.size());
+    sys_dxdt.resize(sys_order.size());
+
+    dxdt_base.resize(caller_order.size());
+    dxdt_perturbed.resize(caller_order.size());
+    steps.resize(caller_order.size());
+}
+
+/**
+ *  @brief Calculates the derivatives of the differential quantities at the
+ *  specified time.
+ *
+ *  @param [in] x The values of the differential quantities, in the caller's
+ *              order
+ *
+ *  @param [out] dxdt The derivatives of the differential quantities, in the
+ *               caller's order; must have the same size as `x`
+ *
+ *  @param [in] time The time index
+ */
+void persistent_system::calculate_derivative(
+    std::vector<double> const& x,
+    std::vector<double>& dxdt,
+    double time)
+{
+    for (size_t i = 0; i < sys_index.size(); ++i) {
+        sys_x[sys_index[i]] = x[i];
+    }
+
+    sys.calculate_derivative(sys_x, sys_dxdt, time);
+
+    for (size_t i = 0; i < sys_index.size(); ++i) {
+        dxdt[i] = sys_dxdt[sys_index[i]];
+    }
+}
+
+/**
+ *  @brief Returns a pointer to the system's copy of a parameter, which can be
+ *  used to change its value between derivative calculations.
+ *
+ *  The dynamical system only sets the values of its parameters when it is
+ *  constructed, and its modules read them through pointers, so a value
+ *  written here is used by all subsequent calculations. The other quantities
+ *  are overwritten by each derivative calculation, so they cannot be changed
+ *  this way.
+ */
+double* persistent_system::get_parameter_ptr(std::string const& name)
+{
+    if (std::find(parameter_names.begin(), parameter_names.end(), name) ==
+        parameter_names.end()) {
+        throw std::out_of_range("`" + name + "` is not a parameter of the system");
+    }
+
+    // The system only provides read-only access to its quantities, but they
+    // are not const objects, so they can be modified through these pointers
+    return const_cast<double*>(sys.get_quantity_access_ptrs({name})[0]);
+}
+
+/**
+ *  @brief Calculates the Jacobian matrix of the system at the specified time
+ *  using forward finite differences.
+ *
+ *  All the columns with the same color (see `jacobian_sparsity`) are
+ *  calculated together by perturbing their differential quantities at once,
+ *  so only `1 + ncolors` derivative calculations are required. Elements that
+ *  are known to be zero from the module graph are set to zero without being
+ *  calculated.
+ *
+ *  The perturbation of each quantity is the square root of the machine
+ *  epsilon times the larger of 1 and the magnitude of the quantity.
+ *
+ *  @param [in] x The values of the differential quantities, in the caller's
+ *              order
+ *
+ *  @param [out] jacobian The Jacobian matrix in column-major order, using the
+ *               caller's order for the rows and columns; its element
+ *               `i + j * n` is the derivative of `dxdt[i]` with respect to
+ *               `x[j]`, where `n` is the number of differential quantities
+ *
+ *  @param [in] time The time index
+ */
+void persistent_system::calculate_jacobian(
+    std::vector<double> const& x,
+    std::vector<double>& jacobian,
+    double time)
+{
+    size_t const n = size();
+    double const sqrt_eps = std::sqrt(std::numeric_limits<double>::epsilon());
+
+    calculate_derivative(x, dxdt_base, time);
+
+    jacobian.assign(n * n, 0.0);
+    x_perturbed = x;
+
+    for (std::vector<size_t> const& columns : sparsity.color_columns) {
+        for (size_t j : columns) {
+            x_perturbed[j] = x[j] + sqrt_eps * std::max(std::abs(x[j]), 1.0);
+
+            // Use the step that was actually taken, which may differ from the
+            // requested one due to rounding
+            steps[j] = x_perturbed[j] - x[j];
+        }
+
+        calculate_derivative(x_perturbed, dxdt_perturbed, time);
+
+        for (size_t j : columns) {
+            for (size_t i : sparsity.column_rows[j]) {
+                jacobian[i + j * n] = (dxdt_perturbed[i] - dxdt_base[i]) / steps[j];
+            }
+            x_perturbed[j] = x[j];
+        }
+    }
+}
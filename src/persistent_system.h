@@ -0,0 +1,107 @@
+#ifndef PERSISTENT_SYSTEM_H
+#define PERSISTENT_SYSTEM_H
+
+#include <string>
+#include <vector>
+#include "framework/state_map.h"         // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"    // for mc_vector
+#include "framework/dynamical_system.h"  // for dynamical_system
+#include "jacobian_sparsity.h"           // for jacobian_sparsity
+
+/**
+ *  @class persistent_system
+ *
+ *  @brief Wraps a `dynamical_system` so that it can be constructed once and
+ *  then used to calculate derivatives many times, as required when
+ *  integrating a BioCro system with an external ODE solver.
+ *
+ *  The dynamical system may store its differential quantities in a different
+ *  order than the one used by the caller. The mapping between the two
+ *  orderings is determined once, during construction, from the names of the
+ *  differential quantities supplied by the caller, so that subsequent calls
+ *  only need to copy values between vectors.
+ *
+ *  The sparsity pattern of the system's Jacobian matrix is also determined
+ *  once, from the inputs and outputs of the modules, so Jacobians can be
+ *  calculated with one derivative calculation per column color rather than
+ *  one per differential quantity; see `jacobian_sparsity` for details.
+ *
+ *  `get_parameter_ptr()` returns a pointer into the parameter storage of the
+ *  wrapped `dynamical_system`, obtained with a `const_cast` of the pointers
+ *  returned by `dynamical_system::get_quantity_access_ptrs()`. This relies on
+ *  the framework never re-copying the parameters after the dynamical system
+ *  has been constructed; the modules hold pointers to the same storage, so
+ *  values written through the pointer are seen by the next derivative
+ *  calculation. If a framework change ever breaks this assumption, changed
+ *  parameters would silently be ignored, which is why the persistent
+ *  simulation tests compare against freshly constructed simulations.
+ *
+ *  The module creators are not owned by this class; the code creating a
+ *  `persistent_system` must make sure that they outlive it.
+ */
+class persistent_system
+{
+   public:
+    persistent_system(
+        state_map const& differential_quantities,
+        string_vector const& caller_order,
+        state_map const& parameters,
+        state_vector_map const& drivers,
+        mc_vector const& direct_mcs,
+        mc_vector const& differential_mcs);
+
+    size_t size() const { return caller_order.size(); }
+
+    string_vector const& get_quantity_names() const { return caller_order; }
+
+    void calculate_derivative(
+        std::vector<double> const& x,
+        std::vector<double>& dxdt,
+        double time);
+
+    string_vector get_output_quantity_names() const
+    {
+        return sys.get_output_quantity_names();
+    }
+
+    // The quantities pointed to are updated by each derivative calculation
+    std::vector<const double*> get_quantity_access_ptrs(
+        string_vector const& quantity_names) const
+    {
+        return sys.get_quantity_access_ptrs(quantity_names);
+    }
+
+    double* get_parameter_ptr(std::string const& name);
+
+    jacobian_sparsity const& get_jacobian_sparsity() const { return sparsity; }
+
+    void calculate_jacobian(
+        std::vector<double> const& x,
+        std::vector<double>& jacobian,
+        double time);
+
+   private:
+    dynamical_system sys;
+    string_vector const caller_order;
+    string_vector const parameter_names;
+
+    // sys_index[i] is the position of the i-th caller quantity in the
+    // ordering used by `sys`
+    std::vector<size_t> sys_index;
+
+    // Storage in the system order; kept here to avoid reallocating it for
+    // each derivative calculation
+    std::vector<double> sys_x;
+    std::vector<double> sys_dxdt;
+
+    // The Jacobian sparsity pattern, in the caller's order
+    jacobian_sparsity const sparsity;
+
+    // Storage used by `calculate_jacobian()`, in the caller's order
+    std::vector<double> x_perturbed;
+    std::vector<double> dxdt_base;
+    std::vector<double> dxdt_perturbed;
+    std::vector<double> steps;
+};
+
+#endif
@@ -0,0 +1,287 @@
+#include <algorithm>  // for std::sort, std::find, std::remove_if, std::copy
+#include <cmath>      // for std::isnan, std::isinf, std::floor
+#include <cstdint>    // for uint32_t, uint64_t
+#include <cstring>    // for std::memcpy
+#include <limits>     // for std::numeric_limits
+#include <stdexcept>  // for std::runtime_error
+#include "simulation_output.h"  // for select_quantity_names
+#include "result_sink.h"
+
+namespace
+{
+void check_stream(std::ofstream const& out, std::string const& filename)
+{
+    if (!out) {
+        throw std::runtime_error("Could not write to `" + filename + "`");
+    }
+}
+
+// Stores an unsigned integer in little-endian byte order, independent of the
+// byte order used by the platform
+template <typename uint_type>
+void store_little_endian(uint_type x, char* bytes)
+{
+    for (size_t i = 0; i < sizeof(uint_type); ++i) {
+        bytes[i] = static_cast<char>((x >> (8 * i)) & 0xFF);
+    }
+}
+
+// The positions used by `chunked_result_writer` to mark the columns that are
+// calculated from `time` rather than copied
+constexpr size_t doy_column = static_cast<size_t>(-1);
+constexpr size_t hour_column = static_cast<size_t>(-2);
+}  // namespace
+
+csv_sink::csv_sink(std::string const& filename)
+    : out{filename}, filename{filename}
+{
+    check_stream(out, filename);
+    out.precision(std::numeric_limits<double>::max_digits10);
+}
+
+void csv_sink::begin(string_vector const& quantity_names)
+{
+    ncol = quantity_names.size();
+    for (size_t j = 0; j < ncol; ++j) {
+        out << (j > 0 ? "," : "") << '"' << quantity_names[j] << '"';
+    }
+    out << '\n';
+    check_stream(out, filename);
+}
+
+void csv_sink::write_chunk(std::vector<double> const& values, size_t nrows)
+{
+    for (size_t i = 0; i < nrows; ++i) {
+        for (size_t j = 0; j < ncol; ++j) {
+            double const v = values[i + j * nrows];
+
+            if (j > 0) {
+                out << ',';
+            }
+
+            // Use the spellings that R recognizes for special values
+            if (std::isnan(v)) {
+                out << "NaN";
+            } else if (std::isinf(v)) {
+                out << (v > 0 ? "Inf" : "-Inf");
+            } else {
+                out << v;
+            }
+        }
+        out << '\n';
+    }
+    check_stream(out, filename);
+}
+
+void csv_sink::end()
+{
+    out.close();
+    check_stream(out, filename);
+}
+
+binary_sink::binary_sink(std::string const& filename)
+    : out{filename, std::ios::binary}, filename{filename}
+{
+    check_stream(out, filename);
+}
+
+void binary_sink::write_int(size_t x)
+{
+    if (x > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error(
+            "A size is too large to be stored in a binary output file");
+    }
+
+    char bytes[4];
+    store_little_endian(static_cast<uint32_t>(x), bytes);
+    out.write(bytes, 4);
+}
+
+void binary_sink::begin(string_vector const& quantity_names)
+{
+    static_assert(
+        std::numeric_limits<double>::is_iec559 && sizeof(double) == 8,
+        "The binary output format requires IEEE 754 doubles");
+
+    out.write("BIOCRO\x01\n", 8);
+
+    ncol = quantity_names.size();
+    write_int(ncol);
+
+    for (std::string const& name : quantity_names) {
+        write_int(name.size());
+        out.write(name.data(), name.size());
+    }
+
+    check_stream(out, filename);
+}
+
+void binary_sink::write_chunk(std::vector<double> const& values, size_t nrows)
+{
+    write_int(nrows);
+
+    std::vector<char> bytes(8 * nrows * ncol);
+    for (size_t k = 0; k < nrows * ncol; ++k) {
+        uint64_t bits;
+        std::memcpy(&bits, &values[k], 8);
+        store_little_endian(bits, &bytes[8 * k]);
+    }
+    out.write(bytes.data(), bytes.size());
+
+    check_stream(out, filename);
+}
+
+void binary_sink::end()
+{
+    out.close();
+    check_stream(out, filename);
+}
+
+chunked_result_writer::chunked_result_writer(
+    result_sink& sink,
+    string_vector const& quantity_patterns,
+    size_t decimation,
+    size_t chunk_size,
+    bool include_doy_and_hour)
+    : sink(sink),
+      quantity_patterns{quantity_patterns},
+      decimation{decimation},
+      chunk_size{chunk_size},
+      include_doy_and_hour{include_doy_and_hour}
+{
+    if (decimation < 1) {
+        throw std::runtime_error("The output decimation must be at least 1");
+    }
+
+    if (chunk_size < 1) {
+        throw std::runtime_error("The chunk size must be at least 1");
+    }
+}
+
+void chunked_result_writer::begin(string_vector const& quantity_names)
+{
+    string_vector names =
+        select_quantity_names(quantity_names, quantity_patterns);
+
+    auto const time_name =
+        std::find(quantity_names.begin(), quantity_names.end(), "time");
+    time_index = time_name - quantity_names.begin();
+
+    bool const add_doy_and_hour =
+        include_doy_and_hour && time_name != quantity_names.end();
+
+    if (add_doy_and_hour) {
+        names.erase(
+            std::remove_if(names.begin(), names.end(), [](std::string const& n) {
+                return n == "doy" || n == "hour";
+            }),
+            names.end());
+        names.push_back("doy");
+        names.push_back("hour");
+    }
+
+    std::sort(names.begin(), names.end());
+
+    selected.clear();
+    for (std::string const& name : names) {
+        if (add_doy_and_hour && name == "doy") {
+            selected.push_back(doy_column);
+        } else if (add_doy_and_hour && name == "hour") {
+            selected.push_back(hour_column);
+        } else {
+            selected.push_back(
+                std::find(quantity_names.begin(), quantity_names.end(), name) -
+                quantity_names.begin());
+        }
+    }
+
+    chunk.assign(chunk_size * selected.size(), 0.0);
+    nrows = 0;
+    row_index = 0;
+
+    sink.begin(names);
+}
+
+void chunked_result_writer::add_row(std::vector<const double*> const& values)
+{
+    if (row_index++ % decimation != 0) {
+        return;
+    }
+
+    for (size_t j = 0; j < selected.size(); ++j) {
+        size_t const k = selected[j];
+        double& v = chunk[j * chunk_size + nrows];
+
+        if (k == doy_column) {
+            v = std::floor(*values[time_index]);
+        } else if (k == hour_column) {
+            double const time = *values[time_index];
+            v = 24.0 * (time - std::floor(time));
+        } else {
+            v = *values[k];
+        }
+    }
+
+    if (++nrows == chunk_size) {
+        write_chunk();
+    }
+}
+
+void chunked_result_writer::end()
+{
+    if (nrows > 0) {
+        write_chunk();
+    }
+
+    sink.end();
+}
+
+void chunked_result_writer::write_chunk()
+{
+    // A partial chunk must be packed so each column has `nrows` values; each
+    // column moves toward the front, so it never overwrites one that has not
+    // been moved yet
+    if (nrows < chunk_size) {
+        for (size_t j = 1; j < selected.size(); ++j) {
+            auto const first = chunk.begin() + j * chunk_size;
+            std::copy(first, first + nrows, chunk.begin() + j * nrows);
+        }
+        chunk.resize(nrows * selected.size());
+    }
+
+    sink.write_chunk(chunk, nrows);
+
+    chunk.resize(chunk_size * selected.size());
+    nrows = 0;
+}
+
+/**
+ *  @brief Sends a complete simulation result to a `chunked_result_writer`;
+ *  this is used for solvers that do not provide their rows as they are
+ *  calculated.
+ */
+void write_result(
+    state_vector_map const& result,
+    chunked_result_writer& writer)
+{
+    string_vector const names = keys(result);
+
+    std::vector<std::vector<double> const*> columns;
+    for (std::string const& name : names) {
+        columns.push_back(&result.at(name));
+    }
+
+    size_t const ntotal = columns.empty() ? 0 : columns[0]->size();
+
+    writer.begin(names);
+
+    std::vector<const double*> values(columns.size());
+    for (size_t i = 0; i < ntotal; ++i) {
+        for (size_t j = 0; j < columns.size(); ++j) {
+            values[j] = &(*columns[j])[i];
+        }
+        writer.add_row(values);
+    }
+
+    writer.end();
+}
@@ -0,0 +1,157 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "framework/state_map.h"  // for state_vector_map, string_vector
+
+/**
+ *  @class result_sink
+ *
+ *  @brief An abstract destination for simulation results.
+ *
+ *  Results are sent to a sink in chunks of consecutive rows, so a sink never
+ *  needs to hold more than one chunk in memory. `begin()` must be called
+ *  once before any chunks are written, and `end()` must be called once after
+ *  the final chunk.
+ *
+ *  Each chunk is passed as a column-major block of values: the first `nrows`
+ *  values belong to the first quantity, the next `nrows` to the second
+ *  quantity, and so on, following the order passed to `begin()`.
+ */
+class result_sink
+{
+   public:
+    virtual ~result_sink() {}
+
+    virtual void begin(string_vector const& quantity_names) = 0;
+
+    virtual void write_chunk(std::vector<double> const& values, size_t nrows) = 0;
+
+    virtual void end() = 0;
+};
+
+/**
+ *  @class csv_sink
+ *
+ *  @brief Writes simulation results to a comma-separated text file with a
+ *  header row. Values are written with enough digits to be read back
+ *  without loss of precision.
+ */
+class csv_sink : public result_sink
+{
+   public:
+    csv_sink(std::string const& filename);
+
+    void begin(string_vector const& quantity_names) override;
+    void write_chunk(std::vector<double> const& values, size_t nrows) override;
+    void end() override;
+
+   private:
+    std::ofstream out;
+    std::string const filename;
+    size_t ncol = 0;
+};
+
+/**
+ *  @class binary_sink
+ *
+ *  @brief Writes simulation results to a compact binary columnar file.
+ *
+ *  All integers are 32-bit and all values are 64-bit IEEE 754 doubles; both
+ *  are stored in little-endian byte order regardless of the platform. The
+ *  file layout is:
+ *
+ *  - The 8-byte magic string `BIOCRO\x01\n`, where `\x01` is the format
+ *    version
+ *
+ *  - The number of columns (`ncol`)
+ *
+ *  - For each column, the length of its name in bytes, followed by the name
+ *    itself (without a terminating null character)
+ *
+ *  - Any number of chunks, each consisting of the number of rows in the chunk
+ *    (`nrows`) followed by `nrows * ncol` values in column-major order
+ *
+ *  Since the position of every column within a chunk can be calculated from
+ *  `nrows`, a reader can extract individual columns or chunks without reading
+ *  the rest of the file.
+ */
+class binary_sink : public result_sink
+{
+   public:
+    binary_sink(std::string const& filename);
+
+    void begin(string_vector const& quantity_names) override;
+    void write_chunk(std::vector<double> const& values, size_t nrows) override;
+    void end() override;
+
+   private:
+    std::ofstream out;
+    std::string const filename;
+    size_t ncol = 0;
+
+    void write_int(size_t x);
+};
+
+/**
+ *  @class chunked_result_writer
+ *
+ *  @brief Collects the rows of a simulation result as they are calculated and
+ *  sends them to a `result_sink` in chunks, so only one chunk of the selected
+ *  output is held in memory at a time.
+ *
+ *  `begin()` must be called once with the names of all the quantities in the
+ *  result, then `add_row()` once per time point with pointers to their values
+ *  in the same order, and finally `end()`. Only the quantities chosen by
+ *  `select_quantity_names()` and every `decimation`-th row are written, with
+ *  the quantities sorted by name in byte order (as in the C locale). This
+ *  can differ from the locale-dependent order used by R's `sort()`, for
+ *  example when names differ only in case.
+ *
+ *  If `include_doy_and_hour` is true and `time` is one of the quantities,
+ *  `doy` and `hour` columns are calculated from it as in `add_doy_and_hour()`,
+ *  replacing any quantities with those names.
+ */
+class chunked_result_writer
+{
+   public:
+    chunked_result_writer(
+        result_sink& sink,
+        string_vector const& quantity_patterns,
+        size_t decimation,
+        size_t chunk_size,
+        bool include_doy_and_hour = false);
+
+    void begin(string_vector const& quantity_names);
+    void add_row(std::vector<const double*> const& values);
+    void end();
+
+   private:
+    result_sink& sink;
+    string_vector const quantity_patterns;
+    size_t const decimation;
+    size_t const chunk_size;
+    bool const include_doy_and_hour;
+
+    // The positions of the selected quantities in the list passed to
+    // `begin()`, in the order they are written, with special values marking
+    // the `doy` and `hour` columns calculated from `time`
+    std::vector<size_t> selected;
+    size_t time_index = 0;
+
+    // The current chunk, stored in column-major order with room for
+    // `chunk_size` rows in each column
+    std::vector<double> chunk;
+    size_t nrows = 0;
+    size_t row_index = 0;
+
+    void write_chunk();
+};
+
+void write_result(
+    state_vector_map const& result,
+    chunked_result_writer& writer);
+
+#endif
@@ -0,0 +1,201 @@
+#include <stdexcept>  // for std::runtime_error
+#include <algorithm>  // for std::find, std::max
+#include <cmath>      // for std::abs, std::sqrt
+#include <limits>     // for std::numeric_limits
+#include "sensitivity_simulation.h"
+
+namespace
+{
+// Returns the perturbation used to calculate sensitivities with respect to a
+// quantity with the specified value
+double sensitivity_step(double value)
+{
+    double const sqrt_eps = std::sqrt(std::numeric_limits<double>::epsilon());
+    double const perturbed = value + sqrt_eps * std::max(std::abs(value), 1.0);
+
+    // Use the step that is actually taken, which may differ from the requested
+    // one due to rounding
+    return perturbed - value;
+}
+
+// Returns true if the ODE solver uses the Euler method and false if it uses
+// the classic fourth-order Runge-Kutta method; other solvers are not supported
+bool uses_euler_method(std::string const& ode_solver_name)
+{
+    if (ode_solver_name == "homemade_euler" || ode_solver_name == "boost_euler") {
+        return true;
+    }
+
+    if (ode_solver_name == "boost_rk4") {
+        return false;
+    }
+
+    throw std::runtime_error(
+        "Sensitivities can only be calculated with the `homemade_euler`, "
+        "`boost_euler`, or `boost_rk4` ODE solvers, not `" +
+        ode_solver_name + "`");
+}
+}  // namespace
+
+sensitivity_simulation::sensitivity_simulation(
+    state_map const& initial_values,
+    string_vector const& quantity_order,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs,
+    std::string const& ode_solver_name,
+    string_vector const& arg_names)
+    : base{initial_values, quantity_order, parameters, drivers, direct_mcs,
+           differential_mcs},
+      ntimes{drivers.begin()->second.size()},
+      use_euler{uses_euler_method(ode_solver_name)}
+{
+    size_t const n = quantity_order.size();
+
+    for (std::string const& name : quantity_order) {
+        x0.push_back(initial_values.at(name));
+    }
+
+    y0 = x0;
+    y0.resize(n * (1 + arg_names.size()), 0.0);
+
+    for (size_t j = 0; j < arg_names.size(); ++j) {
+        std::string const& name = arg_names[j];
+
+        auto it = std::find(quantity_order.begin(), quantity_order.end(), name);
+
+        if (it != quantity_order.end()) {
+            // The sensitivity of each differential quantity to its own
+            // initial value starts at 1
+            size_t const i = it - quantity_order.begin();
+            y0[n * (1 + j) + i] = 1.0;
+            steps.push_back(sensitivity_step(x0[i]));
+            arg_parameters.push_back(nullptr);
+        } else if (parameters.find(name) != parameters.end()) {
+            steps.push_back(sensitivity_step(parameters.at(name)));
+            arg_parameters.push_back(base.get_parameter_ptr(name));
+        } else {
+            throw std::runtime_error(
+                "`" + name + "` is not in the `initial_values` or `parameters`");
+        }
+    }
+
+    x.resize(n);
+    dxdt.resize(n);
+    x_perturbed.resize(n);
+    dxdt_perturbed.resize(n);
+}
+
+/**
+ *  @brief Calculates the derivative of the augmented state `y`, which
+ *  contains the differential quantities followed by their sensitivities to
+ *  each argument.
+ */
+void sensitivity_simulation::calculate_derivative(
+    std::vector<double> const& y,
+    std::vector<double>& dydt,
+    double time)
+{
+    size_t const n = get_nquantities();
+
+    std::copy(y.begin(), y.begin() + n, x.begin());
+    base.calculate_derivative(x, dxdt, time);
+    std::copy(dxdt.begin(), dxdt.end(), dydt.begin());
+
+    for (size_t j = 0; j < get_nargs(); ++j) {
+        size_t const offset = n * (1 + j);
+        double const h = steps[j];
+
+        for (size_t i = 0; i < n; ++i) {
+            x_perturbed[i] = x[i] + h * y[offset + i];
+        }
+
+        double* const parameter = arg_parameters[j];
+
+        if (parameter) {
+            double const value = *parameter;
+            *parameter = value + h;
+            base.calculate_derivative(x_perturbed, dxdt_perturbed, time);
+            *parameter = value;
+        } else {
+            base.calculate_derivative(x_perturbed, dxdt_perturbed, time);
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            dydt[offset + i] = (dxdt_perturbed[i] - dxdt[i]) / h;
+        }
+    }
+}
+
+/**
+ *  @brief Runs the simulation.
+ *
+ *  @param [out] values The values of the differential quantities at each
+ *               time, as a matrix in column-major order whose rows correspond
+ *               to times and whose columns correspond to quantities
+ *
+ *  @param [out] sensitivities The sensitivities of the differential
+ *               quantities at each time, as a three-dimensional array in
+ *               column-major order whose dimensions correspond to times,
+ *               quantities, and arguments, respectively
+ */
+void sensitivity_simulation::run(
+    std::vector<double>& values,
+    std::vector<double>& sensitivities)
+{
+    size_t const n = get_nquantities();
+    size_t const m = get_nargs();
+    size_t const size = y0.size();
+
+    values.assign(ntimes * n, 0.0);
+    sensitivities.assign(ntimes * n * m, 0.0);
+
+    std::vector<double> y = y0;
+    std::vector<double> k1(size), k2(size), k3(size), k4(size), y_stage(size);
+
+    for (size_t t = 0; t < ntimes; ++t) {
+        // Store the current state
+        for (size_t i = 0; i < n; ++i) {
+            values[t + i * ntimes] = y[i];
+            for (size_t j = 0; j < m; ++j) {
+                sensitivities[t + i * ntimes + j * ntimes * n] =
+                    y[n * (1 + j) + i];
+            }
+        }
+
+        if (t + 1 == ntimes) {
+            break;
+        }
+
+        double const time = t;
+
+        calculate_derivative(y, k1, time);
+
+        if (use_euler) {
+            for (size_t i = 0; i < size; ++i) {
+                y[i] += k1[i];
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < size; ++i) {
+            y_stage[i] = y[i] + 0.5 * k1[i];
+        }
+        calculate_derivative(y_stage, k2, time + 0.5);
+
+        for (size_t i = 0; i < size; ++i) {
+            y_stage[i] = y[i] + 0.5 * k2[i];
+        }
+        calculate_derivative(y_stage, k3, time + 0.5);
+
+        for (size_t i = 0; i < size; ++i) {
+            y_stage[i] = y[i] + k3[i];
+        }
+        calculate_derivative(y_stage, k4, time + 1.0);
+
+        for (size_t i = 0; i < size; ++i) {
+            y[i] += (k1[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]) / 6.0;
+        }
+    }
+}
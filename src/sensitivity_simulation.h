@@ -0,0 +1,103 @@
+#ifndef SENSITIVITY_SIMULATION_H
+#define SENSITIVITY_SIMULATION_H
+
+#include <string>
+#include <vector>
+#include "framework/state_map.h"       // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"  // for mc_vector
+#include "persistent_system.h"         // for persistent_system
+
+/**
+ *  @class sensitivity_simulation
+ *
+ *  @brief Integrates a BioCro system along with the forward sensitivities of
+ *  its differential quantities with respect to some of its initial values and
+ *  parameters, so the sensitivities for all of them are found in a single run.
+ *
+ *  If `x` represents the differential quantities and `p_j` is one of the
+ *  initial values or parameters, the sensitivity `S_j = dx / dp_j` obeys
+ *
+ *  `dS_j / dt = (df / dx) S_j + df / dp_j`,
+ *
+ *  where `f` is the derivative of `x`. The right-hand side is a directional
+ *  derivative of `f`, which is calculated with a single forward difference:
+ *
+ *  `(f(x + h_j S_j, p + h_j e_j) - f(x, p)) / h_j`,
+ *
+ *  where `e_j` is the unit vector for `p_j`. A single `persistent_system` is
+ *  used for all of the arguments: to perturb a parameter, its value is changed
+ *  through `persistent_system::get_parameter_ptr()`, the derivative is
+ *  calculated, and the original value is restored. Initial values do not
+ *  change the derivative function, so they are not perturbed; instead, their
+ *  sensitivities start from a unit vector rather than zero.
+ *
+ *  The state and sensitivities are integrated together with a fixed step of
+ *  one time index (i.e., one row of the drivers), so all of them use the same
+ *  steps. The Euler method is used when the ODE solver is `homemade_euler` or
+ *  `boost_euler`, and the classic fourth-order Runge-Kutta method is used when
+ *  it is `boost_rk4`; these match the fixed-step solvers used by
+ *  `biocro_simulation` with an output step size of 1. An exception is thrown
+ *  for any other solver, since adaptive step sizes are not supported. Each
+ *  step requires `1 + m` derivative calculations per stage, where `m` is the
+ *  number of sensitivity arguments.
+ *
+ *  The module creators are not owned by this class; the code creating a
+ *  `sensitivity_simulation` must make sure that they outlive it.
+ */
+class sensitivity_simulation
+{
+   public:
+    sensitivity_simulation(
+        state_map const& initial_values,
+        string_vector const& quantity_order,
+        state_map const& parameters,
+        state_vector_map const& drivers,
+        mc_vector const& direct_mcs,
+        mc_vector const& differential_mcs,
+        std::string const& ode_solver_name,
+        string_vector const& arg_names);
+
+    size_t get_nquantities() const { return x0.size(); }
+
+    size_t get_nargs() const { return steps.size(); }
+
+    size_t get_ntimes() const { return ntimes; }
+
+    string_vector const& get_quantity_names() const
+    {
+        return base.get_quantity_names();
+    }
+
+    void run(std::vector<double>& values, std::vector<double>& sensitivities);
+
+   private:
+    persistent_system base;
+
+    // A pointer to the value of each argument that is a parameter, or
+    // `nullptr` for each argument that is an initial value
+    std::vector<double*> arg_parameters;
+
+    // The perturbation of each argument
+    std::vector<double> steps;
+
+    // The initial augmented state: the differential quantities followed by
+    // the sensitivities for each argument
+    std::vector<double> y0;
+
+    std::vector<double> x0;
+    size_t const ntimes;
+    bool const use_euler;
+
+    // Storage used by `calculate_derivative()`
+    std::vector<double> x;
+    std::vector<double> dxdt;
+    std::vector<double> x_perturbed;
+    std::vector<double> dxdt_perturbed;
+
+    void calculate_derivative(
+        std::vector<double> const& y,
+        std::vector<double>& dydt,
+        double time);
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include <memory>     // for std::unique_ptr
+#include <stdexcept>  // for std::runtime_error
+#include "parallel_for.h"
+#include "simulation_handle.h"
+#include "simulation_batch.h"
+
+using std::string;
+using std::vector;
+
+/**
+ *  @brief Runs a batch of simulations that share the same modules, drivers,
+ *  and ODE solver, but differ in the values of some initial values or
+ *  parameters.
+ *
+ *  Each worker thread creates its own `simulation_handle`, so the inputs that
+ *  are overwritten for each run are never shared between threads. Each
+ *  handle either constructs a new `dispatching_simulation` for each run or
+ *  reuses its own persistent one (see `simulation_handle`), so the
+ *  `dynamical_system` and module objects are never shared between threads
+ *  either. The module creators themselves are only used to create new module
+ *  objects and can safely be shared.
+ *
+ *  @param [in] override_controls The location of each overridden quantity;
+ *              each element must be `"initial_values"` or `"parameters"`
+ *
+ *  @param [in] override_names The names of the overridden quantities
+ *
+ *  @param [in] override_values The values of the overridden quantities for
+ *              each run; `override_values[i]` contains the values for the
+ *              i-th run, in the same order as `override_names`
+ *
+ *  @param [in] nthreads The number of threads to use
+ *
+ *  @param [in] output_patterns The patterns used to select the quantities
+ *              included in the output; see `select_quantity_names()` for
+ *              details
+ *
+ *  @param [in] output_decimation Only every `output_decimation`-th row of
+ *              each run is kept
+ *
+ *  @return The selected quantities from all runs stacked on top of each other, in order,
+ *          with an additional `run_id` column holding the (one-based) index
+ *          of the run that produced each row
+ */
+state_vector_map run_simulation_batch(
+    state_map const& initial_values,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs,
+    string const& ode_solver_name,
+    double output_step_size,
+    double adaptive_rel_error_tol,
+    double adaptive_abs_error_tol,
+    int adaptive_max_steps,
+    string_vector const& override_controls,
+    string_vector const& override_names,
+    vector<vector<double>> const& override_values,
+    size_t nthreads,
+    string_vector const& output_patterns,
+    size_t output_decimation)
+{
+    size_t const nruns = override_values.size();
+    vector<state_vector_map> results(nruns);
+    vector<std::unique_ptr<simulation_handle>> handles(nthreads);
+    vector<size_t> const zero_indices(override_names.size(), 0);
+
+    parallel_for(
+        nruns, nthreads,
+        [&](size_t worker) {
+            handles[worker].reset(new simulation_handle(
+                initial_values, parameters, drivers, direct_mcs,
+                differential_mcs, ode_solver_name, output_step_size,
+                adaptive_rel_error_tol, adaptive_abs_error_tol,
+                adaptive_max_steps, override_controls, override_names,
+                zero_indices));
+
+            handles[worker]->set_output_selection(
+                output_patterns, output_decimation);
+        },
+        [&](size_t worker, size_t i) {
+            string unused_report;
+            try {
+                handles[worker]->set_slots(override_values[i]);
+
+                // Only the selected output from each run is kept until all
+                // the runs have finished
+                results[i] = handles[worker]->run(false, unused_report);
+            } catch (std::exception const& e) {
+                throw std::runtime_error(
+                    "Run " + std::to_string(i + 1) + " failed: " + e.what());
+            }
+        });
+
+    return stack_results(results, "run_id");
+}
+
+/**
+ *  @brief Combines several simulation results that have the same quantities
+ *  into a single result.
+ *
+ *  The stacked columns are allocated at their full size before any input is
+ *  released, so the peak memory use is about twice the combined size of the
+ *  results. Each input result is cleared once it has been copied.
+ *
+ *  @param [in, out] results The results to combine; they will be empty
+ *                   afterwards
+ *
+ *  @param [in] id_name The name of an additional column that holds the
+ *              (one-based) index of the result that produced each row
+ *
+ *  @return The combined result
+ */
+state_vector_map stack_results(
+    vector<state_vector_map>& results,
+    string const& id_name)
+{
+    state_vector_map stacked;
+
+    if (results.empty()) {
+        return stacked;
+    }
+
+    size_t nrows = 0;
+    for (state_vector_map const& r : results) {
+        if (!r.empty()) {
+            nrows += r.begin()->second.size();
+        }
+    }
+
+    for (auto const& x : results[0]) {
+        stacked[x.first].reserve(nrows);
+    }
+
+    if (stacked.find(id_name) != stacked.end()) {
+        throw std::runtime_error(
+            "`" + id_name + "` cannot be used as an id column because it is " +
+            "already one of the output quantities");
+    }
+
+    vector<double>& ids = stacked[id_name];
+    ids.reserve(nrows);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].size() + 1 != stacked.size()) {
+            throw std::runtime_error(
+                "Results cannot be stacked because they do not have the same "
+                "quantities");
+        }
+
+        size_t n = results[i].begin()->second.size();
+
+        for (auto& x : results[i]) {
+            auto it = stacked.find(x.first);
+            if (it == stacked.end()) {
+                throw std::runtime_error(
+                    "Results cannot be stacked because they do not have the "
+                    "same quantities");
+            }
+            it->second.insert(it->second.end(), x.second.begin(), x.second.end());
+        }
+
+        ids.insert(ids.end(), n, (double)(i + 1));
+
+        state_vector_map().swap(results[i]);
+    }
+
+    return stacked;
+}
@@ -0,0 +1,31 @@
+#ifndef SIMULATION_BATCH_H
+#define SIMULATION_BATCH_H
+
+#include <string>
+#include <vector>
+#include "framework/state_map.h"       // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"  // for mc_vector
+
+state_vector_map run_simulation_batch(
+    state_map const& initial_values,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs,
+    std::string const& ode_solver_name,
+    double output_step_size,
+    double adaptive_rel_error_tol,
+    double adaptive_abs_error_tol,
+    int adaptive_max_steps,
+    string_vector const& override_controls,
+    string_vector const& override_names,
+    std::vector<std::vector<double>> const& override_values,
+    size_t nthreads,
+    string_vector const& output_patterns,
+    size_t output_decimation);
+
+state_vector_map stack_results(
+    std::vector<state_vector_map>& results,
+    std::string const& id_name);
+
+#endif
@@ -0,0 +1,260 @@
+#include <stdexcept>  // for std::runtime_error
+#include "framework/ode_solver_library/ode_solver_factory.h"  // for ode_solver_factory
+#include "simulation_dispatch.h"
+#include "simulation_output.h"  // for select_quantity_names, select_columns
+
+dispatching_simulation::dispatching_simulation(
+    state_map const& initial_values,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs,
+    std::string const& ode_solver_name,
+    double output_step_size,
+    double adaptive_rel_error_tol,
+    double adaptive_abs_error_tol,
+    int adaptive_max_steps,
+    bool persistent)
+    : differential_quantity_names{keys(initial_values)},
+      output_selected{false},
+      output_decimation{1}
+{
+    if (ode_solver_name == homemade_lsoda_simulation::get_name()) {
+        lsoda_simulation.reset(new homemade_lsoda_simulation(
+            initial_values, parameters, drivers, direct_mcs, differential_mcs,
+            output_step_size, adaptive_rel_error_tol, adaptive_abs_error_tol,
+            adaptive_max_steps));
+    } else if (ode_solver_name == homemade_dopri5_simulation::get_name()) {
+        dopri5_simulation.reset(new homemade_dopri5_simulation(
+            initial_values, parameters, drivers, direct_mcs, differential_mcs,
+            output_step_size, adaptive_rel_error_tol, adaptive_abs_error_tol,
+            adaptive_max_steps));
+    } else if (persistent && ode_solver_name == homemade_euler_simulation::get_name()) {
+        euler_simulation.reset(new homemade_euler_simulation(
+            initial_values, parameters, drivers, direct_mcs, differential_mcs));
+    } else {
+        framework_simulation.reset(new biocro_simulation(
+            initial_values, parameters, drivers, direct_mcs, differential_mcs,
+            ode_solver_name, output_step_size, adaptive_rel_error_tol,
+            adaptive_abs_error_tol, adaptive_max_steps));
+    }
+}
+
+state_vector_map dispatching_simulation::run_simulation()
+{
+    if (lsoda_simulation) {
+        state_vector_map result = lsoda_simulation->run_simulation();
+        occurrences = lsoda_simulation->get_event_occurrences();
+        return result;
+    }
+
+    if (dopri5_simulation) {
+        state_vector_map result = dopri5_simulation->run_simulation();
+        occurrences = dopri5_simulation->get_event_occurrences();
+        return result;
+    }
+
+    if (euler_simulation) {
+        state_vector_map result = euler_simulation->run_simulation();
+        occurrences = euler_simulation->get_event_occurrences();
+        return result;
+    }
+
+    state_vector_map result = framework_simulation->run_simulation();
+    occurrences = find_events_in_result(result, events);
+
+    if (!output_selected) {
+        return result;
+    }
+
+    string_vector const selected_names = select_quantity_names(
+        keys(result), output_patterns, other_output_names);
+
+    return select_columns(result, selected_names, output_decimation);
+}
+
+/**
+ *  @brief Runs the simulation, passing its result to `writer` rather than
+ *  returning it.
+ */
+void dispatching_simulation::run_simulation(chunked_result_writer& writer)
+{
+    if (lsoda_simulation) {
+        lsoda_simulation->run_simulation(&writer);
+        occurrences = lsoda_simulation->get_event_occurrences();
+        return;
+    }
+
+    if (dopri5_simulation) {
+        dopri5_simulation->run_simulation(&writer);
+        occurrences = dopri5_simulation->get_event_occurrences();
+        return;
+    }
+
+    if (euler_simulation) {
+        state_vector_map result = euler_simulation->run_simulation();
+        occurrences = euler_simulation->get_event_occurrences();
+        write_result(result, writer);
+        return;
+    }
+
+    state_vector_map result = framework_simulation->run_simulation();
+    occurrences = find_events_in_result(result, events);
+    write_result(result, writer);
+}
+
+/**
+ *  @brief Sets the events to look for during the simulation; an exception is
+ *  thrown if any of them refers to a quantity that is not a differential
+ *  quantity.
+ */
+void dispatching_simulation::set_events(
+    std::vector<simulation_event> const& new_events)
+{
+    check_event_quantities(new_events, differential_quantity_names);
+
+    if (lsoda_simulation) {
+        lsoda_simulation->set_events(new_events);
+    }
+
+    if (dopri5_simulation) {
+        dopri5_simulation->set_events(new_events);
+    }
+
+    if (euler_simulation) {
+        euler_simulation->set_events(new_events);
+    }
+
+    events = new_events;
+}
+
+/**
+ *  @brief Chooses the quantities and output times included in the result of
+ *  `run_simulation()`.
+ *
+ *  @param [in] quantity_patterns The patterns used to select quantities; see
+ *              `select_quantity_names()` for details.
+ *
+ *  @param [in] decimation Only every `decimation`-th output time is kept,
+ *              starting with the first; a value of 1 keeps all of them
+ *
+ *  @param [in] other_quantity_names The names of quantities that the caller
+ *              adds to the result separately, which the patterns may match
+ */
+void dispatching_simulation::set_output_selection(
+    string_vector const& quantity_patterns,
+    size_t decimation,
+    string_vector const& other_quantity_names)
+{
+    if (decimation < 1) {
+        throw std::runtime_error("The output decimation must be at least 1");
+    }
+
+    if (lsoda_simulation) {
+        lsoda_simulation->set_output_quantities(
+            select_quantity_names(
+                lsoda_simulation->get_output_quantity_names(),
+                quantity_patterns, other_quantity_names),
+            decimation);
+        return;
+    }
+
+    if (dopri5_simulation) {
+        dopri5_simulation->set_output_quantities(
+            select_quantity_names(
+                dopri5_simulation->get_output_quantity_names(),
+                quantity_patterns, other_quantity_names),
+            decimation);
+        return;
+    }
+
+    if (euler_simulation) {
+        euler_simulation->set_output_quantities(
+            select_quantity_names(
+                euler_simulation->get_output_quantity_names(),
+                quantity_patterns, other_quantity_names),
+            decimation);
+        return;
+    }
+
+    output_selected = true;
+    output_patterns = quantity_patterns;
+    other_output_names = other_quantity_names;
+    output_decimation = decimation;
+}
+
+/**
+ *  @brief Returns a pointer to one of the simulation's initial values or
+ *  parameters, which can be used to change it before the next run.
+ *
+ *  @param [in] control Either `"initial_values"` or `"parameters"`
+ *
+ *  @param [in] name The name of the quantity
+ *
+ *  @return A pointer to the value, or `nullptr` if it cannot be changed after
+ *          the simulation has been constructed. This is always the case for
+ *          the framework's solvers and for drivers, which are copied by the
+ *          framework's `dynamical_system` when it is constructed.
+ */
+double* dispatching_simulation::get_input_ptr(
+    std::string const& control,
+    std::string const& name)
+{
+    if (control == "initial_values") {
+        if (lsoda_simulation) {
+            return lsoda_simulation->get_initial_value_ptr(name);
+        }
+
+        if (dopri5_simulation) {
+            return dopri5_simulation->get_initial_value_ptr(name);
+        }
+
+        if (euler_simulation) {
+            return euler_simulation->get_initial_value_ptr(name);
+        }
+    } else if (control == "parameters") {
+        if (lsoda_simulation) {
+            return lsoda_simulation->get_parameter_ptr(name);
+        }
+
+        if (dopri5_simulation) {
+            return dopri5_simulation->get_parameter_ptr(name);
+        }
+
+        if (euler_simulation) {
+            return euler_simulation->get_parameter_ptr(name);
+        }
+    }
+
+    return nullptr;
+}
+
+std::string dispatching_simulation::generate_report() const
+{
+    if (lsoda_simulation) {
+        return lsoda_simulation->generate_report();
+    }
+
+    if (dopri5_simulation) {
+        return dopri5_simulation->generate_report();
+    }
+
+    if (euler_simulation) {
+        return euler_simulation->generate_report();
+    }
+
+    return framework_simulation->generate_report();
+}
+
+/**
+ *  @brief Returns the names of all available ODE solvers: the ones from the
+ *  framework's ODE solver library followed by the ones implemented in this
+ *  package.
+ */
+string_vector get_all_ode_solver_names()
+{
+    string_vector result = ode_solver_factory::get_ode_solvers();
+    result.push_back(homemade_lsoda_simulation::get_name());
+    result.push_back(homemade_dopri5_simulation::get_name());
+    return result;
+}
@@ -0,0 +1,114 @@
+#ifndef SIMULATION_DISPATCH_H
+#define SIMULATION_DISPATCH_H
+
+#include <memory>                         // for std::unique_ptr
+#include <string>
+#include <vector>
+#include "framework/state_map.h"          // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"     // for mc_vector
+#include "framework/biocro_simulation.h"  // for biocro_simulation
+#include "homemade_dopri5.h"              // for homemade_dopri5_simulation
+#include "homemade_euler.h"               // for homemade_euler_simulation
+#include "homemade_lsoda.h"               // for homemade_lsoda_simulation
+#include "result_sink.h"                  // for chunked_result_writer
+#include "simulation_events.h"            // for simulation_event, event_occurrence
+
+/**
+ *  @class dispatching_simulation
+ *
+ *  @brief Runs a BioCro simulation using either the framework's
+ *  `biocro_simulation` or one of the ODE solvers implemented in this package,
+ *  depending on the name of the ODE solver.
+ *
+ *  Its constructor takes the same arguments as the one for
+ *  `biocro_simulation`, and it provides the same `run_simulation()` and
+ *  `generate_report()` functions, so it can be used wherever a
+ *  `biocro_simulation` would be used.
+ *
+ *  Events can be specified using `set_events()`. The `homemade_lsoda` and
+ *  `homemade_dopri5` solvers check for them after each step and stop after a
+ *  terminal event. The
+ *  framework's solvers do not provide a way to check for events during the
+ *  integration, so their results are searched for events afterwards and
+ *  truncated after any terminal event; see `find_events_in_result()`.
+ *
+ *  The result can also be passed to a `chunked_result_writer`. The
+ *  `homemade_lsoda` and `homemade_dopri5` solvers pass it each row as soon as
+ *  it has been calculated, so the full result is never stored; for the
+ *  framework's solvers, the full result is passed to the writer after the
+ *  simulation has finished.
+ *
+ *  A subset of the quantities and output times can be chosen using
+ *  `set_output_selection()`. The `homemade_lsoda` and `homemade_dopri5`
+ *  solvers only store the selected values. The framework's solvers always
+ *  store every quantity at every output time, so for them the full result is
+ *  still allocated and the selection is applied after the simulation has
+ *  finished. The selection is not applied when the result is passed to a
+ *  `chunked_result_writer`, which performs its own selection.
+ *
+ *  With the `homemade_lsoda` and `homemade_dopri5` solvers, the simulation can
+ *  be run more than once, and its initial values and parameters can be changed
+ *  between runs; see `get_input_ptr()`. The same is true for the
+ *  `homemade_euler` solver when `persistent` is true; in that case, it is run
+ *  by a `homemade_euler_simulation` rather than the framework's solver, which
+ *  gives the same result. The framework's solver is used otherwise, since a
+ *  simulation that is only run once gains nothing from it.
+ *
+ *  The module creators are not owned by this class; the code creating a
+ *  `dispatching_simulation` must make sure that they outlive it.
+ */
+class dispatching_simulation
+{
+   public:
+    dispatching_simulation(
+        state_map const& initial_values,
+        state_map const& parameters,
+        state_vector_map const& drivers,
+        mc_vector const& direct_mcs,
+        mc_vector const& differential_mcs,
+        std::string const& ode_solver_name,
+        double output_step_size,
+        double adaptive_rel_error_tol,
+        double adaptive_abs_error_tol,
+        int adaptive_max_steps,
+        bool persistent = false);
+
+    state_vector_map run_simulation();
+
+    void run_simulation(chunked_result_writer& writer);
+
+    std::string generate_report() const;
+
+    void set_events(std::vector<simulation_event> const& new_events);
+
+    void set_output_selection(
+        string_vector const& quantity_patterns,
+        size_t decimation,
+        string_vector const& other_quantity_names = {});
+
+    double* get_input_ptr(std::string const& control, std::string const& name);
+
+    std::vector<event_occurrence> const& get_event_occurrences() const
+    {
+        return occurrences;
+    }
+
+   private:
+    std::unique_ptr<biocro_simulation> framework_simulation;
+    std::unique_ptr<homemade_lsoda_simulation> lsoda_simulation;
+    std::unique_ptr<homemade_dopri5_simulation> dopri5_simulation;
+    std::unique_ptr<homemade_euler_simulation> euler_simulation;
+    string_vector const differential_quantity_names;
+    std::vector<simulation_event> events;
+    std::vector<event_occurrence> occurrences;
+
+    // The output selection for the framework's solvers
+    bool output_selected;
+    string_vector output_patterns;
+    string_vector other_output_names;
+    size_t output_decimation;
+};
+
+string_vector get_all_ode_solver_names();
+
+#endif
@@ -0,0 +1,172 @@
+#include <algorithm>  // for std::find, std::min, std::stable_sort
+#include <utility>    // for std::pair
+#include <stdexcept>  // for std::runtime_error
+#include "simulation_events.h"
+
+/**
+ *  @brief Determines whether an event function value of `after` following a
+ *  value of `before` is a crossing in the event's direction.
+ */
+bool event_crossed(simulation_event const& event, double before, double after)
+{
+    bool const rising = before < 0.0 && after >= 0.0;
+    bool const falling = before > 0.0 && after <= 0.0;
+
+    return (event.direction >= 0 && rising) ||
+           (event.direction <= 0 && falling);
+}
+
+/**
+ *  @brief Throws an exception if any event refers to a quantity that is not
+ *  one of the differential quantities.
+ */
+void check_event_quantities(
+    std::vector<simulation_event> const& events,
+    string_vector const& differential_quantity_names)
+{
+    for (auto const& e : events) {
+        if (std::find(differential_quantity_names.begin(),
+                      differential_quantity_names.end(),
+                      e.quantity) == differential_quantity_names.end()) {
+            throw std::runtime_error(
+                "The quantity `" + e.quantity + "` used by the event `" +
+                e.name + "` is not a differential quantity");
+        }
+    }
+}
+
+event_detector::event_detector(
+    std::vector<simulation_event> const& events,
+    string_vector const& differential_quantity_names)
+    : events{events}
+{
+    check_event_quantities(events, differential_quantity_names);
+
+    for (auto const& e : events) {
+        indices.push_back(
+            std::find(differential_quantity_names.begin(),
+                      differential_quantity_names.end(),
+                      e.quantity) -
+            differential_quantity_names.begin());
+    }
+}
+
+/**
+ *  @brief Stores the values of the event functions at the start of a
+ *  simulation.
+ */
+void event_detector::reset(std::vector<double> const& x0)
+{
+    g_prev.resize(events.size());
+    for (size_t j = 0; j < events.size(); ++j) {
+        g_prev[j] = x0[indices[j]] - events[j].threshold;
+    }
+}
+
+/**
+ *  @brief Sorts crossings by time and removes any that follow the first
+ *  terminal one.
+ */
+std::vector<event_crossing> event_detector::sort_crossings(
+    std::vector<event_crossing> crossings) const
+{
+    std::stable_sort(
+        crossings.begin(), crossings.end(),
+        [](event_crossing const& a, event_crossing const& b) {
+            return a.time < b.time;
+        });
+
+    for (size_t k = 0; k < crossings.size(); ++k) {
+        if (events[crossings[k].event].terminal) {
+            crossings.resize(k + 1);
+            break;
+        }
+    }
+
+    return crossings;
+}
+
+/**
+ *  @brief Finds the events that occurred in a simulation result that has
+ *  already been calculated.
+ *
+ *  This is used for ODE solvers that do not check for events as they
+ *  integrate. Crossings are found between consecutive rows of the result, and
+ *  their times are found by linear interpolation between the rows. If a
+ *  terminal event occurs, the rows after the first one at or after the event
+ *  are removed from `result`, as if the simulation had stopped there, and no
+ *  later events are reported.
+ *
+ *  @param [in, out] result A simulation result that includes the quantities
+ *                   used by the events
+ *
+ *  @param [in] events The events to look for
+ *
+ *  @return The events that occurred, in order of increasing time. When the
+ *          result includes a `time` quantity, the event times are values of
+ *          `time`; otherwise, they are row indices.
+ */
+std::vector<event_occurrence> find_events_in_result(
+    state_vector_map& result,
+    std::vector<simulation_event> const& events)
+{
+    std::vector<event_occurrence> occurrences;
+
+    if (events.empty() || result.empty()) {
+        return occurrences;
+    }
+
+    std::vector<std::vector<double> const*> columns;
+    for (auto const& e : events) {
+        columns.push_back(&result.at(e.quantity));
+    }
+
+    std::vector<double> const* time_column =
+        result.count("time") ? &result.at("time") : nullptr;
+
+    size_t const nrow = columns[0]->size();
+    size_t last_row = nrow;
+
+    for (size_t r = 1; r < nrow && last_row == nrow; ++r) {
+        double const t0 = time_column ? (*time_column)[r - 1] : r - 1.0;
+        double const t1 = time_column ? (*time_column)[r] : r;
+
+        // The crossings in this interval, as fractions of the interval
+        std::vector<std::pair<double, size_t>> crossings;
+        double first_terminal = 1.0;
+
+        for (size_t j = 0; j < events.size(); ++j) {
+            double const before = (*columns[j])[r - 1] - events[j].threshold;
+            double const after = (*columns[j])[r] - events[j].threshold;
+
+            if (event_crossed(events[j], before, after)) {
+                double const fraction = before / (before - after);
+                crossings.push_back({fraction, j});
+
+                if (events[j].terminal) {
+                    first_terminal = std::min(first_terminal, fraction);
+                    last_row = r;
+                }
+            }
+        }
+
+        // Events are reported in the order they occur, ignoring any that
+        // follow a terminal event
+        std::stable_sort(crossings.begin(), crossings.end());
+
+        for (auto const& c : crossings) {
+            if (c.first <= first_terminal) {
+                occurrences.push_back(
+                    {events[c.second].name, t0 + c.first * (t1 - t0)});
+            }
+        }
+    }
+
+    if (last_row < nrow) {
+        for (auto& x : result) {
+            x.second.resize(last_row + 1);
+        }
+    }
+
+    return occurrences;
+}
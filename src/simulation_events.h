@@ -0,0 +1,180 @@
+#ifndef SIMULATION_EVENTS_H
+#define SIMULATION_EVENTS_H
+
+#include <algorithm>  // for std::max
+#include <cmath>      // for std::abs
+#include <string>
+#include <vector>
+#include "framework/state_map.h"  // for state_vector_map, string_vector
+
+/**
+ *  @brief Describes an event that occurs when a differential quantity crosses
+ *  a threshold.
+ *
+ *  The event function is `value - threshold`. An event with a positive
+ *  `direction` occurs when this function changes from negative to
+ *  non-negative, one with a negative `direction` occurs when it changes from
+ *  positive to non-positive, and one with a `direction` of zero occurs in
+ *  either case. A crossing is only detected when the sign changes during the
+ *  simulation, so an event does not occur at the initial time even if the
+ *  threshold has already been passed.
+ *
+ *  When a terminal event occurs, the simulation stops at the first output
+ *  time at or after the event.
+ */
+struct simulation_event {
+    std::string name;
+    std::string quantity;
+    double threshold;
+    int direction;
+    bool terminal;
+};
+
+/**
+ *  @brief Records the name of an event that occurred and the value of `time`
+ *  when it occurred.
+ */
+struct event_occurrence {
+    std::string name;
+    double time;
+};
+
+/**
+ *  @brief Records the time index where the function of an event crossed zero
+ *  during a step, along with the position of the event in the list of
+ *  events.
+ */
+struct event_crossing {
+    double time;
+    size_t event;
+};
+
+bool event_crossed(simulation_event const& event, double before, double after);
+
+void check_event_quantities(
+    std::vector<simulation_event> const& events,
+    string_vector const& differential_quantity_names);
+
+/**
+ *  @class event_detector
+ *
+ *  @brief Checks for events during the steps of an ODE solver that can
+ *  evaluate its solution at any time within its last step.
+ *
+ *  After each step, the event functions are compared with their values at the
+ *  end of the previous step. When one of them has crossed zero in the event's
+ *  direction, the crossing is located using the Illinois variant of the false
+ *  position method on the solver's interpolated solution, so no additional
+ *  derivative calculations are needed.
+ */
+class event_detector
+{
+   public:
+    event_detector() {}
+
+    event_detector(
+        std::vector<simulation_event> const& events,
+        string_vector const& differential_quantity_names);
+
+    bool empty() const { return events.empty(); }
+
+    simulation_event const& get_event(size_t j) const { return events[j]; }
+
+    void reset(std::vector<double> const& x0);
+
+    /**
+     *  @brief Finds the events that occurred during a step.
+     *
+     *  @param [in] t_prev The time index at the start of the step
+     *
+     *  @param [in] t The time index at the end of the step
+     *
+     *  @param [in] x The differential quantities at the end of the step
+     *
+     *  @param [in] component A function where `component(time, i)` returns
+     *              differential quantity `i` at a time within the step
+     *
+     *  @return The crossings in order of increasing time, ending with the
+     *          first terminal event if any occurred
+     */
+    template <typename interpolator>
+    std::vector<event_crossing> check_step(
+        double t_prev,
+        double t,
+        std::vector<double> const& x,
+        interpolator const& component)
+    {
+        std::vector<event_crossing> crossings;
+
+        for (size_t j = 0; j < events.size(); ++j) {
+            double const g = x[indices[j]] - events[j].threshold;
+            if (event_crossed(events[j], g_prev[j], g)) {
+                auto const g_j = [&](double time) {
+                    return component(time, indices[j]) - events[j].threshold;
+                };
+                crossings.push_back(
+                    {locate_crossing(g_j, t_prev, g_prev[j], t, g), j});
+            }
+            g_prev[j] = g;
+        }
+
+        return sort_crossings(crossings);
+    }
+
+   private:
+    std::vector<simulation_event> events;
+    std::vector<size_t> indices;
+    std::vector<double> g_prev;
+
+    std::vector<event_crossing> sort_crossings(
+        std::vector<event_crossing> crossings) const;
+
+    /**
+     *  @brief Locates the time between `t_a`, where `g` has not crossed
+     *  zero, and `t_b`, where it has, at which the crossing occurs.
+     */
+    template <typename function>
+    static double locate_crossing(
+        function const& g,
+        double t_a,
+        double g_a,
+        double t_b,
+        double g_b)
+    {
+        bool const rising = g_a < 0.0;
+
+        int last_side = 0;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            if (t_b - t_a <= 1e-10 * std::max(1.0, std::abs(t_b))) {
+                break;
+            }
+
+            double const t_c = t_b - g_b * (t_b - t_a) / (g_b - g_a);
+            double const g_c = g(t_c);
+
+            if (rising ? g_c >= 0.0 : g_c <= 0.0) {
+                t_b = t_c;
+                g_b = g_c;
+                if (last_side == 1) {
+                    g_a /= 2.0;
+                }
+                last_side = 1;
+            } else {
+                t_a = t_c;
+                g_a = g_c;
+                if (last_side == -1) {
+                    g_b /= 2.0;
+                }
+                last_side = -1;
+            }
+        }
+
+        return t_b;
+    }
+};
+
+std::vector<event_occurrence> find_events_in_result(
+    state_vector_map& result,
+    std::vector<simulation_event> const& events);
+
+#endif
@@ -0,0 +1,201 @@
+#include <stdexcept>                     // for std::runtime_error, std::out_of_range
+#include <utility>                       // for std::move
+#include "homemade_dopri5.h"             // for homemade_dopri5_simulation
+#include "homemade_euler.h"              // for homemade_euler_simulation
+#include "homemade_lsoda.h"              // for homemade_lsoda_simulation
+#include "simulation_handle.h"
+
+using std::string;
+
+simulation_handle::simulation_handle(
+    state_map const& initial_values,
+    state_map const& parameters,
+    state_vector_map const& drivers,
+    mc_vector const& direct_mcs,
+    mc_vector const& differential_mcs,
+    string ode_solver_name,
+    double output_step_size,
+    double adaptive_rel_error_tol,
+    double adaptive_abs_error_tol,
+    int adaptive_max_steps,
+    string_vector const& slot_controls,
+    string_vector const& slot_names,
+    std::vector<size_t> const& slot_indices)
+    : initial_values{initial_values},
+      parameters{parameters},
+      drivers{drivers},
+      direct_mcs{direct_mcs},
+      differential_mcs{differential_mcs},
+      ode_solver_name{ode_solver_name},
+      output_step_size{output_step_size},
+      adaptive_rel_error_tol{adaptive_rel_error_tol},
+      adaptive_abs_error_tol{adaptive_abs_error_tol},
+      adaptive_max_steps{adaptive_max_steps},
+      ntimes{drivers.empty() ? 0 : drivers.begin()->second.size()},
+      output_decimation{1}
+{
+    if (drivers.empty()) {
+        throw std::runtime_error("The drivers cannot be empty");
+    }
+
+    if (slot_names.size() != slot_controls.size() ||
+        slot_indices.size() != slot_controls.size()) {
+        throw std::runtime_error(
+            "The slot controls, names, and indices must have the same length");
+    }
+
+    // Pointers to elements of an unordered_map remain valid until the element
+    // is erased, and none of the maps are modified after this point, so it is
+    // safe to store these pointers.
+    for (size_t i = 0; i < slot_controls.size(); ++i) {
+        slots.push_back(
+            find_slot(slot_controls[i], slot_names[i], slot_indices[i]));
+    }
+
+    bool const can_persist =
+        ntimes > 0 &&
+        (ode_solver_name == homemade_lsoda_simulation::get_name() ||
+         ode_solver_name == homemade_dopri5_simulation::get_name() ||
+         ode_solver_name == homemade_euler_simulation::get_name());
+
+    if (!can_persist) {
+        return;
+    }
+
+    std::unique_ptr<dispatching_simulation> sim(new dispatching_simulation(
+        this->initial_values, this->parameters, this->drivers, direct_mcs,
+        differential_mcs, ode_solver_name, output_step_size,
+        adaptive_rel_error_tol, adaptive_abs_error_tol, adaptive_max_steps,
+        true));
+
+    std::vector<double*> sim_slots;
+    for (size_t i = 0; i < slot_controls.size(); ++i) {
+        double* ptr = sim->get_input_ptr(slot_controls[i], slot_names[i]);
+
+        if (!ptr) {
+            // This slot can only be changed by rebuilding the simulation
+            return;
+        }
+
+        sim_slots.push_back(ptr);
+    }
+
+    // The stored inputs are no longer needed, since the simulation has its own
+    // copy of them
+    slots = sim_slots;
+    persistent_simulation = std::move(sim);
+    state_map().swap(this->initial_values);
+    state_map().swap(this->parameters);
+    state_vector_map().swap(this->drivers);
+}
+
+double* simulation_handle::find_slot(
+    string const& control,
+    string const& name,
+    size_t index)
+{
+    if (control == "initial_values" || control == "parameters") {
+        state_map& m = control == "initial_values" ? initial_values : parameters;
+
+        if (m.find(name) == m.end()) {
+            throw std::out_of_range(
+                "`" + name + "` is not in the `" + control + "`");
+        }
+
+        if (index != 0) {
+            throw std::out_of_range(
+                "The index for `" + name + "` in the `" + control +
+                "` must be 0");
+        }
+
+        return &m[name];
+    } else if (control == "drivers") {
+        if (drivers.find(name) == drivers.end()) {
+            throw std::out_of_range(
+                "`" + name + "` is not in the `drivers`");
+        }
+
+        std::vector<double>& column = drivers[name];
+
+        if (index >= column.size()) {
+            throw std::out_of_range(
+                "The index for `" + name + "` in the `drivers` is too large");
+        }
+
+        return &column[index];
+    } else {
+        throw std::out_of_range(
+            "`" + control + "` is not a valid slot control; it must be " +
+            "`initial_values`, `parameters`, or `drivers`");
+    }
+}
+
+/**
+ *  @brief Writes new values into the slots, in the same order used when the
+ *  handle was constructed.
+ */
+void simulation_handle::set_slots(std::vector<double> const& values)
+{
+    if (values.size() != slots.size()) {
+        throw std::runtime_error(
+            "The number of values (" + std::to_string(values.size()) +
+            ") does not match the number of slots (" +
+            std::to_string(slots.size()) + ")");
+    }
+
+    for (size_t i = 0; i < slots.size(); ++i) {
+        *slots[i] = values[i];
+    }
+}
+
+/**
+ *  @brief Chooses the quantities and output times included in the result of
+ *  each subsequent run; see `dispatching_simulation::set_output_selection()`.
+ */
+void simulation_handle::set_output_selection(
+    string_vector const& quantity_patterns,
+    size_t decimation)
+{
+    if (persistent_simulation) {
+        persistent_simulation->set_output_selection(quantity_patterns, decimation);
+    }
+
+    output_patterns = quantity_patterns;
+    output_decimation = decimation;
+}
+
+/**
+ *  @brief Runs a simulation using the current values of the stored inputs.
+ *
+ *  @param [in] verbose Indicates whether a report should be generated
+ *
+ *  @param [out] report The simulation report; only modified when `verbose` is
+ *               true
+ */
+state_vector_map simulation_handle::run(bool verbose, string& report)
+{
+    if (persistent_simulation) {
+        state_vector_map result = persistent_simulation->run_simulation();
+
+        if (verbose) {
+            report = persistent_simulation->generate_report();
+        }
+
+        return result;
+    }
+
+    dispatching_simulation gro(initial_values, parameters, drivers, direct_mcs,
+                               differential_mcs, ode_solver_name, output_step_size,
+                               adaptive_rel_error_tol, adaptive_abs_error_tol,
+                               adaptive_max_steps);
+
+    gro.set_output_selection(output_patterns, output_decimation);
+
+    state_vector_map result = gro.run_simulation();
+
+    if (verbose) {
+        report = gro.generate_report();
+    }
+
+    return result;
+}
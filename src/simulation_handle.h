@@ -0,0 +1,97 @@
+#ifndef SIMULATION_HANDLE_H
+#define SIMULATION_HANDLE_H
+
+#include <memory>  // for std::unique_ptr
+#include <string>
+#include <vector>
+#include "framework/state_map.h"       // for state_map, state_vector_map, string_vector
+#include "framework/module_creator.h"  // for mc_vector
+#include "simulation_dispatch.h"       // for dispatching_simulation
+
+/**
+ *  @class simulation_handle
+ *
+ *  @brief Stores all the inputs required to run a BioCro simulation so they
+ *  only need to be converted from R objects once, and provides a way to
+ *  modify a subset of them (the "slots") before each run.
+ *
+ *  A slot is a single value from the `initial_values`, `parameters`, or
+ *  `drivers` inputs, specified by a control name (one of
+ *  `"initial_values"`, `"parameters"`, or `"drivers"`), a quantity name, and
+ *  an index. The index is only meaningful for drivers; for initial values and
+ *  parameters, it must be zero. A pointer to each slot's storage is found
+ *  when the handle is constructed, so updating the slots before a run does
+ *  not require any name lookups.
+ *
+ *  The module creators are not owned by the handle; the code creating a
+ *  handle must make sure that they outlive it.
+ *
+ *  With the `homemade_lsoda`, `homemade_dopri5`, and `homemade_euler` ODE
+ *  solvers, when all the slots are initial values or parameters, one
+ *  `dispatching_simulation` is constructed along with the handle and reused
+ *  for every run; the slots then point to the simulation's own copies of these
+ *  values. Otherwise, a new
+ *  `dispatching_simulation` (including its modules and its copy of the drivers)
+ *  is constructed for each run, since the framework's `biocro_simulation` and
+ *  `dynamical_system` classes do not provide a way to modify their inputs
+ *  after construction. In that case, none of the conversions from R objects
+ *  are repeated, but the construction cost remains.
+ *
+ *  The quantities and output times included in each result can be chosen
+ *  using `set_output_selection()`; see
+ *  `dispatching_simulation::set_output_selection()`.
+ */
+class simulation_handle
+{
+   public:
+    simulation_handle(
+        state_map const& initial_values,
+        state_map const& parameters,
+        state_vector_map const& drivers,
+        mc_vector const& direct_mcs,
+        mc_vector const& differential_mcs,
+        std::string ode_solver_name,
+        double output_step_size,
+        double adaptive_rel_error_tol,
+        double adaptive_abs_error_tol,
+        int adaptive_max_steps,
+        string_vector const& slot_controls,
+        string_vector const& slot_names,
+        std::vector<size_t> const& slot_indices);
+
+    size_t get_nslots() const { return slots.size(); }
+
+    size_t get_ntimes() const { return ntimes; }
+
+    void set_slots(std::vector<double> const& values);
+
+    void set_output_selection(
+        string_vector const& quantity_patterns,
+        size_t decimation);
+
+    state_vector_map run(bool verbose, std::string& report);
+
+   private:
+    state_map initial_values;
+    state_map parameters;
+    state_vector_map drivers;
+    mc_vector const direct_mcs;
+    mc_vector const differential_mcs;
+    std::string const ode_solver_name;
+    double const output_step_size;
+    double const adaptive_rel_error_tol;
+    double const adaptive_abs_error_tol;
+    int const adaptive_max_steps;
+    size_t const ntimes;
+    std::vector<double*> slots;
+    std::unique_ptr<dispatching_simulation> persistent_simulation;
+    string_vector output_patterns;
+    size_t output_decimation;
+
+    double* find_slot(
+        std::string const& control,
+        std::string const& name,
+        size_t index);
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include <cmath>      // for std::floor
+#include <regex>      // for std::regex, std::regex_match
+#include <stdexcept>  // for std::runtime_error
+#include <utility>    // for std::move
+#include <vector>
+#include "simulation_output.h"
+
+/**
+ *  @brief Selects the names of the quantities to include in a simulation's
+ *  output.
+ *
+ *  @param [in] quantity_names The names of all the quantities
+ *
+ *  @param [in] quantity_patterns A set of regular expressions (using the
+ *              ECMAScript grammar); a quantity is selected if its full name
+ *              matches at least one of them. If this is empty, all quantities
+ *              are selected. The `time` quantity is always selected. An
+ *              exception is thrown if any pattern does not match any
+ *              quantity, since that usually indicates a typo.
+ *
+ *  @param [in] other_quantity_names The names of quantities that are added to
+ *              the output separately; they are never selected, but a pattern
+ *              that only matches one of them is not considered unmatched
+ *
+ *  @return The selected names, in the same order as in `quantity_names`
+ */
+string_vector select_quantity_names(
+    string_vector const& quantity_names,
+    string_vector const& quantity_patterns,
+    string_vector const& other_quantity_names)
+{
+    std::vector<std::regex> regexes;
+    for (std::string const& p : quantity_patterns) {
+        regexes.emplace_back(p);
+    }
+
+    std::vector<bool> pattern_used(regexes.size(), false);
+    string_vector selected;
+
+    for (std::string const& name : quantity_names) {
+        bool keep = regexes.empty() || name == "time";
+
+        // Check every pattern, even after a match, so we can tell which
+        // patterns were never used
+        for (size_t i = 0; i < regexes.size(); ++i) {
+            if (std::regex_match(name, regexes[i])) {
+                keep = true;
+                pattern_used[i] = true;
+            }
+        }
+
+        if (keep) {
+            selected.push_back(name);
+        }
+    }
+
+    for (std::string const& name : other_quantity_names) {
+        for (size_t i = 0; i < regexes.size(); ++i) {
+            if (std::regex_match(name, regexes[i])) {
+                pattern_used[i] = true;
+            }
+        }
+    }
+
+    std::string unused_patterns;
+    for (size_t i = 0; i < pattern_used.size(); ++i) {
+        if (!pattern_used[i]) {
+            unused_patterns += (unused_patterns.empty() ? "" : ", ") +
+                               quantity_patterns[i];
+        }
+    }
+
+    if (!unused_patterns.empty()) {
+        throw std::runtime_error(
+            "The following output quantity patterns did not match any "
+            "quantities: " + unused_patterns);
+    }
+
+    return selected;
+}
+
+/**
+ *  @brief Selects a subset of the columns and rows of a simulation result.
+ *
+ *  The selected columns are moved out of `result` rather than copied, and
+ *  decimation is performed in place, so no additional storage is required
+ *  for the selected output. The remaining columns are released when `result`
+ *  is cleared, before returning.
+ *
+ *  @param [in, out] result The full simulation result; it will be empty
+ *                   afterwards
+ *
+ *  @param [in] selected_names The names of the columns to keep
+ *
+ *  @param [in] decimation Only every `decimation`-th row is kept, starting
+ *              with the first; a value of 1 keeps all rows
+ *
+ *  @return The selected columns
+ */
+state_vector_map select_columns(
+    state_vector_map& result,
+    string_vector const& selected_names,
+    size_t decimation)
+{
+    if (decimation < 1) {
+        throw std::runtime_error("The output decimation must be at least 1");
+    }
+
+    state_vector_map selected;
+
+    for (std::string const& name : selected_names) {
+        std::vector<double>& column = result.at(name);
+
+        if (decimation > 1) {
+            size_t const n = (column.size() + decimation - 1) / decimation;
+            for (size_t j = 1; j < n; ++j) {
+                column[j] = column[j * decimation];
+            }
+            column.resize(n);
+            column.shrink_to_fit();
+        }
+
+        selected[name] = std::move(column);
+    }
+
+    result.clear();
+
+    return selected;
+}
+
+/**
+ *  @brief Selects a subset of the quantities and time points from a
+ *  simulation result; see `select_columns()` for details.
+ *
+ *  @param [in] quantity_patterns The patterns used to select quantities; see
+ *              `select_quantity_names()` for details.
+ */
+state_vector_map select_output(
+    state_vector_map& result,
+    string_vector const& quantity_patterns,
+    size_t decimation)
+{
+    return select_columns(
+        result,
+        select_quantity_names(keys(result), quantity_patterns),
+        decimation);
+}
+
+/**
+ *  @brief Calculates `doy` and `hour` columns from the `time` column of a
+ *  simulation result (in units of days), replacing any existing columns with
+ *  those names (which typically come from the drivers). If there is no `time`
+ *  column, the result is not modified.
+ */
+void add_doy_and_hour(state_vector_map& result)
+{
+    if (result.find("time") == result.end()) {
+        return;
+    }
+
+    std::vector<double> const& time = result.at("time");
+    std::vector<double> doy(time.size());
+    std::vector<double> hour(time.size());
+
+    for (size_t i = 0; i < time.size(); ++i) {
+        doy[i] = std::floor(time[i]);
+        hour[i] = 24.0 * (time[i] - doy[i]);
+    }
+
+    result["doy"].swap(doy);
+    result["hour"].swap(hour);
+}
@@ -0,0 +1,23 @@
+#ifndef SIMULATION_OUTPUT_H
+#define SIMULATION_OUTPUT_H
+
+#include "framework/state_map.h"  // for state_vector_map, string_vector
+
+string_vector select_quantity_names(
+    string_vector const& quantity_names,
+    string_vector const& quantity_patterns,
+    string_vector const& other_quantity_names = {});
+
+state_vector_map select_columns(
+    state_vector_map& result,
+    string_vector const& selected_names,
+    size_t decimation);
+
+state_vector_map select_output(
+    state_vector_map& result,
+    string_vector const& quantity_patterns,
+    size_t decimation);
+
+void add_doy_and_hour(state_vector_map& result);
+
+#endif